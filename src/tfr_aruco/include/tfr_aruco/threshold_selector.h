@@ -0,0 +1,71 @@
+#ifndef THRESHOLD_SELECTOR_H
+#define THRESHOLD_SELECTOR_H
+#include <opencv2/core.hpp>
+#include <opencv2/aruco.hpp>
+#include <vector>
+
+/**
+ * Picks the adaptive threshold settings for the aruco detector from how the
+ * frame looks, and learns which settings work in which conditions.
+ *
+ * Each frame is put in a lighting bin from its mean brightness and contrast
+ * (standard deviation), measured over every fourth row with opencv's
+ * vectorized meanStdDev. Every bin keeps a success rate for a short list of
+ * threshold presets. The caller tries presets in the order given by
+ * candidates() until one finds markers, then reports what happened.
+ *
+ * Frames where nothing worked teach nothing, most of the time that just
+ * means the board isn't in view. Frames where something worked count for
+ * the preset that worked and against the ones tried before it.
+ * */
+class ThresholdSelector
+{
+    public:
+        struct Preset
+        {
+            int window_min;
+            int window_max;
+            int window_step;
+            double constant;
+        };
+
+        ThresholdSelector();
+        ~ThresholdSelector() = default;
+        ThresholdSelector(const ThresholdSelector&) = delete;
+        ThresholdSelector& operator=(const ThresholdSelector&) = delete;
+        ThresholdSelector(ThresholdSelector&&) = delete;
+        ThresholdSelector& operator=(ThresholdSelector&&) = delete;
+
+        /*
+         * Bins the frame and fills order with the preset indices, most likely
+         * to work first, cheaper first on a tie. Returns the bin for update.
+         * */
+        int candidates(const cv::Mat& gray, std::vector<int>& order);
+
+        /*
+         * Copies a preset into the detector parameters
+         * */
+        void apply(int preset, cv::aruco::DetectorParameters& params) const;
+
+        /*
+         * Reports the outcome of a frame, tried holds the presets in the order
+         * they ran and found is how many markers the last one saw
+         * */
+        void update(int bin, const std::vector<int>& tried, int found);
+
+    private:
+        static const int BRIGHTNESS_BINS = 4;
+        static const int CONTRAST_BINS = 3;
+        //older outcomes fade so the table follows the lighting
+        static constexpr double FADE = 0.98;
+
+        std::vector<Preset> presets;
+        //thresholding passes per preset, the cost of trying it
+        std::vector<int> windows;
+        //per bin and preset, faded counts
+        std::vector<double> successes, attempts;
+
+        double estimate(int bin, int preset) const;
+};
+
+#endif
@@ -9,11 +9,32 @@
 #include <tfr_msgs/ArucoAction.h>
 #include <actionlib/server/simple_action_server.h>
 #include <tf2/LinearMath/Quaternion.h>
+#include <opencv2/imgproc.hpp>
+#include <dynamic_reconfigure/server.h>
+#include <tfr_aruco/ArucoConfig.h>
+#include <tfr_utilities/snapshot.h>
 #include "generatedMarker.h"
+#include "threshold_selector.h"
 
 #include <iostream>
+#include <algorithm>
 typedef actionlib::SimpleActionServer<tfr_msgs::ArucoAction> Server;
 
+/*
+ * Detector tuning, swapped in whole from dynamic_reconfigure (cfg/Aruco.cfg)
+ * and read once per goal
+ * */
+struct DetectorSettings
+{
+    //pick thresholds per frame with the ThresholdSelector, trying up to
+    //max_attempts of them, otherwise fixed is used
+    bool adaptive_thresholds;
+    int max_attempts;
+    ThresholdSelector::Preset fixed;
+    int corner_refinement_win_size;
+    double min_marker_perimeter_rate;
+};
+
 class TFR_Aruco {
     public:
         cv::Ptr<cv::aruco::Dictionary> dictionary;
@@ -21,7 +42,10 @@ class TFR_Aruco {
         cv::Ptr<cv::aruco::DetectorParameters> params;
         image_geometry::PinholeCameraModel cameraModel;
 
-        TFR_Aruco() {
+        TFR_Aruco(const DetectorSettings& initial) :
+            settings{initial},
+            reconfigureServer{ros::NodeHandle{"~"}}
+        {
             dictionary = cv::aruco::getPredefinedDictionary(cv::aruco::DICT_5X5_250);
 
             // set up board. This method is temporary until an official board is created. Works for now
@@ -35,7 +59,8 @@ class TFR_Aruco {
             // set up params
             params = cv::Ptr<cv::aruco::DetectorParameters>(new cv::aruco::DetectorParameters);
             params->cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
-            params->cornerRefinementWinSize = 5;
+
+            reconfigureServer.setCallback(boost::bind(&TFR_Aruco::reconfigure, this, _1, _2));
         }
 
         // This is the method that will be called when a client makes use
@@ -48,6 +73,9 @@ class TFR_Aruco {
                 return;
             }
             cameraModel.fromCameraInfo(goal->camera_info);
+            const DetectorSettings& current = settings.get();
+            params->cornerRefinementWinSize = current.corner_refinement_win_size;
+            params->minMarkerPerimeterRate = current.min_marker_perimeter_rate;
 
 
             // convert ROS message to opencv image
@@ -64,11 +92,36 @@ class TFR_Aruco {
             }
 
 
-            // detect fiducial markers
+            // detect fiducial markers, the detector would convert to gray on
+            // every attempt so do it once up front
             std::vector<int> markerIds;
             std::vector<std::vector<cv::Point2f> > markerCorners;
+            cv::cvtColor(imageHolder->image, gray, cv::COLOR_BGR2GRAY);
 
-            cv::aruco::detectMarkers(imageHolder->image, dictionary, markerCorners, markerIds, params);
+            if (current.adaptive_thresholds)
+            {
+                int bin = selector.candidates(gray, order);
+                tried.clear();
+                for (int preset : order)
+                {
+                    if (static_cast<int>(tried.size()) >= current.max_attempts)
+                        break;
+                    selector.apply(preset, *params);
+                    tried.push_back(preset);
+                    cv::aruco::detectMarkers(gray, dictionary, markerCorners, markerIds, params);
+                    if (!markerIds.empty())
+                        break;
+                }
+                selector.update(bin, tried, markerIds.size());
+            }
+            else
+            {
+                params->adaptiveThreshWinSizeMin = current.fixed.window_min;
+                params->adaptiveThreshWinSizeMax = current.fixed.window_max;
+                params->adaptiveThreshWinSizeStep = current.fixed.window_step;
+                params->adaptiveThreshConstant = current.fixed.constant;
+                cv::aruco::detectMarkers(gray, dictionary, markerCorners, markerIds, params);
+            }
 
             // get individual marker poses
             cv::Mat cameraMatrix = cv::Mat(cameraModel.fullIntrinsicMatrix()).clone();
@@ -105,14 +158,45 @@ class TFR_Aruco {
         }
     private:
         static constexpr double PI = 3.1415;
+
+        Snapshot<DetectorSettings> settings;
+        dynamic_reconfigure::Server<tfr_aruco::ArucoConfig> reconfigureServer;
+        ThresholdSelector selector;
+        //reused between goals
+        cv::Mat gray;
+        std::vector<int> order, tried;
+
+        void reconfigure(tfr_aruco::ArucoConfig& config, uint32_t level)
+        {
+            DetectorSettings next{};
+            next.adaptive_thresholds = config.adaptive_thresholds;
+            next.max_attempts = config.max_attempts;
+            //opencv wants an odd window and a max at least the min
+            next.fixed.window_min = config.window_min | 1;
+            next.fixed.window_max = std::max(config.window_max | 1, next.fixed.window_min);
+            next.fixed.window_step = config.window_step;
+            next.fixed.constant = config.threshold_constant;
+            next.corner_refinement_win_size = config.corner_refinement_win_size;
+            next.min_marker_perimeter_rate = config.min_marker_perimeter_rate;
+            settings.set(next);
+        }
 };
 
 int main(int argc, char** argv)
 {
     ros::init(argc, argv, "aruco_action_server");
     ros::NodeHandle n;
-    TFR_Aruco aruco;
-    Server server(n, "aruco_action_server", boost::bind(&TFR_Aruco::execute, aruco, _1, &server), false);
+    DetectorSettings settings{};
+    ros::param::param<bool>("~adaptive_thresholds", settings.adaptive_thresholds, true);
+    ros::param::param<int>("~max_attempts", settings.max_attempts, 3);
+    ros::param::param<int>("~window_min", settings.fixed.window_min, 3);
+    ros::param::param<int>("~window_max", settings.fixed.window_max, 23);
+    ros::param::param<int>("~window_step", settings.fixed.window_step, 10);
+    ros::param::param<double>("~threshold_constant", settings.fixed.constant, 7);
+    ros::param::param<int>("~corner_refinement_win_size", settings.corner_refinement_win_size, 5);
+    ros::param::param<double>("~min_marker_perimeter_rate", settings.min_marker_perimeter_rate, 0.03);
+    TFR_Aruco aruco{settings};
+    Server server(n, "aruco_action_server", boost::bind(&TFR_Aruco::execute, &aruco, _1, &server), false);
     server.start();
     ros::spin();
     return 0;
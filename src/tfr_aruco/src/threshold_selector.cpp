@@ -0,0 +1,85 @@
+#include "threshold_selector.h"
+#include <algorithm>
+
+ThresholdSelector::ThresholdSelector() :
+    presets{
+        //opencv's defaults
+        {3, 23, 10, 7},
+        //one small window, cheap and fine in even light
+        {5, 5, 10, 7},
+        //wide windows and a low constant pull faint edges out of dust
+        {7, 37, 15, 3},
+        //high constant for glare and hard shadows
+        {3, 33, 15, 12},
+        //large windows for markers far away in low contrast
+        {15, 55, 20, 5}},
+    windows(presets.size()),
+    successes(BRIGHTNESS_BINS * CONTRAST_BINS * presets.size(), 0.0),
+    attempts(BRIGHTNESS_BINS * CONTRAST_BINS * presets.size(), 0.0)
+{
+    for (size_t i = 0; i < presets.size(); ++i)
+        windows[i] = (presets[i].window_max - presets[i].window_min) /
+            presets[i].window_step + 1;
+    //start out trusting the defaults a little
+    for (int bin = 0; bin < BRIGHTNESS_BINS * CONTRAST_BINS; ++bin)
+    {
+        successes[bin * presets.size()] = 1;
+        attempts[bin * presets.size()] = 1;
+    }
+}
+
+int ThresholdSelector::candidates(const cv::Mat& gray, std::vector<int>& order)
+{
+    //every fourth row is plenty for the statistics
+    cv::Mat sparse(gray.rows / 4, gray.cols, gray.type(), gray.data, gray.step * 4);
+    cv::Scalar mean, deviation;
+    cv::meanStdDev(sparse, mean, deviation);
+
+    int brightness = std::min(static_cast<int>(mean[0] / 64), BRIGHTNESS_BINS - 1);
+    int contrast = deviation[0] < 25 ? 0 : (deviation[0] < 55 ? 1 : 2);
+    int bin = brightness * CONTRAST_BINS + contrast;
+
+    order.resize(presets.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this, bin](int a, int b)
+            {
+                double ea = estimate(bin, a), eb = estimate(bin, b);
+                return ea > eb || (ea == eb && windows[a] < windows[b]);
+            });
+    return bin;
+}
+
+void ThresholdSelector::apply(int preset, cv::aruco::DetectorParameters& params) const
+{
+    params.adaptiveThreshWinSizeMin = presets[preset].window_min;
+    params.adaptiveThreshWinSizeMax = presets[preset].window_max;
+    params.adaptiveThreshWinSizeStep = presets[preset].window_step;
+    params.adaptiveThreshConstant = presets[preset].constant;
+}
+
+void ThresholdSelector::update(int bin, const std::vector<int>& tried, int found)
+{
+    if (found == 0 || tried.empty())
+        return;
+    double* bin_successes = &successes[bin * presets.size()];
+    double* bin_attempts = &attempts[bin * presets.size()];
+    for (size_t i = 0; i < presets.size(); ++i)
+    {
+        bin_successes[i] *= FADE;
+        bin_attempts[i] *= FADE;
+    }
+    for (int preset : tried)
+        bin_attempts[preset] += 1;
+    bin_successes[tried.back()] += 1;
+}
+
+/*
+ * Success rate with one imagined success and failure, so untried presets sit
+ * at a half and still get their turn after the ones that keep failing
+ * */
+double ThresholdSelector::estimate(int bin, int preset) const
+{
+    int index = bin * presets.size() + preset;
+    return (successes[index] + 1) / (attempts[index] + 2);
+}
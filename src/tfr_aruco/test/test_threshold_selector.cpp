@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "threshold_selector.h"
+
+namespace
+{
+    const int WIDTH = 64, HEIGHT = 48;
+
+    cv::Mat uniform(int value)
+    {
+        return cv::Mat(HEIGHT, WIDTH, CV_8UC1, cv::Scalar(value));
+    }
+
+    //vertical stripes of two shades, a mean halfway and a deviation of half
+    //the difference
+    cv::Mat stripes(int low, int high)
+    {
+        cv::Mat image(HEIGHT, WIDTH, CV_8UC1, cv::Scalar(low));
+        for (int row = 0; row < HEIGHT; ++row)
+            for (int col = 1; col < WIDTH; col += 2)
+                image.at<uchar>(row, col) = high;
+        return image;
+    }
+
+    //a frame where the presets in tried ran in order and the last one saw
+    //markers
+    void succeed(ThresholdSelector& selector, const cv::Mat& frame,
+            const std::vector<int>& tried, int times)
+    {
+        std::vector<int> order;
+        for (int i = 0; i < times; ++i)
+            selector.update(selector.candidates(frame, order), tried, 4);
+    }
+}
+
+TEST(ThresholdSelector, StartsWithTheDefaults)
+{
+    ThresholdSelector selector{};
+    std::vector<int> order;
+    selector.candidates(uniform(128), order);
+    //the defaults, then the untried ones cheapest first
+    ASSERT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ThresholdSelector, BinsByBrightnessAndContrast)
+{
+    ThresholdSelector selector{};
+    std::vector<int> order;
+    ASSERT_EQ(selector.candidates(uniform(10), order), 0);
+    ASSERT_EQ(selector.candidates(uniform(250), order), 9);
+    //mean 130 deviation 30
+    ASSERT_EQ(selector.candidates(stripes(100, 160), order), 7);
+    //mean 127.5 deviation 127.5
+    ASSERT_EQ(selector.candidates(stripes(0, 255), order), 5);
+}
+
+TEST(ThresholdSelector, LearnsWhatWorksInEachBin)
+{
+    ThresholdSelector selector{};
+    //in the dark the defaults and the small window keep missing, the wide
+    //windows find the board
+    succeed(selector, uniform(10), {0, 1, 2}, 5);
+    std::vector<int> order;
+    selector.candidates(uniform(10), order);
+    ASSERT_EQ(order[0], 2);
+    //what failed falls behind presets that haven't been tried yet
+    ASSERT_EQ(order.back(), 1);
+    ASSERT_EQ(order[order.size() - 2], 0);
+
+    //the bright bin learned nothing from it
+    selector.candidates(uniform(250), order);
+    ASSERT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ThresholdSelector, LearnsNothingFromMisses)
+{
+    ThresholdSelector selector{};
+    std::vector<int> order;
+    int bin = selector.candidates(uniform(10), order);
+    for (int i = 0; i < 20; ++i)
+    {
+        selector.update(bin, {0, 1, 2, 3, 4}, 0);
+        selector.update(bin, {}, 3);
+    }
+    selector.candidates(uniform(10), order);
+    ASSERT_EQ(order, (std::vector<int>{0, 1, 2, 3, 4}));
+}
+
+TEST(ThresholdSelector, FollowsTheLighting)
+{
+    ThresholdSelector selector{};
+    succeed(selector, uniform(10), {0, 2}, 20);
+    //the dust settles and the defaults work again
+    succeed(selector, uniform(10), {2, 0}, 30);
+    std::vector<int> order;
+    selector.candidates(uniform(10), order);
+    ASSERT_EQ(order[0], 0);
+}
+
+TEST(ThresholdSelector, AppliesThePreset)
+{
+    ThresholdSelector selector{};
+    cv::aruco::DetectorParameters params{};
+    selector.apply(4, params);
+    ASSERT_EQ(params.adaptiveThreshWinSizeMin, 15);
+    ASSERT_EQ(params.adaptiveThreshWinSizeMax, 55);
+    ASSERT_EQ(params.adaptiveThreshWinSizeStep, 20);
+    ASSERT_DOUBLE_EQ(params.adaptiveThreshConstant, 5);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
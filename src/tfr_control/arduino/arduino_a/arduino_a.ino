@@ -23,11 +23,12 @@ const int TURNTABLE_B = 19;
 struct Potentiometer
 {
     Potentiometer(float slope, float intercept) :
-      m{slope}, b{intercept}, estimate{0.0} {}
+      m{slope}, b{intercept}, estimate{0.0}, raw{0.0} {}
 
     float m{}; //the slope of the linear graph
     float b{}; //the y intercept of the linear
     float estimate{}; //uses exponential smoothing 
+    float raw{}; //the last reading as is, the host filters the arm itself
 
     float getPosition(uint16_t val)
     {
@@ -36,8 +37,8 @@ struct Potentiometer
         // more noise we have. The higher the coefficient, the more polluted our 
         // result becomes with erroneous noise data. 4 seems to be a good middle
         // ground.
-        float new_estimate = 0.0174533*(m*val + b);
-        estimate += (new_estimate - estimate)/4;
+        raw = 0.0174533*(m*val + b);
+        estimate += (raw - estimate)/4;
         return estimate;
     }
 };
@@ -104,6 +105,7 @@ void loop()
     ads1115_b.startADC_SingleEnded(0);
     delay(8);
     arduinoReading.arm_upper_pos = pots[ARM_UPPER].getPosition(ads1115_a.collectADC_SingleEnded());
+    arduinoReading.arm_upper_raw = pots[ARM_UPPER].raw;
     arduinoReading.bin_left_pos = pots[BIN_LEFT].getPosition(ads1115_b.collectADC_SingleEnded());
     nh.spinOnce(); 
 
@@ -111,12 +113,14 @@ void loop()
     ads1115_b.startADC_SingleEnded(1);
     delay(8);
     arduinoReading.arm_scoop_pos = pots[ARM_SCOOP].getPosition(ads1115_a.collectADC_SingleEnded());
+    arduinoReading.arm_scoop_raw = pots[ARM_SCOOP].raw;
     arduinoReading.bin_right_pos = pots[BIN_RIGHT].getPosition(ads1115_b.collectADC_SingleEnded());
     nh.spinOnce();
 
     ads1115_a.startADC_SingleEnded(3);
     delay(8);
     arduinoReading.arm_lower_pos = pots[ARM_LOWER].getPosition(ads1115_a.collectADC_SingleEnded());
+    arduinoReading.arm_lower_raw = pots[ARM_LOWER].raw;
     nh.spinOnce();
 
     arduino.publish(&arduinoReading);
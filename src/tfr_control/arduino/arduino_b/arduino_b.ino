@@ -4,8 +4,10 @@
 #include <ros.h>
 #include <tfr_msgs/ArduinoBReading.h>
 #include <quadrature.h>
+#include <tread_control.h>
 #include <std_msgs/Int32.h>
 #include <tfr_msgs/PwmCommand.h>
+#include <tfr_msgs/EStop.h>
 
 ros::NodeHandle nh;
 
@@ -14,6 +16,8 @@ const double CPR = 4096; //pulse per revolution
 const double GEARBOX_MPR = 2*3.1415*0.15; 
 const float MAX_DRIVEBASE_DELTA = 8.0;
 const float MAX_ARM_DELTA = 15.0;
+//the velocity loop corrects itself, allow it finer but faster steps
+const float MAX_VELOCITY_LOOP_DELTA = 1.0;
 
 const float FULL_DELTA = 100.0;
 
@@ -21,10 +25,26 @@ const float FULL_DELTA = 100.0;
 //pin constants
 const int GEARBOX_RIGHT_A = 2;
 const int GEARBOX_RIGHT_B = 3;
+//left gearbox encoder is fanned out from arduino_a, see README
+const int GEARBOX_LEFT_A = 18;
+const int GEARBOX_LEFT_B = 19;
 const int OUTPUT_ENABLE = 4;
 const int JETSON_ENABLE = 8;
 const int NEUTRAL = 470;
 
+//scheduling constants
+const unsigned long CONTROL_PERIOD = 2000; //us, 500hz tread velocity loop
+const unsigned long PUBLISH_PERIOD = 16000; //us, ~60hz feedback to the host
+const unsigned long COMMAND_TIMEOUT = 250000; //us, stop the treads if the host goes quiet
+
+//tread velocity loop gains, output is normalized pwm per m/s
+const float TREAD_KP = 1.1;
+const float TREAD_KI = 0.9;
+const float TREAD_KD = 0.05;
+const float TREAD_KF = 2.0; //1/max tread speed
+const float TREAD_INTEGRAL_LIMIT = 0.5;
+const float METERS_PER_COUNT = GEARBOX_MPR/CPR;
+
 enum class Address : int16_t
 {
     TREAD_LEFT = 0,
@@ -42,15 +62,40 @@ Adafruit_PWMServoDriver pwm = Adafruit_PWMServoDriver();
 
 //encoders
 VelocityQuadrature gearbox_right(CPR, GEARBOX_RIGHT_A, GEARBOX_RIGHT_B);
+VelocityQuadrature gearbox_left(CPR, GEARBOX_LEFT_A, GEARBOX_LEFT_B);
+
+//left motor and encoder are mounted mirrored, direction keeps both in the robot frame
+TreadVelocityController left_tread(TREAD_KP, TREAD_KI, TREAD_KD, TREAD_KF,
+        TREAD_INTEGRAL_LIMIT, METERS_PER_COUNT, -1);
+TreadVelocityController right_tread(TREAD_KP, TREAD_KI, TREAD_KD, TREAD_KF,
+        TREAD_INTEGRAL_LIMIT, METERS_PER_COUNT, 1);
+
+//set by the host per command, when false treads are driven open loop
+bool velocity_mode = false;
+bool outputs_enabled = false;
+unsigned long last_command = 0;
+unsigned long last_control = 0;
+unsigned long last_publish = 0;
 
-//TODO Quadrature turntable(CPR, GEARBOX_LEFT_A, GEARBOX_LEFT_B);
 tfr_msgs::ArduinoBReading arduino_reading;
 ros::Publisher arduino("arduino_b", &arduino_reading);
 void motorOutput(const tfr_msgs::PwmCommand& command);
 ros::Subscriber<tfr_msgs::PwmCommand> motor_subscriber("/motor_output", &motorOutput );
 
+//e-stop bypasses the control loop entirely, and is echoed back so the
+//operator can measure how long it took to land
+tfr_msgs::EStop estop_reading;
+ros::Publisher estop_ack("estop_ack", &estop_reading);
+void eStop(const tfr_msgs::EStop& command);
+ros::Subscriber<tfr_msgs::EStop> estop_subscriber("/estop", &eStop );
+bool estopped = false;
+
 uint16_t pwm_values[9] {};
 
+void setAddress(const Address &addr, float val, float max_delta);
+void updateTreads(unsigned long now);
+void disableOutputs();
+
 
 void setup()
 {
@@ -65,9 +110,12 @@ void setup()
 
     nh.initNode();
     nh.advertise(arduino);
+    nh.advertise(estop_ack);
     nh.subscribe(motor_subscriber);
+    nh.subscribe(estop_subscriber);
     pwm.begin();
     pwm.setPWMFreq(80);  // This is the maximum PWM frequency
+    Wire.setClock(400000); // fast mode i2c, the tread loop writes twice per period
     setAddress(Address::TREAD_LEFT, 0, FULL_DELTA);
     setAddress(Address::TREAD_RIGHT, 0, FULL_DELTA);
     setAddress(Address::ARM_TURNTABLE, 0, FULL_DELTA);
@@ -78,24 +126,80 @@ void setup()
     setAddress(Address::BIN_RIGHT, 0, FULL_DELTA);
 }
 
+/*
+ * Non blocking scheduler, the tread loop runs on a fixed period and everything
+ * else fills in the gaps. Nothing in here is allowed to delay.
+ * */
 void loop()
 {
-    arduino_reading.tread_right_vel = gearbox_right.getVelocity()/GEARBOX_MPR;
-    delay(8);
-    nh.spinOnce(); //I know we don't have any callbacks, but the libary needs this call
-    delay(8);
-    arduino.publish(&arduino_reading);
-    nh.spinOnce(); //I know we don't have any callbacks, but the libary needs this call
+    unsigned long now = micros();
+    if (now - last_control >= CONTROL_PERIOD)
+    {
+        last_control = now;
+        updateTreads(now);
+    }
+
+    if (now - last_publish >= PUBLISH_PERIOD)
+    {
+        last_publish = now;
+        arduino_reading.tread_right_vel = right_tread.getVelocity();
+        arduino.publish(&arduino_reading);
+    }
+    nh.spinOnce();
+}
+
+/*
+ * Samples both tread encoders and, when the host asked for velocity mode,
+ * closes the loop on them.
+ * */
+void updateTreads(unsigned long now)
+{
+    left_tread.measure(gearbox_left.read(), now);
+    right_tread.measure(gearbox_right.read(), now);
+
+    if (!velocity_mode || !outputs_enabled)
+        return;
+
+    //watchdog, the host stopped talking to us so coast to a stop
+    if (now - last_command > COMMAND_TIMEOUT)
+    {
+        left_tread.setTarget(0);
+        right_tread.setTarget(0);
+    }
+
+    float dt = CONTROL_PERIOD*1e-6;
+    setAddress(Address::TREAD_LEFT, left_tread.update(dt), MAX_VELOCITY_LOOP_DELTA);
+    setAddress(Address::TREAD_RIGHT, right_tread.update(dt), MAX_VELOCITY_LOOP_DELTA);
 }
 
 void motorOutput(const tfr_msgs::PwmCommand& command)
 {
 
-    if(command.enabled)
+    last_command = micros();
+    if(command.enabled && !estopped)
     {
       	digitalWrite(OUTPUT_ENABLE, LOW);
-        setAddress(Address::TREAD_LEFT, command.tread_left, MAX_DRIVEBASE_DELTA);
-        setAddress(Address::TREAD_RIGHT, command.tread_right, MAX_DRIVEBASE_DELTA);
+        outputs_enabled = true;
+        if (command.tread_velocity_mode)
+        {
+            //the tread pwm is owned by updateTreads now
+            velocity_mode = true;
+            left_tread.setTarget(command.tread_left_vel);
+            right_tread.setTarget(command.tread_right_vel);
+            left_tread.setFeedforward(command.tread_left_ff);
+            right_tread.setFeedforward(command.tread_right_ff);
+        }
+        else
+        {
+            if (velocity_mode)
+            {
+                left_tread.reset();
+                right_tread.reset();
+            }
+            velocity_mode = false;
+            setAddress(Address::TREAD_LEFT, command.tread_left, MAX_DRIVEBASE_DELTA);
+            setAddress(Address::TREAD_RIGHT, command.tread_right, MAX_DRIVEBASE_DELTA);
+        }
         setAddress(Address::ARM_TURNTABLE, command.arm_turntable, MAX_ARM_DELTA);
         setAddress(Address::ARM_LOWER, command.arm_lower, MAX_ARM_DELTA);
         setAddress(Address::ARM_UPPER, command.arm_upper, MAX_ARM_DELTA);
@@ -104,17 +208,47 @@ void motorOutput(const tfr_msgs::PwmCommand& command)
         setAddress(Address::BIN_RIGHT, command.bin_right, MAX_ARM_DELTA);
     }
     else
+        disableOutputs();
+}
+
+/*
+ * Handles the dedicated e-stop channel. A stop cuts the output enable line
+ * before anything else and latches, so motor commands still in flight from
+ * the control loop are ignored until the operator releases it.
+ * */
+void eStop(const tfr_msgs::EStop& command)
+{
+    if (command.stop)
     {
       	digitalWrite(OUTPUT_ENABLE, HIGH);
-        setAddress(Address::TREAD_LEFT, 0, FULL_DELTA);
-        setAddress(Address::TREAD_RIGHT, 0, FULL_DELTA);
-        setAddress(Address::ARM_TURNTABLE, 0, FULL_DELTA);
-        setAddress(Address::ARM_LOWER, 0, FULL_DELTA);
-        setAddress(Address::ARM_UPPER, 0, FULL_DELTA);
-        setAddress(Address::ARM_SCOOP, 0, FULL_DELTA);
-        setAddress(Address::BIN_LEFT, 0, FULL_DELTA);
-        setAddress(Address::BIN_RIGHT, 0, FULL_DELTA);
+        estopped = true;
+        disableOutputs();
     }
+    else
+        estopped = false;
+
+    estop_reading.stop = estopped;
+    estop_reading.sequence = command.sequence;
+    estop_ack.publish(&estop_reading);
+}
+
+/*
+ * Drops the output enable line and brings every output back to neutral
+ * */
+void disableOutputs()
+{
+  	digitalWrite(OUTPUT_ENABLE, HIGH);
+    outputs_enabled = false;
+    left_tread.reset();
+    right_tread.reset();
+    setAddress(Address::TREAD_LEFT, 0, FULL_DELTA);
+    setAddress(Address::TREAD_RIGHT, 0, FULL_DELTA);
+    setAddress(Address::ARM_TURNTABLE, 0, FULL_DELTA);
+    setAddress(Address::ARM_LOWER, 0, FULL_DELTA);
+    setAddress(Address::ARM_UPPER, 0, FULL_DELTA);
+    setAddress(Address::ARM_SCOOP, 0, FULL_DELTA);
+    setAddress(Address::BIN_LEFT, 0, FULL_DELTA);
+    setAddress(Address::BIN_RIGHT, 0, FULL_DELTA);
 }
 
 /*
@@ -0,0 +1,55 @@
+/**
+ * Adafruit_ADS1015.h
+ *
+ * The ads1115 with the split start and collect calls our sketches use. Like
+ * the chip, collecting before the conversion is done gives the last result
+ * instead, so a sketch which doesn't wait long enough reads stale values.
+ */
+#ifndef ADAFRUIT_ADS1015_H
+#define ADAFRUIT_ADS1015_H
+#include "Arduino.h"
+
+class Adafruit_ADS1115
+{
+    public:
+        Adafruit_ADS1115(uint8_t i2c_address = 0x48) : address{i2c_address} {}
+
+        void begin()
+        {
+        }
+
+        /*
+         * Writes the config register, the conversion starts from here
+         * */
+        void startADC_SingleEnded(uint8_t adc_channel)
+        {
+            sim::i2cTransfer(3);
+            channel = adc_channel;
+            started = sim::now();
+            pending = true;
+        }
+
+        /*
+         * Points at the conversion register and reads it back
+         * */
+        uint16_t collectADC_SingleEnded()
+        {
+            sim::i2cTransfer(1);
+            sim::i2cTransfer(2);
+            if (pending && sim::now() - started >= sim::CONVERSION_TIME)
+            {
+                result = sim::getAdc(address, channel);
+                pending = false;
+            }
+            return result;
+        }
+
+    private:
+        const uint8_t address;
+        uint8_t channel = 0;
+        unsigned long started = 0;
+        bool pending = false;
+        uint16_t result = 0;
+};
+
+#endif
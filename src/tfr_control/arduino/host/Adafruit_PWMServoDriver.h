@@ -0,0 +1,46 @@
+/**
+ * Adafruit_PWMServoDriver.h
+ *
+ * The pca9685, outputs land on the simulated board for sim::getPwm.
+ */
+#ifndef ADAFRUIT_PWMSERVODRIVER_H
+#define ADAFRUIT_PWMSERVODRIVER_H
+#include "Arduino.h"
+
+class Adafruit_PWMServoDriver
+{
+    public:
+        Adafruit_PWMServoDriver(uint8_t i2c_address = 0x40) {}
+
+        void begin()
+        {
+            //reset through mode1
+            sim::i2cTransfer(2);
+        }
+
+        /*
+         * Sleep, set the prescale, wake and restart, the library waits 5ms
+         * for the oscillator in the middle
+         * */
+        void setPWMFreq(float freq)
+        {
+            sim::i2cTransfer(1);
+            sim::i2cTransfer(1);
+            sim::i2cTransfer(2);
+            sim::i2cTransfer(2);
+            sim::i2cTransfer(2);
+            delay(5);
+            sim::i2cTransfer(2);
+        }
+
+        /*
+         * The led register and both 12 bit counts in one transaction
+         * */
+        void setPWM(uint8_t num, uint16_t on, uint16_t off)
+        {
+            sim::i2cTransfer(5);
+            sim::writePwm(num, off);
+        }
+};
+
+#endif
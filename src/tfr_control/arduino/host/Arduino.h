@@ -0,0 +1,55 @@
+/**
+ * Arduino.h
+ *
+ * The parts of the arduino core the sketches use, on the simulated clock.
+ * The ide includes this in every sketch, the host build does it through
+ * sketch.h.
+ */
+#ifndef ARDUINO_H
+#define ARDUINO_H
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+#include "sim.h"
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+inline void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value)
+{
+    sim::setPin(pin, value);
+    sim::advance(sim::DIGITAL_WRITE_TIME);
+}
+
+inline int digitalRead(uint8_t pin)
+{
+    return sim::getPin(pin);
+}
+
+inline unsigned long micros()
+{
+    return sim::now();
+}
+
+inline unsigned long millis()
+{
+    return sim::now() / 1000;
+}
+
+inline void delay(unsigned long ms)
+{
+    sim::advance(ms * 1000);
+}
+
+inline void delayMicroseconds(unsigned int us)
+{
+    sim::advance(us);
+}
+
+#endif
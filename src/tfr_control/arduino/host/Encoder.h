@@ -0,0 +1,30 @@
+/**
+ * Encoder.h
+ *
+ * The pjrc Encoder library, the count lives on the simulated board under the
+ * a pin so the test can turn the shaft with sim::setEncoder.
+ */
+#ifndef ENCODER_H
+#define ENCODER_H
+#include "Arduino.h"
+
+class Encoder
+{
+    public:
+        Encoder(int a_pin, int b_pin) : pin_a{a_pin} {}
+
+        int32_t read()
+        {
+            return sim::getEncoder(pin_a);
+        }
+
+        void write(int32_t count)
+        {
+            sim::setEncoder(pin_a, count);
+        }
+
+    private:
+        const int pin_a;
+};
+
+#endif
@@ -0,0 +1,26 @@
+/**
+ * Wire.h
+ *
+ * Only the bus clock matters on the host, it sets what every i2c device
+ * costs in simulated time.
+ */
+#ifndef WIRE_H
+#define WIRE_H
+#include "Arduino.h"
+
+class TwoWire
+{
+    public:
+        void begin()
+        {
+        }
+
+        void setClock(uint32_t hz)
+        {
+            sim::setI2cClock(hz);
+        }
+};
+
+extern TwoWire Wire;
+
+#endif
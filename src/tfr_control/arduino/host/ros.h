@@ -0,0 +1,116 @@
+/**
+ * ros.h
+ *
+ * Stands in for rosserial. Nothing goes over a serial port, publishers count
+ * what the sketch sends and the test hands messages to a subscriber with
+ * receive, which the sketch gets in its next spinOnce, in the order they
+ * were received.
+ */
+#ifndef ROS_H
+#define ROS_H
+#include "Arduino.h"
+#include <deque>
+#include <functional>
+
+namespace ros
+{
+    class NodeHandle;
+
+    class Publisher
+    {
+        public:
+            template<typename Msg>
+            Publisher(const char* topic, Msg* msg) : topic_name{topic} {}
+
+            template<typename Msg>
+            int publish(const Msg* msg)
+            {
+                ++published;
+                last_published = sim::now();
+                return 0;
+            }
+
+            const char* topic_name;
+            unsigned long published = 0;
+            unsigned long last_published = 0;
+    };
+
+    class SubscriberBase
+    {
+        public:
+            explicit SubscriberBase(const char* topic) : topic_name{topic} {}
+            virtual ~SubscriberBase() = default;
+
+            const char* topic_name;
+
+        protected:
+            friend class NodeHandle;
+            NodeHandle* node = nullptr;
+    };
+
+    class NodeHandle
+    {
+        public:
+            void initNode()
+            {
+                pending.clear();
+            }
+
+            void advertise(Publisher& publisher)
+            {
+            }
+
+            void subscribe(SubscriberBase& subscriber)
+            {
+                subscriber.node = this;
+            }
+
+            /*
+             * Hands over everything received since the last spin
+             * */
+            void spinOnce()
+            {
+                while (!pending.empty())
+                {
+                    auto callback = pending.front();
+                    pending.pop_front();
+                    callback();
+                }
+            }
+
+            void queue(const std::function<void()>& callback)
+            {
+                pending.push_back(callback);
+            }
+
+        private:
+            std::deque<std::function<void()>> pending{};
+    };
+
+    template<typename Msg>
+    class Subscriber : public SubscriberBase
+    {
+        public:
+            typedef void (*Callback)(const Msg&);
+
+            Subscriber(const char* topic, Callback cb) :
+                SubscriberBase{topic}, callback{cb} {}
+
+            /*
+             * A message arriving from the host, dropped like rosserial would
+             * if the sketch never subscribed
+             * */
+            void receive(const Msg& msg)
+            {
+                if (node == nullptr)
+                    return;
+                Callback cb = callback;
+                node->queue([cb, msg]() { cb(msg); });
+            }
+
+        private:
+            const Callback callback;
+    };
+}
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ * sim.cpp
+ *
+ * See tfr_control/arduino/host/sim.h for details.
+ */
+#include "sim.h"
+#include "Wire.h"
+#include <map>
+#include <utility>
+
+TwoWire Wire;
+
+namespace sim
+{
+    namespace
+    {
+        //arduino's default until the sketch sets it
+        const uint32_t DEFAULT_I2C_CLOCK = 100000;
+        //start, address and stop bits rounded into one byte, 9 bits each
+        const unsigned long BITS_PER_BYTE = 9;
+
+        struct Board
+        {
+            unsigned long clock = 0;
+            uint32_t i2c_clock = DEFAULT_I2C_CLOCK;
+            std::map<uint8_t, uint8_t> pins{};
+            std::map<int, int32_t> encoders{};
+            std::map<std::pair<uint8_t, uint8_t>, int16_t> adcs{};
+            std::map<uint8_t, uint16_t> pwms{};
+            unsigned long pwm_writes = 0;
+        };
+
+        Board& board()
+        {
+            //sketch globals touch the board as they're constructed
+            static Board instance{};
+            return instance;
+        }
+    }
+
+    void reset()
+    {
+        board() = Board{};
+    }
+
+    unsigned long now()
+    {
+        return board().clock;
+    }
+
+    void advance(unsigned long us)
+    {
+        board().clock += us;
+    }
+
+    void i2cTransfer(uint8_t bytes)
+    {
+        unsigned long bits = (bytes + 1) * BITS_PER_BYTE;
+        uint32_t hz = board().i2c_clock;
+        advance((bits * 1000000 + hz - 1) / hz);
+    }
+
+    void setI2cClock(uint32_t hz)
+    {
+        board().i2c_clock = hz;
+    }
+
+    uint32_t getI2cClock()
+    {
+        return board().i2c_clock;
+    }
+
+    void setPin(uint8_t pin, uint8_t value)
+    {
+        board().pins[pin] = value;
+    }
+
+    uint8_t getPin(uint8_t pin)
+    {
+        return board().pins[pin];
+    }
+
+    void setEncoder(int pin_a, int32_t count)
+    {
+        board().encoders[pin_a] = count;
+    }
+
+    int32_t getEncoder(int pin_a)
+    {
+        return board().encoders[pin_a];
+    }
+
+    void setAdc(uint8_t address, uint8_t channel, int16_t value)
+    {
+        board().adcs[std::make_pair(address, channel)] = value;
+    }
+
+    int16_t getAdc(uint8_t address, uint8_t channel)
+    {
+        return board().adcs[std::make_pair(address, channel)];
+    }
+
+    void writePwm(uint8_t channel, uint16_t value)
+    {
+        board().pwms[channel] = value;
+        ++board().pwm_writes;
+    }
+
+    uint16_t getPwm(uint8_t channel)
+    {
+        return board().pwms[channel];
+    }
+
+    unsigned long getPwmWrites()
+    {
+        return board().pwm_writes;
+    }
+}
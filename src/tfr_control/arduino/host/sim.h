@@ -0,0 +1,83 @@
+/**
+ * sim.h
+ *
+ * The simulated board behind the host mocks of the arduino libraries, see
+ * README.md. Time only moves when the sketch delays or talks to a device, by
+ * the costs below, or when the test moves it, so every run is the same.
+ *
+ * Encoders, adc inputs and pwm outputs are looked up by the pin or address
+ * the sketch gives them, so only build one sketch into each executable.
+ */
+#ifndef SIM_H
+#define SIM_H
+#include <stdint.h>
+
+namespace sim
+{
+    //a pass of loop() which doesn't touch a device, the scheduler checks and
+    //an empty spinOnce [us]
+    const unsigned long LOOP_TIME = 20;
+    //digitalWrite on a mega [us]
+    const unsigned long DIGITAL_WRITE_TIME = 5;
+    //ads1115 conversion at its default 128 samples per second [us]
+    const unsigned long CONVERSION_TIME = 7813;
+
+    /*
+     * Back to power on, the clock, pins, encoder counts, adc inputs and pwm
+     * outputs. The sketch's own globals are up to the test.
+     * */
+    void reset();
+
+    /*
+     * The clock in microseconds, what micros() gives the sketch
+     * */
+    unsigned long now();
+    void advance(unsigned long us);
+
+    /*
+     * Runs loop for at least duration microseconds of simulated time, each
+     * pass takes LOOP_TIME on top of whatever it spent on devices
+     * */
+    template<typename Loop>
+    void run(unsigned long duration, Loop loop)
+    {
+        unsigned long start = now();
+        while (now() - start < duration)
+        {
+            loop();
+            advance(LOOP_TIME);
+        }
+    }
+
+    /*
+     * One i2c transaction of bytes after the address, at the Wire clock
+     * */
+    void i2cTransfer(uint8_t bytes);
+    void setI2cClock(uint32_t hz);
+    uint32_t getI2cClock();
+
+    void setPin(uint8_t pin, uint8_t value);
+    uint8_t getPin(uint8_t pin);
+
+    /*
+     * Encoder counts by the a pin of the encoder
+     * */
+    void setEncoder(int pin_a, int32_t count);
+    int32_t getEncoder(int pin_a);
+
+    /*
+     * Raw ads1115 inputs by i2c address and channel
+     * */
+    void setAdc(uint8_t address, uint8_t channel, int16_t value);
+    int16_t getAdc(uint8_t address, uint8_t channel);
+
+    /*
+     * The pca9685 off count last written to each channel, and how many
+     * writes it's taken since the reset
+     * */
+    void writePwm(uint8_t channel, uint16_t value);
+    uint16_t getPwm(uint8_t channel);
+    unsigned long getPwmWrites();
+}
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * sketch.h
+ *
+ * Everything a sketch includes, pulled in ahead of it. Include this, then
+ * the .ino inside a namespace:
+ *
+ *   #include "sketch.h"
+ *   namespace arduino_b
+ *   {
+ *   #include "arduino_b/arduino_b.ino"
+ *   }
+ *
+ * The include guards keep the sketch's own includes out of the namespace,
+ * and the test reaches setup, loop and the sketch's globals through it.
+ * Add any new library a sketch includes here as well.
+ */
+#ifndef SKETCH_H
+#define SKETCH_H
+#include <limits.h>
+#include "Arduino.h"
+#include "Encoder.h"
+#include "Wire.h"
+#include "Adafruit_ADS1015.h"
+#include "Adafruit_PWMServoDriver.h"
+#include "ros.h"
+#include "std_msgs/Int32.h"
+#include "tfr_msgs/ArduinoAReading.h"
+#include "tfr_msgs/ArduinoBReading.h"
+#include "tfr_msgs/EStop.h"
+#include "tfr_msgs/PwmCommand.h"
+#include <quadrature.h>
+#include <tread_control.h>
+#endif
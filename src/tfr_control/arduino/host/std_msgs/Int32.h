@@ -0,0 +1,18 @@
+/**
+ * Int32.h
+ *
+ * std_msgs/Int32 as rosserial generates it.
+ */
+#ifndef STD_MSGS_INT32_H
+#define STD_MSGS_INT32_H
+#include <stdint.h>
+
+namespace std_msgs
+{
+    struct Int32
+    {
+        int32_t data = 0;
+    };
+}
+
+#endif
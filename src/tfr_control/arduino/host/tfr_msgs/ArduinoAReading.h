@@ -0,0 +1,27 @@
+/**
+ * ArduinoAReading.h
+ *
+ * The fields of tfr_msgs/ArduinoAReading as rosserial generates them, keep
+ * in step with the msg.
+ */
+#ifndef TFR_MSGS_ARDUINOAREADING_H
+#define TFR_MSGS_ARDUINOAREADING_H
+
+namespace tfr_msgs
+{
+    struct ArduinoAReading
+    {
+        double tread_left_vel = 0;
+        float arm_lower_pos = 0;
+        float arm_upper_pos = 0;
+        float arm_scoop_pos = 0;
+        float bin_right_pos = 0;
+        float bin_left_pos = 0;
+        float arm_turntable_pos = 0;
+        float arm_lower_raw = 0;
+        float arm_upper_raw = 0;
+        float arm_scoop_raw = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * ArduinoBReading.h
+ *
+ * The fields of tfr_msgs/ArduinoBReading as rosserial generates them, keep
+ * in step with the msg.
+ */
+#ifndef TFR_MSGS_ARDUINOBREADING_H
+#define TFR_MSGS_ARDUINOBREADING_H
+
+namespace tfr_msgs
+{
+    struct ArduinoBReading
+    {
+        double tread_right_vel = 0;
+    };
+}
+
+#endif
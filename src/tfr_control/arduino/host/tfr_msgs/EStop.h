@@ -0,0 +1,20 @@
+/**
+ * EStop.h
+ *
+ * The fields of tfr_msgs/EStop as rosserial generates them, keep in step
+ * with the msg.
+ */
+#ifndef TFR_MSGS_ESTOP_H
+#define TFR_MSGS_ESTOP_H
+#include <stdint.h>
+
+namespace tfr_msgs
+{
+    struct EStop
+    {
+        bool stop = false;
+        uint32_t sequence = 0;
+    };
+}
+
+#endif
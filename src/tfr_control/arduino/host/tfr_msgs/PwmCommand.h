@@ -0,0 +1,31 @@
+/**
+ * PwmCommand.h
+ *
+ * The fields of tfr_msgs/PwmCommand as rosserial generates them, keep in
+ * step with the msg.
+ */
+#ifndef TFR_MSGS_PWMCOMMAND_H
+#define TFR_MSGS_PWMCOMMAND_H
+
+namespace tfr_msgs
+{
+    struct PwmCommand
+    {
+        bool enabled = false;
+        float tread_left = 0;
+        float tread_right = 0;
+        float arm_turntable = 0;
+        float arm_lower = 0;
+        float arm_upper = 0;
+        float arm_scoop = 0;
+        float bin_left = 0;
+        float bin_right = 0;
+        bool tread_velocity_mode = false;
+        float tread_left_vel = 0;
+        float tread_right_vel = 0;
+        float tread_left_ff = 0;
+        float tread_right_ff = 0;
+    };
+}
+
+#endif
@@ -30,16 +30,28 @@ class VelocityQuadrature
         data.p_0 = 0;
     }
     
-    //time will only overflow every 50 days of consecutive operation, non issue
-    data.t_1 = millis()*1e-3; 
+    //micros overflows every ~70 minutes, unsigned subtraction keeps dt correct
+    data.t_1 = micros();
+    unsigned long dt = data.t_1 - data.t_0;
+    if (dt == 0)
+        return data.velocity;
 
     //calculate the velocity
-    double velocity = (data.p_1 - data.p_0)/((double)(data.t_1-data.t_0)*CPR);
+    data.velocity = (data.p_1 - data.p_0)/(dt*1e-6*CPR);
     
     data.p_0 = data.p_1;
     data.t_0 = data.t_1;
     
-    return velocity;
+    return data.velocity;
+  }
+
+  /*
+    Raw encoder count, for callers which do their own differencing. Does not
+    recenter, so don't mix with getVelocity on the same encoder.
+  */
+  int32_t read()
+  {
+    return encoder.read();
   }
 
   private:
@@ -48,9 +60,10 @@ class VelocityQuadrature
     struct EncoderData
     {
       int32_t p_0 = 0;
-      double t_0 = 0;
+      unsigned long t_0 = 0;
       int32_t p_1 = 0;
-      double t_1 = 0;
+      unsigned long t_1 = 0;
+      double velocity = 0;
     };
 
     const int CPR;
@@ -75,7 +88,8 @@ class PositionQuadrature
   */
   double getPosition()
   {
-    return encoder.read()/CPR;
+    //cast first, integer division would only move once a revolution
+    return static_cast<double>(encoder.read())/CPR;
   }
 
   private:
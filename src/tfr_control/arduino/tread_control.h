@@ -0,0 +1,141 @@
+#ifndef TREAD_CONTROL_H
+#define TREAD_CONTROL_H
+#include <stdint.h>
+
+/*
+  Closed loop velocity controller for one tread, designed to run at a fixed
+  rate (~500hz) directly against the raw quadrature count.
+
+  A single control period only sees a handful of encoder counts, so velocity
+  is measured across a short sliding window of samples instead of the last
+  interval. The output is a feedforward on the setpoint plus a pid on the
+  error, normalized to [-1, 1] for setAddress.
+
+  direction flips both the measurement and the output so the setpoint is
+  always in the robot frame (positive is forward).
+  */
+class TreadVelocityController
+{
+  public:
+    TreadVelocityController(float kp, float ki, float kd, float kf,
+            float integral_limit, float meters_per_count, int8_t direction):
+        KP{kp}, KI{ki}, KD{kd}, KF{kf}, INTEGRAL_LIMIT{integral_limit},
+        METERS_PER_COUNT{meters_per_count}, DIRECTION{direction} {}
+
+    /*
+      Sets the target velocity in m/s
+      */
+    void setTarget(float target)
+    {
+        setpoint = target;
+    }
+
+    /*
+      Sets the output added on top of the loop to hold against a slope, in the
+      robot frame, so the integral doesn't have to find it
+      */
+    void setFeedforward(float ff)
+    {
+        feedforward = ff;
+    }
+
+    /*
+      Drops the accumulated integral and derivative history, call whenever the
+      outputs are disabled so we don't resume with a stale windup
+      */
+    void reset()
+    {
+        setpoint = 0;
+        feedforward = 0;
+        integral = 0;
+        output = 0;
+        last_velocity = velocity;
+    }
+
+    /*
+      Takes a new sample of the encoder, must be called every control period
+      whether or not the loop is closed so the velocity estimate stays fresh
+      */
+    void measure(int32_t count, unsigned long now)
+    {
+        uint8_t oldest = (head + 1) % WINDOW;
+        counts[head] = count;
+        times[head] = now;
+        if (samples < WINDOW)
+        {
+            ++samples;
+            oldest = 0;
+        }
+        //unsigned subtraction handles micros overflow
+        unsigned long dt = times[head] - times[oldest];
+        last_velocity = velocity;
+        if (dt != 0)
+            velocity = DIRECTION * static_cast<int32_t>(
+                    static_cast<uint32_t>(counts[head]) -
+                    static_cast<uint32_t>(counts[oldest])) *
+                METERS_PER_COUNT / (dt * 1e-6);
+        head = (head + 1) % WINDOW;
+    }
+
+    /*
+      Runs one pid step with period dt (seconds) against the last measurement
+      and gives the motor output in [-1, 1]
+      */
+    float update(float dt)
+    {
+        float error = setpoint - velocity;
+
+        //derivative on measurement, setpoint steps don't kick the output
+        float derivative = -(velocity - last_velocity) / dt;
+
+        float unclamped = KF * setpoint + feedforward + KP * error + KI * integral + KD * derivative;
+
+        //conditional integration, don't wind up while saturated in the same direction
+        bool saturated = (unclamped >= 1 && error > 0) || (unclamped <= -1 && error < 0);
+        if (!saturated)
+        {
+            integral += error * dt;
+            if (integral > INTEGRAL_LIMIT)
+                integral = INTEGRAL_LIMIT;
+            else if (integral < -INTEGRAL_LIMIT)
+                integral = -INTEGRAL_LIMIT;
+        }
+
+        output = unclamped;
+        if (output > 1)
+            output = 1;
+        else if (output < -1)
+            output = -1;
+        return DIRECTION * output;
+    }
+
+    /*
+      Measured velocity in m/s in the robot frame
+      */
+    float getVelocity() const
+    {
+        return velocity;
+    }
+
+  private:
+    static const uint8_t WINDOW = 8;
+
+    const float KP, KI, KD, KF;
+    const float INTEGRAL_LIMIT;
+    const float METERS_PER_COUNT;
+    const int8_t DIRECTION;
+
+    int32_t counts[WINDOW] = {};
+    unsigned long times[WINDOW] = {};
+    uint8_t head = 0;
+    uint8_t samples = 0;
+
+    float setpoint = 0;
+    float feedforward = 0;
+    float velocity = 0;
+    float last_velocity = 0;
+    float integral = 0;
+    float output = 0;
+};
+
+#endif
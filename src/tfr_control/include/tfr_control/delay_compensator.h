@@ -0,0 +1,71 @@
+/**
+ * delay_compensator.h
+ *
+ * Predicts where a joint is now from a position measurement that's behind.
+ *
+ * By the time a potentiometer sample reaches the control loop it's been
+ * through the adc conversion, the arduino loop and rosserial, and the last
+ * few outputs haven't shown up in it yet. A proportional ramp acting on it
+ * keeps driving after the joint is there. This is a Smith predictor for an
+ * actuator that runs at a speed proportional to its pwm: the prediction is
+ * the measurement plus how far the outputs it can't have seen yet should have
+ * moved the joint.
+ *
+ * How many outputs that is gets measured as it runs. While the joint moves,
+ * each change between samples is compared against what the outputs of each
+ * candidate lag would have done, and the lag that has fit best lately is the
+ * delay. A stationary joint says nothing about the delay, so it's only
+ * learned while something is driven.
+ */
+#ifndef DELAY_COMPENSATOR_H
+#define DELAY_COMPENSATOR_H
+
+namespace tfr_control
+{
+    class DelayCompensator
+    {
+        public:
+            //longest delay that can be found, in control cycles
+            static const int HISTORY = 10;
+
+            DelayCompensator();
+            ~DelayCompensator() = default;
+            DelayCompensator(const DelayCompensator&) = delete;
+            DelayCompensator& operator=(const DelayCompensator&) = delete;
+            DelayCompensator(DelayCompensator&&) = delete;
+            DelayCompensator& operator=(DelayCompensator&&) = delete;
+
+            /*
+             * Called once a cycle. Takes the latest measurement, whether it's
+             * a new sample since the last call, the output the joint was given
+             * since the last call (signed to raise the position), the joint
+             * speed at full output, and the time in seconds. Returns the
+             * position predicted for now.
+             * */
+            double compensate(double measured, bool sampled, double applied,
+                    double pwm_rate, double time);
+
+            //the delay found so far [s]
+            double getDelay() const;
+
+        private:
+            //how many samples the lag fit is averaged over, about
+            static constexpr double FIT_SAMPLES = 50.0;
+            //outputs under this don't count as driving the joint
+            static constexpr double DEADBAND = 0.01;
+
+            //outputs and how long each was applied, newest first
+            double outputs[HISTORY];
+            double durations[HISTORY];
+            //averaged squared miss of each lag
+            double misses[HISTORY];
+            int lag;
+            //cycles since the last sample
+            int unsampled;
+            double last_sample;
+            double last_time;
+            bool started;
+    };
+}
+
+#endif
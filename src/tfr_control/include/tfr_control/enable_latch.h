@@ -0,0 +1,57 @@
+/**
+ * enable_latch.h
+ *
+ * Decides whether the control loop may drive the outputs, given the toggle
+ * services and the dedicated e-stop channel.
+ *
+ * A stop on the e-stop channel disables and latches, the same as the
+ * firmware does. Until the operator releases the e-stop (a false on the
+ * channel) enables are refused, so an enable that was queued behind a stop,
+ * or sent by someone who never saw it, can't undo it. Disabling always
+ * works.
+ *
+ * Not thread safe, the caller keeps it in step with the hardware under its
+ * own lock.
+ */
+#ifndef ENABLE_LATCH_H
+#define ENABLE_LATCH_H
+
+namespace tfr_control
+{
+    class EnableLatch
+    {
+        public:
+            EnableLatch();
+            ~EnableLatch() = default;
+            EnableLatch(const EnableLatch&) = delete;
+            EnableLatch& operator=(const EnableLatch&) = delete;
+            EnableLatch(EnableLatch&&) = delete;
+            EnableLatch& operator=(EnableLatch&&) = delete;
+
+            /*
+             * A stop from the e-stop channel, disables until released
+             * */
+            void stop();
+
+            /*
+             * A release from the e-stop channel, the operator has seen every
+             * stop so far
+             * */
+            void release();
+
+            /*
+             * A toggle request, returns false if it was an enable and a stop
+             * is latched
+             * */
+            bool set(bool value);
+
+            bool isEnabled() const;
+            bool isLatched() const;
+
+        private:
+            bool enabled;
+            bool latched;
+    };
+}
+
+#endif
@@ -0,0 +1,81 @@
+/**
+ * joint_estimator.h
+ *
+ * Estimates the angle and speed of an arm joint from its raw potentiometer
+ * samples and the pwm it's driven with.
+ *
+ * The arduino smooths the potentiometers it publishes, which trades noise for
+ * lag the arm ramps then have to be detuned around, and there's no joint
+ * speed at all. This is a kalman filter instead. The actuators are modelled
+ * as running at a speed proportional to their pwm, reached over
+ * response_time, so a new command moves the estimate right away and the
+ * samples only have to correct it. The raw samples are noisy, the filter
+ * weighs them by how sure it is of the model at the time.
+ *
+ * Load and battery voltage change how fast an actuator really runs, so the
+ * speed per pwm is a third state next to angle and speed, starting at
+ * pwm_rate and learned from the samples while the joint is driven.
+ */
+#ifndef JOINT_ESTIMATOR_H
+#define JOINT_ESTIMATOR_H
+
+namespace tfr_control
+{
+    struct EstimatorGains
+    {
+        //joint speed at full pwm, signed the same as the joint [rad/s]
+        double pwm_rate;
+        //how long the actuator takes to get to the speed it's driven at [s]
+        double response_time;
+        //spread of a raw potentiometer sample [rad]
+        double position_noise;
+        //how far the actuator strays from the model, load, binding [rad/s^2]
+        double acceleration_noise;
+        //how quickly the real speed per pwm can drift from pwm_rate
+        //[rad/s per sqrt(s)]
+        double rate_drift;
+    };
+
+    class JointEstimator
+    {
+        public:
+            JointEstimator();
+            ~JointEstimator() = default;
+            JointEstimator(const JointEstimator&) = delete;
+            JointEstimator& operator=(const JointEstimator&) = delete;
+            JointEstimator(JointEstimator&&) = delete;
+            JointEstimator& operator=(JointEstimator&&) = delete;
+
+            /*
+             * Moves the estimate up to time in seconds, pwm being the output
+             * the joint was given since the last call, signed so positive
+             * raises the angle
+             * */
+            void predict(double pwm, double time, const EstimatorGains& gains);
+
+            /*
+             * Takes a raw potentiometer sample [rad], the first one starts the
+             * filter
+             * */
+            void correct(double position, const EstimatorGains& gains);
+
+            //whether there's been a sample yet
+            bool ready() const;
+            double getPosition() const;
+            double getVelocity() const;
+
+        private:
+            //steps longer than this are cut short, a stalled loop shouldn't
+            //throw the estimate [s]
+            static constexpr double MAX_STEP = 0.5;
+            static const int STATES = 3;
+
+            //position, velocity, and how far the speed per pwm is off pwm_rate
+            double state[STATES];
+            double covariance[STATES][STATES];
+            double last_time;
+            bool initialized;
+    };
+}
+
+#endif
@@ -24,8 +24,15 @@
 #include <tfr_msgs/ArduinoAReading.h>
 #include <tfr_msgs/ArduinoBReading.h>
 #include <tfr_msgs/PwmCommand.h>
+#include <sensor_msgs/Imu.h>
 #include <tfr_utilities/control_code.h>
+#include <tfr_utilities/snapshot.h>
+#include <tfr_utilities/trace_log.h>
+#include <atomic>
 #include <vector>
+#include "delay_compensator.h"
+#include "joint_estimator.h"
+#include "tread_feedforward.h"
 
 namespace tfr_control {
 
@@ -43,6 +50,42 @@ namespace tfr_control {
         SCOOP 
     };
 
+    /*
+     * Tuning for the position joints driven by raw pwm. Deltas are joint
+     * errors in radians (meters for the bin), outputs are the pwm duty.
+     * */
+    struct ActuatorConstraints
+    {
+        //arm joints, error under min_delta is left alone, output ramps to
+        //max_pwm at max_delta
+        double arm_min_delta;
+        double arm_max_delta;
+        double arm_max_pwm;
+        //seconds of joint speed taken off the arm error, damps the ramp as
+        //the joint closes in
+        double arm_damping;
+        //the arm joint estimators, see JointEstimator
+        EstimatorGains lower_arm_estimator;
+        EstimatorGains upper_arm_estimator;
+        EstimatorGains scoop_estimator;
+        //same for the turntable
+        double turntable_min_delta;
+        double turntable_max_delta;
+        double turntable_max_pwm;
+        //bin, the actuator that is further ahead is scaled down once the two
+        //differ by more than individual_tolerance
+        double bin_total_tolerance;
+        double bin_individual_tolerance;
+        double bin_scaling;
+        //bin actuator speed at full output, for the delay compensation
+        double bin_pwm_rate;
+        //predict the arm and bin past their measurement delay, see
+        //DelayCompensator
+        bool delay_compensation;
+        //slope feedforward for the firmware tread loop, see TreadFeedforward
+        FeedforwardGains tread_feedforward;
+    };
+
     /**
      * Contains the lower level interface inbetween user commands coming
      * in from the controller layer, and manages the state of all joints,
@@ -56,8 +99,8 @@ namespace tfr_control {
         static const int JOINT_COUNT = 7;
 
 
-        RobotInterface(ros::NodeHandle &n, bool fakes, const double lower_lim[JOINT_COUNT],
-                const double upper_lim[JOINT_COUNT]);
+        RobotInterface(ros::NodeHandle &n, bool fakes, bool firmware_treads,
+                const double lower_lim[JOINT_COUNT], const double upper_lim[JOINT_COUNT]);
 
         
         /*
@@ -93,6 +136,11 @@ namespace tfr_control {
 
         void zeroTurntable();
 
+        /*
+         * Swaps in new actuator tuning, takes effect on the next write
+         * */
+        void setActuatorConstraints(const ActuatorConstraints& c);
+
     private:
         //joint states for Joint state publisher package
         hardware_interface::JointStateInterface joint_state_interface;
@@ -100,16 +148,46 @@ namespace tfr_control {
         hardware_interface::PositionJointInterface joint_position_interface;
         //cmd states for velocity driven joints
         hardware_interface::EffortJointInterface joint_effort_interface;
+        //cmd states for velocity setpoints closed on the arduino
+        hardware_interface::VelocityJointInterface joint_velocity_interface;
 
         //reads from arduino encoder publisher
         ros::Subscriber arduino_a;
         ros::Subscriber arduino_b;
+        ros::Subscriber imu;
         ros::Publisher pwm_publisher;
-        bool enabled;
+        //set by the services while the loop runs
+        std::atomic<bool> enabled;
+        //swapped atomically, the callbacks run on another thread than read()
         tfr_msgs::ArduinoAReadingConstPtr latest_arduino_a;
         tfr_msgs::ArduinoBReadingConstPtr latest_arduino_b;
-
-        double turntable_offset;
+        sensor_msgs::ImuConstPtr latest_imu;
+        ros::Time last_imu_stamp;
+        TreadFeedforward tread_feedforward;
+
+        //arm joint angle and speed from the raw potentiometers
+        JointEstimator lower_arm_estimator;
+        JointEstimator upper_arm_estimator;
+        JointEstimator scoop_estimator;
+        //measurement delay of the arm and each bin actuator
+        DelayCompensator lower_arm_compensator;
+        DelayCompensator upper_arm_compensator;
+        DelayCompensator scoop_compensator;
+        DelayCompensator bin_left_compensator;
+        DelayCompensator bin_right_compensator;
+        //what the bin ramp acts on, (left, right)
+        std::pair<double, double> bin_positions;
+        //output last sent to each bin actuator, signed to extend
+        std::pair<double, double> applied_bin_pwm;
+        //the last reading the estimators took a sample from
+        tfr_msgs::ArduinoAReadingConstPtr last_estimated_a;
+        //output last sent to each joint, signed to raise the angle
+        double applied_pwm[JOINT_COUNT]{};
+
+        //when set the tread commands are setpoints in m/s for arduino_b
+        bool firmware_tread_control;
+
+        std::atomic<double> turntable_offset;
 
 
         // Populated by controller layer for us to use
@@ -125,21 +203,35 @@ namespace tfr_control {
         std::pair<double, double> drivebase_v0;
         ros::Time last_update;
 
+        //written from the spinner thread, read in write()
+        Snapshot<ActuatorConstraints> actuator_constraints;
+
         
         void registerJoint(std::string name, Joint joint);
         void registerArmJoint(std::string name, Joint joint);
         void registerBinJoint(std::string name, Joint joint);
 
+        /*
+         * Brings an arm joint's estimate up to now and fills in its state,
+         * sampling the raw angle if there's a new reading
+         * */
+        void estimateArmJoint(Joint joint, JointEstimator& estimator,
+                DelayCompensator& compensator, const EstimatorGains& gains,
+                double raw, bool sampled, double now);
+
 
         //callback for publisher
         void readArduinoA(const tfr_msgs::ArduinoAReadingConstPtr &msg);
         //callback for publisher
         void readArduinoB(const tfr_msgs::ArduinoBReadingConstPtr &msg);
+        //callback for the imu
+        void readImu(const sensor_msgs::ImuConstPtr &msg);
 
         /**
          * Gets the PWM appropriate output for an angle joint at the current time
          * */
-        double angleToPWM(const double &desired, const double &measured);
+        double angleToPWM(const double &desired, const double &measured,
+                const double &velocity);
 
         /**
          * Gets the PWM appropriate output for turntable at the current time
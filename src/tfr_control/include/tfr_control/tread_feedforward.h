@@ -0,0 +1,77 @@
+/**
+ * tread_feedforward.h
+ *
+ * Works out how much extra tread output slopes call for before the tread
+ * loops see the speed drop.
+ *
+ * Gravity along the robot is sin(pitch) of its weight no matter which way we
+ * drive, so both treads get the same grade term against it. Across a slope
+ * the downhill tread carries more of the weight and drags, pulling the robot
+ * downhill, so it gets the cross term in its direction of travel and the
+ * uphill tread gives the same back. Only applied while the treads are asked
+ * to move, a parked robot doesn't need to fight the slope.
+ *
+ * Attitude is low pass filtered, so the tread output doesn't follow every
+ * bump. Without recent imu data there's no feedforward at all.
+ */
+#ifndef TREAD_FEEDFORWARD_H
+#define TREAD_FEEDFORWARD_H
+
+#include <utility>
+
+namespace tfr_control
+{
+    /*
+     * Outputs are normalized pwm, the same units as the firmware tread loop
+     * */
+    struct FeedforwardGains
+    {
+        //output per sin(pitch), about the output that holds speed on a wall
+        double grade;
+        //output per sin(roll) moved from the uphill tread to the downhill one
+        double cross;
+        //cap on the feedforward per tread
+        double max;
+    };
+
+    class TreadFeedforward
+    {
+        public:
+            TreadFeedforward();
+            ~TreadFeedforward() = default;
+            TreadFeedforward(const TreadFeedforward&) = delete;
+            TreadFeedforward& operator=(const TreadFeedforward&) = delete;
+            TreadFeedforward(TreadFeedforward&&) = delete;
+            TreadFeedforward& operator=(TreadFeedforward&&) = delete;
+
+            /*
+             * Takes an attitude sample, roll and pitch per REP 103 (pitch
+             * positive nose down, roll positive right side down), time in
+             * seconds
+             * */
+            void updateAttitude(double roll, double pitch, double time);
+
+            /*
+             * The (left, right) feedforward for tread setpoints in m/s, robot
+             * frame, at time in seconds
+             * */
+            std::pair<double, double> compute(double left_setpoint,
+                    double right_setpoint, double time,
+                    const FeedforwardGains& gains) const;
+
+        private:
+            //time constant of the attitude filter [s]
+            static constexpr double FILTER_TIME = 0.2;
+            //attitude older than this is ignored [s]
+            static constexpr double TIMEOUT = 0.5;
+            //setpoints under this count as stopped [m/s]
+            static constexpr double DEADBAND = 0.02;
+
+            double roll;
+            double pitch;
+            double last_time;
+            bool has_attitude;
+    };
+}
+
+#endif
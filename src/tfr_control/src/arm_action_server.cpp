@@ -15,6 +15,10 @@
  *              devel/include/tfr_msgs/ArmMoveFeedback.h
  *              devel/include/tfr_msgs/ArmMoveGoal.h
  *              devel/include/tfr_msgs/ArmMoveResult.h
+ *
+ *          Trajectory results come in on the arm_results thread, so a busy
+ *          global queue (MoveIt's state updates, the goal callbacks) can't
+ *          hold up the end of a move.
  * 
  ***************************************************************************************/
 #include <ros/ros.h>
@@ -22,6 +26,7 @@
 #include <actionlib/server/simple_action_server.h>
 #include <tfr_msgs/ArmMoveAction.h>
 #include <moveit/move_group_interface/move_group_interface.h>
+#include <tfr_utilities/callback_thread.h>
 #include <mutex>
 
 //typedef actionlib::SimpleActionServer<tfr_msgs::ArmMoveAction> Server;
@@ -29,12 +34,14 @@ typedef moveit::planning_interface::MoveItErrorCode MoveItErrorCode;
 
 class ArmActionServer {
 public:
-    ArmActionServer(ros::NodeHandle &n) : move_group{"arm_end"}, joint_model_group(*move_group.getCurrentState()->getJointModelGroup("arm_end")),
+    ArmActionServer(ros::NodeHandle &n) : result_thread{"arm_results"},
+        move_group{"arm_end"}, joint_model_group(*move_group.getCurrentState()->getJointModelGroup("arm_end")),
         server{n, "move_arm", boost::bind(&ArmActionServer::execute, this, _1), false}
     {
         ROS_INFO("Arm Action Server: Starting");
         server.start();
-        result_sub = n.subscribe("arm_controller/follow_joint_trajectory/result", 1, &ArmActionServer::resultCallback, this);
+        ros::NodeHandle result_n = result_thread.handle(n);
+        result_sub = result_n.subscribe("arm_controller/follow_joint_trajectory/result", 1, &ArmActionServer::resultCallback, this);
         ROS_INFO("Arm Action Server: Started");
     }
 
@@ -144,6 +151,8 @@ private:
         digging_mutex.unlock();
     }
 
+    //declared first so it outlives result_sub
+    CallbackThread result_thread;
     moveit::planning_interface::MoveGroupInterface move_group;
     const robot_state::JointModelGroup joint_model_group;
     actionlib::SimpleActionServer<tfr_msgs::ArmMoveAction> server;
@@ -165,6 +174,6 @@ int main(int argc, char** argv)
 
     ArmActionServer aas(n);
 
-    while (ros::ok()) ;
+    ros::waitForShutdown();
     return 0;
 }
@@ -5,16 +5,37 @@
  * It has the controller manager, which has the ability to register valid
  * controllers and manage their state. 
  * This layer maintains the state of the controller manager, and performs the
- * control loop for the control package.
+ * control loop for the control package. Runs as the tfr_control/Control
+ * nodelet, the loop gets the nodelet's worker thread to itself.
+ *
+ * The arduino, imu and e-stop callbacks run on the ctl_sensors thread and
+ * the services on ctl_services, so a slow service client never holds up the
+ * feedback the loop reads. Both have rules in the scheduling profile.
  *
  * PARAMETERS:
  *  ~rate: in hz how fast we want to run the control loop (double, default:10)
+ *  ~firmware_tread_control: send tread velocity setpoints to arduino_b
+ *  instead of pwm, needs the matching controllers loaded (bool, default:false)
+ *  The pwm ramps of the arm, turntable and bin, the arm joint estimators,
+ *  the arm and bin delay compensation, and the slope feedforward of the
+ *  firmware tread loop are set through dynamic_reconfigure
+ *  (cfg/Actuators.cfg) and can be tuned while running.
+ *  The estimated arm angles and speeds go out on /joint_states through the
+ *  joint_state_controller.
  * SERVICES:
  *  /toggle_control - uses the empty service, needs to be explicitly turned on to work
  *  /toggle_motors - uses the empty service, needs to be explicitly turned on to work
+ *  A stop on /estop latches like the firmware's, enables answer with
+ *  success false until a release (a false) comes in on /estop, see
+ *  enable_latch.h.
  *  /bin_state - gives the position of the bin
  *  /arm_state - gives the 4d position of the arm
  *  /zero_turntable - zeros the position of the turntable
+ * SUBSCRIBED TOPICS:
+ *  /sensors/mti/sensor/imu - attitude for the tread feedforward
+ *  /estop - disables output immediately on a stop and latches until a
+ *  release, the firmware also listens to this directly so this just keeps
+ *  the loop consistent with it
  */
 #include <ros/ros.h>
 #include <std_srvs/SetBool.h>
@@ -22,11 +43,20 @@
 #include <tfr_msgs/QuerySrv.h>
 #include <tfr_msgs/BinStateSrv.h>
 #include <tfr_msgs/ArmStateSrv.h>
+#include <tfr_msgs/EStop.h>
 #include <urdf/model.h>
 #include <sstream>
+#include <atomic>
+#include <mutex>
 #include <controller_manager/controller_manager.h>
+#include <dynamic_reconfigure/server.h>
+#include <tfr_control/ActuatorsConfig.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <tfr_utilities/callback_thread.h>
+#include <pluginlib/class_list_macros.h>
 #include "robot_interface.h"
 #include "bin_control_server.h"
+#include "enable_latch.h"
 
 
 
@@ -86,17 +116,26 @@ void initializeTestCode(ros::NodeHandle& n)
 class Control
 {
     public:
-        Control(ros::NodeHandle &n, const double& rate):
-            robot_interface{n, use_fake_values, lower_limits, upper_limits},
+        Control(ros::NodeHandle &n, ros::NodeHandle &p_n, const double& rate,
+                const bool& firmware_treads):
+            sensor_thread{"ctl_sensors"},
+            service_thread{"ctl_services"},
+            sensor_n{sensor_thread.handle(n)},
+            service_n{service_thread.handle(n)},
+            robot_interface{sensor_n, use_fake_values, firmware_treads, lower_limits, upper_limits},
             controller_interface{&robot_interface},
-            eStopControl{n.advertiseService("toggle_control", &Control::toggleControl,this)},
-            eStopMotors{n.advertiseService("toggle_motors", &Control::toggleControl,this)},
-            binService{n.advertiseService("bin_state", &Control::getBinState,this)},
-            armService{n.advertiseService("arm_state", &Control::getArmState,this)},
-            zeroService{n.advertiseService("zero_turntable", &Control::zeroTurntable,this)},
+            eStopControl{service_n.advertiseService("toggle_control", &Control::toggleControl,this)},
+            eStopMotors{service_n.advertiseService("toggle_motors", &Control::toggleControl,this)},
+            binService{service_n.advertiseService("bin_state", &Control::getBinState,this)},
+            armService{service_n.advertiseService("arm_state", &Control::getArmState,this)},
+            zeroService{service_n.advertiseService("zero_turntable", &Control::zeroTurntable,this)},
+            eStopSubscriber{sensor_n.subscribe("/estop", 5, &Control::eStop, this)},
             cycle{1/rate},
-            enabled{false}
-        {}
+            enabled{false},
+            reconfigure_server{p_n}
+        {
+            reconfigure_server.setCallback(boost::bind(&Control::reconfigure, this, _1, _2));
+        }
         
         /*
          * performs one iteration of the control loop
@@ -115,6 +154,12 @@ class Control
         }
 
     private:
+        //declared first, the subscribers and servers below go before them
+        CallbackThread sensor_thread;
+        CallbackThread service_thread;
+        ros::NodeHandle sensor_n;
+        ros::NodeHandle service_n;
+
         //the hardware layer
         tfr_control::RobotInterface robot_interface;
 
@@ -132,11 +177,43 @@ class Control
         //reset service
         ros::ServiceServer zeroService;
 
+        //dedicated emergency stop channel
+        ros::Subscriber eStopSubscriber;
+
         //how fast to spin
         ros::Duration cycle;
 
-        //if our motors are enabled
-        bool enabled;
+        //if our motors are enabled, set from both callback threads
+        std::atomic<bool> enabled;
+        //keeps the latch, enabled and the robot interface in step between
+        //the threads
+        std::mutex enable_mutex;
+        tfr_control::EnableLatch latch;
+
+        dynamic_reconfigure::Server<tfr_control::ActuatorsConfig> reconfigure_server;
+
+        void reconfigure(tfr_control::ActuatorsConfig &config, uint32_t level)
+        {
+            robot_interface.setActuatorConstraints(tfr_control::ActuatorConstraints{
+                    config.arm_min_delta, config.arm_max_delta, config.arm_max_pwm,
+                    config.arm_damping,
+                    tfr_control::EstimatorGains{config.lower_arm_pwm_rate,
+                        config.arm_response_time, config.arm_position_noise,
+                        config.arm_acceleration_noise, config.arm_rate_drift},
+                    tfr_control::EstimatorGains{config.upper_arm_pwm_rate,
+                        config.arm_response_time, config.arm_position_noise,
+                        config.arm_acceleration_noise, config.arm_rate_drift},
+                    tfr_control::EstimatorGains{config.scoop_pwm_rate,
+                        config.arm_response_time, config.arm_position_noise,
+                        config.arm_acceleration_noise, config.arm_rate_drift},
+                    config.turntable_min_delta, config.turntable_max_delta,
+                    config.turntable_max_pwm,
+                    config.bin_total_tolerance, config.bin_individual_tolerance,
+                    config.bin_scaling, config.bin_pwm_rate,
+                    config.delay_compensation,
+                    tfr_control::FeedforwardGains{config.tread_grade_feedforward,
+                        config.tread_cross_feedforward, config.tread_max_feedforward}});
+        }
 
         /*
          * Toggles the emergency stop on and off
@@ -144,8 +221,7 @@ class Control
         bool toggleControl(std_srvs::SetBool::Request& request,
                 std_srvs::SetBool::Response& response)
         {
-            enabled = request.data;
-            robot_interface.setEnabled(request.data);
+            response.success = setEnabled(request.data);
             return true;
         }
 
@@ -155,12 +231,42 @@ class Control
         bool toggleMotors(std_srvs::SetBool::Request& request,
                 std_srvs::SetBool::Response& response)
         {
-            enabled = request.data;
-            robot_interface.setEnabled(request.data);
+            response.success = setEnabled(request.data);
             return true;
         }
 
 
+        /*
+         * Handles the dedicated e-stop channel. A stop disables and latches,
+         * a release only lets the toggle services enable again.
+         * */
+        void eStop(const tfr_msgs::EStopConstPtr &msg)
+        {
+            std::lock_guard<std::mutex> lock(enable_mutex);
+            if (msg->stop)
+                latch.stop();
+            else
+                latch.release();
+            enabled = latch.isEnabled();
+            robot_interface.setEnabled(enabled);
+        }
+
+        /*
+         * Sets both enables together, refused while a stop is latched
+         * */
+        bool setEnabled(bool value)
+        {
+            std::lock_guard<std::mutex> lock(enable_mutex);
+            if (!latch.set(value))
+            {
+                ROS_WARN("Control: enable refused, the e-stop hasn't been released");
+                return false;
+            }
+            enabled = latch.isEnabled();
+            robot_interface.setEnabled(enabled);
+            return true;
+        }
+
         /*
          * Gets the state of the bin
          * */
@@ -196,29 +302,41 @@ class Control
 
 };
 
-int main(int argc, char **argv)
+namespace tfr_control
 {
-    ros::init(argc, argv, "control");
-    ros::NodeHandle n;
+    class ControlNodelet : public ComponentNodelet
+    {
+        public:
+            ~ControlNodelet() { stop(); }
 
-    double rate;
-    ros::param::param<double>("~rate", rate, 30.0);
+        private:
+            std::unique_ptr<Control> control;
 
-    //test code
-    if (use_fake_values)
-        initializeTestCode(n);
+            /*
+             * Sensors and services get threads of their own in Control, the
+             * reconfigure server stays with the manager, this one just runs
+             * the loop until unloaded
+             * */
+            void start() override
+            {
+                ros::NodeHandle& n = getNodeHandle();
+                ros::NodeHandle& p_n = getPrivateNodeHandle();
 
-    // Start a spinner for ros node in the background, seperate from this thread
-    // that manages the control loop
-    ros::AsyncSpinner spinner(1);
-    spinner.start();
+                double rate;
+                p_n.param<double>("rate", rate, 30.0);
+                bool firmware_treads;
+                p_n.param<bool>("firmware_tread_control", firmware_treads, false);
 
-    Control control{n, rate};
+                //test code
+                if (use_fake_values)
+                    initializeTestCode(n);
 
-    while (ros::ok())
-    {
-        ros::spinOnce();
-        control.execute();
-    }
-    return 0;
+                control.reset(new Control{n, p_n, rate, firmware_treads});
+
+                while (running())
+                    control->execute();
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_control::ControlNodelet, nodelet::Nodelet)
@@ -0,0 +1,80 @@
+/**
+ * delay_compensator.cpp
+ *
+ * See tfr_control/include/tfr_control/delay_compensator.h for details.
+ */
+#include "delay_compensator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tfr_control
+{
+    const int DelayCompensator::HISTORY;
+    constexpr double DelayCompensator::FIT_SAMPLES;
+    constexpr double DelayCompensator::DEADBAND;
+
+    DelayCompensator::DelayCompensator() :
+        outputs{}, durations{}, misses{}, lag{0}, unsampled{0}, last_sample{0},
+        last_time{0}, started{false}
+    {
+    }
+
+    double DelayCompensator::compensate(double measured, bool sampled,
+            double applied, double pwm_rate, double time)
+    {
+        if (!started)
+        {
+            started = true;
+            last_sample = measured;
+            last_time = time;
+            return measured;
+        }
+
+        std::copy_backward(outputs, outputs + HISTORY - 1, outputs + HISTORY);
+        std::copy_backward(durations, durations + HISTORY - 1, durations + HISTORY);
+        outputs[0] = applied;
+        durations[0] = std::max(time - last_time, 0.0);
+        last_time = time;
+        ++unsampled;
+
+        if (sampled)
+        {
+            bool driven = std::any_of(outputs, outputs + HISTORY,
+                    [](double output) { return std::abs(output) > DEADBAND; });
+            //a sample at lag k has seen everything but the k newest outputs,
+            //so the change since the last one is down to the unsampled outputs
+            //just past those
+            if (driven && unsampled <= HISTORY)
+            {
+                double change = measured - last_sample;
+                for (int k = 0; k + unsampled <= HISTORY; ++k)
+                {
+                    double expected = 0;
+                    for (int j = k; j < k + unsampled; ++j)
+                        expected += pwm_rate * outputs[j] * durations[j];
+                    double miss = change - expected;
+                    misses[k] += (miss * miss - misses[k]) / FIT_SAMPLES;
+                }
+                //ties go to the shorter delay, the one that changes less
+                lag = std::min_element(misses, misses + HISTORY - unsampled + 1) - misses;
+            }
+            last_sample = measured;
+            unsampled = 0;
+        }
+
+        //the outputs the measurement hasn't seen yet
+        int unseen = std::min(lag + unsampled, HISTORY);
+        double predicted = measured;
+        for (int j = 0; j < unseen; ++j)
+            predicted += pwm_rate * outputs[j] * durations[j];
+        return predicted;
+    }
+
+    double DelayCompensator::getDelay() const
+    {
+        double delay = 0;
+        for (int j = 0; j < lag; ++j)
+            delay += durations[j];
+        return delay;
+    }
+}
@@ -5,36 +5,47 @@
  *                  velocity of the two motor sets (left and right). Most of the
  *                  responsibilities are delegated to the DrivebasePublisher class.
  * 
- * Launched By:     drivebase.launch
+ * Launched By:     drivebase.launch, as the tfr_control/Drivebase nodelet
  ***************************************************************************************/
 #include "ros/ros.h"
 #include "drivebase_publisher.h"
+#include <tfr_utilities/component_nodelet.h>
+#include <pluginlib/class_list_macros.h>
 
-
-int main(int argc, char **argv)
+namespace tfr_control
 {
-    ros::init(argc, argv, "drivebase");
+    class DrivebaseNodelet : public ComponentNodelet
+    {
+        public:
+            ~DrivebaseNodelet() { stop(); }
 
-    ros::NodeHandle n;
-    
-    double wheel_span, wheel_radius;
+        private:
+            std::unique_ptr<DrivebasePublisher> publisher;
 
-    ros::param::param<double>("~wheel_span", wheel_span, 1);
-    if (wheel_span <= 0)
-    {
-        ROS_ERROR("Parameter 'wheel_span' must be a positive value.");
-        return 1;
-    }
+            void start() override
+            {
+                ros::NodeHandle& p_n = getPrivateNodeHandle();
 
-    ros::param::param<double>("~wheel_radius", wheel_radius, 1);
-    if (wheel_radius <= 0)
-    {
-        ROS_ERROR("Parameter 'wheel_radius' must be a positive value.");
-        return 1;
-    }
-    
-    tfr_control::DrivebasePublisher publisher(n, wheel_span, wheel_radius);
-
-    ros::spin();
-    return 0;
+                double wheel_span, wheel_radius;
+
+                p_n.param<double>("wheel_span", wheel_span, 1);
+                if (wheel_span <= 0)
+                {
+                    NODELET_ERROR("Parameter 'wheel_span' must be a positive value.");
+                    return;
+                }
+
+                p_n.param<double>("wheel_radius", wheel_radius, 1);
+                if (wheel_radius <= 0)
+                {
+                    NODELET_ERROR("Parameter 'wheel_radius' must be a positive value.");
+                    return;
+                }
+
+                publisher.reset(new DrivebasePublisher(getNodeHandle(), wheel_span,
+                            wheel_radius));
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_control::DrivebaseNodelet, nodelet::Nodelet)
@@ -0,0 +1,38 @@
+#include "enable_latch.h"
+
+namespace tfr_control
+{
+    EnableLatch::EnableLatch() :
+        enabled{false}, latched{false}
+    {
+    }
+
+    void EnableLatch::stop()
+    {
+        enabled = false;
+        latched = true;
+    }
+
+    void EnableLatch::release()
+    {
+        latched = false;
+    }
+
+    bool EnableLatch::set(bool value)
+    {
+        if (value && latched)
+            return false;
+        enabled = value;
+        return true;
+    }
+
+    bool EnableLatch::isEnabled() const
+    {
+        return enabled;
+    }
+
+    bool EnableLatch::isLatched() const
+    {
+        return latched;
+    }
+}
@@ -0,0 +1,135 @@
+/**
+ * joint_estimator.cpp
+ *
+ * See tfr_control/include/tfr_control/joint_estimator.h for details.
+ */
+#include "joint_estimator.h"
+#include <algorithm>
+
+namespace tfr_control
+{
+    constexpr double JointEstimator::MAX_STEP;
+    const int JointEstimator::STATES;
+
+    namespace
+    {
+        enum State
+        {
+            POSITION,
+            VELOCITY,
+            RATE_ERROR
+        };
+    }
+
+    JointEstimator::JointEstimator() :
+        state{}, covariance{}, last_time{0}, initialized{false}
+    {
+    }
+
+    /*
+     * x = F x + B u, with
+     *
+     *      [1   dt        0]       [       0]
+     *  F = [0  1-a  a*pwm  ]   B = [a*pwm_rate]
+     *      [0    0        1]       [       0]
+     *
+     * a being the part of the way to the driven speed the actuator gets in dt.
+     * The acceleration noise is taken as white, giving the usual dt^3/3,
+     * dt^2/2, dt process covariance, and the rate error as a random walk.
+     * */
+    void JointEstimator::predict(double pwm, double time, const EstimatorGains& gains)
+    {
+        double dt = std::min(time - last_time, MAX_STEP);
+        if (!initialized || dt < 0)
+        {
+            last_time = time;
+            return;
+        }
+        last_time = time;
+        if (dt == 0)
+            return;
+
+        double a = dt / (gains.response_time + dt);
+        double f[STATES][STATES] = {
+            {1, dt, 0},
+            {0, 1 - a, a * pwm},
+            {0, 0, 1}};
+
+        state[POSITION] += dt * state[VELOCITY];
+        state[VELOCITY] += a * ((gains.pwm_rate + state[RATE_ERROR]) * pwm -
+                state[VELOCITY]);
+
+        //F P F^T
+        double fp[STATES][STATES] = {};
+        for (int i = 0; i < STATES; ++i)
+            for (int j = 0; j < STATES; ++j)
+                for (int k = 0; k < STATES; ++k)
+                    fp[i][j] += f[i][k] * covariance[k][j];
+        for (int i = 0; i < STATES; ++i)
+            for (int j = 0; j < STATES; ++j)
+            {
+                covariance[i][j] = 0;
+                for (int k = 0; k < STATES; ++k)
+                    covariance[i][j] += fp[i][k] * f[j][k];
+            }
+
+        double q = gains.acceleration_noise * gains.acceleration_noise;
+        covariance[POSITION][POSITION] += q * dt * dt * dt / 3;
+        covariance[POSITION][VELOCITY] += q * dt * dt / 2;
+        covariance[VELOCITY][POSITION] += q * dt * dt / 2;
+        covariance[VELOCITY][VELOCITY] += q * dt;
+        covariance[RATE_ERROR][RATE_ERROR] += gains.rate_drift * gains.rate_drift * dt;
+    }
+
+    void JointEstimator::correct(double measured, const EstimatorGains& gains)
+    {
+        double r = gains.position_noise * gains.position_noise;
+        if (!initialized)
+        {
+            //sure of the angle as one sample goes, not at all of the speed
+            for (int i = 0; i < STATES; ++i)
+            {
+                state[i] = 0;
+                for (int j = 0; j < STATES; ++j)
+                    covariance[i][j] = 0;
+            }
+            state[POSITION] = measured;
+            covariance[POSITION][POSITION] = r;
+            covariance[VELOCITY][VELOCITY] = gains.pwm_rate * gains.pwm_rate;
+            covariance[RATE_ERROR][RATE_ERROR] = gains.pwm_rate * gains.pwm_rate / 4;
+            initialized = true;
+            return;
+        }
+
+        //only the position is measured, H = [1 0 0]
+        double innovation = measured - state[POSITION];
+        double s = covariance[POSITION][POSITION] + r;
+        double gain[STATES];
+        for (int i = 0; i < STATES; ++i)
+            gain[i] = covariance[i][POSITION] / s;
+        for (int i = 0; i < STATES; ++i)
+            state[i] += gain[i] * innovation;
+
+        double measured_row[STATES];
+        for (int j = 0; j < STATES; ++j)
+            measured_row[j] = covariance[POSITION][j];
+        for (int i = 0; i < STATES; ++i)
+            for (int j = 0; j < STATES; ++j)
+                covariance[i][j] -= gain[i] * measured_row[j];
+    }
+
+    bool JointEstimator::ready() const
+    {
+        return initialized;
+    }
+
+    double JointEstimator::getPosition() const
+    {
+        return state[POSITION];
+    }
+
+    double JointEstimator::getVelocity() const
+    {
+        return state[VELOCITY];
+    }
+}
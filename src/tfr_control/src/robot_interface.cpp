@@ -3,6 +3,9 @@
  * the robot itself, and is started by the controller_launcher node.
  */
 #include "robot_interface.h"
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 
 using hardware_interface::JointStateHandle;
 using hardware_interface::JointHandle;
@@ -14,16 +17,28 @@ namespace tfr_control
      * with their relevant interfaces
      * */
     RobotInterface::RobotInterface(ros::NodeHandle &n, bool fakes, 
-            const double *lower_lim, const double *upper_lim) :
+            bool firmware_treads, const double *lower_lim, const double *upper_lim) :
         arduino_a{n.subscribe("/sensors/arduino_a", 5,
                 &RobotInterface::readArduinoA, this)},
         arduino_b{n.subscribe("/sensors/arduino_b", 5,
                 &RobotInterface::readArduinoB, this)},
+        imu{n.subscribe("/sensors/mti/sensor/imu", 5,
+                &RobotInterface::readImu, this)},
         pwm_publisher{n.advertise<tfr_msgs::PwmCommand>("/motor_output", 15)},
         use_fake_values{fakes}, lower_limits{lower_lim},
         upper_limits{upper_lim}, drivebase_v0{std::make_pair(0,0)},
         last_update{ros::Time::now()},
-        enabled{true}
+        enabled{true},
+        firmware_tread_control{firmware_treads},
+        turntable_offset{0.0},
+        actuator_constraints{ActuatorConstraints{0.01, 0.35, 0.8, 0.0,
+            EstimatorGains{0.3, 0.1, 0.005, 0.5, 0.05},
+            EstimatorGains{0.4, 0.1, 0.005, 0.5, 0.05},
+            EstimatorGains{0.6, 0.1, 0.005, 0.5, 0.05},
+            0.01, 0.2, 0.92,
+            0.005, 0.01, 0.6, 0.15,
+            false,
+            FeedforwardGains{0.8, 0.3, 0.3}}}
 
     {
         // Note: the string parameters in these constructors must match the
@@ -41,6 +56,7 @@ namespace tfr_control
         //register the interfaces with the controller layer
         registerInterface(&joint_state_interface);
         registerInterface(&joint_effort_interface);
+        registerInterface(&joint_velocity_interface);
         registerInterface(&joint_position_interface);
     }
 
@@ -54,16 +70,39 @@ namespace tfr_control
      * A couple of our logical joints are controlled by two actuators and read
      * by multiple potentiometers. For the purpose of populating information for
      * control I take the average of the two positions.
+     *
+     * The arm joints are estimated from the raw potentiometers and the output
+     * they were last sent, see JointEstimator. With delay compensation on the
+     * arm samples and the bin are moved past their measurement delay first,
+     * see DelayCompensator.
      * */
     void RobotInterface::read() 
     {
         //Grab the neccessary data
         tfr_msgs::ArduinoAReading reading_a;
         tfr_msgs::ArduinoBReading reading_b;
-        if (latest_arduino_a != nullptr)
-            reading_a = *latest_arduino_a;
-        if (latest_arduino_b != nullptr)
-            reading_b = *latest_arduino_b;
+        //the callbacks store these on the sensor thread
+        tfr_msgs::ArduinoAReadingConstPtr arduino_a_reading =
+            boost::atomic_load(&latest_arduino_a);
+        tfr_msgs::ArduinoBReadingConstPtr arduino_b_reading =
+            boost::atomic_load(&latest_arduino_b);
+        if (arduino_a_reading != nullptr)
+            reading_a = *arduino_a_reading;
+        if (arduino_b_reading != nullptr)
+            reading_b = *arduino_b_reading;
+
+        //ATTITUDE, for the tread feedforward
+        sensor_msgs::ImuConstPtr imu_reading = boost::atomic_load(&latest_imu);
+        if (imu_reading != nullptr && imu_reading->header.stamp != last_imu_stamp)
+        {
+            tf2::Quaternion orientation;
+            tf2::fromMsg(imu_reading->orientation, orientation);
+            double roll, pitch, yaw;
+            tf2::Matrix3x3(orientation).getRPY(roll, pitch, yaw);
+            tread_feedforward.updateAttitude(roll, pitch,
+                    imu_reading->header.stamp.toSec());
+            last_imu_stamp = imu_reading->header.stamp;
+        }
 
         //LEFT_TREAD
         position_values[static_cast<int>(Joint::LEFT_TREAD)] = 0;
@@ -75,6 +114,13 @@ namespace tfr_control
         velocity_values[static_cast<int>(Joint::RIGHT_TREAD)] = reading_b.tread_right_vel;
         effort_values[static_cast<int>(Joint::RIGHT_TREAD)] = 0;
 
+        //one sample per reading however the loops line up
+        const ActuatorConstraints& limits = actuator_constraints.get();
+        bool sampled = arduino_a_reading != nullptr &&
+            arduino_a_reading != last_estimated_a;
+        last_estimated_a = arduino_a_reading;
+        double now = ros::Time::now().toSec();
+
         if (!use_fake_values)
         {
             //TURNTABLE
@@ -84,27 +130,40 @@ namespace tfr_control
             effort_values[static_cast<int>(Joint::TURNTABLE)] = 0;
 
             //LOWER_ARM
-            position_values[static_cast<int>(Joint::LOWER_ARM)] = reading_a.arm_lower_pos;
-            velocity_values[static_cast<int>(Joint::LOWER_ARM)] = 0;
-            effort_values[static_cast<int>(Joint::LOWER_ARM)] = 0;
+            estimateArmJoint(Joint::LOWER_ARM, lower_arm_estimator,
+                    lower_arm_compensator, limits.lower_arm_estimator,
+                    reading_a.arm_lower_raw, sampled, now);
 
             //UPPER_ARM
-            position_values[static_cast<int>(Joint::UPPER_ARM)] = reading_a.arm_upper_pos;
-            velocity_values[static_cast<int>(Joint::UPPER_ARM)] = 0;
-            effort_values[static_cast<int>(Joint::UPPER_ARM)] = 0;
+            estimateArmJoint(Joint::UPPER_ARM, upper_arm_estimator,
+                    upper_arm_compensator, limits.upper_arm_estimator,
+                    reading_a.arm_upper_raw, sampled, now);
 
             //SCOOP
-            position_values[static_cast<int>(Joint::SCOOP)] = reading_a.arm_scoop_pos;
-            velocity_values[static_cast<int>(Joint::SCOOP)] = 0;
-            effort_values[static_cast<int>(Joint::SCOOP)] = 0;
+            estimateArmJoint(Joint::SCOOP, scoop_estimator,
+                    scoop_compensator, limits.scoop_estimator,
+                    reading_a.arm_scoop_raw, sampled, now);
         }
  
-        //BIN
+        //BIN, each actuator seen through its own delay
+        double bin_left = bin_left_compensator.compensate(reading_a.bin_left_pos,
+                sampled, applied_bin_pwm.first, limits.bin_pwm_rate, now);
+        double bin_right = bin_right_compensator.compensate(reading_a.bin_right_pos,
+                sampled, applied_bin_pwm.second, limits.bin_pwm_rate, now);
+        if (limits.delay_compensation)
+            bin_positions = std::make_pair(bin_left, bin_right);
+        else
+            bin_positions = std::make_pair(reading_a.bin_left_pos, reading_a.bin_right_pos);
         position_values[static_cast<int>(Joint::BIN)] = 
-            (reading_a.bin_left_pos + reading_a.bin_right_pos)/2;
+            (bin_positions.first + bin_positions.second)/2;
         velocity_values[static_cast<int>(Joint::BIN)] = 0;
         effort_values[static_cast<int>(Joint::BIN)] = 0;
 
+        TFR_DEBUG_LIMITED(5.0, "delays [s] lower arm %.3f upper arm %.3f scoop %.3f bin %.3f",
+                lower_arm_compensator.getDelay(), upper_arm_compensator.getDelay(),
+                scoop_compensator.getDelay(),
+                std::max(bin_left_compensator.getDelay(), bin_right_compensator.getDelay()));
+
     }
 
     /*
@@ -119,14 +178,8 @@ namespace tfr_control
      * */
     void RobotInterface::write() 
     {
-        //Grab the neccessary data
-        tfr_msgs::ArduinoAReading reading_a;
-        tfr_msgs::ArduinoBReading reading_b;
-
         //package for outgoing data
         tfr_msgs::PwmCommand command;
-        if (latest_arduino_a != nullptr)
-            reading_a = *latest_arduino_a;
 
         double signal;
         if (use_fake_values) //test code  for working with rviz simulator
@@ -147,41 +200,69 @@ namespace tfr_control
 
 
             //LOWER_ARM
+            signal = angleToPWM(command_values[static_cast<int>(Joint::LOWER_ARM)],
+                        position_values[static_cast<int>(Joint::LOWER_ARM)],
+                        velocity_values[static_cast<int>(Joint::LOWER_ARM)]);
+            applied_pwm[static_cast<int>(Joint::LOWER_ARM)] = enabled ? signal : 0;
             //NOTE we reverse these because actuator is mounted backwards
-            signal = -angleToPWM(command_values[static_cast<int>(Joint::LOWER_ARM)],
-                        position_values[static_cast<int>(Joint::LOWER_ARM)]);
-            command.arm_lower = signal;
+            command.arm_lower = -signal;
 
 
             //UPPER_ARM
             signal = angleToPWM(command_values[static_cast<int>(Joint::UPPER_ARM)],
-                        position_values[static_cast<int>(Joint::UPPER_ARM)]);
+                        position_values[static_cast<int>(Joint::UPPER_ARM)],
+                        velocity_values[static_cast<int>(Joint::UPPER_ARM)]);
+            applied_pwm[static_cast<int>(Joint::UPPER_ARM)] = enabled ? signal : 0;
             command.arm_upper = signal;
 
 
             //SCOOP
             signal = angleToPWM(command_values[static_cast<int>(Joint::SCOOP)],
-                        position_values[static_cast<int>(Joint::SCOOP)]);
+                        position_values[static_cast<int>(Joint::SCOOP)],
+                        velocity_values[static_cast<int>(Joint::SCOOP)]);
+            applied_pwm[static_cast<int>(Joint::SCOOP)] = enabled ? signal : 0;
             command.arm_scoop = signal;
 
          }
 
-        //LEFT_TREAD
-        signal = -drivebaseVelocityToPWM(command_values[static_cast<int>(Joint::LEFT_TREAD)], drivebase_v0.first);
-        command.tread_left = signal;
-
-        //RIGHT_TREAD
-        signal = drivebaseVelocityToPWM(command_values[static_cast<int>(Joint::RIGHT_TREAD)],
-                    drivebase_v0.second);
-        command.tread_right = signal;
+        if (firmware_tread_control)
+        {
+            //the loop is closed on arduino_b, just forward the setpoints in
+            //the robot frame, it handles the mirrored left side itself
+            command.tread_velocity_mode = true;
+            command.tread_left_vel = command_values[static_cast<int>(Joint::LEFT_TREAD)];
+            command.tread_right_vel = command_values[static_cast<int>(Joint::RIGHT_TREAD)];
+            //slopes, so the loop doesn't wait for the speed to drop
+            auto feedforward = tread_feedforward.compute(command.tread_left_vel,
+                    command.tread_right_vel, ros::Time::now().toSec(),
+                    actuator_constraints.get().tread_feedforward);
+            command.tread_left_ff = feedforward.first;
+            command.tread_right_ff = feedforward.second;
+        }
+        else
+        {
+            //LEFT_TREAD
+            signal = -drivebaseVelocityToPWM(command_values[static_cast<int>(Joint::LEFT_TREAD)], drivebase_v0.first);
+            command.tread_left = signal;
+
+            //RIGHT_TREAD
+            signal = drivebaseVelocityToPWM(command_values[static_cast<int>(Joint::RIGHT_TREAD)],
+                        drivebase_v0.second);
+            command.tread_right = signal;
+        }
 
 
         //BIN
         auto twin_signal = twinAngleToPWM(command_values[static_cast<int>(Joint::BIN)],
-                    reading_a.bin_left_pos,
-                    reading_a.bin_right_pos);
+                    bin_positions.first,
+                    bin_positions.second);
         command.bin_left = twin_signal.first;
         command.bin_right = twin_signal.second;
+        //positive output retracts
+        if (enabled)
+            applied_bin_pwm = std::make_pair(-twin_signal.first, -twin_signal.second);
+        else
+            applied_bin_pwm = std::make_pair(0.0, 0.0);
 
         command.enabled = enabled;
         pwm_publisher.publish(command);
@@ -197,6 +278,11 @@ namespace tfr_control
         enabled = val;
     }
 
+    void RobotInterface::setActuatorConstraints(const ActuatorConstraints& c)
+    {
+        actuator_constraints.set(c);
+    }
+
     void RobotInterface::adjustFakeJoint(const Joint &j)
     {
         int i = static_cast<int>(j);
@@ -260,6 +346,25 @@ namespace tfr_control
     }
 
 
+    void RobotInterface::estimateArmJoint(Joint joint, JointEstimator& estimator,
+            DelayCompensator& compensator, const EstimatorGains& gains, double raw,
+            bool sampled, double now)
+    {
+        auto idx = static_cast<int>(joint);
+        //the sample moved up to now, so the estimator isn't pulled back by it
+        double sample = compensator.compensate(raw, sampled, applied_pwm[idx],
+                gains.pwm_rate, now);
+        if (!actuator_constraints.get().delay_compensation)
+            sample = raw;
+        estimator.predict(applied_pwm[idx], now, gains);
+        if (sampled)
+            estimator.correct(sample, gains);
+        //nothing to go on until the first reading
+        position_values[idx] = estimator.ready() ? estimator.getPosition() : 0;
+        velocity_values[idx] = estimator.getVelocity();
+        effort_values[idx] = 0;
+    }
+
     /*
      * Register this joint with each neccessary hardware interface
      * */
@@ -271,9 +376,11 @@ namespace tfr_control
             &velocity_values[idx], &effort_values[idx]);
         joint_state_interface.registerHandle(state_handle);
 
-        //allow the joint to be commanded
+        //allow the joint to be commanded, either through a pid on the host
+        //(effort) or as a setpoint for the firmware loop (velocity)
         JointHandle handle(state_handle, &command_values[idx]);
         joint_effort_interface.registerHandle(handle);
+        joint_velocity_interface.registerHandle(handle);
     }
 
     /*
@@ -310,21 +417,20 @@ namespace tfr_control
     }
 
     /*
-     * Input is angle desired/measured and output is in raw pwm frequency.
+     * Input is angle desired/measured and the joint speed, output is in raw
+     * pwm frequency.
      * */
-    double RobotInterface::angleToPWM(const double &desired, const double &actual)
+    double RobotInterface::angleToPWM(const double &desired, const double &actual,
+            const double &velocity)
     {
-        //we don't anticipate this changing very much keep at method level
-        double min_delta = 0.01;
-        double max_delta = 0.35;
+        const ActuatorConstraints& limits = actuator_constraints.get();
 
         double difference = desired - actual;
-        if (std::abs(difference) > min_delta)
+        if (std::abs(difference) > limits.arm_min_delta)
         {
-
-            int sign = (difference < 0) ? -1 : 1;
-            double magnitude = std::min(std::abs(difference)/max_delta, 0.8);           
-            return sign*magnitude;
+            //ease off by how fast the joint is already closing in
+            double output = (difference - limits.arm_damping*velocity)/limits.arm_max_delta;
+            return std::max(-limits.arm_max_pwm, std::min(output, limits.arm_max_pwm));
         }
         return 0;
     }
@@ -337,12 +443,11 @@ namespace tfr_control
     std::pair<double,double> RobotInterface::twinAngleToPWM(const double &desired, 
             const double &actual_left, const double &actual_right)
     {
-        //we don't anticipate these changing very much keep at method level
-        double  total_angle_tolerance = 0.005,
-                individual_angle_tolerance = 0.01,
-                scaling_factor = .6, 
+        const ActuatorConstraints& limits = actuator_constraints.get();
+        double  individual_angle_tolerance = limits.bin_individual_tolerance,
+                scaling_factor = limits.bin_scaling,
                 difference = desired - (actual_left + actual_right)/2;
-        if (std::abs(difference) > total_angle_tolerance)
+        if (std::abs(difference) > limits.bin_total_tolerance)
         {
             int direction = (difference < 0) ? 1 : -1;
             double delta = actual_left - actual_right;
@@ -376,14 +481,13 @@ namespace tfr_control
      * */
     double RobotInterface::turntableAngleToPWM(const double &desired, const double &actual)
     {
-        //we don't anticipate this changing very much keep at method level
-        double min_delta = 0.01;
-        double max_delta = 0.2;
+        const ActuatorConstraints& limits = actuator_constraints.get();
         double difference = desired - actual;
-        if (std::abs(difference) > min_delta)
+        if (std::abs(difference) > limits.turntable_min_delta)
         {
             int sign = (difference < 0) ? 1 : -1;
-            double magnitude = std::min(std::abs(difference)/max_delta, 0.92);           
+            double magnitude = std::min(std::abs(difference)/limits.turntable_max_delta,
+                    limits.turntable_max_pwm);
             return sign*magnitude;
         }
         return 0;
@@ -421,12 +525,20 @@ namespace tfr_control
         return pwm_0 + sign * magnitude;
     }
 
+    /*
+     * Callback for the imu, the attitude is taken in read()
+     * */
+    void RobotInterface::readImu(const sensor_msgs::ImuConstPtr &msg)
+    {
+        boost::atomic_store(&latest_imu, msg);
+    }
+
     /*
      * Callback for our encoder subscriber
      * */
     void RobotInterface::readArduinoA(const tfr_msgs::ArduinoAReadingConstPtr &msg)
     {
-        latest_arduino_a = msg;
+        boost::atomic_store(&latest_arduino_a, msg);
     }
 
     /*
@@ -434,19 +546,18 @@ namespace tfr_control
      * */
     void RobotInterface::readArduinoB(const tfr_msgs::ArduinoBReadingConstPtr &msg)
     {
-        latest_arduino_b = msg;
+        boost::atomic_store(&latest_arduino_b, msg);
     }
 
     void RobotInterface::zeroTurntable()
     {
         //Grab the neccessary data
-        tfr_msgs::ArduinoAReading reading_a;
-        if (latest_arduino_a != nullptr)
-            reading_a = *latest_arduino_a;
-        else 
+        tfr_msgs::ArduinoAReadingConstPtr reading_a =
+            boost::atomic_load(&latest_arduino_a);
+        if (reading_a == nullptr)
             return;
 
-        turntable_offset = -reading_a.arm_turntable_pos; 
+        turntable_offset = -reading_a->arm_turntable_pos;
     }
 
 }
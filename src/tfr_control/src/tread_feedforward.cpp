@@ -0,0 +1,66 @@
+/**
+ * tread_feedforward.cpp
+ *
+ * See tfr_control/include/tfr_control/tread_feedforward.h for details.
+ */
+#include "tread_feedforward.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tfr_control
+{
+    constexpr double TreadFeedforward::FILTER_TIME;
+    constexpr double TreadFeedforward::TIMEOUT;
+    constexpr double TreadFeedforward::DEADBAND;
+
+    TreadFeedforward::TreadFeedforward() :
+        roll{0}, pitch{0}, last_time{0}, has_attitude{false}
+    {
+    }
+
+    void TreadFeedforward::updateAttitude(double r, double p, double time)
+    {
+        double dt = time - last_time;
+        if (!has_attitude || dt > TIMEOUT || dt < 0)
+        {
+            //nothing recent to filter against, start over from this sample
+            roll = r;
+            pitch = p;
+        }
+        else
+        {
+            double alpha = dt / (FILTER_TIME + dt);
+            roll += alpha * (r - roll);
+            pitch += alpha * (p - pitch);
+        }
+        last_time = time;
+        has_attitude = true;
+    }
+
+    std::pair<double, double> TreadFeedforward::compute(double left_setpoint,
+            double right_setpoint, double time, const FeedforwardGains& gains) const
+    {
+        bool left_moving = std::abs(left_setpoint) > DEADBAND;
+        bool right_moving = std::abs(right_setpoint) > DEADBAND;
+        if (!has_attitude || time - last_time > TIMEOUT ||
+                (!left_moving && !right_moving))
+            return std::make_pair(0.0, 0.0);
+
+        //nose down helps us along, nose up holds us back
+        double grade = -gains.grade * std::sin(pitch);
+        //right side down, push the right tread harder
+        double cross = gains.cross * std::sin(roll);
+
+        double left = grade, right = grade;
+        if (left_moving)
+            left -= std::copysign(cross, left_setpoint);
+        if (right_moving)
+            right += std::copysign(cross, right_setpoint);
+
+        auto clamp = [&gains](double value)
+        {
+            return std::max(-gains.max, std::min(gains.max, value));
+        };
+        return std::make_pair(clamp(left), clamp(right));
+    }
+}
@@ -0,0 +1,121 @@
+/**
+ * benchmark_arduino_b.cpp
+ *
+ * Runs the arduino_b sketch on the simulated board and reports how well it
+ * keeps the tread loop on its 2ms period, in simulated time, along with what
+ * a pass of loop() costs on this machine. Run it before and after a firmware
+ * change, see arduino/README.md for what the simulated costs do and don't
+ * cover.
+ *
+ * usage: arduino_b_benchmark [seconds of simulated time, default 10]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "sketch.h"
+
+namespace arduino_b
+{
+#include "arduino_b/arduino_b.ino"
+}
+
+namespace
+{
+    //how often the host sends a command [us]
+    const unsigned long COMMAND_PERIOD = 20000;
+
+    struct Result
+    {
+        unsigned long passes = 0;
+        unsigned long control_runs = 0;
+        unsigned long longest_pass = 0;
+        unsigned long longest_period = 0;
+        unsigned long late_periods = 0;
+        double host_ns = 0;
+    };
+
+    /*
+     * Runs the sketch for duration with the host sending command every
+     * COMMAND_PERIOD, the treads are left stalled since only timing matters
+     * */
+    Result measure(const tfr_msgs::PwmCommand& command, unsigned long duration)
+    {
+        sim::reset();
+        arduino_b::setup();
+        arduino_b::estop_subscriber.receive(tfr_msgs::EStop{});
+        arduino_b::motor_subscriber.receive(tfr_msgs::PwmCommand{});
+        sim::run(10000, arduino_b::loop);
+
+        Result result{};
+        unsigned long last_command = sim::now() - COMMAND_PERIOD;
+        unsigned long last_control = arduino_b::last_control;
+        std::chrono::nanoseconds host_time{0};
+        unsigned long start = sim::now();
+        while (sim::now() - start < duration)
+        {
+            if (sim::now() - last_command >= COMMAND_PERIOD)
+            {
+                last_command = sim::now();
+                arduino_b::motor_subscriber.receive(command);
+            }
+
+            unsigned long before = sim::now();
+            auto host_before = std::chrono::steady_clock::now();
+            arduino_b::loop();
+            host_time += std::chrono::steady_clock::now() - host_before;
+            sim::advance(sim::LOOP_TIME);
+
+            ++result.passes;
+            result.longest_pass = std::max(result.longest_pass, sim::now() - before);
+            if (arduino_b::last_control != last_control)
+            {
+                unsigned long period = arduino_b::last_control - last_control;
+                last_control = arduino_b::last_control;
+                ++result.control_runs;
+                result.longest_period = std::max(result.longest_period, period);
+                //a tenth of a period late is enough to show in the derivative
+                if (period > arduino_b::CONTROL_PERIOD * 11 / 10)
+                    ++result.late_periods;
+            }
+        }
+        result.host_ns = static_cast<double>(host_time.count()) / result.passes;
+        return result;
+    }
+
+    void report(const char* name, const Result& result, unsigned long duration)
+    {
+        double seconds = duration * 1e-6;
+        std::printf("%-22s %8.1f %10lu %10lu %8lu %10.0f\n", name,
+                result.control_runs / seconds, result.longest_period,
+                result.longest_pass, result.late_periods, result.host_ns);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 10.0;
+    unsigned long duration = static_cast<unsigned long>(seconds * 1e6);
+
+    tfr_msgs::PwmCommand open_loop{};
+    open_loop.enabled = true;
+    open_loop.tread_left = 0.5;
+    open_loop.tread_right = 0.5;
+    open_loop.arm_lower = 0.2;
+
+    tfr_msgs::PwmCommand velocity = open_loop;
+    velocity.tread_velocity_mode = true;
+    velocity.tread_left_vel = 0.3;
+    velocity.tread_right_vel = 0.3;
+
+    tfr_msgs::PwmCommand disabled{};
+
+    std::printf("%.1f s simulated, i2c at the sketch's clock, commands every %lu us\n",
+            seconds, COMMAND_PERIOD);
+    std::printf("%-22s %8s %10s %10s %8s %10s\n", "scenario", "loop hz",
+            "max period", "max pass", "late", "host ns");
+    report("disabled", measure(disabled, duration), duration);
+    report("open loop", measure(open_loop, duration), duration);
+    report("velocity mode", measure(velocity, duration), duration);
+    return 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * benchmark_collision.cpp
+ *
+ * Reports what a self collision check of the arm costs with the model and
+ * srdf that are loaded, and optionally how long move_group takes to plan
+ * between random valid states. Run it through launch/collision_benchmark.launch
+ * with simple_collision on and off to compare, see tfr_moveit/README.md.
+ *
+ * params:
+ *   ~group   planning group to sample, default arm_end
+ *   ~states  random states to check, default 10000
+ *   ~plans   plans to time, needs move_group running, default 0
+ */
+#include <ros/ros.h>
+#include <moveit/robot_model_loader/robot_model_loader.h>
+#include <moveit/planning_scene/planning_scene.h>
+#include <moveit/move_group_interface/move_group_interface.h>
+#include <random_numbers/random_numbers.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /*
+     * How many link pairs the scene checks per state, the ones with geometry
+     * that the srdf doesn't always allow
+     * */
+    int checkedPairs(const planning_scene::PlanningScene& scene)
+    {
+        const auto& links = scene.getRobotModel()->getLinkModelsWithCollisionGeometry();
+        const auto& matrix = scene.getAllowedCollisionMatrix();
+        int pairs = 0;
+        for (size_t i = 0; i < links.size(); ++i)
+            for (size_t j = i + 1; j < links.size(); ++j)
+            {
+                collision_detection::AllowedCollision::Type type;
+                if (!matrix.getEntry(links[i]->getName(), links[j]->getName(), type) ||
+                        type != collision_detection::AllowedCollision::ALWAYS)
+                    ++pairs;
+            }
+        return pairs;
+    }
+
+    //a random state of group that isn't in collision
+    robot_state::RobotState validState(const planning_scene::PlanningScene& scene,
+            const robot_state::JointModelGroup* group,
+            random_numbers::RandomNumberGenerator& generator)
+    {
+        robot_state::RobotState state = scene.getCurrentState();
+        do
+        {
+            state.setToRandomPositions(group, generator);
+            state.update();
+        } while (scene.isStateColliding(state, group->getName()));
+        return state;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "collision_benchmark");
+    ros::NodeHandle p_n{"~"};
+    std::string group_name;
+    int state_count, plan_count;
+    p_n.param<std::string>("group", group_name, "arm_end");
+    p_n.param("states", state_count, 10000);
+    p_n.param("plans", plan_count, 0);
+
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    robot_model_loader::RobotModelLoader loader{"robot_description"};
+    planning_scene::PlanningScene scene{loader.getModel()};
+    const robot_state::JointModelGroup* group =
+        scene.getRobotModel()->getJointModelGroup(group_name);
+    if (group == nullptr)
+    {
+        ROS_ERROR("collision_benchmark: no group %s", group_name.c_str());
+        return 1;
+    }
+
+    //drawn up front so only the checks are timed
+    random_numbers::RandomNumberGenerator generator{0};
+    std::vector<robot_state::RobotState> states(state_count, scene.getCurrentState());
+    for (auto& state : states)
+    {
+        state.setToRandomPositions(group, generator);
+        state.update();
+    }
+
+    collision_detection::CollisionRequest request{};
+    int colliding = 0;
+    auto before = std::chrono::steady_clock::now();
+    for (const auto& state : states)
+    {
+        collision_detection::CollisionResult result{};
+        scene.checkSelfCollision(request, result, state);
+        colliding += result.collision;
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - before;
+
+    ROS_INFO("collision_benchmark: %zu links with geometry, %d pairs checked",
+            scene.getRobotModel()->getLinkModelsWithCollisionGeometry().size(),
+            checkedPairs(scene));
+    ROS_INFO("collision_benchmark: %d states, %d colliding, %.1f us a check",
+            state_count, colliding, elapsed.count() / std::max(state_count, 1));
+
+    if (plan_count <= 0)
+        return 0;
+
+    moveit::planning_interface::MoveGroupInterface move_group{group_name};
+    std::vector<double> times{};
+    for (int i = 0; i < plan_count && ros::ok(); ++i)
+    {
+        move_group.setStartState(validState(scene, group, generator));
+        move_group.setJointValueTarget(validState(scene, group, generator));
+        moveit::planning_interface::MoveGroupInterface::Plan plan;
+        if (move_group.plan(plan) == moveit::planning_interface::MoveItErrorCode::SUCCESS)
+            times.push_back(plan.planning_time_);
+    }
+    if (times.empty())
+    {
+        ROS_WARN("collision_benchmark: no plans succeeded");
+        return 0;
+    }
+    std::sort(times.begin(), times.end());
+    double total = 0;
+    for (double time : times)
+        total += time;
+    ROS_INFO("collision_benchmark: %zu of %d plans, mean %.3f s, median %.3f s, worst %.3f s",
+            times.size(), plan_count, total / times.size(), times[times.size() / 2],
+            times.back());
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "sketch.h"
+
+namespace arduino_a
+{
+#include "arduino_a/arduino_a.ino"
+}
+
+namespace
+{
+    const uint8_t ADS1115_A = 0x48;
+    const uint8_t ADS1115_B = 0x49;
+
+    class ArduinoA : public ::testing::Test
+    {
+        protected:
+            void SetUp() override
+            {
+                sim::reset();
+                for (auto& pot : arduino_a::pots)
+                    pot.estimate = 0;
+                arduino_a::setup();
+            }
+
+            static void setAllAdcs(int16_t value)
+            {
+                for (uint8_t channel = 0; channel < 4; ++channel)
+                {
+                    sim::setAdc(ADS1115_A, channel, value);
+                    sim::setAdc(ADS1115_B, channel, value);
+                }
+            }
+
+            static float expected(arduino_a::Potentiometers pot, int16_t value)
+            {
+                const auto& p = arduino_a::pots[pot];
+                return 0.0174533 * (p.m * value + p.b);
+            }
+    };
+}
+
+TEST_F(ArduinoA, PotentiometersSmoothTowardsTheReading)
+{
+    setAllAdcs(12000);
+    arduino_a::loop();
+    //a quarter of the way there on the first reading
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_upper_pos,
+            expected(arduino_a::ARM_UPPER, 12000) / 4, 1e-4);
+
+    for (int i = 0; i < 40; ++i)
+        arduino_a::loop();
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_upper_pos,
+            expected(arduino_a::ARM_UPPER, 12000), 1e-3);
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_lower_pos,
+            expected(arduino_a::ARM_LOWER, 12000), 1e-3);
+    ASSERT_NEAR(arduino_a::arduinoReading.bin_left_pos,
+            expected(arduino_a::BIN_LEFT, 12000), 1e-3);
+}
+
+TEST_F(ArduinoA, RawArmReadingsAreNotSmoothed)
+{
+    setAllAdcs(12000);
+    arduino_a::loop();
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_lower_raw,
+            expected(arduino_a::ARM_LOWER, 12000), 1e-4);
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_upper_raw,
+            expected(arduino_a::ARM_UPPER, 12000), 1e-4);
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_scoop_raw,
+            expected(arduino_a::ARM_SCOOP, 12000), 1e-4);
+}
+
+TEST_F(ArduinoA, ConversionsFinishBeforeTheyAreRead)
+{
+    setAllAdcs(12000);
+    for (int i = 0; i < 40; ++i)
+        arduino_a::loop();
+    //a stale conversion would still be reading the first value
+    setAllAdcs(16000);
+    for (int i = 0; i < 40; ++i)
+        arduino_a::loop();
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_scoop_pos,
+            expected(arduino_a::ARM_SCOOP, 16000), 1e-3);
+    ASSERT_NEAR(arduino_a::arduinoReading.bin_right_pos,
+            expected(arduino_a::BIN_RIGHT, 16000), 1e-3);
+}
+
+TEST_F(ArduinoA, PublishesEveryLoop)
+{
+    unsigned long published = arduino_a::arduino.published;
+    unsigned long start = sim::now();
+    sim::run(1000000, arduino_a::loop);
+    unsigned long loops = arduino_a::arduino.published - published;
+    //three 8ms conversions a loop
+    ASSERT_GE(loops, 35u);
+    ASSERT_LE(loops, 1000000 / 24000);
+    ASSERT_GE(sim::now() - start, 1000000u);
+}
+
+TEST_F(ArduinoA, TreadVelocity)
+{
+    arduino_a::loop();
+    //two revolutions a second at the gearbox
+    int32_t count = 0;
+    for (int i = 0; i < 20; ++i)
+    {
+        unsigned long before = sim::now();
+        arduino_a::loop();
+        count += std::lround(2 * arduino_a::GEARBOX_CPR * (sim::now() - before) * 1e-6);
+        sim::setEncoder(arduino_a::GEARBOX_LEFT_A, count);
+    }
+    arduino_a::loop();
+    ASSERT_NEAR(arduino_a::arduinoReading.tread_left_vel, 2 * arduino_a::GEARBOX_MPR, 0.05);
+}
+
+TEST_F(ArduinoA, TurntableKeepsItsResolution)
+{
+    //less than a revolution of the motor
+    sim::setEncoder(arduino_a::TURNTABLE_A, 14);
+    arduino_a::loop();
+    ASSERT_NEAR(arduino_a::arduinoReading.arm_turntable_pos,
+            0.5 * arduino_a::TURNTABLE_RPR, 1e-6);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
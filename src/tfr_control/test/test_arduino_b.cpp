@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include "sketch.h"
+
+namespace arduino_b
+{
+#include "arduino_b/arduino_b.ino"
+}
+
+namespace
+{
+    //full output moves the treads at about 1/TREAD_KF
+    const double MAX_TREAD_SPEED = 0.5;
+
+    /*
+     * Turns the gearbox shafts by what the tread outputs ask for, both
+     * motors are mounted so the pwm is in the robot frame
+     * */
+    class TreadPlant
+    {
+        public:
+            void step()
+            {
+                unsigned long now = sim::now();
+                double dt = (now - last) * 1e-6;
+                last = now;
+                left += speed(arduino_b::Address::TREAD_LEFT) * dt;
+                right += speed(arduino_b::Address::TREAD_RIGHT) * dt;
+                sim::setEncoder(arduino_b::GEARBOX_LEFT_A, -left);
+                sim::setEncoder(arduino_b::GEARBOX_RIGHT_A, right);
+            }
+
+        private:
+            double left = 0;
+            double right = 0;
+            unsigned long last = 0;
+
+            //counts per second at the output
+            double speed(arduino_b::Address address)
+            {
+                double output = (sim::getPwm(static_cast<uint8_t>(address)) -
+                        arduino_b::NEUTRAL) / 170.0;
+                if (address == arduino_b::Address::TREAD_LEFT)
+                    output = -output;
+                return output * MAX_TREAD_SPEED / arduino_b::METERS_PER_COUNT;
+            }
+    };
+
+    class ArduinoB : public ::testing::Test
+    {
+        protected:
+            void SetUp() override
+            {
+                sim::reset();
+                arduino_b::setup();
+                //clears anything a previous test left latched
+                receive(estop(false));
+                receive(tfr_msgs::PwmCommand{});
+                sim::run(1000, arduino_b::loop);
+            }
+
+            void receive(const tfr_msgs::PwmCommand& command)
+            {
+                arduino_b::motor_subscriber.receive(command);
+            }
+
+            void receive(const tfr_msgs::EStop& command)
+            {
+                arduino_b::estop_subscriber.receive(command);
+            }
+
+            static tfr_msgs::EStop estop(bool stop)
+            {
+                tfr_msgs::EStop command{};
+                command.stop = stop;
+                return command;
+            }
+
+            static tfr_msgs::PwmCommand velocity(float left, float right)
+            {
+                tfr_msgs::PwmCommand command{};
+                command.enabled = true;
+                command.tread_velocity_mode = true;
+                command.tread_left_vel = left;
+                command.tread_right_vel = right;
+                return command;
+            }
+
+            /*
+             * Keeps commanding the treads like the host at 50hz
+             * */
+            void drive(const tfr_msgs::PwmCommand& command, unsigned long duration)
+            {
+                TreadPlant& treads = plant;
+                unsigned long last_command = sim::now();
+                receive(command);
+                sim::run(duration, [&]()
+                {
+                    if (sim::now() - last_command >= 20000)
+                    {
+                        last_command = sim::now();
+                        receive(command);
+                    }
+                    arduino_b::loop();
+                    treads.step();
+                });
+            }
+
+            static uint16_t pwm(arduino_b::Address address)
+            {
+                return sim::getPwm(static_cast<uint8_t>(address));
+            }
+
+            TreadPlant plant{};
+    };
+}
+
+TEST_F(ArduinoB, SetupCentersEveryOutput)
+{
+    for (uint8_t channel = 0; channel < 8; ++channel)
+        ASSERT_EQ(sim::getPwm(channel), arduino_b::NEUTRAL);
+    ASSERT_EQ(sim::getPin(arduino_b::OUTPUT_ENABLE), HIGH);
+}
+
+TEST_F(ArduinoB, OpenLoopIsSlewLimited)
+{
+    tfr_msgs::PwmCommand command{};
+    command.enabled = true;
+    command.tread_left = 1.0;
+    command.arm_lower = -1.0;
+    receive(command);
+    sim::run(1000, arduino_b::loop);
+
+    ASSERT_EQ(sim::getPin(arduino_b::OUTPUT_ENABLE), LOW);
+    ASSERT_EQ(pwm(arduino_b::Address::TREAD_LEFT),
+            arduino_b::NEUTRAL + arduino_b::MAX_DRIVEBASE_DELTA);
+    ASSERT_EQ(pwm(arduino_b::Address::ARM_LOWER),
+            arduino_b::NEUTRAL - arduino_b::MAX_ARM_DELTA);
+
+    for (int i = 0; i < 50; ++i)
+    {
+        receive(command);
+        sim::run(1000, arduino_b::loop);
+    }
+    ASSERT_EQ(pwm(arduino_b::Address::TREAD_LEFT), arduino_b::NEUTRAL + 170);
+    ASSERT_EQ(pwm(arduino_b::Address::ARM_LOWER), arduino_b::NEUTRAL - 170);
+}
+
+TEST_F(ArduinoB, OutOfRangeIsIgnored)
+{
+    tfr_msgs::PwmCommand command{};
+    command.enabled = true;
+    command.tread_right = 1.5;
+    receive(command);
+    sim::run(1000, arduino_b::loop);
+    ASSERT_EQ(pwm(arduino_b::Address::TREAD_RIGHT), arduino_b::NEUTRAL);
+}
+
+TEST_F(ArduinoB, EStopLatchesUntilReleased)
+{
+    tfr_msgs::PwmCommand command{};
+    command.enabled = true;
+    command.arm_upper = 1.0;
+    receive(command);
+    sim::run(1000, arduino_b::loop);
+    ASSERT_NE(pwm(arduino_b::Address::ARM_UPPER), arduino_b::NEUTRAL);
+
+    unsigned long acks = arduino_b::estop_ack.published;
+    tfr_msgs::EStop stop = estop(true);
+    stop.sequence = 42;
+    receive(stop);
+    receive(command);
+    sim::run(1000, arduino_b::loop);
+    ASSERT_EQ(sim::getPin(arduino_b::OUTPUT_ENABLE), HIGH);
+    ASSERT_EQ(pwm(arduino_b::Address::ARM_UPPER), arduino_b::NEUTRAL);
+    ASSERT_EQ(arduino_b::estop_ack.published, acks + 1);
+    ASSERT_EQ(arduino_b::estop_reading.sequence, 42u);
+    ASSERT_TRUE(arduino_b::estop_reading.stop);
+
+    receive(estop(false));
+    receive(command);
+    sim::run(1000, arduino_b::loop);
+    ASSERT_EQ(sim::getPin(arduino_b::OUTPUT_ENABLE), LOW);
+    ASSERT_NE(pwm(arduino_b::Address::ARM_UPPER), arduino_b::NEUTRAL);
+}
+
+TEST_F(ArduinoB, VelocityLoopReachesSetpoint)
+{
+    drive(velocity(0.3, -0.2), 3000000);
+    ASSERT_NEAR(arduino_b::left_tread.getVelocity(), 0.3, 0.02);
+    ASSERT_NEAR(arduino_b::right_tread.getVelocity(), -0.2, 0.02);
+    ASSERT_NEAR(arduino_b::arduino_reading.tread_right_vel, -0.2, 0.02);
+}
+
+TEST_F(ArduinoB, VelocityLoopHoldsItsRate)
+{
+    drive(velocity(0.2, 0.2), 100000);
+    unsigned long runs = 0;
+    unsigned long last_control = arduino_b::last_control;
+    unsigned long longest = 0;
+    TreadPlant& treads = plant;
+    sim::run(1000000, [&]()
+    {
+        arduino_b::loop();
+        treads.step();
+        if (arduino_b::last_control != last_control)
+        {
+            longest = std::max(longest, arduino_b::last_control - last_control);
+            last_control = arduino_b::last_control;
+            ++runs;
+        }
+    });
+    ASSERT_GE(runs, 490u);
+    ASSERT_LT(longest, arduino_b::CONTROL_PERIOD + 500);
+}
+
+TEST_F(ArduinoB, WatchdogStopsTheTreads)
+{
+    drive(velocity(0.3, 0.3), 2000000);
+    ASSERT_GT(arduino_b::right_tread.getVelocity(), 0.25);
+
+    //the host goes quiet
+    TreadPlant& treads = plant;
+    sim::run(1500000, [&]()
+    {
+        arduino_b::loop();
+        treads.step();
+    });
+    ASSERT_NEAR(arduino_b::left_tread.getVelocity(), 0.0, 0.02);
+    ASSERT_NEAR(arduino_b::right_tread.getVelocity(), 0.0, 0.02);
+}
+
+TEST_F(ArduinoB, FeedforwardAddsToTheOutput)
+{
+    //stalled treads, so only the commanded outputs differ
+    receive(velocity(0.0, 0.0));
+    sim::run(100000, arduino_b::loop);
+    uint16_t neutral = pwm(arduino_b::Address::TREAD_RIGHT);
+
+    tfr_msgs::PwmCommand command = velocity(0.0, 0.0);
+    command.tread_right_ff = 0.1;
+    receive(command);
+    sim::run(100000, arduino_b::loop);
+    ASSERT_EQ(pwm(arduino_b::Address::TREAD_RIGHT), neutral + 17);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <random>
+#include "delay_compensator.h"
+
+using tfr_control::DelayCompensator;
+
+namespace
+{
+    const double LOOP = 1 / 30.0;
+    const double RATE = 0.4;
+
+    /*
+     * Drives a joint back and forth for ten seconds, seen through a delay of
+     * lag cycles, returns the worst error of the prediction and of the
+     * measurement once the fit has settled
+     * */
+    std::pair<double, double> drive(DelayCompensator& compensator, int lag,
+            double noise_spread)
+    {
+        std::mt19937 generator{3};
+        std::normal_distribution<double> noise{0, noise_spread};
+        double actual = 0, output = 0;
+        std::deque<double> in_transit(lag, 0.0);
+        double worst_predicted = 0, worst_measured = 0;
+        for (int i = 0; i < 300; ++i)
+        {
+            actual += RATE * output * LOOP;
+            in_transit.push_back(actual + noise(generator));
+            double measured = in_transit.front();
+            in_transit.pop_front();
+
+            double predicted = compensator.compensate(measured, true, output,
+                    RATE, i * LOOP);
+            if (i > 150)
+            {
+                worst_predicted = std::max(worst_predicted, std::abs(predicted - actual));
+                worst_measured = std::max(worst_measured, std::abs(measured - actual));
+            }
+            //a second each way with a pause between
+            int phase = (i / 15) % 4;
+            output = (phase == 0) ? 1.0 : (phase == 2) ? -0.5 : 0.0;
+        }
+        return std::make_pair(worst_predicted, worst_measured);
+    }
+}
+
+TEST(DelayCompensator, PassesTheFirstMeasurementThrough)
+{
+    DelayCompensator compensator{};
+    ASSERT_DOUBLE_EQ(compensator.compensate(0.3, true, 1.0, RATE, 0.0), 0.3);
+    ASSERT_DOUBLE_EQ(compensator.getDelay(), 0.0);
+}
+
+TEST(DelayCompensator, NothingLearnedWhileStill)
+{
+    DelayCompensator compensator{};
+    for (int i = 0; i < 100; ++i)
+        ASSERT_DOUBLE_EQ(compensator.compensate(0.3, true, 0.0, RATE, i * LOOP), 0.3);
+    ASSERT_DOUBLE_EQ(compensator.getDelay(), 0.0);
+}
+
+TEST(DelayCompensator, FindsTheDelay)
+{
+    for (int lag : {0, 2, 4})
+    {
+        DelayCompensator compensator{};
+        auto worst = drive(compensator, lag, 0.0);
+        ASSERT_NEAR(compensator.getDelay(), lag * LOOP, 1e-9) << "lag " << lag;
+        ASSERT_LT(worst.first, 1e-9) << "lag " << lag;
+    }
+}
+
+TEST(DelayCompensator, FindsTheDelayThroughNoise)
+{
+    DelayCompensator compensator{};
+    auto worst = drive(compensator, 3, 0.002);
+    ASSERT_NEAR(compensator.getDelay(), 3 * LOOP, 1e-9);
+    ASSERT_LT(worst.first, worst.second / 2);
+}
+
+TEST(DelayCompensator, CoversTheCyclesSinceTheLastSample)
+{
+    DelayCompensator compensator{};
+    compensator.compensate(0.0, true, 0.0, RATE, 0.0);
+    //no new sample, the output since still counts
+    double predicted = compensator.compensate(0.0, false, 1.0, RATE, LOOP);
+    ASSERT_NEAR(predicted, RATE * LOOP, 1e-12);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
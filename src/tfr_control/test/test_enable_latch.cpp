@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+#include "enable_latch.h"
+
+using tfr_control::EnableLatch;
+
+TEST(EnableLatch, StartsDisabled)
+{
+    EnableLatch latch{};
+    ASSERT_FALSE(latch.isEnabled());
+    ASSERT_FALSE(latch.isLatched());
+    ASSERT_TRUE(latch.set(true));
+    ASSERT_TRUE(latch.isEnabled());
+    ASSERT_TRUE(latch.set(false));
+    ASSERT_FALSE(latch.isEnabled());
+}
+
+TEST(EnableLatch, StopDisables)
+{
+    EnableLatch latch{};
+    latch.set(true);
+    latch.stop();
+    ASSERT_FALSE(latch.isEnabled());
+    ASSERT_TRUE(latch.isLatched());
+}
+
+TEST(EnableLatch, QueuedEnableCantUndoAStop)
+{
+    EnableLatch latch{};
+    //the operator releases and asks to enable, the request waits in the
+    //service queue while a stop comes in on the e-stop channel
+    latch.release();
+    latch.stop();
+    //then the enable runs
+    ASSERT_FALSE(latch.set(true));
+    ASSERT_FALSE(latch.isEnabled());
+    //again and again, until someone releases the stop
+    ASSERT_FALSE(latch.set(true));
+    latch.release();
+    ASSERT_TRUE(latch.set(true));
+    ASSERT_TRUE(latch.isEnabled());
+}
+
+TEST(EnableLatch, DisablingAlwaysWorks)
+{
+    EnableLatch latch{};
+    latch.stop();
+    ASSERT_TRUE(latch.set(false));
+    ASSERT_FALSE(latch.isEnabled());
+    //and doesn't count as a release
+    ASSERT_TRUE(latch.isLatched());
+    ASSERT_FALSE(latch.set(true));
+}
+
+TEST(EnableLatch, EveryStopNeedsARelease)
+{
+    EnableLatch latch{};
+    latch.stop();
+    latch.release();
+    ASSERT_TRUE(latch.set(true));
+    latch.stop();
+    ASSERT_FALSE(latch.set(true));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
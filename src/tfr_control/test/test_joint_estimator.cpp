@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include "joint_estimator.h"
+
+using tfr_control::EstimatorGains;
+using tfr_control::JointEstimator;
+
+namespace
+{
+    const EstimatorGains GAINS{0.4, 0.1, 0.005, 0.5, 0.05};
+    //the control loop and arduino_a rates
+    const double LOOP = 1 / 30.0;
+
+    /*
+     * Drives a joint that really moves at actual_rate per pwm for three
+     * seconds, returns the worst position error of the estimate and of the
+     * quarter step smoothing the arduino used to do once up to speed
+     * */
+    std::pair<double, double> drive(JointEstimator& estimator, double actual_rate)
+    {
+        std::mt19937 generator{2};
+        std::normal_distribution<double> noise{0, GAINS.position_noise};
+        double actual = 0, smoothed = 0, speed = 0;
+        double worst_estimate = 0, worst_smoothed = 0;
+        for (int i = 0; i < 90; ++i)
+        {
+            double pwm = (i >= 15) ? 1.0 : 0.0;
+            speed += LOOP / (GAINS.response_time + LOOP) * (actual_rate * pwm - speed);
+            actual += speed * LOOP;
+            double sample = actual + noise(generator);
+            smoothed += (sample - smoothed) / 4;
+
+            estimator.predict(pwm, i * LOOP, GAINS);
+            estimator.correct(sample, GAINS);
+            if (i > 45)
+            {
+                worst_estimate = std::max(worst_estimate,
+                        std::abs(estimator.getPosition() - actual));
+                worst_smoothed = std::max(worst_smoothed, std::abs(smoothed - actual));
+            }
+        }
+        return std::make_pair(worst_estimate, worst_smoothed);
+    }
+}
+
+TEST(JointEstimator, StartsAtTheFirstSample)
+{
+    JointEstimator estimator{};
+    estimator.predict(0.5, 0.0, GAINS);
+    ASSERT_FALSE(estimator.ready());
+    estimator.correct(0.7, GAINS);
+    ASSERT_TRUE(estimator.ready());
+    ASSERT_DOUBLE_EQ(estimator.getPosition(), 0.7);
+    ASSERT_DOUBLE_EQ(estimator.getVelocity(), 0.0);
+}
+
+TEST(JointEstimator, HoldsStillWhenNotDriven)
+{
+    JointEstimator estimator{};
+    std::mt19937 generator{1};
+    std::normal_distribution<double> noise{0, GAINS.position_noise};
+    for (int i = 0; i < 300; ++i)
+    {
+        estimator.predict(0, i * LOOP, GAINS);
+        estimator.correct(1.0 + noise(generator), GAINS);
+    }
+    ASSERT_NEAR(estimator.getPosition(), 1.0, GAINS.position_noise);
+    ASSERT_NEAR(estimator.getVelocity(), 0.0, 0.05);
+}
+
+TEST(JointEstimator, TracksADrivenJointWithoutLag)
+{
+    JointEstimator estimator{};
+    auto worst = drive(estimator, GAINS.pwm_rate);
+    ASSERT_NEAR(estimator.getVelocity(), GAINS.pwm_rate, 0.05);
+    ASSERT_LT(worst.first, worst.second / 2);
+}
+
+TEST(JointEstimator, SamplesCorrectAWrongRate)
+{
+    //the actuator is slower than it's tuned for, under load say
+    JointEstimator estimator{};
+    auto worst = drive(estimator, GAINS.pwm_rate * 0.6);
+    ASSERT_NEAR(estimator.getVelocity(), GAINS.pwm_rate * 0.6, 0.05);
+    ASSERT_LT(worst.first, worst.second);
+}
+
+TEST(JointEstimator, LongStallsDontThrowTheEstimate)
+{
+    JointEstimator estimator{};
+    estimator.correct(0.2, GAINS);
+    estimator.predict(0, 0.0, GAINS);
+    estimator.predict(1.0, 10.0, GAINS);
+    //one step of at most half a second at full speed
+    ASSERT_LT(estimator.getPosition(), 0.2 + GAINS.pwm_rate * 0.5);
+    estimator.predict(1.0, 9.0, GAINS);
+    ASSERT_LT(estimator.getPosition(), 0.2 + GAINS.pwm_rate * 0.5);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
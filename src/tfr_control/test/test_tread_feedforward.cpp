@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "tread_feedforward.h"
+
+using tfr_control::FeedforwardGains;
+using tfr_control::TreadFeedforward;
+
+namespace
+{
+    const FeedforwardGains GAINS{0.8, 0.4, 0.5};
+    const double SPEED = 0.3;
+}
+
+TEST(TreadFeedforward, NothingWithoutAttitude)
+{
+    TreadFeedforward feedforward{};
+    auto output = feedforward.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_EQ(output.first, 0);
+    ASSERT_EQ(output.second, 0);
+}
+
+TEST(TreadFeedforward, PushesUphillEitherWay)
+{
+    TreadFeedforward feedforward{};
+    //nose up, both treads work harder
+    feedforward.updateAttitude(0, -0.2, 0.0);
+    auto output = feedforward.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, GAINS.grade * std::sin(0.2), 1e-12);
+    ASSERT_NEAR(output.second, output.first, 1e-12);
+    //gravity along the robot is the same backing up
+    output = feedforward.compute(-SPEED, -SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, GAINS.grade * std::sin(0.2), 1e-12);
+
+    //nose down, it holds back
+    TreadFeedforward downhill{};
+    downhill.updateAttitude(0, 0.2, 0.0);
+    output = downhill.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, -GAINS.grade * std::sin(0.2), 1e-12);
+    ASSERT_NEAR(output.second, -GAINS.grade * std::sin(0.2), 1e-12);
+}
+
+TEST(TreadFeedforward, MovesOutputToTheDownhillTread)
+{
+    TreadFeedforward feedforward{};
+    //right side down
+    feedforward.updateAttitude(0.1, 0, 0.0);
+    double cross = GAINS.cross * std::sin(0.1);
+    auto output = feedforward.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, -cross, 1e-12);
+    ASSERT_NEAR(output.second, cross, 1e-12);
+    //backing up, the right tread still pushes harder in its direction of travel
+    output = feedforward.compute(-SPEED, -SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, cross, 1e-12);
+    ASSERT_NEAR(output.second, -cross, 1e-12);
+    //pivoting left, both turn the robot uphill against the drag
+    output = feedforward.compute(-SPEED, SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, cross, 1e-12);
+    ASSERT_NEAR(output.second, cross, 1e-12);
+}
+
+TEST(TreadFeedforward, OnlyWhileMoving)
+{
+    TreadFeedforward feedforward{};
+    feedforward.updateAttitude(0.1, -0.2, 0.0);
+    //parked inside the deadband, nothing to fight
+    auto output = feedforward.compute(0.01, -0.01, 0.0, GAINS);
+    ASSERT_EQ(output.first, 0);
+    ASSERT_EQ(output.second, 0);
+    //a stopped tread gets the grade but not the cross term
+    output = feedforward.compute(0.0, SPEED, 0.0, GAINS);
+    ASSERT_NEAR(output.first, GAINS.grade * std::sin(0.2), 1e-12);
+    ASSERT_NEAR(output.second, GAINS.grade * std::sin(0.2) +
+            GAINS.cross * std::sin(0.1), 1e-12);
+}
+
+TEST(TreadFeedforward, CapsEachTread)
+{
+    TreadFeedforward feedforward{};
+    feedforward.updateAttitude(0.5, -1.2, 0.0);
+    auto output = feedforward.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_DOUBLE_EQ(output.first, GAINS.max);
+    ASSERT_DOUBLE_EQ(output.second, GAINS.max);
+    TreadFeedforward downhill{};
+    downhill.updateAttitude(0, 1.2, 0.0);
+    output = downhill.compute(SPEED, SPEED, 0.0, GAINS);
+    ASSERT_DOUBLE_EQ(output.first, -GAINS.max);
+}
+
+TEST(TreadFeedforward, FiltersBumps)
+{
+    TreadFeedforward feedforward{};
+    feedforward.updateAttitude(0, 0, 0.0);
+    //one sample of a bump only moves it part way
+    feedforward.updateAttitude(0, -0.2, 0.02);
+    double alpha = 0.02 / (0.2 + 0.02);
+    auto output = feedforward.compute(SPEED, SPEED, 0.02, GAINS);
+    ASSERT_NEAR(output.first, GAINS.grade * std::sin(0.2 * alpha), 1e-12);
+    //a slope that stays settles in after a few time constants
+    for (int i = 2; i <= 100; ++i)
+        feedforward.updateAttitude(0, -0.2, i * 0.02);
+    output = feedforward.compute(SPEED, SPEED, 2.0, GAINS);
+    ASSERT_NEAR(output.first, GAINS.grade * std::sin(0.2), 1e-4);
+}
+
+TEST(TreadFeedforward, StopsOnStaleAttitude)
+{
+    TreadFeedforward feedforward{};
+    feedforward.updateAttitude(0, -0.2, 0.0);
+    ASSERT_NE(feedforward.compute(SPEED, SPEED, 0.4, GAINS).first, 0);
+    auto output = feedforward.compute(SPEED, SPEED, 0.6, GAINS);
+    ASSERT_EQ(output.first, 0);
+    ASSERT_EQ(output.second, 0);
+    //after a gap the filter starts over instead of easing in from the old
+    //attitude
+    feedforward.updateAttitude(0, 0.3, 2.0);
+    output = feedforward.compute(SPEED, SPEED, 2.0, GAINS);
+    ASSERT_NEAR(output.first, -GAINS.grade * std::sin(0.3), 1e-12);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
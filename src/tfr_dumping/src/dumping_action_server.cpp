@@ -7,10 +7,16 @@
 #include <tfr_msgs/BinStateSrv.h>
 #include <tfr_utilities/control_code.h>
 #include <tfr_utilities/arm_manipulator.h>
+#include <tfr_utilities/snapshot.h>
+#include <tfr_utilities/trace_log.h>
+#include <tfr_dumping/DumpingConfig.h>
+#include <dynamic_reconfigure/server.h>
 #include <sensor_msgs/Image.h>
 #include <image_transport/image_transport.h>
 #include <actionlib/server/simple_action_server.h>
 #include <actionlib/client/simple_action_client.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <pluginlib/class_list_macros.h>
 /*
  * The dumping action server, it backs up the rover into the navigational aid
  * slowly.
@@ -28,6 +34,11 @@
  *
  * This is currently filled by the camera_topic_wrapper in sensors
  *
+ * It runs as the tfr_dumping/Dumper nodelet.
+ *
+ * The velocities and tolerance can be tuned live through dynamic_reconfigure
+ * (cfg/Dumping.cfg), a new set takes effect on the next control cycle.
+ *
  * published topics:
  *   -/cmd_vel geometry_msgs/Twist the drivebase velocity
  *   -/bin_position_controller/command std_msgs/Float64 the position of the bin
@@ -54,8 +65,8 @@ class Dumper
         };
 
         
-        Dumper(ros::NodeHandle &node, const std::string &service_name,
-                const DumpingConstraints &c) :
+        Dumper(ros::NodeHandle &node, ros::NodeHandle &p_node,
+                const std::string &service_name, const DumpingConstraints &c) :
             server{node, "dump", boost::bind(&Dumper::dump, this, _1), false},
             image_client{node.serviceClient<tfr_msgs::WrappedImage>(service_name)},
             velocity_publisher{node.advertise<geometry_msgs::Twist>("cmd_vel", 10)},
@@ -63,9 +74,11 @@ class Dumper
             detector{"light_detection"},
             aruco{"aruco_action_server",true},
             constraints{c},
+            reconfigure_server{p_node},
             arm_manipulator{node}
         {
             ROS_INFO("dumping action server initializing");
+            reconfigure_server.setCallback(boost::bind(&Dumper::reconfigure, this, _1, _2));
             detector.waitForServer();
             aruco.waitForServer();
             server.start();
@@ -89,8 +102,15 @@ class Dumper
 
         ArmManipulator arm_manipulator;
 
-        const DumpingConstraints &constraints; 
+        Snapshot<DumpingConstraints> constraints;
+        dynamic_reconfigure::Server<tfr_dumping::DumpingConfig> reconfigure_server;
 
+        void reconfigure(tfr_dumping::DumpingConfig &config, uint32_t level)
+        {
+            constraints.set(DumpingConstraints(config.min_lin_vel,
+                        config.max_lin_vel, config.min_ang_vel,
+                        config.max_ang_vel, config.ang_tolerance));
+        }
 
         /*
          * The business logic of the action server.
@@ -182,8 +202,9 @@ class Dumper
             auto siny = +2.0 * (estimate.relative_pose.pose.orientation.w * estimate.relative_pose.pose.orientation.z + estimate.relative_pose.pose.orientation.x * estimate.relative_pose.pose.orientation.y);
             auto cosy = +1.0 - 2.0 * (estimate.relative_pose.pose.orientation.y * estimate.relative_pose.pose.orientation.y +  estimate.relative_pose.pose.orientation.z * estimate.relative_pose.pose.orientation.z );  
             auto angle = atan2(siny, cosy);
-            ROS_INFO("ang %f", angle);
-            if (3.14159 - std::abs(angle) > constraints.getAngTolerance())
+            TFR_DEBUG_LIMITED(0.5, "ang %f", angle);
+            const DumpingConstraints &limits = constraints.get();
+            if (3.14159 - std::abs(angle) > limits.getAngTolerance())
             {
                 /*
                  * Maintenence note:
@@ -198,12 +219,12 @@ class Dumper
                  * */
                 int sign = (angle < 0) ? 1 : -1;
                 cmd.linear.x = 0;
-                cmd.angular.z = sign*constraints.getMaxAngVel();
+                cmd.angular.z = sign*limits.getMaxAngVel();
             }
             
             else
             {
-                cmd.linear.x = -1 * constraints.getMaxLinVel();
+                cmd.linear.x = -1 * limits.getMaxLinVel();
             }
         }
 
@@ -212,9 +233,9 @@ class Dumper
          * */
         void moveBlind()
         {
-            ROS_INFO("backing up blind");
+            TFR_INFO_LIMITED(1.0, "backing up blind");
             geometry_msgs::Twist cmd{};
-            cmd.linear.x = -1*constraints.getMinLinVel();
+            cmd.linear.x = -1*constraints.get().getMinLinVel();
             cmd.angular.z = 0;
             velocity_publisher.publish(cmd);
         }
@@ -249,21 +270,32 @@ class Dumper
         }
 };
 
-int main(int argc, char **argv)
+namespace tfr_dumping
 {
-    ros::init(argc, argv, "dumping_action_server");
-    ros::NodeHandle n;
-    double min_lin_vel, max_lin_vel, min_ang_vel, max_ang_vel, ang_tolerance;
-    ros::param::param<double>("~min_lin_vel",min_lin_vel, 0);
-    ros::param::param<double>("~max_lin_vel",max_lin_vel, 0);
-    ros::param::param<double>("~min_ang_vel",min_ang_vel, 0);
-    ros::param::param<double>("~max_ang_vel",max_ang_vel, 0);
-    ros::param::param<double>("~ang_tolerance",ang_tolerance, 0);
-    std::string service_name;
-    ros::param::param<std::string>("~image_service_name", service_name, "");
-    Dumper::DumpingConstraints constraints(min_lin_vel, max_lin_vel,
-            min_ang_vel, max_ang_vel, ang_tolerance);
-    Dumper dumper(n, service_name, constraints);
-    ros::spin();
-    return 0;
+    class DumperNodelet : public ComponentNodelet
+    {
+        public:
+            ~DumperNodelet() { stop(); }
+
+        private:
+            std::unique_ptr<Dumper> dumper;
+
+            void start() override
+            {
+                ros::NodeHandle &p_n = getPrivateNodeHandle();
+                double min_lin_vel, max_lin_vel, min_ang_vel, max_ang_vel, ang_tolerance;
+                p_n.param<double>("min_lin_vel",min_lin_vel, 0);
+                p_n.param<double>("max_lin_vel",max_lin_vel, 0);
+                p_n.param<double>("min_ang_vel",min_ang_vel, 0);
+                p_n.param<double>("max_ang_vel",max_ang_vel, 0);
+                p_n.param<double>("ang_tolerance",ang_tolerance, 0);
+                std::string service_name;
+                p_n.param<std::string>("image_service_name", service_name, "");
+                Dumper::DumpingConstraints constraints(min_lin_vel, max_lin_vel,
+                        min_ang_vel, max_ang_vel, ang_tolerance);
+                dumper.reset(new Dumper(getNodeHandle(), p_n, service_name, constraints));
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_dumping::DumperNodelet, nodelet::Nodelet)
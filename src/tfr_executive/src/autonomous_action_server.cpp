@@ -18,7 +18,8 @@
  * to return to a safe state on a timeout and promptly exit. 
  * 
  * On startup the action server will be expecting a command to start autonomy, 
- * and initialize autonomous operation. 
+ * and initialize autonomous operation. Runs as the
+ * tfr_executive/AutonomousExecutive nodelet.
  *
  * PRECONDITION
  * The clock service must be up and started, anything else is undefined
@@ -53,11 +54,13 @@
 #include <tfr_utilities/status_publisher.h>
 #include <actionlib/server/simple_action_server.h>
 #include <actionlib/client/simple_action_client.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <pluginlib/class_list_macros.h>
 
 class AutonomousExecutive
 {
     public:
-        AutonomousExecutive(ros::NodeHandle &n,double f):
+        AutonomousExecutive(ros::NodeHandle &n, ros::NodeHandle &p_n, double f):
             server{n, "autonomous_action_server", 
                 boost::bind(&AutonomousExecutive::autonomousMission, this, _1),
                 false},
@@ -71,29 +74,29 @@ class AutonomousExecutive
             moveClient{n, "move_base", true}
             
         {
-            ros::param::param<bool>("~localization_to", LOCALIZATION_TO, true);
-            ros::param::param<bool>("~localization_from", LOCALIZATION_FROM, true);
-            ros::param::param<bool>("~localization_finish", LOCALIZATION_FINISH, true);
+            p_n.param<bool>("localization_to", LOCALIZATION_TO, true);
+            p_n.param<bool>("localization_from", LOCALIZATION_FROM, true);
+            p_n.param<bool>("localization_finish", LOCALIZATION_FINISH, true);
             if (LOCALIZATION_TO || LOCALIZATION_FROM || LOCALIZATION_FINISH)
             {
                 localizationClient.waitForServer();
                 status_publisher.info(StatusCode::EXC_CONNECT_LOCALIZATION, 1.0);
             }
-            ros::param::param<bool>("~navigation_to", NAVIGATION_TO, true);
-            ros::param::param<bool>("~navigation_from", NAVIGATION_FROM, true);
+            p_n.param<bool>("navigation_to", NAVIGATION_TO, true);
+            p_n.param<bool>("navigation_from", NAVIGATION_FROM, true);
             if (NAVIGATION_TO || NAVIGATION_FROM)
             {
                 navigationClient.waitForServer();
                 status_publisher.info(StatusCode::EXC_CONNECT_NAVIGATION, 1.0);
             }
-            ros::param::param<bool>("~digging", DIGGING, true);
+            p_n.param<bool>("digging", DIGGING, true);
             if (DIGGING)
             {
                 ROS_INFO("Autonomous Action Server: Connecting to digging server");
                 diggingClient.waitForServer();
                 ROS_INFO("Autonomous Action Server: Connected to digging server");
             }
-            ros::param::param<bool>("~dumping", DUMPING, true);
+            p_n.param<bool>("dumping", DUMPING, true);
             if (DUMPING)
             {
                 ROS_INFO("Autonomous Action Server: Connecting to digging server");
@@ -192,7 +195,10 @@ class AutonomousExecutive
                 ROS_INFO("Autonomous Action Server: digging time retreived %f",
                         digging_time.response.duration.toSec());
                 goal.diggingTime = digging_time.response.duration;
-                diggingClient.sendGoal(goal);
+                diggingClient.sendGoal(goal,
+                        DiggingClient::SimpleDoneCallback(),
+                        DiggingClient::SimpleActiveCallback(),
+                        boost::bind(&AutonomousExecutive::diggingProgress, this, _1));
 
                 //handle preemption
                 while (!diggingClient.getState().isDone())
@@ -212,6 +218,9 @@ class AutonomousExecutive
                     server.setAborted();
                     return;
                 }
+                ROS_INFO("Autonomous Action Server: payload estimate %f m^3%s",
+                        diggingClient.getResult()->payload_volume,
+                        diggingClient.getResult()->full ? ", bin full" : "");
                 ROS_INFO("Autonomous Action Server: backing up");
                 geometry_msgs::Twist vel;
                 vel.linear.x = -.25;
@@ -294,12 +303,25 @@ class AutonomousExecutive
                     return;
                 }
                 ROS_INFO("Autonomous Action Server: dumping finished");
+                std_srvs::Empty empty;
+                ros::service::call("/reset_payload", empty);
 
             }
             ROS_INFO("Autonomous Action Server: AUTONOMOUS MISSION SUCCESS");
             server.setSucceeded();
         }
         
+        /*
+         * Reports each finished scoop of the digging server
+         * */
+        void diggingProgress(const tfr_msgs::DiggingFeedbackConstPtr &feedback)
+        {
+            if (feedback->state_index + 1 == feedback->set_states)
+                ROS_INFO("Autonomous Action Server: scoop %u done in set %u, %f s left",
+                        feedback->scoops, feedback->set_index,
+                        feedback->remaining.toSec());
+        }
+
         void localize(bool set_odometry, double yaw)
         {
             ROS_INFO("Autonomous Action Server: commencing localization");
@@ -354,7 +376,8 @@ class AutonomousExecutive
         actionlib::SimpleActionServer<tfr_msgs::EmptyAction> server;
         actionlib::SimpleActionClient<tfr_msgs::LocalizationAction> localizationClient;
         actionlib::SimpleActionClient<tfr_msgs::NavigationAction> navigationClient;
-        actionlib::SimpleActionClient<tfr_msgs::DiggingAction> diggingClient;
+        typedef actionlib::SimpleActionClient<tfr_msgs::DiggingAction> DiggingClient;
+        DiggingClient diggingClient;
         actionlib::SimpleActionClient<tfr_msgs::EmptyAction> dumpingClient;
         actionlib::SimpleActionClient<move_base_msgs::MoveBaseAction> moveClient;
 
@@ -372,13 +395,25 @@ class AutonomousExecutive
         ros::Publisher drivebase_publisher;
 };
 
-int main(int argc, char **argv)
+namespace tfr_executive
 {
-    ros::init(argc, argv, "autonomous_action_server");
-    ros::NodeHandle n{};
-    double rate;
-    ros::param::param<double>("~rate", rate, 10.0);
-    AutonomousExecutive autonomousExecutive{n, 1.0/rate};
-    ros::spin();
-    return 0;
+    class AutonomousNodelet : public ComponentNodelet
+    {
+        public:
+            ~AutonomousNodelet() { stop(); }
+
+        private:
+            std::unique_ptr<AutonomousExecutive> executive;
+
+            void start() override
+            {
+                ros::NodeHandle& p_n = getPrivateNodeHandle();
+                double rate;
+                p_n.param<double>("rate", rate, 10.0);
+                executive.reset(new AutonomousExecutive{getNodeHandle(), p_n,
+                        1.0/rate});
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_executive::AutonomousNodelet, nodelet::Nodelet)
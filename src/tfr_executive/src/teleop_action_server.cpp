@@ -3,6 +3,7 @@
  * and performing smooth remote operation for our operations team. All commands
  * for teleoperation will be processed by this server, except for emergency 
  * stop, which is handled by the control system directly for fast response time.
+ * Runs as the tfr_executive/TeleopExecutive nodelet.
  * 
  * The commands it supports:
  * - None
@@ -46,6 +47,8 @@
 #include <tfr_msgs/ArmMoveAction.h>
 #include <actionlib/server/simple_action_server.h>
 #include <actionlib/client/simple_action_client.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <pluginlib/class_list_macros.h>
 
 
 
@@ -346,16 +349,31 @@ class TeleopExecutive
 };
 
 
-int main(int argc, char** argv)
+namespace tfr_executive
 {
-    ros::init(argc, argv, "teleop_action_server");
-    ros::NodeHandle n{};
-    double linear_velocity, angular_velocity, rate;
-    ros::param::param<double>("~linear_velocity", linear_velocity, 0.25);
-    ros::param::param<double>("~angular_velocity", angular_velocity, 0.3);
-    ros::param::param<double>("~rate", rate, 10.0);
-    TeleopExecutive::DriveVelocity velocities{linear_velocity, angular_velocity};
-    TeleopExecutive teleop{n, velocities, 1.0/rate};
-    ros::spin();
-    return 0;
+    class TeleopNodelet : public ComponentNodelet
+    {
+        public:
+            ~TeleopNodelet() { stop(); }
+
+        private:
+            //declared before the executive, which holds a reference to it
+            std::unique_ptr<TeleopExecutive::DriveVelocity> velocities;
+            std::unique_ptr<TeleopExecutive> teleop;
+
+            void start() override
+            {
+                ros::NodeHandle& p_n = getPrivateNodeHandle();
+                double linear_velocity, angular_velocity, rate;
+                p_n.param<double>("linear_velocity", linear_velocity, 0.25);
+                p_n.param<double>("angular_velocity", angular_velocity, 0.3);
+                p_n.param<double>("rate", rate, 10.0);
+                velocities.reset(new TeleopExecutive::DriveVelocity{linear_velocity,
+                        angular_velocity});
+                teleop.reset(new TeleopExecutive{getNodeHandle(), *velocities,
+                        1.0/rate});
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_executive::TeleopNodelet, nodelet::Nodelet)
@@ -0,0 +1,27 @@
+#ifndef SCHEDULING_RULES_H
+#define SCHEDULING_RULES_H
+#include <xmlrpcpp/XmlRpcValue.h>
+#include <string>
+#include <vector>
+#include "thread_scheduling.h"
+
+namespace tfr_launch
+{
+    /*
+     * Reads one rule of the profile, fields left out keep their defaults.
+     * False if the entry isn't a struct with a list of nodes.
+     * */
+    bool parseRule(XmlRpc::XmlRpcValue& entry, SchedulingRule& rule);
+
+    /*
+     * The rule a thread of the node runs under, nullptr to leave it alone.
+     *
+     * A rule for the thread by name wins over one for its whole process,
+     * which wins over the default. The default only covers nodes some other
+     * rule names.
+     * */
+    const SchedulingRule* findRule(const std::vector<SchedulingRule>& rules,
+            const std::string& node, const std::string& thread);
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef THREAD_SCHEDULING_H
+#define THREAD_SCHEDULING_H
+#include <sys/types.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tfr_launch
+{
+    enum class SchedulingPolicy
+    {
+        OTHER,
+        FIFO
+    };
+
+    /**
+     * What one group of threads should run with.
+     *
+     * A rule covers the processes of the ros nodes it names. With a thread
+     * name it only covers the threads of that name (as in
+     * /proc/<pid>/task/<tid>/comm), otherwise every thread of the process.
+     * The node "*" covers the threads of named nodes that no other rule
+     * covers, nodes the profile doesn't name are left alone.
+     * */
+    struct SchedulingRule
+    {
+        //ros node base names this rule applies to
+        std::vector<std::string> nodes;
+        //thread name to match, empty for the whole process
+        std::string thread;
+        //cores to run on, empty leaves affinity alone
+        std::vector<int> cpus;
+        SchedulingPolicy policy;
+        //1-99, only for FIFO
+        int priority;
+        //-20-19, only for OTHER
+        int nice;
+        //cores worth of time the group may use, 0 is no limit, only for OTHER
+        //since cfs quotas don't touch realtime threads
+        double cpu_quota;
+        //cgroup under <cgroup_root>/tfr the quota is applied through
+        std::string group;
+    };
+
+    /*
+     * The threads of a process as (tid, name), empty if it's gone
+     * */
+    std::vector<std::pair<pid_t, std::string>> listThreads(pid_t pid);
+
+    /*
+     * Whether the command line of pid has "__name:=<node>", which roslaunch
+     * gives every node it starts. Guards against a pid from another machine.
+     * */
+    bool isNodeProcess(pid_t pid, const std::string& node);
+
+    /*
+     * Applies the rule to one thread, the cgroup quota is set up first if it
+     * needs one. Returns false with what went wrong in error.
+     * */
+    bool applyRule(pid_t tid, const SchedulingRule& rule,
+            const std::string& cgroup_root, std::string& error);
+
+    /*
+     * Checks the thread is running the way the rule says. Returns false with
+     * each difference in report.
+     * */
+    bool checkRule(pid_t tid, const SchedulingRule& rule, std::string& report);
+}
+
+#endif
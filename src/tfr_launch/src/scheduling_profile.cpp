@@ -0,0 +1,204 @@
+/**
+ * scheduling_profile.cpp
+ *
+ * Pins our nodes to cores and sets their scheduling from a profile, so the
+ * control loop keeps a core of its own while OMPL, ArUco and the Kinect
+ * pipeline burst on the others. The "*" rule only covers the leftover
+ * threads of nodes the profile names, anything it doesn't name is left as
+ * it is, use isolcpus on the kernel command line to keep the rest of the
+ * system off the reserved cores.
+ *
+ * Nodes are found through the master and resolved to a pid with getPid, the
+ * same as rosnode. Only processes on this machine are touched, checked by the
+ * __name:= argument roslaunch passes. The profile is checked again every
+ * check_period, nodes that come up late or respawn get it applied then, and
+ * anything that drifted is put back and warned about.
+ *
+ * SCHED_FIFO and negative nice need CAP_SYS_NICE, the quotas need write
+ * access to the cpu cgroup (v1) hierarchy, so this runs as root on the robot.
+ * Without either it applies what it can and reports the rest, warning again
+ * only when what it couldn't apply changes.
+ *
+ * PARAMETERS:
+ *  ~rules: the profile, see config/scheduling_profile.yaml (list)
+ *  ~check_period: seconds between checks (double, default: 5.0)
+ *  ~cgroup_root: where the cpu controller is mounted (string,
+ *  default: /sys/fs/cgroup/cpu)
+ * SERVICES:
+ *  ~verify: std_srvs/Trigger, checks and applies the profile now, the message
+ *  lists every thread that still isn't running the way its rule says
+ */
+#include <ros/ros.h>
+#include <ros/master.h>
+#include <ros/network.h>
+#include <xmlrpcpp/XmlRpc.h>
+#include <std_srvs/Trigger.h>
+#include "scheduling_rules.h"
+#include "thread_scheduling.h"
+
+using tfr_launch::SchedulingRule;
+
+class SchedulingProfile
+{
+    public:
+        SchedulingProfile(ros::NodeHandle &n, ros::NodeHandle &p_n,
+                const std::vector<SchedulingRule> &r, const std::string &root,
+                double check_period) :
+            rules{r},
+            cgroup_root{root},
+            verify_service{p_n.advertiseService("verify",
+                    &SchedulingProfile::verify, this)},
+            timer{n.createTimer(ros::Duration{check_period},
+                    &SchedulingProfile::check, this)}
+        {
+            if (!enforce(last_report))
+                ROS_WARN("Scheduling Profile: %s", last_report.c_str());
+        }
+        ~SchedulingProfile() = default;
+        SchedulingProfile(const SchedulingProfile&) = delete;
+        SchedulingProfile& operator=(const SchedulingProfile&) = delete;
+        SchedulingProfile(SchedulingProfile&&) = delete;
+        SchedulingProfile& operator=(SchedulingProfile&&) = delete;
+
+    private:
+        const std::vector<SchedulingRule> rules;
+        const std::string cgroup_root;
+
+        ros::ServiceServer verify_service;
+        ros::Timer timer;
+        //what the last check couldn't apply, so it's only warned about once
+        std::string last_report;
+
+        void check(const ros::TimerEvent&)
+        {
+            std::string report;
+            enforce(report);
+            if (report != last_report)
+            {
+                if (report.empty())
+                    ROS_INFO("Scheduling Profile: profile active");
+                else
+                    ROS_WARN("Scheduling Profile: %s", report.c_str());
+            }
+            last_report = report;
+        }
+
+        bool verify(std_srvs::Trigger::Request& request,
+                std_srvs::Trigger::Response& response)
+        {
+            response.success = enforce(response.message);
+            if (response.success)
+                response.message = "profile active";
+            return true;
+        }
+
+        /*
+         * Goes over every node on this machine, puts back any thread that
+         * doesn't match its rule, and checks it took. Returns false with what
+         * couldn't be applied in report.
+         * */
+        bool enforce(std::string& report)
+        {
+            ros::V_string nodes;
+            if (!ros::master::getNodes(nodes))
+            {
+                report += "couldn't reach the master; ";
+                return false;
+            }
+
+            bool ok = true;
+            for (const auto& node : nodes)
+            {
+                std::string name = node.substr(node.rfind('/') + 1);
+                pid_t pid;
+                if (!lookupPid(node, pid) || !tfr_launch::isNodeProcess(pid, name))
+                    continue;
+
+                for (const auto& thread : tfr_launch::listThreads(pid))
+                {
+                    const SchedulingRule* rule = tfr_launch::findRule(rules, name,
+                            thread.second);
+                    if (rule == nullptr)
+                        continue;
+
+                    std::string differences, error;
+                    if (tfr_launch::checkRule(thread.first, *rule, differences))
+                        continue;
+                    ROS_INFO("Scheduling Profile: applying to %s/%s, %s",
+                            node.c_str(), thread.second.c_str(),
+                            differences.c_str());
+                    differences.clear();
+                    if (!tfr_launch::applyRule(thread.first, *rule, cgroup_root, error) ||
+                            !tfr_launch::checkRule(thread.first, *rule, differences))
+                    {
+                        report += node + "/" + thread.second + ": " + error +
+                            differences;
+                        ok = false;
+                    }
+                }
+            }
+            return ok;
+        }
+
+        /*
+         * Asks the node for its pid over its xmlrpc api
+         * */
+        bool lookupPid(const std::string& node, pid_t& pid)
+        {
+            XmlRpc::XmlRpcValue args, result, payload;
+            args[0] = ros::this_node::getName();
+            args[1] = node;
+            if (!ros::master::execute("lookupNode", args, result, payload, false))
+                return false;
+
+            std::string host;
+            uint32_t port;
+            if (!ros::network::splitURI(static_cast<std::string>(payload), host, port))
+                return false;
+
+            XmlRpc::XmlRpcClient client{host.c_str(), static_cast<int>(port), "/"};
+            XmlRpc::XmlRpcValue request, response;
+            request[0] = ros::this_node::getName();
+            if (!client.execute("getPid", request, response) ||
+                    response.getType() != XmlRpc::XmlRpcValue::TypeArray ||
+                    response.size() != 3 || static_cast<int>(response[0]) != 1)
+                return false;
+            pid = static_cast<int>(response[2]);
+            return true;
+        }
+};
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "scheduling_profile");
+    ros::NodeHandle n{};
+    ros::NodeHandle p_n{"~"};
+
+    double check_period;
+    std::string cgroup_root;
+    p_n.param<double>("check_period", check_period, 5.0);
+    p_n.param<std::string>("cgroup_root", cgroup_root, "/sys/fs/cgroup/cpu");
+
+    XmlRpc::XmlRpcValue entries;
+    if (!p_n.getParam("rules", entries) ||
+            entries.getType() != XmlRpc::XmlRpcValue::TypeArray)
+    {
+        ROS_ERROR("Scheduling Profile: no rules loaded, exiting");
+        return 1;
+    }
+    std::vector<SchedulingRule> rules;
+    for (int i = 0; i < entries.size(); i++)
+    {
+        SchedulingRule rule;
+        if (!tfr_launch::parseRule(entries[i], rule))
+        {
+            ROS_ERROR("Scheduling Profile: rule %d needs a list of nodes, exiting", i);
+            return 1;
+        }
+        rules.push_back(rule);
+    }
+
+    SchedulingProfile profile{n, p_n, rules, cgroup_root, check_period};
+    ros::spin();
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "scheduling_rules.h"
+#include <algorithm>
+
+namespace tfr_launch
+{
+    namespace
+    {
+        /*
+         * A number from the yaml, which gives 1 as an int and 1.0 as a double
+         * */
+        double toDouble(XmlRpc::XmlRpcValue& value)
+        {
+            if (value.getType() == XmlRpc::XmlRpcValue::TypeInt)
+                return static_cast<int>(value);
+            return static_cast<double>(value);
+        }
+    }
+
+    bool parseRule(XmlRpc::XmlRpcValue& entry, SchedulingRule& rule)
+    {
+        if (entry.getType() != XmlRpc::XmlRpcValue::TypeStruct ||
+                !entry.hasMember("nodes"))
+            return false;
+        rule = SchedulingRule{{}, "", {}, SchedulingPolicy::OTHER, 0, 0, 0.0, ""};
+
+        for (int i = 0; i < entry["nodes"].size(); i++)
+            rule.nodes.push_back(static_cast<std::string>(entry["nodes"][i]));
+        if (rule.nodes.empty())
+            return false;
+        if (entry.hasMember("thread"))
+            rule.thread = static_cast<std::string>(entry["thread"]);
+        if (entry.hasMember("cpus"))
+            for (int i = 0; i < entry["cpus"].size(); i++)
+                rule.cpus.push_back(static_cast<int>(entry["cpus"][i]));
+        if (entry.hasMember("policy") &&
+                static_cast<std::string>(entry["policy"]) == "fifo")
+        {
+            rule.policy = SchedulingPolicy::FIFO;
+            rule.priority = entry.hasMember("priority") ?
+                static_cast<int>(entry["priority"]) : 50;
+        }
+        if (entry.hasMember("nice"))
+            rule.nice = static_cast<int>(entry["nice"]);
+        if (entry.hasMember("cpu_quota"))
+            rule.cpu_quota = toDouble(entry["cpu_quota"]);
+        rule.group = entry.hasMember("group") ?
+            static_cast<std::string>(entry["group"]) : rule.nodes.front();
+        return true;
+    }
+
+    const SchedulingRule* findRule(const std::vector<SchedulingRule>& rules,
+            const std::string& node, const std::string& thread)
+    {
+        const SchedulingRule* process_rule = nullptr;
+        const SchedulingRule* default_rule = nullptr;
+        bool managed = false;
+        for (const auto& rule : rules)
+        {
+            bool named = std::find(rule.nodes.begin(), rule.nodes.end(), node)
+                != rule.nodes.end();
+            bool fallback = std::find(rule.nodes.begin(), rule.nodes.end(), "*")
+                != rule.nodes.end();
+            managed = managed || named;
+            if (named && rule.thread == thread)
+                return &rule;
+            if (named && rule.thread.empty())
+                process_rule = &rule;
+            if (fallback && rule.thread.empty())
+                default_rule = &rule;
+        }
+        if (process_rule != nullptr)
+            return process_rule;
+        return managed ? default_rule : nullptr;
+    }
+}
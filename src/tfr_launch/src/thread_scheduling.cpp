@@ -0,0 +1,223 @@
+#include "thread_scheduling.h"
+#include <sched.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace tfr_launch
+{
+    namespace
+    {
+        //the kernel's default cfs period in microseconds
+        const long CFS_PERIOD = 100000;
+
+        std::string procPath(pid_t tid, const std::string& file)
+        {
+            return "/proc/" + std::to_string(tid) + "/" + file;
+        }
+
+        std::string groupPath(const std::string& cgroup_root, const std::string& group)
+        {
+            return cgroup_root + "/tfr/" + group;
+        }
+
+        bool writeFile(const std::string& path, const std::string& value)
+        {
+            std::ofstream file{path};
+            file << value;
+            file.flush();
+            return static_cast<bool>(file);
+        }
+
+        std::string describeError(const std::string& what)
+        {
+            return what + ": " + std::strerror(errno) + "; ";
+        }
+
+        /*
+         * Makes the group and sets its quota, mkdir on an existing group is fine
+         * */
+        bool setupGroup(const SchedulingRule& rule, const std::string& cgroup_root,
+                std::string& error)
+        {
+            mkdir((cgroup_root + "/tfr").c_str(), 0755);
+            std::string path = groupPath(cgroup_root, rule.group);
+            if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                error += describeError("mkdir " + path);
+                return false;
+            }
+            long quota = std::lround(rule.cpu_quota * CFS_PERIOD);
+            if (!writeFile(path + "/cpu.cfs_period_us", std::to_string(CFS_PERIOD)) ||
+                    !writeFile(path + "/cpu.cfs_quota_us", std::to_string(quota)))
+            {
+                error += "couldn't set the quota of " + path + "; ";
+                return false;
+            }
+            return true;
+        }
+
+        /*
+         * The cpu controller's path for the thread, from lines like
+         * "4:cpu,cpuacct:/tfr/move_group"
+         * */
+        std::string cpuGroupOf(pid_t tid)
+        {
+            std::ifstream file{procPath(tid, "cgroup")};
+            std::string line;
+            while (std::getline(file, line))
+            {
+                size_t first = line.find(':');
+                size_t second = line.find(':', first + 1);
+                if (first == std::string::npos || second == std::string::npos)
+                    continue;
+                std::stringstream controllers{line.substr(first + 1, second - first - 1)};
+                std::string controller;
+                while (std::getline(controllers, controller, ','))
+                    if (controller == "cpu")
+                        return line.substr(second + 1);
+            }
+            return "";
+        }
+    }
+
+    std::vector<std::pair<pid_t, std::string>> listThreads(pid_t pid)
+    {
+        std::vector<std::pair<pid_t, std::string>> threads{};
+        std::string task_path = procPath(pid, "task");
+        DIR* tasks = opendir(task_path.c_str());
+        if (tasks == nullptr)
+            return threads;
+        while (dirent* entry = readdir(tasks))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            std::ifstream comm{task_path + "/" + entry->d_name + "/comm"};
+            std::string name;
+            std::getline(comm, name);
+            threads.emplace_back(std::atoi(entry->d_name), name);
+        }
+        closedir(tasks);
+        return threads;
+    }
+
+    bool isNodeProcess(pid_t pid, const std::string& node)
+    {
+        std::ifstream cmdline{procPath(pid, "cmdline")};
+        std::string argument;
+        const std::string expected = "__name:=" + node;
+        while (std::getline(cmdline, argument, '\0'))
+            if (argument == expected)
+                return true;
+        return false;
+    }
+
+    bool applyRule(pid_t tid, const SchedulingRule& rule,
+            const std::string& cgroup_root, std::string& error)
+    {
+        bool ok = true;
+        if (!rule.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (int cpu : rule.cpus)
+                CPU_SET(cpu, &set);
+            if (sched_setaffinity(tid, sizeof(set), &set) != 0)
+            {
+                error += describeError("affinity");
+                ok = false;
+            }
+        }
+
+        sched_param param{};
+        if (rule.policy == SchedulingPolicy::FIFO)
+        {
+            param.sched_priority = rule.priority;
+            if (sched_setscheduler(tid, SCHED_FIFO, &param) != 0)
+            {
+                error += describeError("SCHED_FIFO");
+                ok = false;
+            }
+        }
+        else
+        {
+            if (sched_setscheduler(tid, SCHED_OTHER, &param) != 0)
+            {
+                error += describeError("SCHED_OTHER");
+                ok = false;
+            }
+            //per thread on linux, despite the name
+            if (setpriority(PRIO_PROCESS, tid, rule.nice) != 0)
+            {
+                error += describeError("nice");
+                ok = false;
+            }
+        }
+
+        if (rule.policy == SchedulingPolicy::OTHER && rule.cpu_quota > 0)
+        {
+            //tasks moves a single thread, cgroup.procs would take the process
+            if (!setupGroup(rule, cgroup_root, error) ||
+                    !writeFile(groupPath(cgroup_root, rule.group) + "/tasks",
+                        std::to_string(tid)))
+            {
+                error += "couldn't move the thread into " + rule.group + "; ";
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    bool checkRule(pid_t tid, const SchedulingRule& rule, std::string& report)
+    {
+        bool ok = true;
+        if (!rule.cpus.empty())
+        {
+            cpu_set_t expected, actual;
+            CPU_ZERO(&expected);
+            for (int cpu : rule.cpus)
+                CPU_SET(cpu, &expected);
+            if (sched_getaffinity(tid, sizeof(actual), &actual) != 0 ||
+                    !CPU_EQUAL(&expected, &actual))
+            {
+                report += "affinity differs; ";
+                ok = false;
+            }
+        }
+
+        int policy = sched_getscheduler(tid);
+        if (rule.policy == SchedulingPolicy::FIFO)
+        {
+            sched_param param{};
+            if (policy != SCHED_FIFO || sched_getparam(tid, &param) != 0 ||
+                    param.sched_priority != rule.priority)
+            {
+                report += "not SCHED_FIFO " + std::to_string(rule.priority) + "; ";
+                ok = false;
+            }
+        }
+        else
+        {
+            //-1 is a valid nice value, errno tells it apart from a failure
+            errno = 0;
+            int nice = getpriority(PRIO_PROCESS, tid);
+            if (policy != SCHED_OTHER || errno != 0 || nice != rule.nice)
+            {
+                report += "not SCHED_OTHER at nice " + std::to_string(rule.nice) + "; ";
+                ok = false;
+            }
+            if (rule.cpu_quota > 0 && cpuGroupOf(tid) != "/tfr/" + rule.group)
+            {
+                report += "not in cgroup " + rule.group + "; ";
+                ok = false;
+            }
+        }
+        return ok;
+    }
+}
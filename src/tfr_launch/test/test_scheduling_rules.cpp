@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "scheduling_rules.h"
+
+using tfr_launch::SchedulingPolicy;
+using tfr_launch::SchedulingRule;
+
+namespace
+{
+    //a profile entry as the yaml loads it
+    XmlRpc::XmlRpcValue entry(const std::vector<std::string>& nodes)
+    {
+        XmlRpc::XmlRpcValue value;
+        value["nodes"].setSize(0);
+        for (int i = 0; i < static_cast<int>(nodes.size()); i++)
+            value["nodes"][i] = nodes[i];
+        return value;
+    }
+
+    SchedulingRule rule(const std::vector<std::string>& nodes,
+            const std::string& thread)
+    {
+        return SchedulingRule{nodes, thread, {}, SchedulingPolicy::OTHER, 0, 0, 0.0,
+            nodes.front()};
+    }
+}
+
+TEST(ParseRule, NeedsAListOfNodes)
+{
+    SchedulingRule parsed;
+    XmlRpc::XmlRpcValue number{3};
+    ASSERT_FALSE(tfr_launch::parseRule(number, parsed));
+    XmlRpc::XmlRpcValue nameless;
+    nameless["thread"] = "control";
+    ASSERT_FALSE(tfr_launch::parseRule(nameless, parsed));
+    XmlRpc::XmlRpcValue empty = entry({});
+    ASSERT_FALSE(tfr_launch::parseRule(empty, parsed));
+}
+
+TEST(ParseRule, Defaults)
+{
+    SchedulingRule parsed;
+    XmlRpc::XmlRpcValue value = entry({"move_group", "rviz"});
+    ASSERT_TRUE(tfr_launch::parseRule(value, parsed));
+    ASSERT_EQ(parsed.nodes, (std::vector<std::string>{"move_group", "rviz"}));
+    ASSERT_EQ(parsed.thread, "");
+    ASSERT_TRUE(parsed.cpus.empty());
+    ASSERT_EQ(parsed.policy, SchedulingPolicy::OTHER);
+    ASSERT_EQ(parsed.nice, 0);
+    ASSERT_EQ(parsed.cpu_quota, 0.0);
+    //the quota's group is named after the first node
+    ASSERT_EQ(parsed.group, "move_group");
+}
+
+TEST(ParseRule, Fifo)
+{
+    SchedulingRule parsed;
+    XmlRpc::XmlRpcValue value = entry({"control", "robot_manager"});
+    value["thread"] = "control";
+    value["cpus"][0] = 3;
+    value["policy"] = "fifo";
+    value["priority"] = 80;
+    ASSERT_TRUE(tfr_launch::parseRule(value, parsed));
+    ASSERT_EQ(parsed.thread, "control");
+    ASSERT_EQ(parsed.cpus, std::vector<int>{3});
+    ASSERT_EQ(parsed.policy, SchedulingPolicy::FIFO);
+    ASSERT_EQ(parsed.priority, 80);
+
+    XmlRpc::XmlRpcValue unprioritized = entry({"arduino_a_handler"});
+    unprioritized["policy"] = "fifo";
+    ASSERT_TRUE(tfr_launch::parseRule(unprioritized, parsed));
+    ASSERT_EQ(parsed.priority, 50);
+}
+
+TEST(ParseRule, ParsingResetsTheRule)
+{
+    SchedulingRule parsed;
+    XmlRpc::XmlRpcValue fifo = entry({"control"});
+    fifo["policy"] = "fifo";
+    fifo["cpus"][0] = 3;
+    ASSERT_TRUE(tfr_launch::parseRule(fifo, parsed));
+    XmlRpc::XmlRpcValue other = entry({"move_group"});
+    other["nice"] = 10;
+    ASSERT_TRUE(tfr_launch::parseRule(other, parsed));
+    ASSERT_EQ(parsed.nodes, std::vector<std::string>{"move_group"});
+    ASSERT_EQ(parsed.policy, SchedulingPolicy::OTHER);
+    ASSERT_TRUE(parsed.cpus.empty());
+    ASSERT_EQ(parsed.nice, 10);
+}
+
+TEST(ParseRule, IntegerAndRealQuotas)
+{
+    SchedulingRule parsed;
+    //the yaml gives 1 as an int, which XmlRpcValue won't cast to a double
+    XmlRpc::XmlRpcValue whole = entry({"aruco_action_server"});
+    whole["cpu_quota"] = 1;
+    ASSERT_TRUE(tfr_launch::parseRule(whole, parsed));
+    ASSERT_EQ(parsed.cpu_quota, 1.0);
+
+    XmlRpc::XmlRpcValue part = entry({"aruco_action_server"});
+    part["cpu_quota"] = 0.5;
+    part["group"] = "vision";
+    ASSERT_TRUE(tfr_launch::parseRule(part, parsed));
+    ASSERT_EQ(parsed.cpu_quota, 0.5);
+    ASSERT_EQ(parsed.group, "vision");
+}
+
+TEST(FindRule, ThreadBeatsProcessBeatsDefault)
+{
+    std::vector<SchedulingRule> rules{rule({"*"}, ""), rule({"control"}, ""),
+        rule({"control", "robot_manager"}, "control")};
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "control"), &rules[2]);
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "ctl_services"), &rules[1]);
+    ASSERT_EQ(tfr_launch::findRule(rules, "robot_manager", "control"), &rules[2]);
+    ASSERT_EQ(tfr_launch::findRule(rules, "robot_manager", "ctl_services"), &rules[0]);
+}
+
+TEST(FindRule, PrecedenceDoesntDependOnOrder)
+{
+    std::vector<SchedulingRule> rules{rule({"control"}, "control"),
+        rule({"control"}, ""), rule({"*"}, "")};
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "control"), &rules[0]);
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "ctl_services"), &rules[1]);
+}
+
+TEST(FindRule, NamesMatchExactly)
+{
+    std::vector<SchedulingRule> rules{rule({"control"}, "control")};
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "control"), &rules[0]);
+    ASSERT_EQ(tfr_launch::findRule(rules, "control_2", "control"), nullptr);
+    ASSERT_EQ(tfr_launch::findRule(rules, "contro", "control"), nullptr);
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "control_2"), nullptr);
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", ""), nullptr);
+}
+
+TEST(FindRule, DefaultOnlyCoversNamedNodes)
+{
+    std::vector<SchedulingRule> rules{rule({"control"}, "control"), rule({"*"}, "")};
+    //named by a thread rule is enough
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "ctl_sensors"), &rules[1]);
+    //nodes the profile doesn't name are left alone
+    ASSERT_EQ(tfr_launch::findRule(rules, "rviz", "rviz"), nullptr);
+}
+
+TEST(FindRule, NoDefaultLeavesTheRestAlone)
+{
+    std::vector<SchedulingRule> rules{rule({"control"}, "control")};
+    ASSERT_EQ(tfr_launch::findRule(rules, "control", "ctl_services"), nullptr);
+    ASSERT_EQ(tfr_launch::findRule(std::vector<SchedulingRule>{}, "control", "control"),
+            nullptr);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
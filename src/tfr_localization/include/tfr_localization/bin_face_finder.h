@@ -0,0 +1,105 @@
+#ifndef BIN_FACE_FINDER_H
+#define BIN_FACE_FINDER_H
+#include <random>
+#include <vector>
+#include "landmark_estimator.h"
+#include "scan_matcher.h"
+
+namespace tfr_localization
+{
+    struct FaceConstraints
+    {
+        double bin_width;
+        //accept faces this far from bin_width [m]
+        double width_tolerance;
+        //shortest segment that counts as a wall [m]
+        double wall_length;
+        //ransac line tolerance [m]
+        double inlier_threshold;
+        int min_line_points;
+        //split a line where its points are further apart [m]
+        double max_gap;
+    };
+
+    /*
+     * A straight run of scan points
+     * */
+    struct Segment
+    {
+        double center_x, center_y;
+        //unit vector along the segment
+        double direction_x, direction_y;
+        double length;
+        double rms;
+        int points;
+    };
+
+    struct FaceFix
+    {
+        //center of the face, x pointing out of the bin toward the scanner
+        PlanarPose pose;
+        //row major 3x3 over x, y, yaw
+        double covariance[9];
+        //how wide the face measured [m]
+        double width;
+        //whether a wall behind the face tightened the heading
+        bool used_wall;
+    };
+
+    /**
+     * Finds the face of the collection bin in a 2d scan.
+     *
+     * Straight segments are pulled out of the scan with sequential ransac.
+     * The bin face is the segment closest to the known bin width. If a long
+     * wall runs parallel behind it (the bin sits against the end of the
+     * arena) it is used to tighten the heading.
+     *
+     * Covariance comes from the line fit and how well the measured width
+     * matches. The random sequence is seeded the same every call, so a given
+     * scan always gives the same fix.
+     * */
+    class BinFaceFinder
+    {
+        public:
+            explicit BinFaceFinder(const FaceConstraints& c);
+            ~BinFaceFinder() = default;
+            BinFaceFinder(const BinFaceFinder&) = delete;
+            BinFaceFinder& operator=(const BinFaceFinder&) = delete;
+            BinFaceFinder(BinFaceFinder&&) = delete;
+            BinFaceFinder& operator=(BinFaceFinder&&) = delete;
+
+            /*
+             * Looks for the face in a scan ordered by bearing, the fix is in
+             * the frame of the scan. Returns false if no segment is the width
+             * of the bin.
+             * */
+            bool find(const std::vector<ScanMatcher::Point>& scan, FaceFix& fix);
+
+            /*
+             * The segments found by the last call
+             * */
+            const std::vector<Segment>& getSegments() const { return segments; }
+
+        private:
+            static const int RANSAC_ITERATIONS = 100;
+            static const int MAX_LINES = 6;
+            //a wall further behind the bin face than this isn't the one it is on
+            static constexpr double MAX_WALL_OFFSET = 1.0;
+            static constexpr double MAX_WALL_ANGLE = 0.15;
+
+            const FaceConstraints& constraints;
+            std::mt19937 generator;
+            std::vector<int> remaining, inliers, best_inliers;
+            std::vector<Segment> segments;
+
+            void extractSegments(const std::vector<ScanMatcher::Point>& scan);
+            void splitRuns(const std::vector<ScanMatcher::Point>& scan);
+            Segment fitSegment(const std::vector<ScanMatcher::Point>& scan,
+                    size_t begin, size_t end) const;
+            const Segment* findBinFace() const;
+            const Segment* findWall(const Segment& face) const;
+            void fillFix(const Segment& face, const Segment* wall, FaceFix& fix) const;
+    };
+}
+
+#endif
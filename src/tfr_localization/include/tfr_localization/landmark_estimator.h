@@ -0,0 +1,88 @@
+#ifndef LANDMARK_ESTIMATOR_H
+#define LANDMARK_ESTIMATOR_H
+
+namespace tfr_localization
+{
+    struct PlanarPose
+    {
+        double x;
+        double y;
+        double yaw;
+    };
+
+    struct LandmarkConstraints
+    {
+        //sightings from closer than this count fully, further ones fall off
+        //with the square of the range [m]
+        double reference_range;
+        //caps how much history the estimate holds, so later sightings still
+        //count late in the mission
+        double max_weight;
+        //weight needed before sightings far from the estimate are thrown out
+        double gate_weight;
+        double gate_distance;
+        double gate_angle;
+        //how far the estimate has to move before it's worth republishing
+        double update_distance;
+        double update_angle;
+    };
+
+    /**
+     * Keeps a weighted average of where a landmark (the bin) is from every
+     * sighting of it, instead of trusting whichever one came last.
+     *
+     * Position is a weighted mean, heading a weighted mean of unit vectors so
+     * it wraps properly. Marker pose error grows about with the square of the
+     * range, so that is what the weight falls off with. Once there is enough
+     * weight behind the estimate, sightings too far from it are taken as bad
+     * detections (a flipped board, a partial view) and dropped.
+     *
+     * Sightings are expressed through odometry, so averaging takes out the
+     * noise of the markers, not the drift of the odometry.
+     * */
+    class LandmarkEstimator
+    {
+        public:
+            explicit LandmarkEstimator(const LandmarkConstraints& c);
+            ~LandmarkEstimator() = default;
+            LandmarkEstimator(const LandmarkEstimator&) = delete;
+            LandmarkEstimator& operator=(const LandmarkEstimator&) = delete;
+            LandmarkEstimator(LandmarkEstimator&&) = delete;
+            LandmarkEstimator& operator=(LandmarkEstimator&&) = delete;
+
+            /*
+             * Starts over from a known pose, for when odometry is reset
+             * */
+            void reset(const PlanarPose& pose, double weight);
+
+            /*
+             * Adds a sighting taken from range away, returns false if it was
+             * gated out
+             * */
+            bool addSighting(const PlanarPose& pose, double range);
+
+            bool hasEstimate() const;
+            PlanarPose getEstimate() const;
+            double getWeight() const;
+
+            /*
+             * Gives the estimate if it moved far enough from the last one taken
+             * */
+            bool takeUpdate(PlanarPose& pose);
+
+        private:
+            const LandmarkConstraints& constraints;
+
+            //weighted sums of position and heading vector
+            double sum_x;
+            double sum_y;
+            double sum_cos;
+            double sum_sin;
+            double weight;
+
+            PlanarPose published;
+            bool has_published;
+    };
+}
+
+#endif
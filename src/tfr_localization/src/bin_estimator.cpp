@@ -0,0 +1,196 @@
+/*
+ * Broadcasts where the bin is, refined from every sighting of its markers
+ * instead of the single one localization takes.
+ *
+ * /localize_bin still sets the bin outright, the same as the point
+ * broadcaster it replaces, since localization resets odometry with it. From
+ * there every board sighting localization makes from either camera
+ * (published on bin_sightings) is moved into the parent frame and averaged
+ * in, see LandmarkEstimator. The frame only changes once the estimate has
+ * moved by more than update_distance or update_angle, so the fiducial
+ * odometry isn't chasing noise. The fiducial odometry's own sightings are
+ * left out, it corrects odometry against this frame and would drag the bin
+ * along with the drift.
+ *
+ * parameters:
+ *  - ~parent_frame: frame the bin is estimated in (string, default: "odom")
+ *  - ~point_frame: frame to broadcast (string, default: "bin_footprint")
+ *  - ~service_name: service that sets the bin (string, default: "localize_bin")
+ *  - ~height: height adjustment of the frame [m] (double, default: 0.0)
+ *  - ~hz: how often to broadcast (double, default: 10.0)
+ *  - ~reset_weight: how many full sightings the pose from the service counts
+ *  as (double, default: 3.0)
+ *  - ~reference_range: sightings closer than this count fully [m] (double,
+ *  default: 2.0)
+ *  - ~max_weight: cap on the weight behind the estimate (double, default: 50.0)
+ *  - ~gate_weight: weight needed before outliers are dropped (double, default: 3.0)
+ *  - ~gate_distance: sightings further off are dropped [m] (double, default: 0.5)
+ *  - ~gate_angle: sightings turned further are dropped [rad] (double, default: 0.35)
+ *  - ~update_distance: movement that updates the frame [m] (double, default: 0.02)
+ *  - ~update_angle: rotation that updates the frame [rad] (double, default: 0.01)
+ *
+ * subscribed topics:
+ *  - bin_sightings (geometry_msgs/PoseStamped) board poses in a camera frame
+ * services:
+ *  - /localize_bin (tfr_msgs/PoseSrv) sets the bin, replacing the estimate
+ * */
+#include <ros/ros.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/utils.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_broadcaster.h>
+#include <tfr_msgs/PoseSrv.h>
+#include <tfr_utilities/tf_manipulator.h>
+#include <mutex>
+#include <cmath>
+#include "landmark_estimator.h"
+
+using tfr_localization::PlanarPose;
+
+class BinEstimator
+{
+    public:
+        BinEstimator(ros::NodeHandle &n, const std::string &parent_frame,
+                const std::string &point_frame, const std::string &service_name,
+                const double &h, const double &r_weight,
+                const tfr_localization::LandmarkConstraints &constraints) :
+            estimator{constraints},
+            height{h},
+            reset_weight{r_weight},
+            server{n.advertiseService(service_name, &BinEstimator::localizeBin, this)},
+            subscriber{n.subscribe("bin_sightings", 10, &BinEstimator::addSighting, this)}
+        {
+            transform.header.frame_id = parent_frame;
+            transform.child_frame_id = point_frame;
+            transform.transform.rotation.w = 1;
+        }
+        ~BinEstimator() = default;
+        BinEstimator(const BinEstimator&) = delete;
+        BinEstimator& operator=(const BinEstimator&) = delete;
+        BinEstimator(BinEstimator&&) = delete;
+        BinEstimator& operator=(BinEstimator&&) = delete;
+
+        void broadcast()
+        {
+            std::lock_guard<std::mutex> lock(estimate_mutex);
+            transform.header.stamp = ros::Time::now();
+            broadcaster.sendTransform(transform);
+        }
+
+    private:
+        tfr_localization::LandmarkEstimator estimator;
+        const double &height;
+        const double &reset_weight;
+
+        tf2_ros::TransformBroadcaster broadcaster{};
+        geometry_msgs::TransformStamped transform{};
+        TfManipulator tf_manipulator{};
+        std::mutex estimate_mutex;
+
+        ros::ServiceServer server;
+        ros::Subscriber subscriber;
+
+        /*
+         * Sets the bin outright, localization calls this as it resets
+         * odometry, so the old sightings no longer line up
+         * */
+        bool localizeBin(tfr_msgs::PoseSrv::Request &request,
+                tfr_msgs::PoseSrv::Response &response)
+        {
+            std::lock_guard<std::mutex> lock(estimate_mutex);
+            estimator.reset(toPlanar(request.pose.pose), reset_weight);
+            publishUpdate();
+            return true;
+        }
+
+        void addSighting(const geometry_msgs::PoseStampedConstPtr &sighting)
+        {
+            geometry_msgs::PoseStamped in_parent;
+            if (!tf_manipulator.transform_pose(*sighting, in_parent,
+                        transform.header.frame_id))
+                return;
+
+            const auto& position = sighting->pose.position;
+            double range = std::sqrt(position.x * position.x +
+                    position.y * position.y + position.z * position.z);
+
+            std::lock_guard<std::mutex> lock(estimate_mutex);
+            if (!estimator.addSighting(toPlanar(in_parent.pose), range))
+            {
+                ROS_DEBUG("Bin Estimator: sighting at %f m dropped as an outlier", range);
+                return;
+            }
+            publishUpdate();
+        }
+
+        /*
+         * Moves the frame if the estimate moved enough, needs the lock held
+         * */
+        void publishUpdate()
+        {
+            PlanarPose pose;
+            if (!estimator.takeUpdate(pose))
+                return;
+            transform.transform.translation.x = pose.x;
+            transform.transform.translation.y = pose.y;
+            transform.transform.translation.z = -height;
+            tf2::Quaternion rotation;
+            rotation.setRPY(0, 0, pose.yaw);
+            transform.transform.rotation.x = rotation.x();
+            transform.transform.rotation.y = rotation.y();
+            transform.transform.rotation.z = rotation.z();
+            transform.transform.rotation.w = rotation.w();
+            ROS_INFO("Bin Estimator: bin at %f %f %f, weight %f", pose.x, pose.y,
+                    pose.yaw, estimator.getWeight());
+        }
+
+        static PlanarPose toPlanar(const geometry_msgs::Pose &pose)
+        {
+            tf2::Quaternion rotation;
+            tf2::fromMsg(pose.orientation, rotation);
+            return PlanarPose{pose.position.x, pose.position.y,
+                tf2::getYaw(rotation)};
+        }
+};
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "bin_estimator");
+    ros::NodeHandle n;
+
+    std::string parent_frame, point_frame, service_name;
+    double height, hz, reset_weight;
+    tfr_localization::LandmarkConstraints constraints;
+
+    ros::param::param<std::string>("~parent_frame", parent_frame, "odom");
+    ros::param::param<std::string>("~point_frame", point_frame, "bin_footprint");
+    ros::param::param<std::string>("~service_name", service_name, "localize_bin");
+    ros::param::param<double>("~height", height, 0.0);
+    ros::param::param<double>("~hz", hz, 10.0);
+    ros::param::param<double>("~reset_weight", reset_weight, 3.0);
+    ros::param::param<double>("~reference_range", constraints.reference_range, 2.0);
+    ros::param::param<double>("~max_weight", constraints.max_weight, 50.0);
+    ros::param::param<double>("~gate_weight", constraints.gate_weight, 3.0);
+    ros::param::param<double>("~gate_distance", constraints.gate_distance, 0.5);
+    ros::param::param<double>("~gate_angle", constraints.gate_angle, 0.35);
+    ros::param::param<double>("~update_distance", constraints.update_distance, 0.02);
+    ros::param::param<double>("~update_angle", constraints.update_angle, 0.01);
+
+    BinEstimator estimator{n, parent_frame, point_frame, service_name, height,
+        reset_weight, constraints};
+
+    //sightings come in on their own thread so a slow transform lookup
+    //doesn't hold up the broadcast
+    ros::AsyncSpinner spinner(1);
+    spinner.start();
+
+    ros::Rate rate(hz);
+    while (ros::ok())
+    {
+        estimator.broadcast();
+        rate.sleep();
+    }
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include "bin_face_finder.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tfr_localization
+{
+    namespace
+    {
+        double headingVariance(const Segment& segment)
+        {
+            //slope variance of a least squares line over evenly spread points
+            double rms = std::max(segment.rms, 0.005);
+            return 12 * rms * rms / (segment.points * segment.length * segment.length);
+        }
+    }
+
+    constexpr double BinFaceFinder::MAX_WALL_OFFSET;
+    constexpr double BinFaceFinder::MAX_WALL_ANGLE;
+
+    BinFaceFinder::BinFaceFinder(const FaceConstraints& c) :
+        constraints{c}
+    {
+    }
+
+    bool BinFaceFinder::find(const std::vector<ScanMatcher::Point>& scan, FaceFix& fix)
+    {
+        //the same answer for the same scan, call to call
+        generator.seed();
+        extractSegments(scan);
+        const Segment* face = findBinFace();
+        if (face == nullptr)
+            return false;
+        fillFix(*face, findWall(*face), fix);
+        return true;
+    }
+
+    /*
+     * Sequential ransac, each pass takes the best supported line out of what
+     * is left, then splits its inliers into contiguous runs since a wall and
+     * the bin can be collinear.
+     * */
+    void BinFaceFinder::extractSegments(const std::vector<ScanMatcher::Point>& scan)
+    {
+        segments.clear();
+        remaining.resize(scan.size());
+        for (size_t i = 0; i < scan.size(); ++i)
+            remaining[i] = i;
+
+        for (int line = 0; line < MAX_LINES; ++line)
+        {
+            if (static_cast<int>(remaining.size()) < constraints.min_line_points ||
+                    remaining.empty())
+                return;
+            std::uniform_int_distribution<int> pick(0, remaining.size() - 1);
+            best_inliers.clear();
+            for (int iteration = 0; iteration < RANSAC_ITERATIONS; ++iteration)
+            {
+                const auto& a = scan[remaining[pick(generator)]];
+                const auto& b = scan[remaining[pick(generator)]];
+                double dx = b.x - a.x, dy = b.y - a.y;
+                double length = std::hypot(dx, dy);
+                if (length < 0.1)
+                    continue;
+                //unit normal, distance of a point to the line is the dot
+                double nx = -dy / length, ny = dx / length;
+                inliers.clear();
+                for (int index : remaining)
+                    if (std::abs(nx * (scan[index].x - a.x) + ny * (scan[index].y - a.y))
+                            < constraints.inlier_threshold)
+                        inliers.push_back(index);
+                if (inliers.size() > best_inliers.size())
+                    std::swap(inliers, best_inliers);
+            }
+            if (static_cast<int>(best_inliers.size()) < constraints.min_line_points)
+                return;
+
+            splitRuns(scan);
+
+            //take the line out, both lists are sorted so this is one pass
+            size_t kept = 0, j = 0;
+            for (int index : remaining)
+            {
+                while (j < best_inliers.size() && best_inliers[j] < index)
+                    ++j;
+                if (j < best_inliers.size() && best_inliers[j] == index)
+                    continue;
+                remaining[kept++] = index;
+            }
+            remaining.resize(kept);
+        }
+    }
+
+    /*
+     * Inliers are in bearing order, so a run breaks wherever two neighbours
+     * are further apart than the gap
+     * */
+    void BinFaceFinder::splitRuns(const std::vector<ScanMatcher::Point>& scan)
+    {
+        size_t start = 0;
+        for (size_t i = 1; i <= best_inliers.size(); ++i)
+        {
+            if (i < best_inliers.size())
+            {
+                const auto& a = scan[best_inliers[i - 1]];
+                const auto& b = scan[best_inliers[i]];
+                if (std::hypot(b.x - a.x, b.y - a.y) < constraints.max_gap)
+                    continue;
+            }
+            if (static_cast<int>(i - start) >= constraints.min_line_points)
+                segments.push_back(fitSegment(scan, start, i));
+            start = i;
+        }
+    }
+
+    /*
+     * Total least squares over best_inliers[begin, end)
+     * */
+    Segment BinFaceFinder::fitSegment(const std::vector<ScanMatcher::Point>& scan,
+            size_t begin, size_t end) const
+    {
+        Segment segment;
+        segment.points = end - begin;
+        double mean_x = 0, mean_y = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            mean_x += scan[best_inliers[i]].x;
+            mean_y += scan[best_inliers[i]].y;
+        }
+        mean_x /= segment.points;
+        mean_y /= segment.points;
+
+        double xx = 0, xy = 0, yy = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            double dx = scan[best_inliers[i]].x - mean_x;
+            double dy = scan[best_inliers[i]].y - mean_y;
+            xx += dx * dx;
+            xy += dx * dy;
+            yy += dy * dy;
+        }
+        double angle = 0.5 * std::atan2(2 * xy, xx - yy);
+        segment.direction_x = std::cos(angle);
+        segment.direction_y = std::sin(angle);
+
+        double low = 0, high = 0, squared_error = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            double dx = scan[best_inliers[i]].x - mean_x;
+            double dy = scan[best_inliers[i]].y - mean_y;
+            double along = dx * segment.direction_x + dy * segment.direction_y;
+            double across = -dx * segment.direction_y + dy * segment.direction_x;
+            low = std::min(low, along);
+            high = std::max(high, along);
+            squared_error += across * across;
+        }
+        segment.length = high - low;
+        double middle = (low + high) / 2;
+        segment.center_x = mean_x + middle * segment.direction_x;
+        segment.center_y = mean_y + middle * segment.direction_y;
+        segment.rms = std::sqrt(squared_error / segment.points);
+        return segment;
+    }
+
+    const Segment* BinFaceFinder::findBinFace() const
+    {
+        const Segment* best = nullptr;
+        double best_error = constraints.width_tolerance;
+        for (const auto& segment : segments)
+        {
+            double error = std::abs(segment.length - constraints.bin_width);
+            if (error < best_error)
+            {
+                best_error = error;
+                best = &segment;
+            }
+        }
+        return best;
+    }
+
+    /*
+     * A long segment parallel to the face and just behind it
+     * */
+    const Segment* BinFaceFinder::findWall(const Segment& face) const
+    {
+        double face_range = std::hypot(face.center_x, face.center_y);
+        for (const auto& segment : segments)
+        {
+            if (&segment == &face || segment.length < constraints.wall_length)
+                continue;
+            double cross = face.direction_x * segment.direction_y -
+                face.direction_y * segment.direction_x;
+            if (std::abs(cross) > std::sin(MAX_WALL_ANGLE))
+                continue;
+            //offset along the face normal
+            double offset = std::abs(-face.direction_y * (segment.center_x - face.center_x) +
+                    face.direction_x * (segment.center_y - face.center_y));
+            if (offset < MAX_WALL_OFFSET &&
+                    std::hypot(segment.center_x, segment.center_y) > face_range)
+                return &segment;
+        }
+        return nullptr;
+    }
+
+    void BinFaceFinder::fillFix(const Segment& face, const Segment* wall, FaceFix& fix) const
+    {
+        //the normal pointing back at the scanner is the bin's x axis
+        double nx = -face.direction_y, ny = face.direction_x;
+        if (nx * -face.center_x + ny * -face.center_y < 0)
+        {
+            nx = -nx;
+            ny = -ny;
+        }
+        double yaw = std::atan2(ny, nx);
+        double yaw_variance = headingVariance(face);
+
+        if (wall != nullptr)
+        {
+            //fuse the wall heading, flipped onto the same side
+            double wall_yaw = std::atan2(wall->direction_x, -wall->direction_y);
+            double difference = std::remainder(wall_yaw - yaw, M_PI);
+            double wall_variance = headingVariance(*wall);
+            double weight = yaw_variance / (yaw_variance + wall_variance);
+            yaw += weight * difference;
+            yaw_variance = yaw_variance * wall_variance / (yaw_variance + wall_variance);
+        }
+
+        //across the face we are as good as the fit, along it we are only as
+        //good as the ends of the face, which show up as width error
+        double rms = std::max(face.rms, 0.005);
+        double across = rms * rms / face.points;
+        double width_error = std::abs(face.length - constraints.bin_width) / 2 + rms;
+        double along = width_error * width_error;
+        double c = std::cos(yaw), s = std::sin(yaw);
+        //x is across the face, y along it
+        double xx = c * c * across + s * s * along;
+        double yy = s * s * across + c * c * along;
+        double xy = c * s * (across - along);
+
+        fix.pose = PlanarPose{face.center_x, face.center_y, yaw};
+        double covariance[9] = { xx, xy,            0,
+                                 xy, yy,            0,
+                                  0,  0, yaw_variance };
+        std::copy(covariance, covariance + 9, fix.covariance);
+        fix.width = face.length;
+        fix.used_wall = wall != nullptr;
+    }
+}
@@ -0,0 +1,179 @@
+/*
+ * Fallback localization for when the fiducials can't be seen, finds the face
+ * of the collection bin in the kinect depth data instead.
+ *
+ * The depth image is cut into a 2d scan (see tfr_sensor/depth_scan.h), and
+ * the bin face is found in that by its width, see bin_face_finder.h.
+ *
+ * The fix is the center of the bin face in the footprint frame, with x
+ * pointing out of the bin toward the robot, the same convention the aruco
+ * board gives. Covariance comes from the line fit and how well the measured
+ * width matches.
+ *
+ * parameters:
+ *  - ~footprint_frame: the frame of the robot (string, default: "base_footprint")
+ *  - ~bin_width: width of the bin face (double, default: 1.65)
+ *  - ~width_tolerance: accept faces this far from bin_width (double, default: 0.25)
+ *  - ~wall_length: shortest segment that counts as a wall (double, default: 2.0)
+ *  - ~min_height: lowest point of the scan band (double, default: 0.1)
+ *  - ~max_height: highest point of the scan band (double, default: 0.8)
+ *  - ~max_range: ignore points further than this (double, default: 5.0)
+ *  - ~inlier_threshold: ransac line tolerance in meters (double, default: 0.03)
+ *  - ~min_line_points: fewest points in a segment (int, default: 15)
+ *  - ~max_gap: split a line where its points are further apart (double,
+ *  default: 0.3)
+ *
+ * subscribed topics:
+ *  - depth/image_raw, depth/camera_info : the kinect depth stream
+ * services:
+ *  - /localize_geometry : (tfr_msgs/GeometryFix) pose of the bin face relative
+ *  to the robot from the latest depth image
+ * */
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <tfr_msgs/GeometryFix.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include "depth_scan.h"
+#include "bin_face_finder.h"
+
+using tfr_localization::BinFaceFinder;
+using tfr_localization::FaceConstraints;
+using tfr_localization::FaceFix;
+
+class GeometryLocalizer
+{
+    public:
+        GeometryLocalizer(ros::NodeHandle& n,
+                const std::string& f_frame,
+                const DepthScan::ScanConstraints& s,
+                const FaceConstraints& f) :
+            tf_listener{tf_buffer},
+            image_transport{n},
+            footprint_frame{f_frame},
+            depth_scan{s},
+            face_finder{f}
+        {
+            subscriber = image_transport.subscribeCamera("depth/image_raw", 1,
+                    &GeometryLocalizer::storeDepth, this);
+            server = n.advertiseService("/localize_geometry",
+                    &GeometryLocalizer::localize, this);
+        }
+
+        ~GeometryLocalizer() = default;
+        GeometryLocalizer(const GeometryLocalizer&) = delete;
+        GeometryLocalizer& operator=(const GeometryLocalizer&) = delete;
+        GeometryLocalizer(GeometryLocalizer&&) = delete;
+        GeometryLocalizer& operator=(GeometryLocalizer&&) = delete;
+
+    private:
+        tf2_ros::Buffer tf_buffer;
+        tf2_ros::TransformListener tf_listener;
+        image_transport::ImageTransport image_transport;
+        image_transport::CameraSubscriber subscriber;
+        ros::ServiceServer server;
+        const std::string& footprint_frame;
+
+        DepthScan depth_scan;
+        BinFaceFinder face_finder;
+        sensor_msgs::ImageConstPtr latest_image;
+        sensor_msgs::CameraInfoConstPtr latest_info;
+
+        std::vector<ScanMatcher::Point> scan;
+
+        void storeDepth(const sensor_msgs::ImageConstPtr& image,
+                const sensor_msgs::CameraInfoConstPtr& info)
+        {
+            latest_image = image;
+            latest_info = info;
+        }
+
+        bool localize(tfr_msgs::GeometryFix::Request& request,
+                tfr_msgs::GeometryFix::Response& response)
+        {
+            response.success = false;
+            if (latest_image == nullptr)
+            {
+                ROS_WARN("Geometry Localizer: no depth data yet");
+                return true;
+            }
+
+            geometry_msgs::TransformStamped mount;
+            try
+            {
+                mount = tf_buffer.lookupTransform(footprint_frame,
+                        latest_image->header.frame_id, ros::Time(0));
+            }
+            catch (tf2::TransformException &ex)
+            {
+                ROS_WARN("Geometry Localizer: %s", ex.what());
+                return true;
+            }
+            tf2::Transform transform;
+            tf2::fromMsg(mount.transform, transform);
+            if (!depth_scan.extract(*latest_image, *latest_info, transform, scan))
+                return true;
+
+            FaceFix fix;
+            if (!face_finder.find(scan, fix))
+            {
+                ROS_INFO("Geometry Localizer: %lu segments, no bin face",
+                        face_finder.getSegments().size());
+                return true;
+            }
+            fillPose(fix, response.pose);
+            response.pose.header.stamp = latest_image->header.stamp;
+            response.success = true;
+            ROS_INFO("Geometry Localizer: bin face %f wide at %f %f",
+                    fix.width, fix.pose.x, fix.pose.y);
+            return true;
+        }
+
+        void fillPose(const FaceFix& fix, geometry_msgs::PoseWithCovarianceStamped& pose)
+        {
+            pose.header.frame_id = footprint_frame;
+            pose.pose.pose.position.x = fix.pose.x;
+            pose.pose.pose.position.y = fix.pose.y;
+            pose.pose.pose.position.z = 0;
+            tf2::Quaternion orientation;
+            orientation.setRPY(0, 0, fix.pose.yaw);
+            pose.pose.pose.orientation = tf2::toMsg(orientation);
+            const double* c = fix.covariance;
+            pose.pose.covariance = { c[0], c[1],   0,   0,   0, c[2],
+                                     c[3], c[4],   0,   0,   0, c[5],
+                                        0,    0, 1e3,   0,   0,    0,
+                                        0,    0,   0, 1e3,   0,    0,
+                                        0,    0,   0,   0, 1e3,    0,
+                                     c[6], c[7],   0,   0,   0, c[8] };
+        }
+};
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "geometry_localizer");
+    ros::NodeHandle n{};
+
+    std::string footprint_frame;
+    DepthScan::ScanConstraints scan_constraints;
+    FaceConstraints constraints;
+    ros::param::param<std::string>("~footprint_frame", footprint_frame, "base_footprint");
+    ros::param::param<double>("~bin_width", constraints.bin_width, 1.65);
+    ros::param::param<double>("~width_tolerance", constraints.width_tolerance, 0.25);
+    ros::param::param<double>("~wall_length", constraints.wall_length, 2.0);
+    ros::param::param<double>("~inlier_threshold", constraints.inlier_threshold, 0.03);
+    ros::param::param<int>("~min_line_points", constraints.min_line_points, 15);
+    ros::param::param<double>("~max_gap", constraints.max_gap, 0.3);
+    ros::param::param<double>("~min_height", scan_constraints.min_height, 0.1);
+    ros::param::param<double>("~max_height", scan_constraints.max_height, 0.8);
+    ros::param::param<double>("~max_range", scan_constraints.max_range, 5.0);
+    scan_constraints.column_step = 2;
+    scan_constraints.row_step = 4;
+
+    GeometryLocalizer localizer{n, footprint_frame, scan_constraints, constraints};
+    ros::spin();
+    return 0;
+}
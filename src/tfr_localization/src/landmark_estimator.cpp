@@ -0,0 +1,95 @@
+#include "landmark_estimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tfr_localization
+{
+    namespace
+    {
+        double angleBetween(double a, double b)
+        {
+            return std::abs(std::atan2(std::sin(a - b), std::cos(a - b)));
+        }
+    }
+
+    LandmarkEstimator::LandmarkEstimator(const LandmarkConstraints& c) :
+        constraints{c}, sum_x{0}, sum_y{0}, sum_cos{0}, sum_sin{0}, weight{0},
+        published{0, 0, 0}, has_published{false}
+    {
+    }
+
+    void LandmarkEstimator::reset(const PlanarPose& pose, double w)
+    {
+        weight = w;
+        sum_x = w * pose.x;
+        sum_y = w * pose.y;
+        sum_cos = w * std::cos(pose.yaw);
+        sum_sin = w * std::sin(pose.yaw);
+        //always worth republishing after a reset
+        has_published = false;
+    }
+
+    bool LandmarkEstimator::addSighting(const PlanarPose& pose, double range)
+    {
+        if (weight >= constraints.gate_weight)
+        {
+            PlanarPose estimate = getEstimate();
+            if (std::hypot(pose.x - estimate.x, pose.y - estimate.y) > constraints.gate_distance ||
+                    angleBetween(pose.yaw, estimate.yaw) > constraints.gate_angle)
+                return false;
+        }
+
+        double ratio = constraints.reference_range / std::max(range, 1e-3);
+        double w = std::min(1.0, ratio * ratio);
+
+        //past the cap the history shrinks to make room, so old sightings fade
+        if (weight + w > constraints.max_weight && weight > 0)
+        {
+            double scale = std::max(constraints.max_weight - w, 0.0) / weight;
+            sum_x *= scale;
+            sum_y *= scale;
+            sum_cos *= scale;
+            sum_sin *= scale;
+            weight *= scale;
+        }
+
+        weight += w;
+        sum_x += w * pose.x;
+        sum_y += w * pose.y;
+        sum_cos += w * std::cos(pose.yaw);
+        sum_sin += w * std::sin(pose.yaw);
+        return true;
+    }
+
+    bool LandmarkEstimator::hasEstimate() const
+    {
+        return weight > 0;
+    }
+
+    PlanarPose LandmarkEstimator::getEstimate() const
+    {
+        if (weight <= 0)
+            return PlanarPose{0, 0, 0};
+        return PlanarPose{sum_x / weight, sum_y / weight, std::atan2(sum_sin, sum_cos)};
+    }
+
+    double LandmarkEstimator::getWeight() const
+    {
+        return weight;
+    }
+
+    bool LandmarkEstimator::takeUpdate(PlanarPose& pose)
+    {
+        if (!hasEstimate())
+            return false;
+        PlanarPose estimate = getEstimate();
+        if (has_published &&
+                std::hypot(estimate.x - published.x, estimate.y - published.y) < constraints.update_distance &&
+                angleBetween(estimate.yaw, published.yaw) < constraints.update_angle)
+            return false;
+        published = estimate;
+        has_published = true;
+        pose = estimate;
+        return true;
+    }
+}
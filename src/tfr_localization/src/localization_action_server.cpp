@@ -2,17 +2,29 @@
  * The action server in charge of localizing the robot.
  *
  * Takes in the empty action request, and provides no feedback.
- * Turns until it sees the aruco markers, exits succesfully once it does.
+ * Turns until it sees the aruco markers, exits succesfully once it does. If
+ * the markers can't be found after a few turns it asks the geometry localizer
+ * for a fix off the shape of the bin instead.
  *
  * Needs access to the image wrapper topic wrapper to fetch images, 
  * name is specified as a parameter.
  *
+ * It runs as the tfr_localization/Localizer nodelet.
+ *
+ * The parameters can be tuned live through dynamic_reconfigure
+ * (cfg/Localization.cfg), each pass of the loop reads the latest set.
+ *
  * parameters:
- *  - ~turn_speed: how fast to turn [rad/s] (double, default: 0.0)
+ *  - ~turn_velocity: how fast to turn [rad/s] (double, default: 0.0)
  *  - ~turn_duration: how long to turn [s] (double, default: 0.0)
+ *  - ~yaw_threshold: how close to the target yaw to stop [rad] (double, default: 0.0)
+ *  - ~max_aruco_attempts: failed looks for the markers before falling back
+ *  to /localize_geometry (int, default: 4)
  *
  * published topics:
  *  - /cmd_vel publishes to the drivebase (geometry_msgs/Twist)
+ *  - /bin_sightings every board pose seen, for the bin estimator
+ *  (geometry_msgs/PoseStamped)
  * */
 
 #include <ros/ros.h>
@@ -22,22 +34,38 @@
 #include <tfr_msgs/LocalizationAction.h>
 #include <tfr_msgs/WrappedImage.h>
 #include <tfr_msgs/PoseSrv.h>
+#include <tfr_msgs/GeometryFix.h>
 #include <tfr_utilities/tf_manipulator.h>
+#include <tfr_utilities/snapshot.h>
+#include <tfr_utilities/trace_log.h>
+#include <tfr_localization/LocalizationConfig.h>
+#include <dynamic_reconfigure/server.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <pluginlib/class_list_macros.h>
 #include <geometry_msgs/Twist.h>
 
+struct LocalizationConstraints
+{
+    double turn_velocity;
+    double turn_duration;
+    double yaw_threshold;
+    int max_aruco_attempts;
+};
+
 class Localizer
 {
     public:
-        Localizer(ros::NodeHandle &n, const double& velocity, const double&
-                duration, const double& thresh) : 
+        Localizer(ros::NodeHandle &n, ros::NodeHandle &p_n,
+                const LocalizationConstraints& c) :
             aruco{n, "aruco_action_server"},
             server{n, "localize", boost::bind(&Localizer::localize, this, _1) ,false},
             cmd_publisher{n.advertise<geometry_msgs::Twist>("cmd_vel", 5)},
-            turn_velocity{velocity},
-            turn_duration{duration},
-            threshold{thresh}
+            sighting_publisher{n.advertise<geometry_msgs::PoseStamped>("/bin_sightings", 5)},
+            constraints{c},
+            reconfigure_server{p_n}
 
         {
+            reconfigure_server.setCallback(boost::bind(&Localizer::reconfigure, this, _1, _2));
             ROS_INFO("Localization Action Server: Connecting Aruco");
             aruco.waitForServer();
             ROS_INFO("Localization Action Server: Connected Aruco");
@@ -52,6 +80,7 @@ class Localizer
             while(!front_cam_client.call(request))
                 busy_wait.sleep();
             ROS_INFO("Localization Action Server: Connected Image Clients");
+            geometry_client = n.serviceClient<tfr_msgs::GeometryFix>("/localize_geometry");
             ROS_INFO("Localization Action Server: Starting");
             server.start();
             ROS_INFO("Localization Action Server: Started");
@@ -65,12 +94,20 @@ class Localizer
         actionlib::SimpleActionServer<tfr_msgs::LocalizationAction> server;
         actionlib::SimpleActionClient<tfr_msgs::ArucoAction> aruco;
         ros::Publisher cmd_publisher;
+        ros::Publisher sighting_publisher;
         ros::ServiceClient rear_cam_client;
         ros::ServiceClient front_cam_client;
+        ros::ServiceClient geometry_client;
         TfManipulator tf_manipulator;
-        const double& turn_velocity;
-        const double& turn_duration;
-        const double& threshold;
+        Snapshot<LocalizationConstraints> constraints;
+        dynamic_reconfigure::Server<tfr_localization::LocalizationConfig> reconfigure_server;
+
+        void reconfigure(tfr_localization::LocalizationConfig &config, uint32_t level)
+        {
+            constraints.set(LocalizationConstraints{config.turn_velocity,
+                    config.turn_duration, config.yaw_threshold,
+                    config.max_aruco_attempts});
+        }
 
         void localize( const tfr_msgs::LocalizationGoalConstPtr &goal)
         {
@@ -79,18 +116,20 @@ class Localizer
             bool odometry = goal->set_odometry, success = true, set = false;
 
             geometry_msgs::Twist cmd;
-            cmd.angular.z = turn_velocity;
+            cmd.angular.z = constraints.get().turn_velocity;
             cmd_publisher.publish(cmd);
 
             ROS_INFO("Localization Action Server: odometry %d, target yaw %f",
                     odometry, goal->target_yaw);
 
             tfr_msgs::LocalizationResult output;
+            int failed_attempts = 0;
             //loop
             while (true)
             {
 
-                ROS_INFO("Localization Action Server: iterating");
+                TFR_DEBUG_LIMITED(1.0, "Localization Action Server: iterating");
+                const LocalizationConstraints& limits = constraints.get();
                 if (server.isPreemptRequested())
                 {
                     ROS_INFO("Localization Action Server: preempt requested");
@@ -98,33 +137,54 @@ class Localizer
                     success = false;
                     break;
                 }
+                geometry_msgs::PoseStamped processed_pose;
+                bool found = false;
                 tfr_msgs::ArucoResultConstPtr result = nullptr;
                 tfr_msgs::WrappedImage image_wrapper{};
                 if (rear_cam_client.call(image_wrapper))
                     result = sendAruco(image_wrapper);
-                ROS_INFO("Localization Action Server: rearcam %d", result->number_found);
+                if (result != nullptr)
+                    TFR_DEBUG_LIMITED(0.5, "Localization Action Server: rearcam %d",
+                            result->number_found);
 
-                if (result != nullptr && result->number_found == 0 && front_cam_client.call(image_wrapper))
+                if ((result == nullptr || result->number_found == 0) && front_cam_client.call(image_wrapper))
+                {
                     result = sendAruco(image_wrapper);
+                    if (result != nullptr)
+                        TFR_DEBUG_LIMITED(0.5, "Localization Action Server: frontcam %d",
+                                result->number_found);
+                }
 
-                ROS_INFO("Localization Action Server: frontcam %d", result->number_found);
                 if (result != nullptr && result->number_found > 0)
                 {
-                    //we found something
-                    geometry_msgs::PoseStamped unprocessed_pose = result->relative_pose;
-
+                    sighting_publisher.publish(result->relative_pose);
                     //transform from camera to footprint perspective
-                    geometry_msgs::PoseStamped processed_pose;
-                    if (!tf_manipulator.transform_pose(unprocessed_pose, processed_pose, "base_footprint"))
+                    if (!tf_manipulator.transform_pose(result->relative_pose, processed_pose, "base_footprint"))
                     {
                         ROS_WARN("Localization Action Server: Transform Failed");
                         server.setAborted(output);
                         success = false;
                         break;
                     }
+                    TFR_DEBUG_LIMITED(1.0, "Localization Action Server: transformed");
+                    found = true;
+                    failed_attempts = 0;
+                }
+                else if (++failed_attempts >= limits.max_aruco_attempts)
+                {
+                    //markers are blocked or washed out, try the bin geometry
+                    tfr_msgs::GeometryFix fix{};
+                    if (geometry_client.call(fix) && fix.response.success)
+                    {
+                        ROS_INFO("Localization Action Server: using geometry fix");
+                        processed_pose.header = fix.response.pose.header;
+                        processed_pose.pose = fix.response.pose.pose.pose;
+                        found = true;
+                    }
+                }
 
-                    ROS_INFO("transformed");
-                    
+                if (found)
+                {
                     processed_pose.pose.position.z = 0;
                     processed_pose.header.stamp = ros::Time::now();
 
@@ -146,7 +206,7 @@ class Localizer
                             }
                             else
                             {
-                                ROS_INFO("Localization Action Server: retrying to localize movable point");
+                                TFR_WARN_LIMITED(1.0, "Localization Action Server: retrying to localize movable point");
                             }
                         }
 
@@ -160,8 +220,9 @@ class Localizer
                     auto angle = atan2(siny, cosy);
 
                     auto difference = std::abs(goal->target_yaw) - std::abs(angle);
-                    ROS_INFO("Angle %f Difference %f", angle, difference);
-                    if (std::abs(difference) < threshold)
+                    TFR_INFO_LIMITED(0.5, "Localization Action Server: angle %f difference %f",
+                            angle, difference);
+                    if (std::abs(difference) < limits.yaw_threshold)
                     {
                         if (!set)
                         {
@@ -170,17 +231,17 @@ class Localizer
                         break;
                     }
                 }
-                ROS_INFO("Localization Action Server: turning");
+                TFR_DEBUG_LIMITED(1.0, "Localization Action Server: turning");
 
                 geometry_msgs::Twist cmd;
-                cmd.angular.z = turn_velocity;
+                cmd.angular.z = limits.turn_velocity;
                 cmd_publisher.publish(cmd);
-                ros::Duration(turn_duration).sleep();
-                ROS_INFO("Localization Action Server: stopping");
+                ros::Duration(limits.turn_duration).sleep();
+                TFR_DEBUG_LIMITED(1.0, "Localization Action Server: stopping");
 
                 cmd.angular.z = 0;
                 cmd_publisher.publish(cmd);
-                ros::Duration(turn_duration).sleep();
+                ros::Duration(limits.turn_duration).sleep();
             }
 
             if (success)
@@ -206,17 +267,29 @@ class Localizer
 
 };
 
-int main(int argc, char** argv)
+namespace tfr_localization
 {
-    ros::init(argc, argv, "localization_action_server");
-    ros::NodeHandle n{};
-    double turn_velocity, turn_duration, threshold;
-    ros::param::param<double>("~turn_velocity", turn_velocity, 0.0);
-    ros::param::param<double>("~turn_duration", turn_duration, 0.0);
-    ros::param::param<double>("~yaw_threshold", threshold, 0.0);
-    if (turn_velocity == 0.0 || turn_duration == 0.0)
-        ROS_WARN("Localization Action Server: Uninitialized Parameters");
-    Localizer localizer(n, turn_velocity, turn_duration, threshold);
-    ros::spin();
-    return 0;
+    class LocalizerNodelet : public ComponentNodelet
+    {
+        public:
+            ~LocalizerNodelet() { stop(); }
+
+        private:
+            std::unique_ptr<Localizer> localizer;
+
+            void start() override
+            {
+                ros::NodeHandle &p_n = getPrivateNodeHandle();
+                LocalizationConstraints constraints;
+                p_n.param<double>("turn_velocity", constraints.turn_velocity, 0.0);
+                p_n.param<double>("turn_duration", constraints.turn_duration, 0.0);
+                p_n.param<double>("yaw_threshold", constraints.yaw_threshold, 0.0);
+                p_n.param<int>("max_aruco_attempts", constraints.max_aruco_attempts, 4);
+                if (constraints.turn_velocity == 0.0 || constraints.turn_duration == 0.0)
+                    ROS_WARN("Localization Action Server: Uninitialized Parameters");
+                localizer.reset(new Localizer(getNodeHandle(), p_n, constraints));
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_localization::LocalizerNodelet, nodelet::Nodelet)
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "bin_face_finder.h"
+
+using tfr_localization::BinFaceFinder;
+using tfr_localization::FaceConstraints;
+using tfr_localization::FaceFix;
+
+namespace
+{
+    //the geometry_localizer defaults
+    const FaceConstraints CONSTRAINTS{1.65, 0.25, 2.0, 0.03, 15, 0.3};
+
+    struct Wall
+    {
+        double x_0, y_0, x_1, y_1;
+    };
+
+    /*
+     * What a scanner at the origin sees of the walls, a point every fifth of
+     * a degree across 120 degrees, in bearing order. Every other point is
+     * pushed out a few mm so the fits have something to average.
+     * */
+    std::vector<ScanMatcher::Point> scan(const std::vector<Wall>& walls)
+    {
+        std::vector<ScanMatcher::Point> points;
+        for (int step = -300; step <= 300; ++step)
+        {
+            double bearing = step * M_PI / 900;
+            double dx = std::cos(bearing), dy = std::sin(bearing);
+            double range = std::numeric_limits<double>::infinity();
+            for (const auto& wall : walls)
+            {
+                //solve origin + range * d = wall start + t * (wall end - wall start)
+                double ex = wall.x_1 - wall.x_0, ey = wall.y_1 - wall.y_0;
+                double determinant = dx * -ey + dy * ex;
+                if (std::abs(determinant) < 1e-12)
+                    continue;
+                double r = (wall.x_0 * -ey + wall.y_0 * ex) / determinant;
+                double t = (dx * wall.y_0 - dy * wall.x_0) / determinant;
+                if (r > 0 && t >= 0 && t <= 1)
+                    range = std::min(range, r);
+            }
+            if (std::isinf(range))
+                continue;
+            range += (step % 2 ? 0.004 : -0.004);
+            points.push_back(ScanMatcher::Point{range * dx, range * dy});
+        }
+        return points;
+    }
+
+    //a bin face width wide centered at (x, y), the bin's x axis at yaw
+    Wall face(double x, double y, double yaw, double width)
+    {
+        double along_x = -std::sin(yaw) * width / 2, along_y = std::cos(yaw) * width / 2;
+        return Wall{x - along_x, y - along_y, x + along_x, y + along_y};
+    }
+}
+
+TEST(BinFaceFinder, FindsTheFaceHeadOn)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    FaceFix fix;
+    ASSERT_TRUE(finder.find(scan({face(2.0, 0, M_PI, 1.65)}), fix));
+    ASSERT_NEAR(fix.pose.x, 2.0, 0.01);
+    ASSERT_NEAR(fix.pose.y, 0, 0.02);
+    //x points out of the bin, back at the scanner
+    ASSERT_NEAR(std::cos(fix.pose.yaw), -1, 1e-4);
+    ASSERT_NEAR(fix.width, 1.65, 0.02);
+    ASSERT_FALSE(fix.used_wall);
+    //well placed across the face, less so along it
+    ASSERT_LT(fix.covariance[0], fix.covariance[4]);
+    ASSERT_NEAR(fix.covariance[1], 0, 1e-6);
+    ASSERT_GT(fix.covariance[8], 0);
+}
+
+TEST(BinFaceFinder, FindsTheFaceAtAnAngle)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    FaceFix fix;
+    const double yaw = M_PI + 0.4;
+    ASSERT_TRUE(finder.find(scan({face(2.5, 0.6, yaw, 1.65)}), fix));
+    ASSERT_NEAR(fix.pose.x, 2.5, 0.02);
+    ASSERT_NEAR(fix.pose.y, 0.6, 0.02);
+    ASSERT_NEAR(std::remainder(fix.pose.yaw - yaw, 2 * M_PI), 0, 0.01);
+}
+
+TEST(BinFaceFinder, TightensTheHeadingWithTheWallBehind)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    FaceFix alone, against;
+    ASSERT_TRUE(finder.find(scan({face(2.0, 0, M_PI, 1.65)}), alone));
+    //the end of the arena half a meter behind the face
+    ASSERT_TRUE(finder.find(scan({face(2.0, 0, M_PI, 1.65),
+                    Wall{2.5, -5.0, 2.5, 5.0}}), against));
+    ASSERT_TRUE(against.used_wall);
+    ASSERT_LT(against.covariance[8], alone.covariance[8]);
+    ASSERT_NEAR(std::cos(against.pose.yaw), -1, 1e-4);
+    ASSERT_NEAR(against.pose.x, 2.0, 0.01);
+}
+
+TEST(BinFaceFinder, SplitsFacesOutOfCollinearWalls)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    FaceFix fix;
+    //one line with gaps in it, only the middle run is the bin's width
+    ASSERT_TRUE(finder.find(scan({Wall{2.0, -4.0, 2.0, -1.5},
+                    face(2.0, 0, M_PI, 1.65),
+                    Wall{2.0, 1.5, 2.0, 4.0}}), fix));
+    ASSERT_GE(finder.getSegments().size(), 3u);
+    ASSERT_NEAR(fix.width, 1.65, 0.02);
+    ASSERT_NEAR(fix.pose.y, 0, 0.02);
+}
+
+TEST(BinFaceFinder, IgnoresTheWrongWidth)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    FaceFix fix;
+    ASSERT_FALSE(finder.find(scan({face(2.0, 0, M_PI, 1.0)}), fix));
+    ASSERT_EQ(finder.getSegments().size(), 1u);
+    ASSERT_NEAR(finder.getSegments()[0].length, 1.0, 0.02);
+    //or nothing to see at all
+    ASSERT_FALSE(finder.find({}, fix));
+    ASSERT_TRUE(finder.getSegments().empty());
+}
+
+TEST(BinFaceFinder, RepeatsItself)
+{
+    BinFaceFinder finder{CONSTRAINTS};
+    auto points = scan({face(2.2, -0.3, M_PI - 0.2, 1.65), Wall{3.0, -5.0, 3.5, 5.0}});
+    FaceFix first, second;
+    ASSERT_TRUE(finder.find(points, first));
+    ASSERT_TRUE(finder.find(points, second));
+    ASSERT_EQ(first.pose.x, second.pose.x);
+    ASSERT_EQ(first.pose.y, second.pose.y);
+    ASSERT_EQ(first.pose.yaw, second.pose.yaw);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include "landmark_estimator.h"
+
+using tfr_localization::LandmarkConstraints;
+using tfr_localization::LandmarkEstimator;
+using tfr_localization::PlanarPose;
+
+namespace
+{
+    //the bin_estimator defaults
+    const LandmarkConstraints CONSTRAINTS{2.0, 50.0, 3.0, 0.5, 0.35, 0.02, 0.01};
+}
+
+TEST(LandmarkEstimator, StartsEmpty)
+{
+    LandmarkEstimator estimator{CONSTRAINTS};
+    PlanarPose pose{};
+    ASSERT_FALSE(estimator.hasEstimate());
+    ASSERT_FALSE(estimator.takeUpdate(pose));
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), 0);
+}
+
+TEST(LandmarkEstimator, WeightsByTheSquareOfTheRange)
+{
+    LandmarkEstimator estimator{CONSTRAINTS};
+    //inside the reference range counts fully
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{1.0, 0.0, 0.0}, 1.0));
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), 1.0);
+    //twice as far counts a quarter
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{2.0, 1.0, 0.0}, 4.0));
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), 1.25);
+    PlanarPose estimate = estimator.getEstimate();
+    ASSERT_NEAR(estimate.x, (1.0 + 0.25 * 2.0) / 1.25, 1e-12);
+    ASSERT_NEAR(estimate.y, 0.25 / 1.25, 1e-12);
+    ASSERT_NEAR(estimate.yaw, 0.0, 1e-12);
+}
+
+TEST(LandmarkEstimator, AveragesHeadingAcrossTheWrap)
+{
+    LandmarkEstimator estimator{CONSTRAINTS};
+    estimator.addSighting(PlanarPose{0, 0, M_PI - 0.1}, 1.0);
+    estimator.addSighting(PlanarPose{0, 0, -M_PI + 0.1}, 1.0);
+    ASSERT_NEAR(std::abs(estimator.getEstimate().yaw), M_PI, 1e-9);
+}
+
+TEST(LandmarkEstimator, GatesOutliersOnceConfident)
+{
+    LandmarkEstimator estimator{CONSTRAINTS};
+    //not enough behind the estimate yet, everything counts
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{0, 0, 0}, 1.0));
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{1.0, 0, 0}, 1.0));
+    estimator.reset(PlanarPose{0, 0, 0}, CONSTRAINTS.gate_weight);
+    //too far, too turned
+    ASSERT_FALSE(estimator.addSighting(PlanarPose{0.6, 0, 0}, 1.0));
+    ASSERT_FALSE(estimator.addSighting(PlanarPose{0, 0, 0.4}, 1.0));
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), CONSTRAINTS.gate_weight);
+    ASSERT_DOUBLE_EQ(estimator.getEstimate().x, 0);
+    //inside the gate is fine
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{0.4, 0, 0.3}, 1.0));
+    ASSERT_NEAR(estimator.getEstimate().x, 0.1, 1e-12);
+}
+
+TEST(LandmarkEstimator, CapsTheHistory)
+{
+    LandmarkConstraints constraints = CONSTRAINTS;
+    constraints.max_weight = 4.0;
+    LandmarkEstimator estimator{constraints};
+    estimator.reset(PlanarPose{0, 0, 0}, 4.0);
+    //the old history shrinks to 3 to make room for the new sighting
+    ASSERT_TRUE(estimator.addSighting(PlanarPose{0.4, 0, 0}, 1.0));
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), 4.0);
+    ASSERT_NEAR(estimator.getEstimate().x, 0.1, 1e-12);
+    //so a steady new position takes over in the end
+    for (int i = 0; i < 100; ++i)
+        estimator.addSighting(PlanarPose{0.4, 0, 0}, 1.0);
+    ASSERT_DOUBLE_EQ(estimator.getWeight(), 4.0);
+    ASSERT_NEAR(estimator.getEstimate().x, 0.4, 1e-9);
+}
+
+TEST(LandmarkEstimator, UpdatesOnlyOnRealMoves)
+{
+    LandmarkEstimator estimator{CONSTRAINTS};
+    PlanarPose pose{};
+    estimator.reset(PlanarPose{1.0, 2.0, 0.5}, 3.0);
+    ASSERT_TRUE(estimator.takeUpdate(pose));
+    ASSERT_DOUBLE_EQ(pose.x, 1.0);
+    ASSERT_DOUBLE_EQ(pose.y, 2.0);
+    ASSERT_NEAR(pose.yaw, 0.5, 1e-12);
+    ASSERT_FALSE(estimator.takeUpdate(pose));
+    //moves the mean 1 cm, under update_distance
+    estimator.addSighting(PlanarPose{1.04, 2.0, 0.5}, 1.0);
+    ASSERT_FALSE(estimator.takeUpdate(pose));
+    //and 3 cm from where it was published
+    estimator.addSighting(PlanarPose{1.2, 2.0, 0.5}, 1.0);
+    ASSERT_TRUE(estimator.takeUpdate(pose));
+    ASSERT_NEAR(pose.x, 1.048, 1e-12);
+    //a reset always publishes
+    estimator.reset(pose, 3.0);
+    ASSERT_TRUE(estimator.takeUpdate(pose));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
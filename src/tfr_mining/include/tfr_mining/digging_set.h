@@ -40,8 +40,19 @@ namespace tfr_mining
          * states).
          **/
         double getTimeEstimate();
+
+        /**
+         * Gets the time estimate for the state popState will return next.
+         **/
+        double getNextTimeEstimate();
+
+        /**
+         * Returns how many states are left in this set.
+         **/
+        size_t size();
     private:
         std::queue<std::vector<double> > states;
+        std::queue<double> state_times;
         double time_estimate;
     };
 }
@@ -0,0 +1,126 @@
+/****************************************************************************************
+ * File:            excavation_tracker.h
+ * 
+ * Purpose:         Estimates how much regolith the scoop takes out of the
+ *                  ground and how much of it ends up in the bin, from nothing
+ *                  but the arm joint positions.
+ *
+ *                  The scoop tip is found by forward kinematics of the arm
+ *                  (the same chain as the urdf). While the tip is below the
+ *                  ground it cuts a slot as wide as the scoop, so the volume
+ *                  of a stroke is the area between the ground line and the
+ *                  tip path, in the plane of the arm, times the scoop width,
+ *                  capped by what the scoop can hold. A stroke ends when the
+ *                  tip comes back out. The load is carried until the scoop
+ *                  tips past the dump angle, it only counts as payload if
+ *                  the turntable is over the bin at that point.
+ ***************************************************************************************/
+#ifndef EXCAVATION_TRACKER_H
+#define EXCAVATION_TRACKER_H
+
+#include <vector>
+
+namespace tfr_mining
+{
+    class ExcavationTracker
+    {
+    public:
+        /**
+         * Link offsets of the arm in meters, in the frame of the joint they
+         * hang off, defaults match tfr_description
+         **/
+        struct ArmGeometry
+        {
+            //turntable axis in the footprint frame
+            double turntable_x, turntable_z;
+            //lower arm pivot in the turntable
+            double lower_x, lower_z;
+            double lower_length;
+            //scoop pivot in the upper arm
+            double scoop_x, scoop_z;
+            //pivot to cutting edge
+            double scoop_length;
+            double scoop_width;
+        };
+
+        struct ExcavationConstraints
+        {
+            //height of the undisturbed surface in the footprint frame
+            double ground_height;
+            //largest load the scoop can hold in m^3
+            double scoop_capacity;
+            //fraction of a full cut which stays in the scoop
+            double fill_factor;
+            //scoop angles below this tip the load out
+            double dump_angle;
+            //turntable angles within this of zero are over the bin
+            double bin_tolerance;
+        };
+
+        enum class Event
+        {
+            NONE,
+            STROKE,
+            BIN_DUMP,
+            SIDE_DUMP
+        };
+
+        ExcavationTracker(const ArmGeometry& g, const ExcavationConstraints& c);
+        ~ExcavationTracker() = default;
+        ExcavationTracker(const ExcavationTracker&) = delete;
+        ExcavationTracker& operator=(const ExcavationTracker&) = delete;
+        ExcavationTracker(ExcavationTracker&&) = delete;
+        ExcavationTracker& operator=(ExcavationTracker&&) = delete;
+
+        /**
+         * Takes the next arm state (turntable, lower arm, upper arm, scoop)
+         * and reports whether a stroke or a dump just finished.
+         **/
+        Event update(const std::vector<double>& joints);
+
+        /**
+         * Position of the scoop cutting edge in the footprint frame.
+         **/
+        void scoopTip(const std::vector<double>& joints, double& x, double& y, double& z) const;
+
+        /**
+         * Replaces the kinematic estimate of everything dug since the last
+         * call with a measured volume, the payload from that period is scaled
+         * by the same ratio.
+         **/
+        void correct(double measured);
+
+        /**
+         * Empties the bin, the excavated total is kept.
+         **/
+        void resetPayload();
+
+        double getExcavated() const;
+        double getPayload() const;
+        double getCarried() const;
+        double getLastStroke() const;
+        int getStrokes() const;
+
+    private:
+        const ArmGeometry& geometry;
+        const ExcavationConstraints& constraints;
+
+        bool cutting;
+        double last_reach, last_depth, last_scoop;
+        //cross section of the current cut in m^2
+        double stroke_area;
+
+        double excavated, payload, carried, last_stroke;
+        //kinematic totals since the last correction
+        double excavated_since, payload_since;
+        int strokes;
+
+        /**
+         * Distance of the cutting edge from the turntable axis and its height,
+         * in the plane of the arm.
+         **/
+        void planarTip(const std::vector<double>& joints, double& reach, double& z) const;
+    };
+}
+
+#endif // EXCAVATION_TRACKER_H
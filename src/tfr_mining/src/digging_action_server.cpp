@@ -1,6 +1,6 @@
 /****************************************************************************************
  * File:    digging_action_server.cpp
- * Node:    digging_server
+ * Node:    digging_server, runs as the tfr_mining/DiggingActionServer nodelet
  * 
  * Purpose: This is an action server that handles all of the digging subsystem.
  * 
@@ -13,6 +13,14 @@
  *              devel/include/tfr_msgs/DiggingFeedback.h
  *              devel/include/tfr_msgs/DiggingGoal.h
  *              devel/include/tfr_msgs/DiggingResult.h
+ *
+ *          Digging stops early once /mining_status reports the bin full. If
+ *          the dig site survey is up it is called before and after, so the
+ *          payload estimate gets corrected from the kinect.
+ *
+ *          Feedback goes out as each state finishes: which set and state,
+ *          the time planned for it against the time it took, and how many
+ *          scoops (whole sets) are done.
  * 
  ***************************************************************************************/
 
@@ -20,10 +28,15 @@
 #include <actionlib/client/simple_action_client.h>
 #include <tfr_msgs/DiggingAction.h>  // Note: "Action" is appended
 #include <tfr_msgs/ArmMoveAction.h>  // Note: "Action" is appended
+#include <tfr_msgs/MiningStatus.h>
+#include <std_srvs/Trigger.h>
 #include <tfr_utilities/arm_manipulator.h>
 #include <geometry_msgs/Twist.h>
 #include <tfr_utilities/teleop_code.h>
-#include <actionlib/client/simple_action_client.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <tfr_utilities/trace_log.h>
+#include <pluginlib/class_list_macros.h>
+#include <mutex>
 #include "digging_queue.h"
 
 typedef actionlib::SimpleActionServer<tfr_msgs::DiggingAction> Server;
@@ -36,7 +49,10 @@ public:
         drivebase_publisher{nh.advertise<geometry_msgs::Twist>("cmd_vel", 5)},
         server{nh, "dig", boost::bind(&DiggingActionServer::execute, this, _1),
             false},
-        arm_manipulator{nh}
+        arm_manipulator{nh},
+        status_subscriber{nh.subscribe("/mining_status", 5,
+                &DiggingActionServer::updateStatus, this)},
+        sets_started{0}
 
     {
         server.start();
@@ -57,10 +73,26 @@ private:
         client.waitForServer();
         ROS_DEBUG("Connected with arm action server");
 
+        std_srvs::Trigger survey;
+        ros::service::call("/survey_dig_site", survey);
+
+        tfr_msgs::DiggingResult result;
+        tfr_msgs::DiggingFeedback feedback;
+        feedback.scoops = 0;
         while (!queue.isEmpty())
         {
-            ROS_INFO("Time remaining: %f", (endTime - ros::Time::now()).toSec());
+            if (getStatus().full)
+            {
+                ROS_INFO("Bin is full with %f m^3, done digging", getStatus().payload_volume);
+                result.full = true;
+                break;
+            }
+
+            TFR_INFO_LIMITED(1.0, "Time remaining: %f", (endTime - ros::Time::now()).toSec());
             tfr_mining::DiggingSet set = queue.popDiggingSet();
+            feedback.set_index = sets_started++;
+            feedback.set_states = set.size();
+            feedback.state_index = 0;
             ros::Time now = ros::Time::now();
 
             ROS_INFO("starting set");
@@ -74,6 +106,8 @@ private:
 
             while (!set.isEmpty())
             {
+                ros::Time state_start = ros::Time::now();
+                feedback.planned = ros::Duration{set.getNextTimeEstimate()};
                 std::vector<double> state = set.popState();
                 tfr_msgs::ArmMoveGoal goal;
                 goal.pose.resize(5);
@@ -82,7 +116,8 @@ private:
                 goal.pose[2] = state[2];
                 goal.pose[3] = state[3];
 
-                ROS_INFO("goal %f %f %f %f", goal.pose[0], goal.pose[1], goal.pose[2], goal.pose[3]);
+                TFR_INFO_LIMITED(1.0, "goal %f %f %f %f", goal.pose[0], goal.pose[1],
+                        goal.pose[2], goal.pose[3]);
 
                 client.sendGoal(goal);
                 ros::Rate rate(10.0);
@@ -132,6 +167,14 @@ private:
                 {
                     ros::Duration(0.5).sleep(); 
                 }
+
+                ros::Time state_end = ros::Time::now();
+                feedback.actual = state_end - state_start;
+                feedback.remaining = endTime - state_end;
+                if (set.isEmpty())
+                    feedback.scoops++;
+                server.publishFeedback(feedback);
+                feedback.state_index++;
             }
         }
         ROS_WARN("Moving arm to final position, exiting.");
@@ -141,26 +184,57 @@ private:
         ros::Duration(3.0).sleep();
         arm_manipulator.moveArm(0, 0.50, 1.07, 1.6);
 
-        tfr_msgs::DiggingResult result;
+        ros::service::call("/survey_dig_site", survey);
+        result.payload_volume = getStatus().payload_volume;
         server.setSucceeded(result);
     }
 
 
+    /*
+     * Keeps the latest payload estimate from mining_analytics, comes in on
+     * the spinner while execute runs on the action server's thread
+     * */
+    void updateStatus(const tfr_msgs::MiningStatusConstPtr &msg)
+    {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        status = *msg;
+    }
+
+    tfr_msgs::MiningStatus getStatus()
+    {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        return status;
+    }
+
     ros::NodeHandle &priv_nh;
     ros::Publisher drivebase_publisher;
  
     ArmManipulator arm_manipulator;
     tfr_mining::DiggingQueue queue;
     Server server;
+    ros::Subscriber status_subscriber;
+    std::mutex status_mutex;
+    tfr_msgs::MiningStatus status;
+    //sets taken off the queue so far, the queue isn't refilled between goals
+    uint32_t sets_started;
 };
 
-int main(int argc, char** argv)
+namespace tfr_mining
 {
-    ros::init(argc, argv, "digging_server");
-    ros::NodeHandle n;
-    ros::NodeHandle p_n("~");
+    class DiggingNodelet : public ComponentNodelet
+    {
+        public:
+            ~DiggingNodelet() { stop(); }
+
+        private:
+            std::unique_ptr<DiggingActionServer> server;
 
-    DiggingActionServer server(n, p_n);
-    ros::spin();
-    return 0;
+            void start() override
+            {
+                server.reset(new DiggingActionServer(getNodeHandle(),
+                            getPrivateNodeHandle()));
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_mining::DiggingNodelet, nodelet::Nodelet)
@@ -2,7 +2,7 @@
 
 namespace tfr_mining
 {
-    DiggingSet::DiggingSet() : states{}, time_estimate{0}
+    DiggingSet::DiggingSet() : states{}, state_times{}, time_estimate{0}
     {
 
     }
@@ -10,6 +10,7 @@ namespace tfr_mining
     void DiggingSet::insertState(std::vector<double> state, double time)
     {
         states.push(state);
+        state_times.push(time);
         time_estimate += time;
     }
 
@@ -22,6 +23,7 @@ namespace tfr_mining
     {
         std::vector<double> state = states.front();
         states.pop();
+        state_times.pop();
         return state;
     }
 
@@ -29,4 +31,14 @@ namespace tfr_mining
     {
         return time_estimate;
     }
+
+    double DiggingSet::getNextTimeEstimate()
+    {
+        return state_times.front();
+    }
+
+    size_t DiggingSet::size()
+    {
+        return states.size();
+    }
 }
@@ -0,0 +1,147 @@
+#include "excavation_tracker.h"
+#include <algorithm>
+#include <cmath>
+
+namespace tfr_mining
+{
+    ExcavationTracker::ExcavationTracker(const ArmGeometry& g,
+            const ExcavationConstraints& c) :
+        geometry{g}, constraints{c}, cutting{false}, last_reach{0},
+        last_depth{0}, last_scoop{0}, stroke_area{0}, excavated{0}, payload{0}, carried{0},
+        last_stroke{0}, excavated_since{0}, payload_since{0}, strokes{0}
+    {
+    }
+
+    ExcavationTracker::Event ExcavationTracker::update(const std::vector<double>& joints)
+    {
+        if (joints.size() < 4)
+            return Event::NONE;
+
+        double reach, z;
+        planarTip(joints, reach, z);
+        double depth = constraints.ground_height - z;
+
+        if (depth > 0)
+        {
+            //trapezoid between the ground line and the tip path
+            if (cutting)
+                stroke_area += 0.5 * (depth + last_depth) * std::abs(reach - last_reach);
+            else
+                stroke_area = 0;
+            cutting = true;
+            last_scoop = joints[3];
+            last_reach = reach;
+            last_depth = depth;
+            return Event::NONE;
+        }
+
+        if (cutting)
+        {
+            //close the cut out to where the tip crossed the surface
+            stroke_area += 0.5 * last_depth * std::abs(reach - last_reach) *
+                last_depth / (last_depth - depth);
+            cutting = false;
+            last_scoop = joints[3];
+            double volume = std::min(stroke_area * geometry.scoop_width,
+                    constraints.scoop_capacity);
+            last_stroke = volume;
+            excavated += volume;
+            excavated_since += volume;
+            carried = std::min(carried + volume * constraints.fill_factor,
+                    constraints.scoop_capacity);
+            ++strokes;
+            return Event::STROKE;
+        }
+
+        //the scoop is still tipped forward right after a cut, only count
+        //it tipping back over once it has been curled up
+        bool tipped = last_scoop >= constraints.dump_angle && joints[3] < constraints.dump_angle;
+        last_scoop = joints[3];
+        if (carried > 0 && tipped)
+        {
+            double load = carried;
+            carried = 0;
+            if (std::abs(std::remainder(joints[0], 2 * M_PI)) < constraints.bin_tolerance)
+            {
+                payload += load;
+                payload_since += load;
+                return Event::BIN_DUMP;
+            }
+            return Event::SIDE_DUMP;
+        }
+        return Event::NONE;
+    }
+
+    void ExcavationTracker::planarTip(const std::vector<double>& joints,
+            double& reach, double& z) const
+    {
+        //each joint pitches about y, so a link along (x, z) in its own frame
+        //is (x cos + z sin, z cos - x sin) in the turntable plane
+        double pitch = joints[1];
+        double x_0 = geometry.lower_x, z_0 = geometry.lower_z;
+        x_0 += geometry.lower_length * std::sin(pitch);
+        z_0 += geometry.lower_length * std::cos(pitch);
+        pitch += joints[2];
+        x_0 += geometry.scoop_x * std::cos(pitch) + geometry.scoop_z * std::sin(pitch);
+        z_0 += geometry.scoop_z * std::cos(pitch) - geometry.scoop_x * std::sin(pitch);
+        pitch += joints[3];
+        x_0 += geometry.scoop_length * std::cos(pitch);
+        z_0 -= geometry.scoop_length * std::sin(pitch);
+        reach = x_0;
+        z = geometry.turntable_z + z_0;
+    }
+
+    void ExcavationTracker::scoopTip(const std::vector<double>& joints,
+            double& x, double& y, double& z) const
+    {
+        double reach;
+        planarTip(joints, reach, z);
+        //the turntable is mounted facing backwards
+        double yaw = M_PI + joints[0];
+        x = geometry.turntable_x + reach * std::cos(yaw);
+        y = reach * std::sin(yaw);
+    }
+
+    void ExcavationTracker::correct(double measured)
+    {
+        if (excavated_since > 0)
+        {
+            double ratio = measured / excavated_since;
+            payload += payload_since * (ratio - 1);
+        }
+        excavated += measured - excavated_since;
+        excavated_since = 0;
+        payload_since = 0;
+    }
+
+    void ExcavationTracker::resetPayload()
+    {
+        payload = 0;
+        payload_since = 0;
+    }
+
+    double ExcavationTracker::getExcavated() const
+    {
+        return excavated;
+    }
+
+    double ExcavationTracker::getPayload() const
+    {
+        return payload;
+    }
+
+    double ExcavationTracker::getCarried() const
+    {
+        return carried;
+    }
+
+    double ExcavationTracker::getLastStroke() const
+    {
+        return last_stroke;
+    }
+
+    int ExcavationTracker::getStrokes() const
+    {
+        return strokes;
+    }
+}
@@ -0,0 +1,316 @@
+/****************************************************************************************
+ * File:    mining_analytics.cpp
+ * Node:    mining_analytics
+ * 
+ * Purpose: Keeps a running estimate of how much regolith has been dug and how
+ *          much of it is in the bin, so digging can stop on a full bin instead
+ *          of only on time.
+ *
+ *          Every arm state goes through the excavation tracker (see
+ *          excavation_tracker.h), which works out the volume of each stroke
+ *          from the arm kinematics. Optionally the dig site can be surveyed
+ *          with the kinect, the first survey is the before picture and each
+ *          one after that measures what was removed since, which replaces
+ *          the kinematic estimate for that period.
+ *
+ * Parameters:
+ *  - ~ground_height: surface height in the footprint frame [m] (double, default: 0.0)
+ *  - ~scoop_capacity: most the scoop holds [m^3] (double, default: 0.0085)
+ *  - ~fill_factor: fraction of a cut that stays in the scoop (double, default: 0.8)
+ *  - ~dump_angle: scoop angle that tips the load out [rad] (double, default: -0.5)
+ *  - ~bin_tolerance: turntable angle from zero that is over the bin [rad]
+ *    (double, default: 0.35)
+ *  - ~bin_capacity: payload that counts as a full bin [m^3] (double, default: 0.11)
+ *  - ~regolith_density: [kg/m^3] (double, default: 1500.0)
+ *  - ~use_depth: allow kinect surveys of the dig site (bool, default: false)
+ *  - ~footprint_frame: (string, default: "base_footprint")
+ *  - ~site_min_x, ~site_max_x, ~site_min_y, ~site_max_y: the dig site box in
+ *    the footprint frame [m] (double, default: 0.6, 1.8, -0.6, 0.6)
+ *  - ~site_resolution: grid cell size [m] (double, default: 0.05)
+ *  - ~survey_frames: depth frames averaged per survey (int, default: 10)
+ *
+ * Subscribed topics:
+ *  - /joint_states: (sensor_msgs/JointState) the arm joints
+ *  - depth/image_raw, depth/camera_info: the kinect, only with ~use_depth
+ * Published topics:
+ *  - /mining_status: (tfr_msgs/MiningStatus) latched, on every stroke and dump
+ * Services:
+ *  - /survey_dig_site: (std_srvs/Trigger) measures the dig site
+ *  - /reset_payload: (std_srvs/Empty) call once the bin is emptied
+ ***************************************************************************************/
+#include <ros/ros.h>
+#include <sensor_msgs/JointState.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <std_srvs/Trigger.h>
+#include <std_srvs/Empty.h>
+#include <tfr_msgs/MiningStatus.h>
+#include <image_transport/image_transport.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include <tfr_sensor/elevation_grid.h>
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include "excavation_tracker.h"
+
+class MiningAnalytics
+{
+public:
+    MiningAnalytics(ros::NodeHandle &n,
+            const tfr_mining::ExcavationTracker::ArmGeometry &g,
+            const tfr_mining::ExcavationTracker::ExcavationConstraints &c,
+            const ElevationGrid::GridConstraints &s,
+            const std::string &f_frame, const double &capacity,
+            const double &density, const int &frames, const bool &use_depth) :
+        tracker{g, c},
+        before{s},
+        after{s},
+        tf_listener{tf_buffer},
+        image_transport{n},
+        footprint_frame{f_frame},
+        bin_capacity{capacity},
+        regolith_density{density},
+        survey_frames{frames},
+        surveyed{false},
+        frames_needed{0},
+        joints(4, 0.0),
+        joint_index(4, -1)
+    {
+        status_publisher = n.advertise<tfr_msgs::MiningStatus>("/mining_status", 5, true);
+        joint_subscriber = n.subscribe("/joint_states", 50, &MiningAnalytics::updateArm, this);
+        reset_server = n.advertiseService("/reset_payload", &MiningAnalytics::resetPayload, this);
+        if (use_depth)
+        {
+            depth_subscriber = image_transport.subscribeCamera("depth/image_raw", 1,
+                    &MiningAnalytics::addDepth, this);
+            survey_server = n.advertiseService("/survey_dig_site",
+                    &MiningAnalytics::survey, this);
+        }
+        std::lock_guard<std::mutex> lock(status_mutex);
+        publish();
+    }
+    ~MiningAnalytics() = default;
+    MiningAnalytics(const MiningAnalytics&) = delete;
+    MiningAnalytics& operator=(const MiningAnalytics&) = delete;
+    MiningAnalytics(MiningAnalytics&&) = delete;
+    MiningAnalytics& operator=(MiningAnalytics&&) = delete;
+
+private:
+    const std::vector<std::string> ARM_JOINTS{"turntable_joint",
+        "lower_arm_joint", "upper_arm_joint", "scoop_joint"};
+
+    tfr_mining::ExcavationTracker tracker;
+    ElevationGrid before, after;
+    tf2_ros::Buffer tf_buffer;
+    tf2_ros::TransformListener tf_listener;
+    image_transport::ImageTransport image_transport;
+    image_transport::CameraSubscriber depth_subscriber;
+    ros::Subscriber joint_subscriber;
+    ros::Publisher status_publisher;
+    ros::ServiceServer survey_server, reset_server;
+
+    const std::string &footprint_frame;
+    const double &bin_capacity;
+    const double &regolith_density;
+    const int &survey_frames;
+
+    //guards the survey between the service and image callbacks
+    std::mutex survey_mutex;
+    //guards the tracker and the status message, the spinner runs the joint
+    //callback and both services on different threads
+    std::mutex status_mutex;
+    bool surveyed;
+    int frames_needed;
+
+    std::vector<double> joints;
+    //where each arm joint sits in the joint state message
+    std::vector<int> joint_index;
+    tfr_msgs::MiningStatus status;
+
+    void updateArm(const sensor_msgs::JointStateConstPtr &msg)
+    {
+        for (size_t i = 0; i < ARM_JOINTS.size(); ++i)
+        {
+            int index = joint_index[i];
+            if (index < 0 || index >= static_cast<int>(msg->name.size()) ||
+                    msg->name[index] != ARM_JOINTS[i])
+            {
+                auto found = std::find(msg->name.begin(), msg->name.end(), ARM_JOINTS[i]);
+                if (found == msg->name.end())
+                    return;
+                index = joint_index[i] = found - msg->name.begin();
+            }
+            joints[i] = msg->position[index];
+        }
+
+        using Event = tfr_mining::ExcavationTracker::Event;
+        std::lock_guard<std::mutex> lock(status_mutex);
+        Event event = tracker.update(joints);
+        if (event == Event::NONE)
+            return;
+        if (event == Event::STROKE)
+            ROS_INFO("Mining Analytics: stroke %d cut %f m^3", tracker.getStrokes(),
+                    tracker.getLastStroke());
+        else if (event == Event::BIN_DUMP)
+            ROS_INFO("Mining Analytics: dumped into bin, payload %f m^3", tracker.getPayload());
+        publish();
+    }
+
+    /*
+     * Call with status_mutex held
+     * */
+    void publish()
+    {
+        status.header.stamp = ros::Time::now();
+        status.excavated_volume = tracker.getExcavated();
+        status.payload_volume = tracker.getPayload();
+        status.payload_mass = tracker.getPayload() * regolith_density;
+        status.carried_volume = tracker.getCarried();
+        status.last_stroke_volume = tracker.getLastStroke();
+        status.strokes = tracker.getStrokes();
+        status.full = tracker.getPayload() >= bin_capacity;
+        status_publisher.publish(status);
+    }
+
+    /*
+     * Accumulates depth frames while a survey is waiting on them
+     * */
+    void addDepth(const sensor_msgs::ImageConstPtr &image,
+            const sensor_msgs::CameraInfoConstPtr &info)
+    {
+        std::lock_guard<std::mutex> lock(survey_mutex);
+        if (frames_needed == 0)
+            return;
+        geometry_msgs::TransformStamped mount;
+        try
+        {
+            mount = tf_buffer.lookupTransform(footprint_frame,
+                    image->header.frame_id, ros::Time(0));
+        }
+        catch (tf2::TransformException &ex)
+        {
+            ROS_WARN_THROTTLE(5, "Mining Analytics: %s", ex.what());
+            return;
+        }
+        tf2::Transform transform;
+        tf2::fromMsg(mount.transform, transform);
+        if (after.add(*image, *info, transform))
+            --frames_needed;
+    }
+
+    /*
+     * Takes a fresh grid of the dig site, and if there is an earlier one
+     * corrects the estimate with what was removed in between
+     * */
+    bool survey(std_srvs::Trigger::Request &request, std_srvs::Trigger::Response &response)
+    {
+        {
+            std::lock_guard<std::mutex> lock(survey_mutex);
+            after.clear();
+            frames_needed = survey_frames;
+        }
+        //the depth callback runs on its own spinner thread
+        ros::Rate rate(30);
+        ros::Time timeout = ros::Time::now() + ros::Duration(2.0);
+        while (ros::ok() && ros::Time::now() < timeout)
+        {
+            {
+                std::lock_guard<std::mutex> lock(survey_mutex);
+                if (frames_needed == 0)
+                    break;
+            }
+            rate.sleep();
+        }
+
+        std::lock_guard<std::mutex> lock(survey_mutex);
+        if (frames_needed > 0)
+        {
+            frames_needed = 0;
+            response.success = false;
+            response.message = "no depth data";
+            return true;
+        }
+
+        std::stringstream message;
+        if (surveyed)
+        {
+            double removed = after.removedSince(before);
+            message << "removed " << removed << " m^3 over "
+                << after.getCoverage() * 100 << "% of the site";
+            std::lock_guard<std::mutex> status_lock(status_mutex);
+            tracker.correct(removed);
+            publish();
+        }
+        else
+            message << "baseline over " << after.getCoverage() * 100 << "% of the site";
+        before.swap(after);
+        surveyed = true;
+        response.success = true;
+        response.message = message.str();
+        ROS_INFO("Mining Analytics: %s", response.message.c_str());
+        return true;
+    }
+
+    bool resetPayload(std_srvs::Empty::Request &request, std_srvs::Empty::Response &response)
+    {
+        std::lock_guard<std::mutex> lock(status_mutex);
+        tracker.resetPayload();
+        publish();
+        return true;
+    }
+};
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "mining_analytics");
+    ros::NodeHandle n;
+
+    const double itom = 0.0254;
+    tfr_mining::ExcavationTracker::ArmGeometry geometry;
+    //from tfr_description, base_link sits 0.15 above the footprint
+    geometry.turntable_x = 50 * itom / 2 - 4.92 * itom;
+    geometry.turntable_z = 0.15 + 2 * itom;
+    geometry.lower_x = -2.165 * itom;
+    geometry.lower_z = 2.25 * itom;
+    geometry.lower_length = 22 * itom;
+    geometry.scoop_x = 1.5 * itom;
+    geometry.scoop_z = 20 * itom - 0.875 * itom;
+    geometry.scoop_length = 12 * itom;
+    geometry.scoop_width = 8.5 * itom;
+
+    tfr_mining::ExcavationTracker::ExcavationConstraints constraints;
+    ros::param::param<double>("~ground_height", constraints.ground_height, 0.0);
+    ros::param::param<double>("~scoop_capacity", constraints.scoop_capacity, 0.0085);
+    ros::param::param<double>("~fill_factor", constraints.fill_factor, 0.8);
+    ros::param::param<double>("~dump_angle", constraints.dump_angle, -0.5);
+    ros::param::param<double>("~bin_tolerance", constraints.bin_tolerance, 0.35);
+
+    double bin_capacity, regolith_density;
+    ros::param::param<double>("~bin_capacity", bin_capacity, 0.11);
+    ros::param::param<double>("~regolith_density", regolith_density, 1500.0);
+
+    bool use_depth;
+    int survey_frames;
+    std::string footprint_frame;
+    ElevationGrid::GridConstraints site;
+    ros::param::param<bool>("~use_depth", use_depth, false);
+    ros::param::param<std::string>("~footprint_frame", footprint_frame, "base_footprint");
+    ros::param::param<double>("~site_min_x", site.min_x, 0.6);
+    ros::param::param<double>("~site_max_x", site.max_x, 1.8);
+    ros::param::param<double>("~site_min_y", site.min_y, -0.6);
+    ros::param::param<double>("~site_max_y", site.max_y, 0.6);
+    ros::param::param<double>("~site_resolution", site.resolution, 0.05);
+    ros::param::param<int>("~survey_frames", survey_frames, 10);
+    site.pixel_step = 2;
+    site.min_samples = 3;
+
+    MiningAnalytics analytics{n, geometry, constraints, site, footprint_frame,
+        bin_capacity, regolith_density, survey_frames, use_depth};
+
+    //surveys block their callback waiting on depth frames
+    ros::AsyncSpinner spinner(2);
+    spinner.start();
+    ros::waitForShutdown();
+    return 0;
+}
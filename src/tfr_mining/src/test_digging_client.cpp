@@ -64,7 +64,10 @@ char getch()
 // Called every time feedback is received for the goal
 void feedback(const tfr_msgs::DiggingFeedbackConstPtr& feedback)
 {
-    
+    ROS_INFO("set %u state %u/%u: planned %.2fs took %.2fs, %u scoops, %.1fs left",
+            feedback->set_index, feedback->state_index + 1, feedback->set_states,
+            feedback->planned.toSec(), feedback->actual.toSec(), feedback->scoops,
+            feedback->remaining.toSec());
 }
 
 // Called once when the goal completes
@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "excavation_tracker.h"
+
+using tfr_mining::ExcavationTracker;
+using Event = ExcavationTracker::Event;
+
+namespace
+{
+    /*
+     * An arm whose cutting edge swings on a unit circle about the lower arm
+     * pivot as the upper arm turns, pitch p puts it at (cos p, -sin p), so
+     * sweeping p from 0 to pi cuts half a unit disk out of the ground.
+     * */
+    ExcavationTracker::ArmGeometry circleArm(double width)
+    {
+        ExcavationTracker::ArmGeometry geometry{};
+        geometry.turntable_x = 0.5;
+        geometry.scoop_x = 1.0;
+        geometry.scoop_width = width;
+        return geometry;
+    }
+
+    ExcavationTracker::ExcavationConstraints constraints()
+    {
+        ExcavationTracker::ExcavationConstraints c{};
+        c.ground_height = 0.0;
+        c.scoop_capacity = 0.0085;
+        c.fill_factor = 0.8;
+        c.dump_angle = -0.5;
+        c.bin_tolerance = 0.35;
+        return c;
+    }
+
+    //one pass of the upper arm through the ground, how many events came out
+    int cut(ExcavationTracker& tracker, int& stroke_events)
+    {
+        int events = 0;
+        stroke_events = 0;
+        for (double pitch = -0.1; pitch <= M_PI + 0.1; pitch += 0.01)
+        {
+            Event event = tracker.update({0, 0, pitch, 0});
+            events += event != Event::NONE;
+            stroke_events += event == Event::STROKE;
+        }
+        return events;
+    }
+
+    //tips the scoop out at the turntable angle, returns the event
+    Event dump(ExcavationTracker& tracker, double turntable)
+    {
+        tracker.update({turntable, 0, -0.2, 0});
+        return tracker.update({turntable, 0, -0.2, -1.0});
+    }
+}
+
+TEST(ExcavationTracker, MeasuresAStroke)
+{
+    const double width = 0.001;
+    auto geometry = circleArm(width);
+    auto c = constraints();
+    ExcavationTracker tracker{geometry, c};
+    int strokes;
+    ASSERT_EQ(cut(tracker, strokes), 1);
+    ASSERT_EQ(strokes, 1);
+    ASSERT_EQ(tracker.getStrokes(), 1);
+    //half the unit disk, less a little for the chords of the samples
+    ASSERT_NEAR(tracker.getLastStroke(), M_PI / 2 * width, M_PI / 2 * width * 0.01);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), tracker.getLastStroke());
+    ASSERT_DOUBLE_EQ(tracker.getCarried(), tracker.getLastStroke() * c.fill_factor);
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), 0);
+}
+
+TEST(ExcavationTracker, IgnoresSwingsAboveGround)
+{
+    auto geometry = circleArm(0.001);
+    auto c = constraints();
+    c.ground_height = -2.0;
+    ExcavationTracker tracker{geometry, c};
+    int strokes;
+    ASSERT_EQ(cut(tracker, strokes), 0);
+    ASSERT_EQ(tracker.getStrokes(), 0);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), 0);
+    //and short joint states
+    ASSERT_EQ(tracker.update({0, 0, 1}), Event::NONE);
+}
+
+TEST(ExcavationTracker, CapsAtTheScoop)
+{
+    auto geometry = circleArm(1.0);
+    auto c = constraints();
+    ExcavationTracker tracker{geometry, c};
+    int strokes;
+    cut(tracker, strokes);
+    ASSERT_DOUBLE_EQ(tracker.getLastStroke(), c.scoop_capacity);
+    //a second stroke can't overfill what's carried
+    cut(tracker, strokes);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), 2 * c.scoop_capacity);
+    ASSERT_DOUBLE_EQ(tracker.getCarried(), c.scoop_capacity);
+}
+
+TEST(ExcavationTracker, CountsOnlyDumpsOverTheBin)
+{
+    auto geometry = circleArm(0.001);
+    auto c = constraints();
+    ExcavationTracker tracker{geometry, c};
+    int strokes;
+    cut(tracker, strokes);
+    double load = tracker.getCarried();
+    ASSERT_EQ(dump(tracker, M_PI / 2), Event::SIDE_DUMP);
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), 0);
+    ASSERT_DOUBLE_EQ(tracker.getCarried(), 0);
+    //an empty scoop tipping doesn't count at all
+    ASSERT_EQ(dump(tracker, 0), Event::NONE);
+
+    cut(tracker, strokes);
+    //a full turn round still lands over the bin
+    ASSERT_EQ(dump(tracker, 2 * M_PI + 0.1), Event::BIN_DUMP);
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), load);
+    //held tipped, it only dumps once
+    ASSERT_EQ(tracker.update({0, 0, -0.2, -1.0}), Event::NONE);
+}
+
+TEST(ExcavationTracker, CorrectsToTheSurvey)
+{
+    auto geometry = circleArm(0.001);
+    auto c = constraints();
+    ExcavationTracker tracker{geometry, c};
+    int strokes;
+    cut(tracker, strokes);
+    dump(tracker, 0);
+    double kinematic = tracker.getExcavated();
+    double payload = tracker.getPayload();
+
+    //the survey found twice as much gone, the payload scales with it
+    tracker.correct(2 * kinematic);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), 2 * kinematic);
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), 2 * payload);
+    //nothing dug since, so the next survey only adds to the total
+    tracker.correct(0.001);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), 2 * kinematic + 0.001);
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), 2 * payload);
+
+    tracker.resetPayload();
+    ASSERT_DOUBLE_EQ(tracker.getPayload(), 0);
+    ASSERT_DOUBLE_EQ(tracker.getExcavated(), 2 * kinematic + 0.001);
+}
+
+TEST(ExcavationTracker, ScoopTipFacesBackwards)
+{
+    auto geometry = circleArm(0.001);
+    auto c = constraints();
+    ExcavationTracker tracker{geometry, c};
+    double x, y, z;
+    tracker.scoopTip({0, 0, 0, 0}, x, y, z);
+    ASSERT_NEAR(x, geometry.turntable_x - 1.0, 1e-12);
+    ASSERT_NEAR(y, 0, 1e-12);
+    ASSERT_NEAR(z, 0, 1e-12);
+    tracker.scoopTip({M_PI / 2, 0, M_PI / 2, 0}, x, y, z);
+    ASSERT_NEAR(x, geometry.turntable_x, 1e-12);
+    ASSERT_NEAR(y, 0, 1e-12);
+    ASSERT_NEAR(z, -1.0, 1e-12);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
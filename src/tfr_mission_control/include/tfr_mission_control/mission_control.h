@@ -16,12 +16,15 @@
 #include <tfr_msgs/TeleopAction.h>
 #include <tfr_msgs/ArmMoveAction.h>
 #include <tfr_msgs/ArmStateSrv.h>
+#include <tfr_msgs/EStop.h>
 
 #include <tfr_utilities/teleop_code.h>
 #include <tfr_utilities/status_code.h>
+#include <tfr_utilities/callback_thread.h>
 
 
 #include <cstdint>
+#include <mutex>
 
 #include <QWidget>
 #include <QObject>
@@ -83,6 +86,10 @@ namespace tfr_mission_control {
             //NOTE can cause bouncy keys if user has too long of a delay for
             //repeated keys
             const double MOTOR_INTERVAL = 1000/4;
+            //how often to resend an unacknowledged e-stop (ms)
+            const int ESTOP_RETRY_INTERVAL = 20;
+            //how long to keep resending before warning the operator (s)
+            const double ESTOP_TIMEOUT = 1.0;
 
             /* ======================================================================== */
             /* Variables                                                                */
@@ -96,6 +103,15 @@ namespace tfr_mission_control {
             QTimer* countdownClock;
             //The watchdog for the motors
             QTimer* motorKill;
+            //resends the e-stop until the firmware acknowledges it
+            QTimer* estopRetry;
+
+            //the e-stop echo and the status stream each get a thread, so a
+            //flood of status can't delay the e-stop round trip, and neither
+            //waits on the action clients on rqt's queue. Declared before the
+            //subscribers, so they outlive them.
+            CallbackThread estopThread;
+            CallbackThread statusThread;
 
             ros::NodeHandle nh;
             //The action servers
@@ -106,6 +122,15 @@ namespace tfr_mission_control {
             //our message subscriber
             ros::Subscriber com;
 
+            //dedicated e-stop channel straight to the firmware
+            ros::Publisher estop;
+            ros::Subscriber estopAck;
+            //guards the pending e-stop, the ack comes in on estopThread
+            std::mutex estopMutex;
+            tfr_msgs::EStop estopPending;
+            ros::WallTime estopSent;
+            bool estopAcknowledged;
+
             //Whether teleop commands should be accepted
             bool teleopEnabled;
 
@@ -127,6 +152,9 @@ namespace tfr_mission_control {
 
             void resetTurntable();
 
+            //sends a stop/release over the e-stop channel and starts timing it
+            void sendEStop(bool stop);
+
             /* ======================================================================== */
             /* Events                                                                   */
             /* ======================================================================== */
@@ -140,6 +168,8 @@ namespace tfr_mission_control {
             //triggered by incoming status message, and cascades other signals into thread
             //safe gui update
             void updateStatus(const tfr_msgs::SystemStatusConstPtr &status);
+            //triggered by the firmware echoing an e-stop, reports the latency
+            void acknowledgeEStop(const tfr_msgs::EStopConstPtr &ack);
 
             protected slots:
 
@@ -164,6 +194,7 @@ namespace tfr_mission_control {
                 virtual void performTeleop(tfr_utilities::TeleopCode code);
                 virtual void toggleControl(bool state);    //e-stop and start
                 virtual void toggleMotors(bool state);    //e-stop and start
+                virtual void retryEStop();
     
             signals:
                 /* ======================================================================== */
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <ros/ros.h>
+#include <actionlib/client/simple_action_client.h>
+#include <std_srvs/SetBool.h>
+#include <std_srvs/Empty.h>
+
+#include <tfr_msgs/EmptyAction.h>
+#include <tfr_msgs/TeleopAction.h>
+#include <tfr_msgs/EStop.h>
+
+#include <tfr_utilities/teleop_code.h>
+#include <tfr_utilities/callback_thread.h>
+
+#include "tfr_mission_control/operator_script.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tfr_mission_control {
+
+    /* Drives the same interfaces as the MissionControl plugin without the
+     * gui, so the operator path can be scripted and timed: teleop goals,
+     * autonomy, the e-stop channel and the control, motor and mission
+     * services. Every call waits for its reply and records how long it took,
+     * nothing retries forever the way the plugin's buttons do, a call that
+     * doesn't come back within the timeout is recorded as failed. Service
+     * calls run on a worker thread so a hung server can't hold up the script,
+     * the worker is left behind if the call never returns.
+     * */
+    class OperatorClient
+    {
+        public:
+
+            //timeout is how long to wait on any one reply (s)
+            OperatorClient(ros::NodeHandle& nh, double timeout);
+            ~OperatorClient() = default;
+            OperatorClient(const OperatorClient&) = delete;
+            OperatorClient& operator=(const OperatorClient&) = delete;
+            OperatorClient(OperatorClient&&) = delete;
+            OperatorClient& operator=(OperatorClient&&) = delete;
+
+            //waits for both action servers, false if they aren't up in time
+            bool connect(double timeout);
+
+            //a teleop goal, from sending it to its result
+            bool teleop(tfr_utilities::TeleopCode code);
+            //an autonomy goal, from sending it to the server taking it
+            bool startAutonomy();
+            //from cancelling autonomy to it finishing
+            bool preemptAutonomy();
+            //sends a stop or release on the e-stop channel, to the firmware's echo
+            bool estop(bool stop);
+            //e-stop and toggle_control, the release first on an enable, timed
+            //separately
+            bool toggleControl(bool state);
+            //e-stop and toggle_motors, the release first on an enable, timed
+            //separately
+            bool toggleMotors(bool state);
+            bool startMission();
+            bool zeroTurntable();
+
+            //runs the steps in order, false if any of them failed
+            bool run(const std::vector<ScriptStep>& steps);
+
+            const std::vector<CommandTiming>& getTimings() const { return timings; }
+
+        private:
+
+            //how often to resend an unacknowledged e-stop (s), as the plugin
+            const double ESTOP_RETRY_INTERVAL = 0.02;
+
+            const ros::WallDuration timeout;
+            const ros::WallTime start;
+
+            //the e-stop echo gets its own thread so it isn't held up by the
+            //waits on the caller's, declared before the subscriber
+            CallbackThread estopThread;
+
+            actionlib::SimpleActionClient<tfr_msgs::EmptyAction> autonomy;
+            actionlib::SimpleActionClient<tfr_msgs::TeleopAction> teleopClient;
+            ros::Publisher estopPublisher;
+            ros::Subscriber estopAck;
+            ros::ServiceClient controlService;
+            ros::ServiceClient motorService;
+            ros::ServiceClient missionService;
+            ros::ServiceClient turntableService;
+
+            //guards the replies that come in on other threads, the e-stop
+            //echo on estopThread and autonomy going active on its client's
+            std::mutex replyMutex;
+            std::condition_variable replied;
+            uint32_t estopSequence;
+            uint32_t estopAcked;
+            bool autonomyActive;
+
+            std::vector<CommandTiming> timings;
+
+            bool record(const std::string& command, bool ok, const ros::WallTime& sent);
+            bool record(const std::string& command, bool ok, const ros::WallTime& sent,
+                    const ros::WallTime& done);
+            //resends until the echo or the timeout, done is when it stopped
+            bool sendEStop(bool stop, ros::WallTime& done);
+            bool toggle(ros::ServiceClient& service, const std::string& command,
+                    bool state);
+            bool runStep(const ScriptStep& step);
+            void acknowledgeEStop(const tfr_msgs::EStopConstPtr &ack);
+    };
+} // namespace
@@ -0,0 +1,97 @@
+/*
+ * Scripts and timings for the headless operator client, kept apart from ros
+ * so they can be tested on their own.
+ *
+ * A script is one command a line, blank lines and anything after a # are
+ * ignored:
+ *
+ *   teleop <code>           a teleop goal, code as in TeleopCode (FORWARD, DIG...)
+ *   autonomy start|preempt  sends or cancels the autonomy goal
+ *   control on|off          e-stop and toggle_control, like the plugin's buttons
+ *   motors on|off           e-stop and toggle_motors
+ *   estop stop|release      just the e-stop channel
+ *   start_mission           starts the mission clock
+ *   zero_turntable          zeros the turntable
+ *   wait <seconds>          sleeps
+ *
+ * Any of them can be prefixed with "repeat <n> [every <seconds>]" to run it n
+ * times, back to back or paced at the given period.
+ * */
+#ifndef OPERATOR_SCRIPT_H
+#define OPERATOR_SCRIPT_H
+
+#include <tfr_utilities/teleop_code.h>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace tfr_mission_control
+{
+    enum class OperatorCommand
+    {
+        TELEOP,
+        START_AUTONOMY,
+        PREEMPT_AUTONOMY,
+        CONTROL,
+        MOTORS,
+        ESTOP,
+        START_MISSION,
+        ZERO_TURNTABLE,
+        WAIT
+    };
+
+    struct ScriptStep
+    {
+        OperatorCommand command;
+        //the teleop code for TELEOP
+        tfr_utilities::TeleopCode code;
+        //on/stop for CONTROL, MOTORS and ESTOP
+        bool enable;
+        //how long for WAIT [s]
+        double seconds;
+        int repeat;
+        //how often to start each repeat, 0 for back to back [s]
+        double period;
+    };
+
+    //the enum's name for code, as scripts write it
+    std::string teleopCodeName(tfr_utilities::TeleopCode code);
+
+    /*
+     * Parses a whole script, on a bad line returns false with error saying
+     * which line and why
+     * */
+    bool parseScript(std::istream& script, std::vector<ScriptStep>& steps,
+            std::string& error);
+
+    //how long one command took to come back
+    struct CommandTiming
+    {
+        std::string command;
+        bool ok;
+        //since the client started [s]
+        double started;
+        //from sending to the reply [s]
+        double round_trip;
+    };
+
+    struct TimingSummary
+    {
+        std::string command;
+        int count;
+        int failed;
+        double mean;
+        double median;
+        double p95;
+        double worst;
+    };
+
+    //per command statistics of the successful round trips, in first seen order
+    std::vector<TimingSummary> summarize(const std::vector<CommandTiming>& timings);
+
+    void writeTimings(std::ostream& out, const std::vector<CommandTiming>& timings);
+    void writeSummary(std::ostream& out, const std::vector<TimingSummary>& summary);
+}
+
+#endif
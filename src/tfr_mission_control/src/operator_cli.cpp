@@ -0,0 +1,78 @@
+/**
+ * operator_cli.cpp
+ *
+ * Runs an operator script against the robot without the gui and reports the
+ * round trip of every command, see operator_script.h for the commands.
+ *
+ * usage: operator_cli <script, - for stdin> [timings.csv]
+ *
+ * params:
+ *   ~timeout          how long to wait on any one reply (s), default 5
+ *   ~connect_timeout  how long to wait for the action servers (s), default 10
+ *
+ * Exits non zero if the script doesn't parse, the servers aren't up, or any
+ * command failed.
+ */
+#include <ros/ros.h>
+#include "tfr_mission_control/operator_client.h"
+#include "tfr_mission_control/operator_script.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace tfr_mission_control;
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "operator_cli");
+    std::vector<std::string> args;
+    ros::removeROSArgs(argc, argv, args);
+    if (args.size() < 2 || args.size() > 3)
+    {
+        std::cerr << "usage: operator_cli <script, - for stdin> [timings.csv]" << std::endl;
+        return 2;
+    }
+
+    std::vector<ScriptStep> steps;
+    std::string error;
+    bool parsed;
+    if (args[1] == "-")
+        parsed = parseScript(std::cin, steps, error);
+    else
+    {
+        std::ifstream script{args[1]};
+        if (!script)
+        {
+            std::cerr << "operator_cli: can't open " << args[1] << std::endl;
+            return 2;
+        }
+        parsed = parseScript(script, steps, error);
+    }
+    if (!parsed)
+    {
+        std::cerr << "operator_cli: " << error << std::endl;
+        return 2;
+    }
+
+    ros::NodeHandle n;
+    ros::NodeHandle p_n{"~"};
+    double timeout, connect_timeout;
+    p_n.param("timeout", timeout, 5.0);
+    p_n.param("connect_timeout", connect_timeout, 10.0);
+
+    OperatorClient client{n, timeout};
+    if (!client.connect(connect_timeout))
+    {
+        ROS_ERROR("Operator Client: action servers not up after %.1f s", connect_timeout);
+        return 1;
+    }
+    bool ok = client.run(steps);
+
+    writeSummary(std::cout, summarize(client.getTimings()));
+    if (args.size() == 3)
+    {
+        std::ofstream out{args[2]};
+        writeTimings(out, client.getTimings());
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+#include "tfr_mission_control/operator_client.h"
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <thread>
+
+namespace tfr_mission_control {
+
+    namespace
+    {
+        /*
+         * ros::ServiceClient::call has no timeout, so the call goes out on a
+         * detached thread with its own copy of the client and request. The
+         * response is only copied back if it came in time.
+         * */
+        template <class Service>
+        bool callWithin(ros::ServiceClient service, Service& request,
+                const ros::WallDuration& timeout)
+        {
+            auto call = std::make_shared<Service>(request);
+            auto reply = std::make_shared<std::promise<bool>>();
+            auto answered = reply->get_future();
+            std::thread{[service, call, reply] () mutable
+                {
+                    reply->set_value(service.call(*call));
+                }}.detach();
+            if (answered.wait_for(std::chrono::duration<double>(timeout.toSec())) !=
+                    std::future_status::ready || !answered.get())
+                return false;
+            request = *call;
+            return true;
+        }
+
+        const char* estopName(bool stop)
+        {
+            return stop ? "estop_stop" : "estop_release";
+        }
+    }
+
+    /* ========================================================================== */
+    /* Constructor/Destructor                                                     */
+    /* ========================================================================== */
+
+    OperatorClient::OperatorClient(ros::NodeHandle& nh, double t)
+        : timeout{t},
+        start{ros::WallTime::now()},
+        estopThread{"oc_estop"},
+        autonomy{nh, "autonomous_action_server", true},
+        teleopClient{nh, "teleop_action_server", true},
+        estopPublisher{nh.advertise<tfr_msgs::EStop>("/estop", 5)},
+        estopAck{estopThread.handle(nh).subscribe("/sensors/estop_ack", 5,
+                &OperatorClient::acknowledgeEStop, this)},
+        controlService{nh.serviceClient<std_srvs::SetBool>("toggle_control")},
+        motorService{nh.serviceClient<std_srvs::SetBool>("toggle_motors")},
+        missionService{nh.serviceClient<std_srvs::Empty>("start_mission")},
+        turntableService{nh.serviceClient<std_srvs::Empty>("/zero_turntable")},
+        estopSequence{0},
+        estopAcked{0},
+        autonomyActive{false}
+    {
+    }
+
+    bool OperatorClient::connect(double wait)
+    {
+        ros::Duration limit{wait};
+        return autonomy.waitForServer(limit) && teleopClient.waitForServer(limit);
+    }
+
+    /* ========================================================================== */
+    /* Commands                                                                   */
+    /* ========================================================================== */
+
+    bool OperatorClient::teleop(tfr_utilities::TeleopCode code)
+    {
+        tfr_msgs::TeleopGoal goal;
+        goal.code = static_cast<uint8_t>(code);
+        auto sent = ros::WallTime::now();
+        teleopClient.sendGoal(goal);
+        bool ok = teleopClient.waitForResult(ros::Duration{timeout.toSec()}) &&
+            teleopClient.getState() == actionlib::SimpleClientGoalState::SUCCEEDED;
+        if (!teleopClient.getState().isDone())
+            teleopClient.cancelGoal();
+        return record("teleop " + teleopCodeName(code), ok, sent);
+    }
+
+    bool OperatorClient::startAutonomy()
+    {
+        {
+            std::lock_guard<std::mutex> lock(replyMutex);
+            autonomyActive = false;
+        }
+        auto sent = ros::WallTime::now();
+        autonomy.sendGoal(tfr_msgs::EmptyGoal{},
+                actionlib::SimpleActionClient<tfr_msgs::EmptyAction>::SimpleDoneCallback(),
+                [this] ()
+                {
+                    std::lock_guard<std::mutex> lock(replyMutex);
+                    autonomyActive = true;
+                    replied.notify_all();
+                });
+        std::unique_lock<std::mutex> lock(replyMutex);
+        bool ok = replied.wait_for(lock, std::chrono::duration<double>(timeout.toSec()),
+                [this] () { return autonomyActive; });
+        lock.unlock();
+        return record("autonomy_start", ok, sent);
+    }
+
+    bool OperatorClient::preemptAutonomy()
+    {
+        auto sent = ros::WallTime::now();
+        autonomy.cancelGoal();
+        bool ok = autonomy.waitForResult(ros::Duration{timeout.toSec()});
+        return record("autonomy_preempt", ok, sent);
+    }
+
+    bool OperatorClient::estop(bool stop)
+    {
+        auto sent = ros::WallTime::now();
+        ros::WallTime done;
+        bool ok = sendEStop(stop, done);
+        return record(estopName(stop), ok, sent, done);
+    }
+
+    bool OperatorClient::toggleControl(bool state)
+    {
+        return toggle(controlService, "toggle_control", state);
+    }
+
+    bool OperatorClient::toggleMotors(bool state)
+    {
+        return toggle(motorService, "toggle_motors", state);
+    }
+
+    bool OperatorClient::startMission()
+    {
+        std_srvs::Empty request;
+        auto sent = ros::WallTime::now();
+        bool ok = callWithin(missionService, request, timeout);
+        return record("start_mission", ok, sent);
+    }
+
+    bool OperatorClient::zeroTurntable()
+    {
+        std_srvs::Empty request;
+        auto sent = ros::WallTime::now();
+        bool ok = callWithin(turntableService, request, timeout);
+        return record("zero_turntable", ok, sent);
+    }
+
+    /* ========================================================================== */
+    /* Scripts                                                                    */
+    /* ========================================================================== */
+
+    bool OperatorClient::run(const std::vector<ScriptStep>& steps)
+    {
+        bool ok = true;
+        for (const auto& step : steps)
+        {
+            auto next = ros::WallTime::now();
+            for (int i = 0; i < step.repeat && ros::ok(); ++i)
+            {
+                ok = runStep(step) && ok;
+                //paced from the start of each, so a slow reply eats into the
+                //wait rather than stretching the period
+                next += ros::WallDuration{step.period};
+                auto now = ros::WallTime::now();
+                if (next > now)
+                    (next - now).sleep();
+            }
+        }
+        return ok;
+    }
+
+    bool OperatorClient::runStep(const ScriptStep& step)
+    {
+        switch (step.command)
+        {
+            case (OperatorCommand::TELEOP):
+                return teleop(step.code);
+            case (OperatorCommand::START_AUTONOMY):
+                return startAutonomy();
+            case (OperatorCommand::PREEMPT_AUTONOMY):
+                return preemptAutonomy();
+            case (OperatorCommand::CONTROL):
+                return toggleControl(step.enable);
+            case (OperatorCommand::MOTORS):
+                return toggleMotors(step.enable);
+            case (OperatorCommand::ESTOP):
+                return estop(step.enable);
+            case (OperatorCommand::START_MISSION):
+                return startMission();
+            case (OperatorCommand::ZERO_TURNTABLE):
+                return zeroTurntable();
+            case (OperatorCommand::WAIT):
+                ros::WallDuration{step.seconds}.sleep();
+                return true;
+        }
+        return false;
+    }
+
+    /* ========================================================================== */
+    /* Utilities                                                                  */
+    /* ========================================================================== */
+
+    bool OperatorClient::record(const std::string& command, bool ok,
+            const ros::WallTime& sent)
+    {
+        return record(command, ok, sent, ros::WallTime::now());
+    }
+
+    bool OperatorClient::record(const std::string& command, bool ok,
+            const ros::WallTime& sent, const ros::WallTime& done)
+    {
+        timings.push_back(CommandTiming{command, ok, (sent - start).toSec(),
+                (done - sent).toSec()});
+        if (!ok)
+            ROS_WARN("Operator Client: %s failed after %.1f ms", command.c_str(),
+                    (done - sent).toSec() * 1000);
+        return ok;
+    }
+
+    /*
+     * Resends the same sequence number until the firmware echoes it, as the
+     * plugin does
+     * */
+    bool OperatorClient::sendEStop(bool stop, ros::WallTime& done)
+    {
+        tfr_msgs::EStop msg;
+        msg.stop = stop;
+        std::unique_lock<std::mutex> lock(replyMutex);
+        msg.sequence = ++estopSequence;
+        auto sent = ros::WallTime::now();
+        bool ok = false;
+        while (!ok && ros::WallTime::now() - sent < timeout && ros::ok())
+        {
+            estopPublisher.publish(msg);
+            ok = replied.wait_for(lock, std::chrono::duration<double>(ESTOP_RETRY_INTERVAL),
+                    [this, &msg] () { return estopAcked == msg.sequence; });
+        }
+        done = ros::WallTime::now();
+        return ok;
+    }
+
+    /*
+     * A disable runs the e-stop resend alongside the service call, so a
+     * silent firmware doesn't hold up the software disable. An enable goes
+     * out only once the release has been echoed, control refuses enables
+     * until it has seen the release, and still refuses one if another stop
+     * comes in before it runs.
+     * */
+    bool OperatorClient::toggle(ros::ServiceClient& service,
+            const std::string& command, bool state)
+    {
+        auto sent = ros::WallTime::now();
+        ros::WallTime echoed;
+        auto echo = std::async(std::launch::async,
+                [this, state, &echoed] () { return sendEStop(!state, echoed); });
+        if (state)
+            echo.wait();
+
+        std_srvs::SetBool request;
+        request.request.data = state;
+        bool called = callWithin(service, request, timeout) && request.response.success;
+        auto answered = ros::WallTime::now();
+
+        bool acked = echo.get();
+        record(estopName(!state), acked, sent, echoed);
+        record(command, called, sent, answered);
+        return acked && called;
+    }
+
+    /* ========================================================================== */
+    /* Callbacks                                                                  */
+    /* ========================================================================== */
+
+    //the firmware echoing the e-stop channel, on the oc_estop thread
+    void OperatorClient::acknowledgeEStop(const tfr_msgs::EStopConstPtr &ack)
+    {
+        std::lock_guard<std::mutex> lock(replyMutex);
+        estopAcked = ack->sequence;
+        replied.notify_all();
+    }
+} // namespace
@@ -0,0 +1,243 @@
+#include "tfr_mission_control/operator_script.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <utility>
+
+namespace tfr_mission_control
+{
+    namespace
+    {
+        using tfr_utilities::TeleopCode;
+
+        const std::pair<const char*, TeleopCode> TELEOP_NAMES[] =
+        {
+            {"STOP_DRIVEBASE", TeleopCode::STOP_DRIVEBASE},
+            {"FORWARD", TeleopCode::FORWARD},
+            {"BACKWARD", TeleopCode::BACKWARD},
+            {"LEFT", TeleopCode::LEFT},
+            {"RIGHT", TeleopCode::RIGHT},
+            {"CLOCKWISE", TeleopCode::CLOCKWISE},
+            {"COUNTERCLOCKWISE", TeleopCode::COUNTERCLOCKWISE},
+            {"DIG", TeleopCode::DIG},
+            {"DUMP", TeleopCode::DUMP},
+            {"RESET_DUMPING", TeleopCode::RESET_DUMPING},
+            {"RESET_STARTING", TeleopCode::RESET_STARTING},
+            {"DRIVING_POSITION", TeleopCode::DRIVING_POSITION},
+            {"RAISE_ARM", TeleopCode::RAISE_ARM}
+        };
+
+        bool parseTeleopCode(std::string name, TeleopCode& code)
+        {
+            std::transform(name.begin(), name.end(), name.begin(),
+                    [](unsigned char c) { return std::toupper(c); });
+            for (const auto& entry : TELEOP_NAMES)
+                if (name == entry.first)
+                {
+                    code = entry.second;
+                    return true;
+                }
+            return false;
+        }
+
+        bool parseSwitch(const std::string& word, const char* on, const char* off,
+                bool& value)
+        {
+            value = word == on;
+            return value || word == off;
+        }
+
+        //a number that's all there is of word
+        bool parseNumber(const std::string& word, double& value)
+        {
+            std::istringstream in{word};
+            return (in >> value) && in.eof() && std::isfinite(value) && value >= 0;
+        }
+
+        bool parseLine(std::vector<std::string> words, ScriptStep& step,
+                std::string& error)
+        {
+            step = ScriptStep{OperatorCommand::WAIT, TeleopCode::STOP_DRIVEBASE,
+                false, 0.0, 1, 0.0};
+            if (words[0] == "repeat")
+            {
+                double count;
+                if (words.size() < 3 || !parseNumber(words[1], count) ||
+                        count < 1 || count != std::floor(count))
+                {
+                    error = "repeat needs a count and a command";
+                    return false;
+                }
+                step.repeat = static_cast<int>(count);
+                words.erase(words.begin(), words.begin() + 2);
+                if (words[0] == "every")
+                {
+                    if (words.size() < 3 || !parseNumber(words[1], step.period))
+                    {
+                        error = "every needs a period and a command";
+                        return false;
+                    }
+                    words.erase(words.begin(), words.begin() + 2);
+                }
+            }
+
+            const std::string& verb = words[0];
+            size_t arguments = (verb == "start_mission" || verb == "zero_turntable") ? 1 : 2;
+            if (words.size() != arguments)
+            {
+                error = verb + " takes " + std::to_string(arguments - 1) + " argument(s)";
+                return false;
+            }
+
+            bool valid = true;
+            if (verb == "teleop")
+            {
+                step.command = OperatorCommand::TELEOP;
+                valid = parseTeleopCode(words[1], step.code);
+            }
+            else if (verb == "autonomy")
+            {
+                bool start;
+                valid = parseSwitch(words[1], "start", "preempt", start);
+                step.command = start ? OperatorCommand::START_AUTONOMY :
+                    OperatorCommand::PREEMPT_AUTONOMY;
+            }
+            else if (verb == "control" || verb == "motors")
+            {
+                step.command = verb == "control" ? OperatorCommand::CONTROL :
+                    OperatorCommand::MOTORS;
+                valid = parseSwitch(words[1], "on", "off", step.enable);
+            }
+            else if (verb == "estop")
+            {
+                step.command = OperatorCommand::ESTOP;
+                valid = parseSwitch(words[1], "stop", "release", step.enable);
+            }
+            else if (verb == "start_mission")
+                step.command = OperatorCommand::START_MISSION;
+            else if (verb == "zero_turntable")
+                step.command = OperatorCommand::ZERO_TURNTABLE;
+            else if (verb == "wait")
+            {
+                step.command = OperatorCommand::WAIT;
+                valid = parseNumber(words[1], step.seconds);
+            }
+            else
+            {
+                error = "unknown command " + verb;
+                return false;
+            }
+            if (!valid)
+                error = "bad argument " + words[1] + " to " + verb;
+            return valid;
+        }
+
+        double percentile(const std::vector<double>& sorted, double fraction)
+        {
+            size_t index = static_cast<size_t>(std::ceil(fraction * sorted.size()));
+            return sorted[std::min(std::max(index, size_t{1}), sorted.size()) - 1];
+        }
+    }
+
+    std::string teleopCodeName(tfr_utilities::TeleopCode code)
+    {
+        for (const auto& entry : TELEOP_NAMES)
+            if (code == entry.second)
+                return entry.first;
+        return std::to_string(static_cast<int>(code));
+    }
+
+    bool parseScript(std::istream& script, std::vector<ScriptStep>& steps,
+            std::string& error)
+    {
+        steps.clear();
+        std::string line;
+        for (int number = 1; std::getline(script, line); ++number)
+        {
+            line = line.substr(0, line.find('#'));
+            std::istringstream in{line};
+            std::vector<std::string> words{};
+            for (std::string word; in >> word;)
+                words.push_back(word);
+            if (words.empty())
+                continue;
+
+            ScriptStep step;
+            if (!parseLine(words, step, error))
+            {
+                error = "line " + std::to_string(number) + ": " + error;
+                return false;
+            }
+            steps.push_back(step);
+        }
+        return true;
+    }
+
+    std::vector<TimingSummary> summarize(const std::vector<CommandTiming>& timings)
+    {
+        std::vector<std::string> commands{};
+        for (const auto& timing : timings)
+            if (std::find(commands.begin(), commands.end(), timing.command) == commands.end())
+                commands.push_back(timing.command);
+
+        std::vector<TimingSummary> summary{};
+        for (const auto& command : commands)
+        {
+            TimingSummary entry{command, 0, 0, 0.0, 0.0, 0.0, 0.0};
+            std::vector<double> round_trips{};
+            for (const auto& timing : timings)
+            {
+                if (timing.command != command)
+                    continue;
+                ++entry.count;
+                if (timing.ok)
+                    round_trips.push_back(timing.round_trip);
+                else
+                    ++entry.failed;
+            }
+            if (!round_trips.empty())
+            {
+                std::sort(round_trips.begin(), round_trips.end());
+                double total = 0;
+                for (double round_trip : round_trips)
+                    total += round_trip;
+                entry.mean = total / round_trips.size();
+                entry.median = percentile(round_trips, 0.5);
+                entry.p95 = percentile(round_trips, 0.95);
+                entry.worst = round_trips.back();
+            }
+            summary.push_back(entry);
+        }
+        return summary;
+    }
+
+    void writeTimings(std::ostream& out, const std::vector<CommandTiming>& timings)
+    {
+        out << "command,ok,started,round_trip\n";
+        char line[128];
+        for (const auto& timing : timings)
+        {
+            std::snprintf(line, sizeof(line), ",%d,%.6f,%.6f\n", timing.ok,
+                    timing.started, timing.round_trip);
+            out << timing.command << line;
+        }
+    }
+
+    void writeSummary(std::ostream& out, const std::vector<TimingSummary>& summary)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-24s %6s %6s %9s %9s %9s %9s\n",
+                "command", "count", "failed", "mean ms", "median ms", "p95 ms", "worst ms");
+        out << line;
+        for (const auto& entry : summary)
+        {
+            std::snprintf(line, sizeof(line), "%-24s %6d %6d %9.2f %9.2f %9.2f %9.2f\n",
+                    entry.command.c_str(), entry.count, entry.failed, entry.mean * 1000,
+                    entry.median * 1000, entry.p95 * 1000, entry.worst * 1000);
+            out << line;
+        }
+    }
+}
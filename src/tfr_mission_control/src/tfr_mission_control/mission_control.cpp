@@ -15,10 +15,15 @@ namespace tfr_mission_control {
     MissionControl::MissionControl()
         : rqt_gui_cpp::Plugin(),
         widget(nullptr),
+        estopThread{"mc_estop"},
+        statusThread{"mc_status"},
         autonomy{"autonomous_action_server",true},
         teleop{"teleop_action_server",true},
         arm_client{"move_arm", true},
-        com{nh.subscribe("com", 5, &MissionControl::updateStatus, this)},
+        com{statusThread.handle(nh).subscribe("com", 5, &MissionControl::updateStatus, this)},
+        estop{nh.advertise<tfr_msgs::EStop>("/estop", 5)},
+        estopAck{estopThread.handle(nh).subscribe("/sensors/estop_ack", 5, &MissionControl::acknowledgeEStop, this)},
+        estopAcknowledged{true},
         teleopEnabled{false}
     {
         setObjectName("MissionControl");
@@ -34,6 +39,7 @@ namespace tfr_mission_control {
     {
         delete countdownClock;
         delete motorKill;
+        delete estopRetry;
         delete widget;
     }
 
@@ -67,6 +73,7 @@ namespace tfr_mission_control {
         countdownClock = new QTimer(this); //mission clock, runs repeatedly
         motorKill = new QTimer(this); //motor watchdog
         motorKill->setSingleShot(true); //tells it to only run on demand
+        estopRetry = new QTimer(this); //e-stop resend, runs until acknowledged
 
         /* Sets up all the signal/slot connections.
          *
@@ -97,6 +104,7 @@ namespace tfr_mission_control {
         connect(ui.motor_enable_button,&QPushButton::clicked, [this] () {toggleMotors(true);});
         connect(ui.motor_disable_button,&QPushButton::clicked, [this] () {toggleMotors(false);});
         connect(countdownClock, &QTimer::timeout, this,  &MissionControl::renderClock);
+        connect(estopRetry, &QTimer::timeout, this,  &MissionControl::retryEStop);
         connect(this, &MissionControl::emitStatus, ui.status_log, &QPlainTextEdit::appendPlainText);
         connect(ui.status_log, &QPlainTextEdit::textChanged, this,  &MissionControl::renderStatus);
 
@@ -162,6 +170,8 @@ namespace tfr_mission_control {
     {
         //note because qt plugins are weird we need to manually kill ros entities
         com.shutdown();
+        estopAck.shutdown();
+        estop.shutdown();
         autonomy.cancelAllGoals();
         autonomy.stopTrackingGoal();
         teleop.cancelAllGoals();
@@ -207,6 +217,27 @@ namespace tfr_mission_control {
 
     }
    
+    /*
+     * Publishes on the e-stop channel, which goes straight to the firmware and
+     * does not wait on the control loop. We keep resending the same sequence
+     * number until the firmware echoes it back so a dropped serial frame
+     * can't eat a stop.
+     * */
+    void MissionControl::sendEStop(bool stop)
+    {
+        tfr_msgs::EStop msg;
+        {
+            std::lock_guard<std::mutex> lock(estopMutex);
+            estopPending.stop = stop;
+            estopPending.sequence++;
+            estopSent = ros::WallTime::now();
+            estopAcknowledged = false;
+            msg = estopPending;
+        }
+        estop.publish(msg);
+        estopRetry->start(ESTOP_RETRY_INTERVAL);
+    }
+
     /* greys/ungreys all teleop buttons, and tell's system whether to process teleop or
      * not
      * */
@@ -321,7 +352,7 @@ namespace tfr_mission_control {
     /* Callbacks                                                                  */
     /* ========================================================================== */
     /*
-     * Callback for our status subscriber this happens in the "ros" thread so I
+     * Callback for our status subscriber this happens in the mc_status thread so I
      * need to communicate to the GUI in a safe signal/slot combination.
      *
      * This triggers our custom emitStatus signal, which triggers the built in
@@ -336,6 +367,29 @@ namespace tfr_mission_control {
         emit emitStatus(msg);
     }
 
+    /*
+     * Callback for the firmware echoing the e-stop channel, on the mc_estop
+     * thread. Stale sequence numbers from resends are ignored, so the latency
+     * is measured from the first send to the first echo.
+     * */
+    void MissionControl::acknowledgeEStop(const tfr_msgs::EStopConstPtr &ack)
+    {
+        double latency;
+        {
+            std::lock_guard<std::mutex> lock(estopMutex);
+            if (estopAcknowledged || ack->sequence != estopPending.sequence)
+                return;
+            estopAcknowledged = true;
+            latency = (ros::WallTime::now() - estopSent).toSec() * 1000;
+        }
+        ROS_INFO("Mission Control: e-stop %u acknowledged in %.1f ms",
+                ack->sequence, latency);
+        QString msg = QString("E-Stop %1 by firmware, round trip %2 ms")
+            .arg(ack->stop ? "engaged" : "released")
+            .arg(latency, 0, 'f', 1);
+        emit emitStatus(msg);
+    }
+
     /* ========================================================================== */
     /* Slots                                                                      */
     /* ========================================================================== */
@@ -400,22 +454,57 @@ namespace tfr_mission_control {
         teleop.sendGoal(goal);
     }
 
-    //toggles control for estop (on/off)
+    //toggles control for estop (on/off), the e-stop channel goes out first
+    //so a stop never waits on the service
     void MissionControl::toggleControl(bool state)
     {
+        sendEStop(!state);
         std_srvs::SetBool request;
         request.request.data = state;
-        while(!ros::service::call("toggle_control", request));
-        setControl(state);
+        while(!ros::service::call("toggle_control", request))
+            ros::Duration{0.01}.sleep();
+        //refused if a stop came in that hasn't been released
+        if (!request.response.success)
+            ROS_WARN("Mission Control: toggle_control refused, release the e-stop first");
+        setControl(state && request.response.success);
     }
 
-    //toggles control for estop (on/off)
+    //toggles control for estop (on/off), the e-stop channel goes out first
+    //so a stop never waits on the service
     void MissionControl::toggleMotors(bool state)
     {
+        sendEStop(!state);
         std_srvs::SetBool request;
         request.request.data = state;
-        while(!ros::service::call("toggle_motors", request));
-        setMotors(state);
+        while(!ros::service::call("toggle_motors", request))
+            ros::Duration{0.01}.sleep();
+        //refused if a stop came in that hasn't been released
+        if (!request.response.success)
+            ROS_WARN("Mission Control: toggle_motors refused, release the e-stop first");
+        setMotors(state && request.response.success);
+    }
+
+    //resends the pending e-stop until it is acknowledged, or gives up and
+    //warns the operator the firmware isn't listening
+    void MissionControl::retryEStop()
+    {
+        tfr_msgs::EStop msg;
+        {
+            std::lock_guard<std::mutex> lock(estopMutex);
+            if (estopAcknowledged)
+            {
+                estopRetry->stop();
+                return;
+            }
+            if ((ros::WallTime::now() - estopSent).toSec() > ESTOP_TIMEOUT)
+            {
+                estopRetry->stop();
+                emit emitStatus("Warning: E-Stop not acknowledged by firmware");
+                return;
+            }
+            msg = estopPending;
+        }
+        estop.publish(msg);
     }
 
     //self explanitory
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "tfr_mission_control/operator_script.h"
+
+using namespace tfr_mission_control;
+using tfr_utilities::TeleopCode;
+
+namespace
+{
+    bool parse(const std::string& text, std::vector<ScriptStep>& steps,
+            std::string& error)
+    {
+        std::istringstream script{text};
+        return parseScript(script, steps, error);
+    }
+}
+
+TEST(OperatorScript, ParsesEveryCommand)
+{
+    std::vector<ScriptStep> steps;
+    std::string error;
+    ASSERT_TRUE(parse(
+                "# warm up\n"
+                "start_mission\n"
+                "control on\n"
+                "motors off   # trailing comment\n"
+                "\n"
+                "teleop forward\n"
+                "autonomy start\n"
+                "autonomy preempt\n"
+                "estop stop\n"
+                "zero_turntable\n"
+                "wait 0.5\n", steps, error)) << error;
+    ASSERT_EQ(steps.size(), 9u);
+    ASSERT_EQ(steps[0].command, OperatorCommand::START_MISSION);
+    ASSERT_EQ(steps[1].command, OperatorCommand::CONTROL);
+    ASSERT_TRUE(steps[1].enable);
+    ASSERT_EQ(steps[2].command, OperatorCommand::MOTORS);
+    ASSERT_FALSE(steps[2].enable);
+    ASSERT_EQ(steps[3].command, OperatorCommand::TELEOP);
+    ASSERT_EQ(steps[3].code, TeleopCode::FORWARD);
+    ASSERT_EQ(steps[4].command, OperatorCommand::START_AUTONOMY);
+    ASSERT_EQ(steps[5].command, OperatorCommand::PREEMPT_AUTONOMY);
+    ASSERT_EQ(steps[6].command, OperatorCommand::ESTOP);
+    ASSERT_TRUE(steps[6].enable);
+    ASSERT_EQ(steps[7].command, OperatorCommand::ZERO_TURNTABLE);
+    ASSERT_EQ(steps[8].command, OperatorCommand::WAIT);
+    ASSERT_DOUBLE_EQ(steps[8].seconds, 0.5);
+    for (const auto& step : steps)
+        ASSERT_EQ(step.repeat, 1);
+}
+
+TEST(OperatorScript, ParsesRepeats)
+{
+    std::vector<ScriptStep> steps;
+    std::string error;
+    ASSERT_TRUE(parse("repeat 40 every 0.25 teleop LEFT\nrepeat 3 estop release\n",
+                steps, error)) << error;
+    ASSERT_EQ(steps.size(), 2u);
+    ASSERT_EQ(steps[0].repeat, 40);
+    ASSERT_DOUBLE_EQ(steps[0].period, 0.25);
+    ASSERT_EQ(steps[0].code, TeleopCode::LEFT);
+    ASSERT_EQ(steps[1].repeat, 3);
+    ASSERT_DOUBLE_EQ(steps[1].period, 0.0);
+    ASSERT_FALSE(steps[1].enable);
+}
+
+TEST(OperatorScript, ReportsTheBadLine)
+{
+    const char* bad[] = {
+        "teleop SIDEWAYS",
+        "control maybe",
+        "wait -1",
+        "wait soon",
+        "start_mission now",
+        "repeat 0 start_mission",
+        "repeat 2.5 start_mission",
+        "repeat 2",
+        "repeat 2 every 0.1",
+        "launch"
+    };
+    for (const char* line : bad)
+    {
+        std::vector<ScriptStep> steps;
+        std::string error;
+        ASSERT_FALSE(parse(std::string{"wait 1\n"} + line + "\n", steps, error)) << line;
+        ASSERT_EQ(error.compare(0, 7, "line 2:"), 0) << error;
+    }
+}
+
+TEST(OperatorScript, NamesRoundTrip)
+{
+    std::vector<ScriptStep> steps;
+    std::string error;
+    for (int code = 0; code <= static_cast<int>(TeleopCode::RAISE_ARM); ++code)
+    {
+        auto name = teleopCodeName(static_cast<TeleopCode>(code));
+        ASSERT_TRUE(parse("teleop " + name, steps, error)) << name;
+        ASSERT_EQ(static_cast<int>(steps[0].code), code);
+    }
+}
+
+TEST(OperatorScript, SummarizesPerCommand)
+{
+    std::vector<CommandTiming> timings;
+    for (int i = 1; i <= 20; ++i)
+        timings.push_back(CommandTiming{"teleop FORWARD", true, i * 0.1, i * 0.001});
+    timings.push_back(CommandTiming{"estop_stop", false, 3.0, 5.0});
+    timings.push_back(CommandTiming{"estop_stop", true, 9.0, 0.004});
+
+    auto summary = summarize(timings);
+    ASSERT_EQ(summary.size(), 2u);
+    ASSERT_EQ(summary[0].command, "teleop FORWARD");
+    ASSERT_EQ(summary[0].count, 20);
+    ASSERT_EQ(summary[0].failed, 0);
+    ASSERT_NEAR(summary[0].mean, 0.0105, 1e-12);
+    ASSERT_NEAR(summary[0].median, 0.010, 1e-12);
+    ASSERT_NEAR(summary[0].p95, 0.019, 1e-12);
+    ASSERT_NEAR(summary[0].worst, 0.020, 1e-12);
+    //the failure counts but its time doesn't
+    ASSERT_EQ(summary[1].count, 2);
+    ASSERT_EQ(summary[1].failed, 1);
+    ASSERT_DOUBLE_EQ(summary[1].worst, 0.004);
+}
+
+TEST(OperatorScript, WritesOneRowPerTiming)
+{
+    std::vector<CommandTiming> timings{
+        {"start_mission", true, 0.5, 0.002},
+        {"teleop DIG", false, 1.0, 5.0}
+    };
+    std::ostringstream out;
+    writeTimings(out, timings);
+    ASSERT_EQ(out.str(), "command,ok,started,round_trip\n"
+            "start_mission,1,0.500000,0.002000\n"
+            "teleop DIG,0,1.000000,5.000000\n");
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
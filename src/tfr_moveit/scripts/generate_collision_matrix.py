@@ -0,0 +1,293 @@
+#!/usr/bin/env python
+"""
+Regenerates the disabled collision pairs in config/excavator.srdf.
+
+Every pair of links MoveIt doesn't know to skip is checked on every state it
+validates, and the planner validates thousands per plan. This samples the
+joints through their limits and disables the pairs that can't matter, the
+way the setup assistant does:
+
+    Adjacent  joined by a joint
+    Always    touching in every sample, parts of one rigid piece
+    Never     never within the padding of each other in any sample
+
+Unlike the setup assistant, touching in the default state isn't enough, the
+default sits the arm against the bin and those are the pairs that matter.
+
+Links are bounded by a box per collision shape, cylinders and spheres
+included, so a pair that's Never here never touches in MoveIt either. Meshes
+aren't supported, the model doesn't have any.
+
+The srdf is shared by every variant of the model, so give each expanded urdf
+and a pair is only disabled if it's safe in all of them:
+
+    rosrun xacro xacro --inorder model.xacro simple_collision:=true > simple.urdf
+    rosrun xacro xacro --inorder model.xacro simple_collision:=false > full.urdf
+    rosrun tfr_moveit generate_collision_matrix.py simple.urdf full.urdf
+"""
+from __future__ import print_function
+import argparse
+import itertools
+import math
+import os
+import random
+import re
+import sys
+import xml.etree.ElementTree as ET
+
+DEFAULT_SRDF = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+        '..', 'config', 'excavator.srdf')
+
+# 3x3 rotations and 3 vectors as plain lists, the model is small enough that
+# numpy isn't worth the dependency
+
+def mat_mul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(3)) for j in range(3)]
+            for i in range(3)]
+
+def mat_vec(a, v):
+    return [sum(a[i][k] * v[k] for k in range(3)) for i in range(3)]
+
+def add(a, b):
+    return [a[i] + b[i] for i in range(3)]
+
+def rpy_to_mat(r, p, y):
+    cr, sr = math.cos(r), math.sin(r)
+    cp, sp = math.cos(p), math.sin(p)
+    cy, sy = math.cos(y), math.sin(y)
+    return [[cy * cp, cy * sp * sr - sy * cr, cy * sp * cr + sy * sr],
+            [sy * cp, sy * sp * sr + cy * cr, sy * sp * cr - cy * sr],
+            [-sp, cp * sr, cp * cr]]
+
+def axis_angle_to_mat(axis, angle):
+    norm = math.sqrt(sum(a * a for a in axis))
+    x, y, z = [a / norm for a in axis]
+    c, s = math.cos(angle), math.sin(angle)
+    t = 1 - c
+    return [[t * x * x + c, t * x * y - s * z, t * x * z + s * y],
+            [t * x * y + s * z, t * y * y + c, t * y * z - s * x],
+            [t * x * z - s * y, t * y * z + s * x, t * z * z + c]]
+
+IDENTITY = rpy_to_mat(0, 0, 0)
+
+def compose(a, b):
+    """ (rotation, translation) of frame b expressed in a's parent """
+    return (mat_mul(a[0], b[0]), add(mat_vec(a[0], b[1]), a[1]))
+
+def parse_floats(text, default):
+    return [float(v) for v in text.split()] if text else default
+
+def parse_origin(elem):
+    origin = elem.find('origin') if elem is not None else None
+    if origin is None:
+        return (IDENTITY, [0.0, 0.0, 0.0])
+    xyz = parse_floats(origin.get('xyz'), [0.0, 0.0, 0.0])
+    rpy = parse_floats(origin.get('rpy'), [0.0, 0.0, 0.0])
+    return (rpy_to_mat(*rpy), xyz)
+
+def parse_half_extents(geometry, link):
+    shape = geometry[0]
+    if shape.tag == 'box':
+        return [s / 2 for s in parse_floats(shape.get('size'), None)]
+    if shape.tag == 'cylinder':
+        radius = float(shape.get('radius'))
+        return [radius, radius, float(shape.get('length')) / 2]
+    if shape.tag == 'sphere':
+        return [float(shape.get('radius'))] * 3
+    sys.exit('{}: {} collision geometry isn\'t supported'.format(link, shape.tag))
+
+
+class Model(object):
+    """ The links, joints and collision boxes of one urdf """
+
+    def __init__(self, path):
+        root = ET.parse(path).getroot()
+        self.path = path
+        self.links = [link.get('name') for link in root.findall('link')]
+        # link -> [(pose in the link, half extents)]
+        self.boxes = {}
+        for link in root.findall('link'):
+            name = link.get('name')
+            self.boxes[name] = [(parse_origin(c), parse_half_extents(c.find('geometry'), name))
+                    for c in link.findall('collision')]
+        # child link -> (parent, origin, type, axis)
+        self.joints = {}
+        self.limits = {}
+        for joint in root.findall('joint'):
+            name = joint.get('name')
+            child = joint.find('child').get('link')
+            kind = joint.get('type')
+            axis = joint.find('axis')
+            self.joints[child] = (joint.find('parent').get('link'), parse_origin(joint),
+                    kind, name, parse_floats(axis.get('xyz') if axis is not None else None,
+                        [1.0, 0.0, 0.0]))
+            if kind in ('revolute', 'prismatic'):
+                limit = joint.find('limit')
+                self.limits[name] = (float(limit.get('lower')), float(limit.get('upper')))
+            elif kind == 'continuous':
+                self.limits[name] = (-math.pi, math.pi)
+        self.order = []
+        for link in self.links:
+            self.visit(link)
+
+    def visit(self, link):
+        """ orders links parents first """
+        if link in self.order:
+            return
+        if link in self.joints:
+            self.visit(self.joints[link][0])
+        self.order.append(link)
+
+    def random_positions(self, generator):
+        return dict((name, generator.uniform(lower, upper))
+                for name, (lower, upper) in self.limits.items())
+
+    def pose_boxes(self, positions, padding):
+        """ link -> [(axes, centre, half extents, radius)] in the root frame """
+        frames = {}
+        for link in self.order:
+            if link not in self.joints:
+                frames[link] = (IDENTITY, [0.0, 0.0, 0.0])
+                continue
+            parent, origin, kind, name, axis = self.joints[link]
+            frame = compose(frames[parent], origin)
+            if kind in ('revolute', 'continuous'):
+                frame = compose(frame, (axis_angle_to_mat(axis, positions[name]), [0.0, 0.0, 0.0]))
+            elif kind == 'prismatic':
+                frame = compose(frame, (IDENTITY, [a * positions[name] for a in axis]))
+            frames[link] = frame
+        posed = {}
+        for link, boxes in self.boxes.items():
+            posed[link] = []
+            for pose, half in boxes:
+                rotation, centre = compose(frames[link], pose)
+                axes = [[rotation[i][j] for i in range(3)] for j in range(3)]
+                half = [h + padding / 2 for h in half]
+                posed[link].append((axes, centre, half, math.sqrt(dot(half, half))))
+        return posed
+
+    def adjacent(self, a, b):
+        return any(self.joints.get(child, (None,))[0] == parent
+                for child, parent in ((a, b), (b, a)))
+
+
+def dot(a, b):
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]
+
+def cross(a, b):
+    return [a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]]
+
+def boxes_overlap(a, b):
+    """ separating axis test between two oriented boxes """
+    a_axes, a_centre, a_half, a_radius = a
+    b_axes, b_centre, b_half, b_radius = b
+    offset = [b_centre[i] - a_centre[i] for i in range(3)]
+    if dot(offset, offset) > (a_radius + b_radius) ** 2:
+        return False
+    candidates = a_axes + b_axes + [cross(u, v) for u in a_axes for v in b_axes]
+    for axis in candidates:
+        if dot(axis, axis) < 1e-12:
+            continue
+        reach = (sum(a_half[i] * abs(dot(a_axes[i], axis)) for i in range(3)) +
+                sum(b_half[i] * abs(dot(b_axes[i], axis)) for i in range(3)))
+        if abs(dot(offset, axis)) > reach:
+            return False
+    return True
+
+def links_touch(posed, a, b):
+    return any(boxes_overlap(x, y) for x in posed[a] for y in posed[b])
+
+
+def classify(model, samples, padding, seed):
+    """ pair -> reason for every pair that can be disabled """
+    solid = [link for link in model.links if model.boxes[link]]
+    pairs = [tuple(sorted(pair)) for pair in itertools.combinations(model.links, 2)]
+    reasons = {}
+    for a, b in pairs:
+        if model.adjacent(a, b):
+            reasons[(a, b)] = 'Adjacent'
+        elif a not in solid or b not in solid:
+            reasons[(a, b)] = 'Never'
+
+    # a pair is settled once it's been seen both touching and apart
+    touched = set()
+    apart = set()
+    open_pairs = [pair for pair in pairs if pair not in reasons]
+    generator = random.Random(seed)
+    for _ in range(samples):
+        if not open_pairs:
+            break
+        posed = model.pose_boxes(model.random_positions(generator), padding)
+        for pair in open_pairs:
+            (touched if links_touch(posed, *pair) else apart).add(pair)
+        open_pairs = [pair for pair in open_pairs if not (pair in touched and pair in apart)]
+    for pair in pairs:
+        if pair in reasons:
+            continue
+        if pair not in touched:
+            reasons[pair] = 'Never'
+        elif pair not in apart:
+            reasons[pair] = 'Always'
+    return reasons
+
+
+def checked_pairs(model, disabled):
+    """ how many link pairs and shape pairs MoveIt has to check in each state """
+    solid = [link for link in model.links if model.boxes[link]]
+    pairs = [pair for pair in itertools.combinations(sorted(solid), 2) if pair not in disabled]
+    return len(pairs), sum(len(model.boxes[a]) * len(model.boxes[b]) for a, b in pairs)
+
+def read_disabled(srdf):
+    root = ET.parse(srdf).getroot()
+    return set(tuple(sorted((d.get('link1'), d.get('link2'))))
+            for d in root.findall('disable_collisions'))
+
+def write_disabled(srdf, reasons):
+    """ swaps the disable_collisions lines, everything else stays as it was """
+    with open(srdf) as f:
+        text = f.read()
+    lines = ''.join('    <disable_collisions link1="{}" link2="{}" reason="{}" />\n'.format(a, b, reason)
+            for (a, b), reason in sorted(reasons.items()))
+    pattern = re.compile(r'(?:[ \t]*<disable_collisions [^\n]*\n)+')
+    first = pattern.search(text)
+    if first is None:
+        text = text.replace('</robot>', lines + '</robot>')
+    else:
+        text = text[:first.start()] + lines + pattern.sub('', text[first.end():])
+    with open(srdf, 'w') as f:
+        f.write(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('urdfs', nargs='+', help='expanded urdf of each model variant')
+    parser.add_argument('--srdf', default=DEFAULT_SRDF, help='srdf to rewrite')
+    parser.add_argument('--samples', type=int, default=10000, help='random states to check')
+    parser.add_argument('--padding', type=float, default=0.01,
+            help='closer than this counts as touching [m]')
+    parser.add_argument('--seed', type=int, default=0)
+    parser.add_argument('--dry-run', action='store_true', help='report without writing')
+    args = parser.parse_args()
+
+    models = [Model(path) for path in args.urdfs]
+    found = [classify(model, args.samples, args.padding, args.seed) for model in models]
+    # only what every variant agrees on, a link without geometry in one of
+    # them makes its pairs Never there, so the strongest reason wins
+    strength = ['Adjacent', 'Always', 'Never']
+    reasons = dict((pair, min((other[pair] for other in found), key=strength.index))
+            for pair in found[0] if all(pair in other for other in found[1:]))
+
+    before = read_disabled(args.srdf)
+    for model in models:
+        print('{}: {} link pairs ({} shape pairs) checked, {} ({}) before'.format(model.path,
+            *(checked_pairs(model, reasons) + checked_pairs(model, before))))
+    for pair in sorted(before - set(reasons)):
+        print('enabled {} {}'.format(*pair))
+    for pair in sorted(set(reasons) - before):
+        print('disabled {} {} ({})'.format(pair[0], pair[1], reasons[pair]))
+    if not args.dry_run:
+        write_disabled(args.srdf, reasons)
+
+
+if __name__ == '__main__':
+    main()
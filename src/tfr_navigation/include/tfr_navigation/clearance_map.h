@@ -0,0 +1,104 @@
+#ifndef CLEARANCE_MAP_H
+#define CLEARANCE_MAP_H
+#include <cstdint>
+#include <vector>
+
+namespace tfr_navigation
+{
+    struct GovernorConstraints
+    {
+        //cap in clutter or without the imu [m/s]
+        double min_speed;
+        //cap in the open [m/s]
+        double max_speed;
+        //clearance at which the cap is min_speed and max_speed [m]
+        double near_clearance;
+        double far_clearance;
+        //half the robot width [m]
+        double inscribed_radius;
+        //how far ahead a command is rolled out [s]
+        double horizon;
+        //occupancy values at or over this are obstacles
+        int lethal_cost;
+        //roll or pitch that holds us to min_speed [rad]
+        double max_tilt;
+        //acceleration deviation that holds us to min_speed [m/s^2]
+        double max_vibration;
+        //imu data older than this doesn't count [s]
+        double imu_timeout;
+    };
+
+    /**
+     * Distance from every cell of an occupancy grid to the closest obstacle,
+     * and how close a command's arc gets to one.
+     *
+     * The distance field is a two pass chamfer, fine for a local costmap.
+     * Unknown cells (-1) could be anything, so they count as obstacles.
+     * Cells are row major with row 0 at origin_y, as in nav_msgs/OccupancyGrid.
+     * */
+    class ClearanceMap
+    {
+        public:
+            ClearanceMap();
+            ~ClearanceMap() = default;
+            ClearanceMap(const ClearanceMap&) = delete;
+            ClearanceMap& operator=(const ClearanceMap&) = delete;
+            ClearanceMap(ClearanceMap&&) = delete;
+            ClearanceMap& operator=(ClearanceMap&&) = delete;
+
+            /*
+             * Replaces the map, costs holds width * height occupancy values
+             * and (map_x, map_y) is the corner of cell 0
+             * */
+            void update(const int8_t* costs, int width, int height,
+                    double cell_size, double map_x, double map_y, int lethal_cost);
+
+            bool hasMap() const { return !distances.empty(); }
+
+            /*
+             * Distance from a point to the closest obstacle [m], negative
+             * infinity off the map
+             * */
+            double distance(double x, double y) const;
+
+            /*
+             * Closest a robot at (x, y, yaw) driving the command gets to an
+             * obstacle over the horizon, less the inscribed radius [m]. The
+             * arc stops where it leaves the map. Negative infinity without a
+             * map or with the robot off it, being blind holds us to min_speed.
+             * */
+            double clearance(double x, double y, double yaw,
+                    double linear, double angular,
+                    const GovernorConstraints& constraints) const;
+
+        private:
+            //chamfer steps, in tenths of a cell
+            static const int STRAIGHT = 10, DIAGONAL = 14;
+            //time step along the arc [s]
+            static constexpr double STEP = 0.1;
+
+            //distance to the closest obstacle per cell, in tenths of a cell
+            std::vector<int> distances;
+            int columns, rows;
+            double resolution, origin_x, origin_y;
+
+            int closest(double x, double y) const;
+    };
+
+    /*
+     * How far past min_speed the imu lets us go, 0 to 1. Stale data, tilt at
+     * max_tilt or vibration at max_vibration give 0.
+     * */
+    double rideStability(double tilt, double vibration, bool fresh,
+            const GovernorConstraints& constraints);
+
+    /*
+     * The speed cap, linear in the clearance from min_speed at near_clearance
+     * to max_speed at far_clearance, scaled back toward min_speed by the
+     * stability
+     * */
+    double speedCap(double clearance, double stability,
+            const GovernorConstraints& constraints);
+}
+
+#endif
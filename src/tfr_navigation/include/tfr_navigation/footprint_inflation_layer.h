@@ -0,0 +1,76 @@
+#ifndef FOOTPRINT_INFLATION_LAYER_H
+#define FOOTPRINT_INFLATION_LAYER_H
+#include <ros/ros.h>
+#include <costmap_2d/layer.h>
+#include <costmap_2d/layered_costmap.h>
+#include <costmap_2d/costmap_2d.h>
+#include <vector>
+#include <cstdint>
+
+namespace tfr_navigation
+{
+    /**
+     * Inflation for our rectangular footprint instead of a circle around it.
+     *
+     * The stock inflation layer has to assume the worst orientation, so
+     * anything within the circumscribed radius looks blocked and gaps a
+     * little wider than the robot get closed off. This layer precomputes the
+     * cells the footprint covers at a handful of headings (a kernel per
+     * orientation bin). A cell's cost is how many headings would put the
+     * footprint on an obstacle: all of them is inscribed (can't be there at
+     * all), some of them is a graded cost the planner will go through if it
+     * has to, none is free.
+     *
+     * Only the window the other layers report as changed, grown by the
+     * footprint radius, is recomputed each update.
+     *
+     * parameters (in the layer's namespace):
+     *  - orientation_bins: headings over half a turn, the rectangle repeats
+     *  after that (int, default: 16, at most 32)
+     *  - min_cost: cost of a cell blocked in only one heading (int,
+     *  default: 128)
+     * */
+    class FootprintInflationLayer : public costmap_2d::Layer
+    {
+        public:
+            FootprintInflationLayer();
+            ~FootprintInflationLayer() = default;
+            FootprintInflationLayer(const FootprintInflationLayer&) = delete;
+            FootprintInflationLayer& operator=(const FootprintInflationLayer&) = delete;
+            FootprintInflationLayer(FootprintInflationLayer&&) = delete;
+            FootprintInflationLayer& operator=(FootprintInflationLayer&&) = delete;
+
+            void onInitialize() override;
+            void updateBounds(double robot_x, double robot_y, double robot_yaw,
+                    double* min_x, double* min_y, double* max_x, double* max_y) override;
+            void updateCosts(costmap_2d::Costmap2D& master_grid,
+                    int min_i, int min_j, int max_i, int max_j) override;
+            void matchSize() override;
+            void onFootprintChanged() override;
+
+        private:
+            struct Offset
+            {
+                int x, y;
+            };
+
+            int orientation_bins;
+            int min_cost;
+
+            //cells covered by the footprint centered on the origin, per bin
+            std::vector<std::vector<Offset> > kernels;
+            //furthest any kernel reaches, in cells
+            int reach;
+            double reach_meters;
+            //the kernels changed, everything has to be redone once
+            bool need_full_update;
+            //one bit per orientation bin for each cell of the update window
+            std::vector<uint32_t> blocked;
+            //cost for each number of blocked bins
+            std::vector<unsigned char> cost_table;
+
+            void computeKernels();
+    };
+}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef PIVOT_LATTICE_H
+#define PIVOT_LATTICE_H
+#include <cstdint>
+#include <vector>
+
+namespace tfr_navigation
+{
+    /*
+     * How the treads actually drive, the costs of the lattice are times
+     * worked out from these
+     * */
+    struct TreadDynamics
+    {
+        //cruising speed [m/s]
+        double linear_speed;
+        //speeding up and slowing down [m/s^2]
+        double linear_acceleration;
+        //pivot rate [rad/s]
+        double pivot_speed;
+        //[rad/s^2]
+        double pivot_acceleration;
+        //breaking the treads loose before a pivot gets going [s]
+        double pivot_delay;
+    };
+
+    struct LatticeCosts
+    {
+        //how much slower a cell at the highest non inscribed cost is to
+        //drive through than a free one, 1 is twice as slow
+        double cost_weight;
+        //most a cell can cost and still pivot in, the footprint layer gives a
+        //cell blocked in any heading at least its min_cost
+        int pivot_cost_limit;
+        //whether cells with no information can be planned through
+        bool allow_unknown;
+    };
+
+    /**
+     * A search over straight runs and pivots in place, which is how the
+     * treads drive well, instead of the grid planner's gentle curves they
+     * drive poorly.
+     *
+     * States are a cell and one of 16 headings. Each heading steps along a
+     * short lattice vector ((1,0), (2,1), (1,1)...), so a straight run stays
+     * exactly on the grid. From any state there are two kinds of move: one
+     * more step straight on, or a pivot in place to any other heading.
+     * Costs are time: a step is its length at cruising speed, slowed by the
+     * costs of the cells it sweeps, and a pivot is the stop and start around
+     * it, the breakaway delay and the turn itself. So a plan is fast straight
+     * runs joined by as few pivots as it can get away with.
+     *
+     * The steps (with the cells they sweep) and the pivot times between
+     * every pair of headings are worked out once in configure(), and the
+     * search buffers are kept between plans, so planning doesn't allocate
+     * once the grid size settles.
+     *
+     * Costs are read as in costmap_2d, inscribed and up is blocked.
+     * */
+    class PivotLattice
+    {
+        public:
+            static const int HEADINGS = 16;
+
+            struct State
+            {
+                int x, y, heading;
+            };
+
+            PivotLattice();
+            ~PivotLattice() = default;
+            PivotLattice(const PivotLattice&) = delete;
+            PivotLattice& operator=(const PivotLattice&) = delete;
+            PivotLattice(PivotLattice&&) = delete;
+            PivotLattice& operator=(PivotLattice&&) = delete;
+
+            /*
+             * Rebuilds the primitive table, resolution is the size of a cell
+             * [m]
+             * */
+            void configure(const TreadDynamics& dynamics, const LatticeCosts& costs,
+                    double resolution);
+
+            /*
+             * Searches from start to any heading in the goal cell over a row
+             * major grid of costs. On success path holds every state from
+             * start to goal, a pivot shows up as two states in the same cell.
+             * */
+            bool plan(const unsigned char* costs, int size_x, int size_y,
+                    const State& start, int goal_x, int goal_y,
+                    std::vector<State>& path);
+
+            //time the last successful plan takes to drive [s]
+            double getPlanTime() const { return plan_time; }
+            //states taken off the open list in the last plan
+            int getExpanded() const { return expanded; }
+
+            //the heading closest to yaw
+            static int nearestHeading(double yaw);
+            static double headingYaw(int heading);
+
+        private:
+            struct Step
+            {
+                int dx, dy;
+                //cells swept on the way, relative to the start, not including it
+                std::vector<int> swept_x, swept_y;
+                double time;
+            };
+
+            struct Open
+            {
+                float f, g;
+                uint32_t index;
+            };
+
+            Step steps[HEADINGS];
+            double pivot_times[HEADINGS][HEADINGS];
+            //least any pivot costs, for the heuristic
+            double min_pivot;
+            double resolution;
+            double speed;
+            double cost_weight;
+            int pivot_cost_limit;
+            bool allow_unknown;
+
+            //search buffers, one entry per state, kept between plans
+            std::vector<float> best;
+            std::vector<uint32_t> parents;
+            std::vector<uint8_t> closed;
+            std::vector<Open> open;
+            double plan_time;
+            int expanded;
+
+            //cost of a cell as the search sees it, 255 for blocked
+            unsigned char cellCost(unsigned char cost) const;
+            //lower bound on the time from a state to the goal
+            float heuristic(int x, int y, int heading, int goal_x, int goal_y) const;
+    };
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PIVOT_PLANNER_H
+#define PIVOT_PLANNER_H
+#include <ros/ros.h>
+#include <nav_core/base_global_planner.h>
+#include <costmap_2d/costmap_2d_ros.h>
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/Path.h>
+#include <string>
+#include <vector>
+#include "pivot_lattice.h"
+
+namespace tfr_navigation
+{
+    /**
+     * Global planner for move_base that plans the way the treads drive:
+     * straight runs joined by pivots in place, see pivot_lattice.h.
+     *
+     * The plan has a pose per lattice state, a pivot is two poses at the same
+     * spot with different yaws, so the local planner can see where the turns
+     * are meant to happen. The last pose is the goal as given.
+     *
+     * parameters (in the planner's namespace):
+     *  - linear_speed: cruising speed [m/s] (double, default: 0.5)
+     *  - linear_acceleration: [m/s^2] (double, default: 0.5)
+     *  - pivot_speed: [rad/s] (double, default: 0.6)
+     *  - pivot_acceleration: [rad/s^2] (double, default: 0.7)
+     *  - pivot_delay: time to break the treads loose before a pivot [s]
+     *  (double, default: 0.5)
+     *  - cost_weight: how much slower the costliest passable cell is than a
+     *  free one, 1 is twice (double, default: 1.0)
+     *  - pivot_cost_limit: most a cell can cost and still be pivoted in, keep
+     *  it under the footprint layer's min_cost (int, default: 127)
+     *  - allow_unknown: plan through cells with no information (bool,
+     *  default: true)
+     *
+     * published topics:
+     *  - ~<name>/plan (nav_msgs/Path) the last plan
+     * */
+    class PivotPlanner : public nav_core::BaseGlobalPlanner
+    {
+        public:
+            PivotPlanner();
+            ~PivotPlanner() = default;
+            PivotPlanner(const PivotPlanner&) = delete;
+            PivotPlanner& operator=(const PivotPlanner&) = delete;
+            PivotPlanner(PivotPlanner&&) = delete;
+            PivotPlanner& operator=(PivotPlanner&&) = delete;
+
+            void initialize(std::string name, costmap_2d::Costmap2DROS* costmap_ros) override;
+            bool makePlan(const geometry_msgs::PoseStamped& start,
+                    const geometry_msgs::PoseStamped& goal,
+                    std::vector<geometry_msgs::PoseStamped>& plan) override;
+
+        private:
+            costmap_2d::Costmap2DROS* costmap_ros;
+            ros::Publisher plan_publisher;
+            PivotLattice lattice;
+            TreadDynamics dynamics;
+            LatticeCosts costs;
+            //the cell size the lattice was configured for
+            double resolution;
+            bool initialized;
+            std::vector<PivotLattice::State> states;
+    };
+}
+
+#endif
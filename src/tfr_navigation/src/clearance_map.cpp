@@ -0,0 +1,126 @@
+#include "clearance_map.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace tfr_navigation
+{
+    constexpr double ClearanceMap::STEP;
+
+    ClearanceMap::ClearanceMap() :
+        columns{0}, rows{0}, resolution{0}, origin_x{0}, origin_y{0}
+    {
+    }
+
+    void ClearanceMap::update(const int8_t* costs, int width, int height,
+            double cell_size, double map_x, double map_y, int lethal_cost)
+    {
+        columns = width;
+        rows = height;
+        resolution = cell_size;
+        origin_x = map_x;
+        origin_y = map_y;
+
+        const int far = std::numeric_limits<int>::max() / 2;
+        distances.resize(columns * rows);
+        for (int i = 0; i < columns * rows; ++i)
+            distances[i] = (costs[i] < 0 || costs[i] >= lethal_cost) ? 0 : far;
+
+        //forward then backward pass over the 8 neighbours
+        for (int y = 0; y < rows; ++y)
+            for (int x = 0; x < columns; ++x)
+            {
+                int& d = distances[y * columns + x];
+                if (x > 0)
+                    d = std::min(d, distances[y * columns + x - 1] + STRAIGHT);
+                if (y > 0)
+                {
+                    d = std::min(d, distances[(y - 1) * columns + x] + STRAIGHT);
+                    if (x > 0)
+                        d = std::min(d, distances[(y - 1) * columns + x - 1] + DIAGONAL);
+                    if (x + 1 < columns)
+                        d = std::min(d, distances[(y - 1) * columns + x + 1] + DIAGONAL);
+                }
+            }
+        for (int y = rows - 1; y >= 0; --y)
+            for (int x = columns - 1; x >= 0; --x)
+            {
+                int& d = distances[y * columns + x];
+                if (x + 1 < columns)
+                    d = std::min(d, distances[y * columns + x + 1] + STRAIGHT);
+                if (y + 1 < rows)
+                {
+                    d = std::min(d, distances[(y + 1) * columns + x] + STRAIGHT);
+                    if (x + 1 < columns)
+                        d = std::min(d, distances[(y + 1) * columns + x + 1] + DIAGONAL);
+                    if (x > 0)
+                        d = std::min(d, distances[(y + 1) * columns + x - 1] + DIAGONAL);
+                }
+            }
+    }
+
+    double ClearanceMap::distance(double x, double y) const
+    {
+        int d = closest(x, y);
+        if (d < 0)
+            return -std::numeric_limits<double>::infinity();
+        return d * resolution / STRAIGHT;
+    }
+
+    double ClearanceMap::clearance(double x, double y, double yaw,
+            double linear, double angular,
+            const GovernorConstraints& constraints) const
+    {
+        int nearest = std::numeric_limits<int>::max();
+        for (double t = 0; t <= constraints.horizon; t += STEP)
+        {
+            int d = closest(x, y);
+            //off the map is out of what we can see, stop there
+            if (d < 0)
+                break;
+            nearest = std::min(nearest, d);
+            x += linear * std::cos(yaw) * STEP;
+            y += linear * std::sin(yaw) * STEP;
+            yaw += angular * STEP;
+        }
+        //no map, or we're off it ourselves
+        if (nearest == std::numeric_limits<int>::max())
+            return -std::numeric_limits<double>::infinity();
+        return nearest * resolution / STRAIGHT - constraints.inscribed_radius;
+    }
+
+    /*
+     * Chamfer distance of the cell holding a point, -1 off the map
+     * */
+    int ClearanceMap::closest(double x, double y) const
+    {
+        if (distances.empty())
+            return -1;
+        int column = std::floor((x - origin_x) / resolution);
+        int row = std::floor((y - origin_y) / resolution);
+        if (column < 0 || column >= columns || row < 0 || row >= rows)
+            return -1;
+        return distances[row * columns + column];
+    }
+
+    double rideStability(double tilt, double vibration, bool fresh,
+            const GovernorConstraints& constraints)
+    {
+        if (!fresh)
+            return 0;
+        double stability = std::min(1 - tilt / constraints.max_tilt,
+                1 - vibration / constraints.max_vibration);
+        return std::min(std::max(stability, 0.0), 1.0);
+    }
+
+    double speedCap(double clearance, double stability,
+            const GovernorConstraints& constraints)
+    {
+        double room = (clearance - constraints.near_clearance) /
+            (constraints.far_clearance - constraints.near_clearance);
+        double cap = constraints.min_speed + (constraints.max_speed - constraints.min_speed) *
+            std::min(std::max(room, 0.0), 1.0);
+        return constraints.min_speed + (cap - constraints.min_speed) *
+            std::min(std::max(stability, 0.0), 1.0);
+    }
+}
@@ -0,0 +1,289 @@
+/*
+ * Picks where to dig each cycle, so we stop going back to the same spot that
+ * was already scooped out.
+ *
+ * Keeps an elevation map of the mining zone in the bin frame, fed from the
+ * kinect whenever the zone is in view. The map is a fixed grid, old samples
+ * are faded out a little every update so it follows the ground as we dig it
+ * up without growing.
+ *
+ * Candidate parking poses are laid out on a lattice facing away from the bin.
+ * Each one is scored by how much material sits above the deepest the scoop
+ * can reach over the patch in front of it, less a small cost for driving
+ * further, and thrown out if the ground under the robot is too rough to
+ * park on. Patches we have already handed out are marked so unseen holes
+ * still count against a site.
+ *
+ * parameters:
+ *  - ~bin_frame: frame the map and goals are in (string, default: "bin_footprint")
+ *  - ~zone_min_x, ~zone_max_x, ~zone_min_y, ~zone_max_y: extent of the map
+ *  [m] (double, default: 4.4, 7.2, -1.7, 1.7)
+ *  - ~resolution: cell size [m] (double, default: 0.1)
+ *  - ~ground_height: undisturbed surface height [m] (double, default: 0.0)
+ *  - ~dig_depth: deepest the scoop reaches below the surface [m] (double, default: 0.3)
+ *  - ~dig_reach: footprint to the middle of the dig patch [m] (double, default: 1.45)
+ *  - ~patch_size: side of the square the scoop works [m] (double, default: 0.4)
+ *  - ~min_robot_x: closest parking spot to the bin [m] (double, default: 3.0)
+ *  - ~robot_length, ~robot_width: footprint checked for parking [m] (double,
+ *  default: 1.3, 0.9)
+ *  - ~max_step: roughest ground we will park on [m] (double, default: 0.15)
+ *  - ~candidate_step: lattice spacing [m] (double, default: 0.2)
+ *  - ~distance_weight: cost per meter of extra driving [m] (double, default: 0.01)
+ *  - ~unknown_fraction: how full an unseen cell is assumed to be (double,
+ *  default: 0.6)
+ *  - ~update_period: least time between map updates [s] (double, default: 0.5)
+ *  - ~fade: weight kept by old samples per update (double, default: 0.9)
+ *
+ * subscribed topics:
+ *  - depth/image_raw, depth/camera_info : the kinect depth stream
+ * services:
+ *  - /next_dig_site : (tfr_msgs/DigSite) the best place to park and dig
+ * */
+#include <ros/ros.h>
+#include <image_transport/image_transport.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <tfr_msgs/DigSite.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "elevation_grid.h"
+
+/*
+ * The shape of the robot and the scoop's work area
+ * */
+struct SiteConstraints
+{
+    double ground_height;
+    double dig_depth;
+    double dig_reach;
+    double patch_size;
+    double min_robot_x;
+    double robot_length;
+    double robot_width;
+    double max_step;
+    double candidate_step;
+    double distance_weight;
+    double unknown_fraction;
+};
+
+class DigSitePlanner
+{
+    public:
+        DigSitePlanner(ros::NodeHandle& n,
+                const std::string& b_frame,
+                const ElevationGrid::GridConstraints& g,
+                const SiteConstraints& s,
+                const double& period,
+                const double& f) :
+            tf_listener{tf_buffer},
+            image_transport{n},
+            bin_frame{b_frame},
+            grid_constraints{g},
+            constraints{s},
+            update_period{period},
+            fade{f},
+            map{g},
+            dug(map.getColumns() * map.getRows(), false)
+        {
+            subscriber = image_transport.subscribeCamera("depth/image_raw", 1,
+                    &DigSitePlanner::updateMap, this);
+            server = n.advertiseService("/next_dig_site",
+                    &DigSitePlanner::nextSite, this);
+        }
+
+        ~DigSitePlanner() = default;
+        DigSitePlanner(const DigSitePlanner&) = delete;
+        DigSitePlanner& operator=(const DigSitePlanner&) = delete;
+        DigSitePlanner(DigSitePlanner&&) = delete;
+        DigSitePlanner& operator=(DigSitePlanner&&) = delete;
+
+    private:
+        tf2_ros::Buffer tf_buffer;
+        tf2_ros::TransformListener tf_listener;
+        image_transport::ImageTransport image_transport;
+        image_transport::CameraSubscriber subscriber;
+        ros::ServiceServer server;
+        const std::string& bin_frame;
+        const ElevationGrid::GridConstraints& grid_constraints;
+        const SiteConstraints& constraints;
+        const double& update_period;
+        const double& fade;
+
+        ElevationGrid map;
+        //cells inside patches already handed out
+        std::vector<bool> dug;
+        ros::Time last_update;
+
+        void updateMap(const sensor_msgs::ImageConstPtr& image,
+                const sensor_msgs::CameraInfoConstPtr& info)
+        {
+            if ((image->header.stamp - last_update).toSec() < update_period)
+                return;
+
+            geometry_msgs::TransformStamped mount;
+            try
+            {
+                mount = tf_buffer.lookupTransform(bin_frame, image->header.frame_id,
+                        image->header.stamp, ros::Duration(0.05));
+            }
+            catch (tf2::TransformException &ex)
+            {
+                ROS_DEBUG("Dig Site Planner: %s", ex.what());
+                return;
+            }
+            tf2::Transform transform;
+            tf2::fromMsg(mount.transform, transform);
+            map.age(fade);
+            map.add(*image, *info, transform);
+            last_update = image->header.stamp;
+        }
+
+        bool nextSite(tfr_msgs::DigSite::Request& request,
+                tfr_msgs::DigSite::Response& response)
+        {
+            response.success = false;
+            double best_score = -std::numeric_limits<double>::infinity();
+            double best_x = 0, best_y = 0;
+
+            double half_patch = constraints.patch_size / 2;
+            double max_x = grid_constraints.max_x - constraints.dig_reach - half_patch;
+            double min_y = grid_constraints.min_y + constraints.robot_width / 2;
+            double max_y = grid_constraints.max_y - constraints.robot_width / 2;
+            for (double x = constraints.min_robot_x; x <= max_x; x += constraints.candidate_step)
+                for (double y = min_y; y <= max_y; y += constraints.candidate_step)
+                {
+                    if (!canPark(x, y))
+                        continue;
+                    //out and across from the straight line off the bin
+                    double travel = x - constraints.min_robot_x + std::abs(y);
+                    double score = availability(x + constraints.dig_reach, y) -
+                        constraints.distance_weight * travel;
+                    if (score > best_score)
+                    {
+                        best_score = score;
+                        best_x = x;
+                        best_y = y;
+                    }
+                }
+
+            if (std::isinf(best_score))
+            {
+                ROS_WARN("Dig Site Planner: no candidate site");
+                return true;
+            }
+            markDug(best_x + constraints.dig_reach, best_y);
+
+            response.pose.header.frame_id = bin_frame;
+            response.pose.header.stamp = ros::Time::now();
+            response.pose.pose.position.x = best_x;
+            response.pose.pose.position.y = best_y;
+            response.pose.pose.orientation.w = 1;
+            response.success = true;
+            ROS_INFO("Dig Site Planner: site %f %f score %f coverage %f",
+                    best_x, best_y, best_score, map.getCoverage());
+            return true;
+        }
+
+        /*
+         * Mean depth of material the scoop can still reach over the patch
+         * centered here
+         * */
+        double availability(double x, double y)
+        {
+            double half = constraints.patch_size / 2;
+            double floor = constraints.ground_height - constraints.dig_depth;
+            double total = 0;
+            int cells = 0;
+            for (double px = x - half; px < x + half; px += grid_constraints.resolution)
+                for (double py = y - half; py < y + half; py += grid_constraints.resolution)
+                {
+                    int column, row;
+                    if (!map.cellOf(px, py, column, row))
+                        continue;
+                    double height, material;
+                    if (map.height(column, row, height))
+                        material = std::min(std::max(height - floor, 0.0), constraints.dig_depth);
+                    else
+                        material = constraints.unknown_fraction * constraints.dig_depth;
+                    if (dug[row * map.getColumns() + column])
+                        material = 0;
+                    total += material;
+                    ++cells;
+                }
+            return cells == 0 ? 0 : total / cells;
+        }
+
+        /*
+         * The part of the footprint the map covers has to be smooth enough to
+         * sit on, the rest is outside the zone and was driven over to get here
+         * */
+        bool canPark(double x, double y)
+        {
+            double low = std::numeric_limits<double>::infinity();
+            double high = -low;
+            double half_length = constraints.robot_length / 2;
+            double half_width = constraints.robot_width / 2;
+            for (double px = x - half_length; px < x + half_length; px += grid_constraints.resolution)
+                for (double py = y - half_width; py < y + half_width; py += grid_constraints.resolution)
+                {
+                    int column, row;
+                    double height;
+                    if (!map.cellOf(px, py, column, row) || !map.height(column, row, height))
+                        continue;
+                    low = std::min(low, height);
+                    high = std::max(high, height);
+                }
+            return std::isinf(low) || high - low < constraints.max_step;
+        }
+
+        void markDug(double x, double y)
+        {
+            double half = constraints.patch_size / 2;
+            for (double px = x - half; px < x + half; px += grid_constraints.resolution)
+                for (double py = y - half; py < y + half; py += grid_constraints.resolution)
+                {
+                    int column, row;
+                    if (map.cellOf(px, py, column, row))
+                        dug[row * map.getColumns() + column] = true;
+                }
+        }
+};
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "dig_site_planner");
+    ros::NodeHandle n{};
+
+    std::string bin_frame;
+    ElevationGrid::GridConstraints grid;
+    SiteConstraints site;
+    double update_period, fade;
+    ros::param::param<std::string>("~bin_frame", bin_frame, "bin_footprint");
+    ros::param::param<double>("~zone_min_x", grid.min_x, 4.4);
+    ros::param::param<double>("~zone_max_x", grid.max_x, 7.2);
+    ros::param::param<double>("~zone_min_y", grid.min_y, -1.7);
+    ros::param::param<double>("~zone_max_y", grid.max_y, 1.7);
+    ros::param::param<double>("~resolution", grid.resolution, 0.1);
+    grid.pixel_step = 4;
+    grid.min_samples = 2;
+    ros::param::param<double>("~ground_height", site.ground_height, 0.0);
+    ros::param::param<double>("~dig_depth", site.dig_depth, 0.3);
+    ros::param::param<double>("~dig_reach", site.dig_reach, 1.45);
+    ros::param::param<double>("~patch_size", site.patch_size, 0.4);
+    ros::param::param<double>("~min_robot_x", site.min_robot_x, 3.0);
+    ros::param::param<double>("~robot_length", site.robot_length, 1.3);
+    ros::param::param<double>("~robot_width", site.robot_width, 0.9);
+    ros::param::param<double>("~max_step", site.max_step, 0.15);
+    ros::param::param<double>("~candidate_step", site.candidate_step, 0.2);
+    ros::param::param<double>("~distance_weight", site.distance_weight, 0.01);
+    ros::param::param<double>("~unknown_fraction", site.unknown_fraction, 0.6);
+    ros::param::param<double>("~update_period", update_period, 0.5);
+    ros::param::param<double>("~fade", fade, 0.9);
+
+    DigSitePlanner planner{n, bin_frame, grid, site, update_period, fade};
+    ros::spin();
+    return 0;
+}
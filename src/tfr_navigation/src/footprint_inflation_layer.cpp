@@ -0,0 +1,189 @@
+#include "footprint_inflation_layer.h"
+#include <pluginlib/class_list_macros.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+PLUGINLIB_EXPORT_CLASS(tfr_navigation::FootprintInflationLayer, costmap_2d::Layer)
+
+using costmap_2d::LETHAL_OBSTACLE;
+using costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+using costmap_2d::NO_INFORMATION;
+
+namespace
+{
+    /*
+     * True if the point is inside the polygon or within margin of its edge
+     * */
+    bool covers(const std::vector<geometry_msgs::Point>& polygon,
+            double x, double y, double margin)
+    {
+        bool inside = false;
+        double closest = std::numeric_limits<double>::infinity();
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++)
+        {
+            const auto& a = polygon[i];
+            const auto& b = polygon[j];
+            if ((a.y > y) != (b.y > y) &&
+                    x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x)
+                inside = !inside;
+
+            double dx = b.x - a.x, dy = b.y - a.y;
+            double length = dx * dx + dy * dy;
+            double t = length > 0 ? ((x - a.x) * dx + (y - a.y) * dy) / length : 0;
+            t = std::min(std::max(t, 0.0), 1.0);
+            closest = std::min(closest, std::hypot(a.x + t * dx - x, a.y + t * dy - y));
+        }
+        return inside || closest <= margin;
+    }
+}
+
+namespace tfr_navigation
+{
+    FootprintInflationLayer::FootprintInflationLayer() :
+        orientation_bins{16},
+        min_cost{128},
+        reach{0},
+        reach_meters{0},
+        need_full_update{true}
+    {
+    }
+
+    void FootprintInflationLayer::onInitialize()
+    {
+        ros::NodeHandle nh("~/" + name_);
+        nh.param("enabled", enabled_, true);
+        nh.param("orientation_bins", orientation_bins, 16);
+        nh.param("min_cost", min_cost, 128);
+        orientation_bins = std::min(std::max(orientation_bins, 1), 32);
+        min_cost = std::min(std::max(min_cost, 1), INSCRIBED_INFLATED_OBSTACLE - 1);
+        current_ = true;
+        computeKernels();
+    }
+
+    void FootprintInflationLayer::matchSize()
+    {
+        computeKernels();
+    }
+
+    void FootprintInflationLayer::onFootprintChanged()
+    {
+        computeKernels();
+    }
+
+    /*
+     * Rasterizes the footprint at each heading. A cell counts as covered if
+     * its center is within half a cell of the polygon, so a footprint edge
+     * that clips a cell still sees what is in it.
+     * */
+    void FootprintInflationLayer::computeKernels()
+    {
+        const auto& footprint = layered_costmap_->getFootprint();
+        double resolution = layered_costmap_->getCostmap()->getResolution();
+        kernels.assign(orientation_bins, std::vector<Offset>{});
+        reach = 0;
+        if (footprint.size() < 3 || resolution <= 0)
+            return;
+
+        double radius = 0;
+        for (const auto& point : footprint)
+            radius = std::max(radius, std::hypot(point.x, point.y));
+        int cells = std::ceil(radius / resolution) + 1;
+        double margin = resolution / 2;
+
+        std::vector<geometry_msgs::Point> rotated(footprint.size());
+        for (int bin = 0; bin < orientation_bins; ++bin)
+        {
+            double yaw = M_PI * bin / orientation_bins;
+            double c = std::cos(yaw), s = std::sin(yaw);
+            for (size_t i = 0; i < footprint.size(); ++i)
+            {
+                rotated[i].x = c * footprint[i].x - s * footprint[i].y;
+                rotated[i].y = s * footprint[i].x + c * footprint[i].y;
+            }
+            for (int y = -cells; y <= cells; ++y)
+                for (int x = -cells; x <= cells; ++x)
+                    if (covers(rotated, x * resolution, y * resolution, margin))
+                    {
+                        kernels[bin].push_back(Offset{x, y});
+                        reach = std::max(reach, std::max(std::abs(x), std::abs(y)));
+                    }
+        }
+        reach_meters = (reach + 1) * resolution;
+
+        //all bins blocked is inscribed, one is min_cost, graded in between
+        cost_table.assign(orientation_bins + 1, 0);
+        for (int count = 1; count <= orientation_bins; ++count)
+            cost_table[count] = (count == orientation_bins) ? INSCRIBED_INFLATED_OBSTACLE :
+                min_cost + (INSCRIBED_INFLATED_OBSTACLE - 1 - min_cost) * (count - 1) /
+                std::max(orientation_bins - 1, 1);
+        need_full_update = true;
+    }
+
+    void FootprintInflationLayer::updateBounds(double robot_x, double robot_y,
+            double robot_yaw, double* min_x, double* min_y, double* max_x, double* max_y)
+    {
+        if (!enabled_)
+            return;
+        if (need_full_update)
+        {
+            need_full_update = false;
+            *min_x = -std::numeric_limits<float>::max();
+            *min_y = -std::numeric_limits<float>::max();
+            *max_x = std::numeric_limits<float>::max();
+            *max_y = std::numeric_limits<float>::max();
+            return;
+        }
+        //an obstacle that changed blocks cells up to a footprint away
+        *min_x -= reach_meters;
+        *min_y -= reach_meters;
+        *max_x += reach_meters;
+        *max_y += reach_meters;
+    }
+
+    void FootprintInflationLayer::updateCosts(costmap_2d::Costmap2D& master_grid,
+            int min_i, int min_j, int max_i, int max_j)
+    {
+        if (!enabled_ || kernels.empty() || max_i <= min_i || max_j <= min_j)
+            return;
+
+        unsigned char* master = master_grid.getCharMap();
+        int size_x = master_grid.getSizeInCellsX();
+        int size_y = master_grid.getSizeInCellsY();
+        int width = max_i - min_i, height = max_j - min_j;
+        blocked.assign(width * height, 0);
+
+        //obstacles just outside the window still block cells inside it
+        int x_0 = std::max(0, min_i - reach), x_1 = std::min(size_x, max_i + reach);
+        int y_0 = std::max(0, min_j - reach), y_1 = std::min(size_y, max_j + reach);
+        for (int oy = y_0; oy < y_1; ++oy)
+            for (int ox = x_0; ox < x_1; ++ox)
+            {
+                if (master[oy * size_x + ox] != LETHAL_OBSTACLE)
+                    continue;
+                //the robot at o - offset would put that offset on the obstacle
+                for (int bin = 0; bin < orientation_bins; ++bin)
+                {
+                    uint32_t bit = 1u << bin;
+                    for (const auto& offset : kernels[bin])
+                    {
+                        int cx = ox - offset.x - min_i, cy = oy - offset.y - min_j;
+                        if (cx >= 0 && cx < width && cy >= 0 && cy < height)
+                            blocked[cy * width + cx] |= bit;
+                    }
+                }
+            }
+
+        for (int y = 0; y < height; ++y)
+            for (int x = 0; x < width; ++x)
+            {
+                uint32_t bins = blocked[y * width + x];
+                if (bins == 0)
+                    continue;
+                unsigned char cost = cost_table[__builtin_popcount(bins)];
+                unsigned char& old = master[(y + min_j) * size_x + x + min_i];
+                if (old == NO_INFORMATION ? cost >= INSCRIBED_INFLATED_OBSTACLE : old < cost)
+                    old = cost;
+            }
+    }
+}
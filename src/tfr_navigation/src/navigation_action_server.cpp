@@ -5,7 +5,11 @@
 #include <move_base_msgs/MoveBaseAction.h>
 #include <tfr_msgs/NavigationAction.h>
 #include <tfr_msgs/PoseSrv.h>
+#include <tfr_msgs/DigSite.h>
 #include <tfr_utilities/location_codes.h>
+#include <tfr_utilities/component_nodelet.h>
+#include <tfr_utilities/trace_log.h>
+#include <pluginlib/class_list_macros.h>
 #include <boost/bind.hpp>
 #include <cstdint>
 class Navigator
@@ -40,7 +44,8 @@ class Navigator
         Navigator(ros::NodeHandle& n,
                 const GeometryConstraints &c,
                 const double& height_adj,
-                const std::string &bin_f):
+                const std::string &bin_f,
+                const bool& plan_sites):
             node{n}, 
             rate{10},
             height_adjustment{height_adj},
@@ -48,7 +53,8 @@ class Navigator
             server{n, "navigate", boost::bind(&Navigator::navigate, this, _1) ,
             false}, 
             nav_stack{n, "move_base", true},
-            bin_frame{bin_f}
+            bin_frame{bin_f},
+            use_site_planner{plan_sites}
         {
             ROS_DEBUG("Navigation server constructed %f", ros::Time::now().toSec());
             
@@ -102,7 +108,8 @@ class Navigator
             //test for completion
             while (true)
             {
-                ROS_INFO("%d %d", server.isPreemptRequested(), server.isActive());
+                TFR_DEBUG_LIMITED(1.0, "preempt %d active %d", server.isPreemptRequested(),
+                        server.isActive());
 
                 //Deal with preemption or error
                 if (server.isPreemptRequested() || !ros::ok()) 
@@ -116,7 +123,7 @@ class Navigator
                 {
                     rate.sleep();
                 }
-                ROS_INFO("state %s", nav_stack.getState().toString().c_str());
+                TFR_INFO_LIMITED(1.0, "state %s", nav_stack.getState().toString().c_str());
                 if (nav_stack.getState().isDone())
                     break;
             }
@@ -141,6 +148,7 @@ class Navigator
         std::string action_name{};
         ros::Rate rate;
         const double& height_adjustment;
+        const bool& use_site_planner;
         
         //the constraints to the problem
         const GeometryConstraints &constraints;
@@ -158,6 +166,19 @@ class Navigator
                     nav_goal.target_pose.pose.position.x = constraints.get_safe_mining_distance();
                     nav_goal.target_pose.pose.position.z = height_adjustment;
                     nav_goal.target_pose.pose.orientation.w = 1;
+                    if (use_site_planner)
+                    {
+                        //fall back on straight out from the bin if it isn't up
+                        tfr_msgs::DigSite site;
+                        if (ros::service::call("/next_dig_site", site) && site.response.success)
+                        {
+                            nav_goal.target_pose.pose.position.x = site.response.pose.pose.position.x;
+                            nav_goal.target_pose.pose.position.y = site.response.pose.pose.position.y;
+                            nav_goal.target_pose.pose.orientation = site.response.pose.pose.orientation;
+                        }
+                        else
+                            ROS_WARN("Navigation server: no dig site, using safe_mining_distance");
+                    }
                     break;
                 case(tfr_utilities::LocationCode::DUMPING):
                     nav_goal.target_pose.pose.position.x = constraints.get_finish_line();
@@ -174,25 +195,40 @@ class Navigator
         }
 };
 
-/**
- * Main entry point for the navigation action server, spins up the server and
- * awaits callbacks.
+/*
+ * Runs the navigation action server as the tfr_navigation/Navigator nodelet
  * */
-int main(int argc, char** argv)
+namespace tfr_navigation
 {
-    ros::init(argc, argv, "navigation_action_server");
-    ros::NodeHandle n;
-    double safe_mining_distance, finish_line, height_adjustment;
-    std::string bin_frame;
-
-    ros::param::param<double>("~safe_mining_distance", safe_mining_distance, 5.1);
-    ros::param::param<double>("~finish_line", finish_line, 0.84);
-    ros::param::param<double>("~height_adjustment", height_adjustment, -.16);
-    ros::param::param<std::string>("~bin_frame", bin_frame, "bin_footprint");
-
-    Navigator::GeometryConstraints 
-        constraints(safe_mining_distance, finish_line);
-    Navigator navigator(n, constraints, height_adjustment, bin_frame);
-    ros::spin();
-    return 0;
+    class NavigatorNodelet : public ComponentNodelet
+    {
+        public:
+            ~NavigatorNodelet() { stop(); }
+
+        private:
+            //the navigator keeps references to these
+            double height_adjustment;
+            std::string bin_frame;
+            bool use_site_planner;
+            std::unique_ptr<Navigator::GeometryConstraints> constraints;
+            std::unique_ptr<Navigator> navigator;
+
+            void start() override
+            {
+                ros::NodeHandle &p_n = getPrivateNodeHandle();
+                double safe_mining_distance, finish_line;
+                p_n.param<double>("safe_mining_distance", safe_mining_distance, 5.1);
+                p_n.param<double>("finish_line", finish_line, 0.84);
+                p_n.param<double>("height_adjustment", height_adjustment, -.16);
+                p_n.param<std::string>("bin_frame", bin_frame, "bin_footprint");
+                p_n.param<bool>("use_site_planner", use_site_planner, false);
+
+                constraints.reset(new Navigator::GeometryConstraints(safe_mining_distance,
+                            finish_line));
+                navigator.reset(new Navigator(getNodeHandle(), *constraints,
+                            height_adjustment, bin_frame, use_site_planner));
+            }
+    };
 }
+
+PLUGINLIB_EXPORT_CLASS(tfr_navigation::NavigatorNodelet, nodelet::Nodelet)
@@ -0,0 +1,240 @@
+#include "pivot_lattice.h"
+#include <costmap_2d/cost_values.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using costmap_2d::INSCRIBED_INFLATED_OBSTACLE;
+using costmap_2d::NO_INFORMATION;
+
+namespace
+{
+    //the step each heading takes, counterclockwise from +x
+    const int LATTICE[tfr_navigation::PivotLattice::HEADINGS][2] =
+    {
+        {1, 0}, {2, 1}, {1, 1}, {1, 2}, {0, 1}, {-1, 2}, {-1, 1}, {-2, 1},
+        {-1, 0}, {-2, -1}, {-1, -1}, {-1, -2}, {0, -1}, {1, -2}, {1, -1}, {2, -1}
+    };
+
+    //samples along a step when finding the cells it sweeps, per cell
+    const int SWEEP_SAMPLES = 16;
+
+    const uint8_t BLOCKED = 255;
+
+    /*
+     * Time to move distance from rest to rest at up to speed, with a
+     * trapezoidal profile
+     * */
+    double profileTime(double distance, double speed, double acceleration)
+    {
+        if (distance >= speed * speed / acceleration)
+            return distance / speed + speed / acceleration;
+        return 2 * std::sqrt(distance / acceleration);
+    }
+}
+
+namespace tfr_navigation
+{
+    const int PivotLattice::HEADINGS;
+
+    PivotLattice::PivotLattice() :
+        steps{}, pivot_times{}, min_pivot{0}, resolution{1}, speed{1},
+        cost_weight{0}, pivot_cost_limit{0}, allow_unknown{true},
+        best{}, parents{}, closed{}, open{}, plan_time{0}, expanded{0}
+    {
+    }
+
+    int PivotLattice::nearestHeading(double yaw)
+    {
+        int nearest = 0;
+        double closest = std::numeric_limits<double>::infinity();
+        for (int heading = 0; heading < HEADINGS; ++heading)
+        {
+            double difference = std::abs(std::remainder(yaw - headingYaw(heading), 2 * M_PI));
+            if (difference < closest)
+            {
+                closest = difference;
+                nearest = heading;
+            }
+        }
+        return nearest;
+    }
+
+    double PivotLattice::headingYaw(int heading)
+    {
+        return std::atan2(LATTICE[heading][1], LATTICE[heading][0]);
+    }
+
+    void PivotLattice::configure(const TreadDynamics& dynamics,
+            const LatticeCosts& costs, double cell_size)
+    {
+        resolution = cell_size;
+        speed = dynamics.linear_speed;
+        cost_weight = costs.cost_weight;
+        pivot_cost_limit = costs.pivot_cost_limit;
+        allow_unknown = costs.allow_unknown;
+
+        for (int heading = 0; heading < HEADINGS; ++heading)
+        {
+            Step& step = steps[heading];
+            step.dx = LATTICE[heading][0];
+            step.dy = LATTICE[heading][1];
+            //cruising, the stops and starts are charged to the pivots
+            step.time = std::hypot(step.dx, step.dy) * resolution / speed;
+            step.swept_x.clear();
+            step.swept_y.clear();
+            int samples = SWEEP_SAMPLES * std::max(std::abs(step.dx), std::abs(step.dy));
+            for (int i = 1; i <= samples; ++i)
+            {
+                int x = std::floor(step.dx * i / double(samples) + 0.5);
+                int y = std::floor(step.dy * i / double(samples) + 0.5);
+                bool seen = (x == 0 && y == 0);
+                for (size_t j = 0; j < step.swept_x.size() && !seen; ++j)
+                    seen = step.swept_x[j] == x && step.swept_y[j] == y;
+                if (!seen)
+                {
+                    step.swept_x.push_back(x);
+                    step.swept_y.push_back(y);
+                }
+            }
+        }
+
+        //stopping and starting again loses half the ramp each way
+        double stop_start = dynamics.linear_speed / dynamics.linear_acceleration;
+        min_pivot = std::numeric_limits<double>::infinity();
+        for (int from = 0; from < HEADINGS; ++from)
+            for (int to = 0; to < HEADINGS; ++to)
+            {
+                double angle = std::abs(std::remainder(headingYaw(to) - headingYaw(from), 2 * M_PI));
+                pivot_times[from][to] = (from == to) ? 0 : stop_start + dynamics.pivot_delay +
+                    profileTime(angle, dynamics.pivot_speed, dynamics.pivot_acceleration);
+                if (from != to)
+                    min_pivot = std::min(min_pivot, pivot_times[from][to]);
+            }
+    }
+
+    unsigned char PivotLattice::cellCost(unsigned char cost) const
+    {
+        if (cost == NO_INFORMATION)
+            return allow_unknown ? 0 : BLOCKED;
+        return cost >= INSCRIBED_INFLATED_OBSTACLE ? BLOCKED : cost;
+    }
+
+    float PivotLattice::heuristic(int x, int y, int heading, int goal_x, int goal_y) const
+    {
+        int dx = goal_x - x, dy = goal_y - y;
+        double time = std::hypot(dx, dy) * resolution / speed;
+        //unless the goal is straight ahead on the lattice, there's a pivot
+        //somewhere on the way
+        const Step& step = steps[heading];
+        bool ahead = dx * step.dy == dy * step.dx && dx * step.dx + dy * step.dy >= 0 &&
+            dx % std::max(std::abs(step.dx), 1) == 0 && dy % std::max(std::abs(step.dy), 1) == 0;
+        if (!ahead)
+            time += min_pivot;
+        return time;
+    }
+
+    /*
+     * A* over (cell, heading). The open list is a binary heap in a reused
+     * vector, entries go stale instead of being decreased and are skipped
+     * when they come off.
+     * */
+    bool PivotLattice::plan(const unsigned char* costs, int size_x, int size_y,
+            const State& start, int goal_x, int goal_y, std::vector<State>& path)
+    {
+        path.clear();
+        expanded = 0;
+        auto inside = [size_x, size_y] (int x, int y)
+        {
+            return x >= 0 && y >= 0 && x < size_x && y < size_y;
+        };
+        if (!inside(start.x, start.y) || !inside(goal_x, goal_y) ||
+                start.heading < 0 || start.heading >= HEADINGS ||
+                cellCost(costs[goal_y * size_x + goal_x]) == BLOCKED)
+            return false;
+
+        size_t states = static_cast<size_t>(size_x) * size_y * HEADINGS;
+        best.assign(states, std::numeric_limits<float>::infinity());
+        parents.resize(states);
+        closed.assign(states, 0);
+        open.clear();
+
+        auto indexOf = [size_x] (int x, int y, int heading)
+        {
+            return static_cast<uint32_t>((y * size_x + x) * HEADINGS + heading);
+        };
+        //ties go to the deeper state, it's closer to done
+        auto later = [] (const Open& a, const Open& b)
+        {
+            return a.f > b.f || (a.f == b.f && a.g < b.g);
+        };
+        auto push = [&] (uint32_t index, uint32_t parent, float g, int x, int y, int heading)
+        {
+            if (g >= best[index])
+                return;
+            best[index] = g;
+            parents[index] = parent;
+            open.push_back(Open{g + heuristic(x, y, heading, goal_x, goal_y), g, index});
+            std::push_heap(open.begin(), open.end(), later);
+        };
+
+        uint32_t start_index = indexOf(start.x, start.y, start.heading);
+        push(start_index, start_index, 0, start.x, start.y, start.heading);
+        while (!open.empty())
+        {
+            std::pop_heap(open.begin(), open.end(), later);
+            Open current = open.back();
+            open.pop_back();
+            if (closed[current.index])
+                continue;
+            closed[current.index] = 1;
+            ++expanded;
+
+            int heading = current.index % HEADINGS;
+            int cell = current.index / HEADINGS;
+            int x = cell % size_x, y = cell / size_x;
+            if (x == goal_x && y == goal_y)
+            {
+                plan_time = current.g;
+                for (uint32_t index = current.index; ; index = parents[index])
+                {
+                    int at = index / HEADINGS;
+                    path.push_back(State{at % size_x, at / size_x,
+                            static_cast<int>(index % HEADINGS)});
+                    if (index == start_index)
+                        break;
+                }
+                std::reverse(path.begin(), path.end());
+                return true;
+            }
+
+            //a step straight on, as slow as the worst cell it sweeps
+            const Step& step = steps[heading];
+            int next_x = x + step.dx, next_y = y + step.dy;
+            if (inside(next_x, next_y))
+            {
+                unsigned char worst = 0;
+                for (size_t i = 0; i < step.swept_x.size() && worst != BLOCKED; ++i)
+                {
+                    int sx = x + step.swept_x[i], sy = y + step.swept_y[i];
+                    worst = inside(sx, sy) ?
+                        std::max(worst, cellCost(costs[sy * size_x + sx])) : BLOCKED;
+                }
+                if (worst != BLOCKED)
+                {
+                    double slowdown = 1 + cost_weight * worst / (INSCRIBED_INFLATED_OBSTACLE - 1);
+                    push(indexOf(next_x, next_y, heading), current.index,
+                            current.g + step.time * slowdown, next_x, next_y, heading);
+                }
+            }
+
+            //or a pivot, where the footprint can turn
+            if (cellCost(costs[cell]) <= pivot_cost_limit)
+                for (int to = 0; to < HEADINGS; ++to)
+                    if (to != heading)
+                        push(indexOf(x, y, to), current.index,
+                                current.g + pivot_times[heading][to], x, y, to);
+        }
+        return false;
+    }
+}
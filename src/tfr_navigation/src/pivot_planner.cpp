@@ -0,0 +1,120 @@
+#include "pivot_planner.h"
+#include <pluginlib/class_list_macros.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/utils.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <boost/thread/locks.hpp>
+#include <algorithm>
+
+PLUGINLIB_EXPORT_CLASS(tfr_navigation::PivotPlanner, nav_core::BaseGlobalPlanner)
+
+namespace tfr_navigation
+{
+    PivotPlanner::PivotPlanner() :
+        costmap_ros{nullptr},
+        dynamics{0.5, 0.5, 0.6, 0.7, 0.5},
+        costs{1.0, 127, true},
+        resolution{0},
+        initialized{false}
+    {
+    }
+
+    void PivotPlanner::initialize(std::string name, costmap_2d::Costmap2DROS* costmap)
+    {
+        if (initialized)
+        {
+            ROS_WARN("Pivot Planner: already initialized");
+            return;
+        }
+        costmap_ros = costmap;
+        ros::NodeHandle nh("~/" + name);
+        nh.param("linear_speed", dynamics.linear_speed, 0.5);
+        nh.param("linear_acceleration", dynamics.linear_acceleration, 0.5);
+        nh.param("pivot_speed", dynamics.pivot_speed, 0.6);
+        nh.param("pivot_acceleration", dynamics.pivot_acceleration, 0.7);
+        nh.param("pivot_delay", dynamics.pivot_delay, 0.5);
+        nh.param("cost_weight", costs.cost_weight, 1.0);
+        nh.param("pivot_cost_limit", costs.pivot_cost_limit, 127);
+        nh.param("allow_unknown", costs.allow_unknown, true);
+        if (dynamics.linear_speed <= 0 || dynamics.linear_acceleration <= 0 ||
+                dynamics.pivot_speed <= 0 || dynamics.pivot_acceleration <= 0 ||
+                dynamics.pivot_delay < 0 || costs.cost_weight < 0)
+        {
+            ROS_WARN("Pivot Planner: speeds and accelerations should be positive, using defaults");
+            dynamics = TreadDynamics{0.5, 0.5, 0.6, 0.7, 0.5};
+            costs.cost_weight = std::max(costs.cost_weight, 0.0);
+        }
+        plan_publisher = nh.advertise<nav_msgs::Path>("plan", 1);
+        initialized = true;
+    }
+
+    bool PivotPlanner::makePlan(const geometry_msgs::PoseStamped& start,
+            const geometry_msgs::PoseStamped& goal,
+            std::vector<geometry_msgs::PoseStamped>& plan)
+    {
+        plan.clear();
+        if (!initialized)
+        {
+            ROS_ERROR("Pivot Planner: not initialized");
+            return false;
+        }
+
+        costmap_2d::Costmap2D* costmap = costmap_ros->getCostmap();
+        //the whole plan is against one snapshot of the map
+        boost::unique_lock<costmap_2d::Costmap2D::mutex_t> lock(*costmap->getMutex());
+        if (costmap->getResolution() != resolution)
+        {
+            resolution = costmap->getResolution();
+            lattice.configure(dynamics, costs, resolution);
+        }
+
+        unsigned int start_x, start_y, goal_x, goal_y;
+        if (!costmap->worldToMap(start.pose.position.x, start.pose.position.y, start_x, start_y))
+        {
+            ROS_WARN("Pivot Planner: start is off the costmap");
+            return false;
+        }
+        if (!costmap->worldToMap(goal.pose.position.x, goal.pose.position.y, goal_x, goal_y))
+        {
+            ROS_WARN("Pivot Planner: goal is off the costmap");
+            return false;
+        }
+
+        PivotLattice::State from{static_cast<int>(start_x), static_cast<int>(start_y),
+            PivotLattice::nearestHeading(tf2::getYaw(start.pose.orientation))};
+        ros::WallTime began = ros::WallTime::now();
+        bool found = lattice.plan(costmap->getCharMap(), costmap->getSizeInCellsX(),
+                costmap->getSizeInCellsY(), from, goal_x, goal_y, states);
+        double took = (ros::WallTime::now() - began).toSec();
+        if (!found)
+        {
+            ROS_WARN("Pivot Planner: no path, %d states in %.1f ms",
+                    lattice.getExpanded(), took * 1000);
+            return false;
+        }
+        ROS_DEBUG("Pivot Planner: %.1f s drive, %d states in %.1f ms",
+                lattice.getPlanTime(), lattice.getExpanded(), took * 1000);
+
+        //the ends are the poses as given, the lattice only has their cells
+        plan.push_back(start);
+        geometry_msgs::PoseStamped pose{};
+        pose.header.frame_id = costmap_ros->getGlobalFrameID();
+        pose.header.stamp = ros::Time::now();
+        for (size_t i = 1; i + 1 < states.size(); ++i)
+        {
+            costmap->mapToWorld(states[i].x, states[i].y,
+                    pose.pose.position.x, pose.pose.position.y);
+            tf2::Quaternion orientation;
+            orientation.setRPY(0, 0, PivotLattice::headingYaw(states[i].heading));
+            pose.pose.orientation = tf2::toMsg(orientation);
+            plan.push_back(pose);
+        }
+        plan.push_back(goal);
+
+        nav_msgs::Path path{};
+        path.header = pose.header;
+        path.poses = plan;
+        plan_publisher.publish(path);
+        return true;
+    }
+}
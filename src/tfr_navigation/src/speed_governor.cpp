@@ -0,0 +1,214 @@
+/*
+ * Sits between move_base and the drivebase and sets how fast we may drive
+ * from how much room there is, instead of one cap for the whole arena.
+ *
+ * Every local costmap is turned into a distance field (see clearance_map.h).
+ * Each command is rolled forward along its arc for a short
+ * horizon, and the clearance is the closest the path gets to an obstacle less
+ * the inscribed radius. The cap goes linearly from min_speed at near_clearance
+ * to max_speed at far_clearance. Unknown cells count as obstacles, and with
+ * no costmap, no transform or the robot off the map the cap stays at
+ * min_speed. The pose comes from tf in the costmap's frame, with the leading
+ * slash costmap_2d allows (global_frame: /odom) stripped off for tf2.
+ *
+ * Anything over min_speed has to be backed up by the imu: fresh data, tilt
+ * under max_tilt, and vibration (deviation of the acceleration magnitude)
+ * under max_vibration, with the cap falling off as either one climbs.
+ *
+ * Commands over the cap are scaled down as a whole, so the arc the planner
+ * picked is kept.
+ *
+ * parameters:
+ *  - ~footprint_frame: (string, default: "base_footprint")
+ *  - ~min_speed: cap in clutter or without the imu [m/s] (double, default: 0.33)
+ *  - ~max_speed: cap in the open [m/s] (double, default: 0.6)
+ *  - ~near_clearance: clearance at which the cap is min_speed [m] (double, default: 0.3)
+ *  - ~far_clearance: clearance at which the cap is max_speed [m] (double, default: 1.2)
+ *  - ~inscribed_radius: half the robot width [m] (double, default: 0.33)
+ *  - ~horizon: how far ahead the command is rolled out [s] (double, default: 2.0)
+ *  - ~lethal_cost: costmap values at or over this are obstacles, the
+ *  inflation is already covered by inscribed_radius (int, default: 100)
+ *  - ~max_tilt: roll or pitch that holds us to min_speed [rad] (double, default: 0.25)
+ *  - ~max_vibration: acceleration deviation that holds us to min_speed [m/s^2]
+ *  (double, default: 3.0)
+ *  - ~imu_timeout: imu data older than this doesn't count [s] (double, default: 0.5)
+ *
+ * subscribed topics:
+ *  - cmd_vel_raw : (geometry_msgs/Twist) commands from move_base
+ *  - /move_base/local_costmap/costmap : (nav_msgs/OccupancyGrid)
+ *  - /sensors/mti/sensor/imu : (sensor_msgs/Imu)
+ * published topics:
+ *  - cmd_vel : (geometry_msgs/Twist) the governed command
+ * */
+#include <ros/ros.h>
+#include <geometry_msgs/Twist.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <sensor_msgs/Imu.h>
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "clearance_map.h"
+
+using tfr_navigation::ClearanceMap;
+using tfr_navigation::GovernorConstraints;
+
+namespace
+{
+    //costmap_2d takes frames like "/odom" but tf2 rejects the leading slash
+    std::string stripSlash(const std::string& frame)
+    {
+        return (!frame.empty() && frame[0] == '/') ? frame.substr(1) : frame;
+    }
+}
+
+class SpeedGovernor
+{
+    public:
+        SpeedGovernor(ros::NodeHandle& n, const std::string& f_frame,
+                const GovernorConstraints& c) :
+            tf_listener{tf_buffer},
+            footprint_frame{stripSlash(f_frame)},
+            constraints{c},
+            tilt{0},
+            vibration{0},
+            mean_acceleration{9.81}
+        {
+            publisher = n.advertise<geometry_msgs::Twist>("cmd_vel", 5);
+            command_subscriber = n.subscribe("cmd_vel_raw", 5,
+                    &SpeedGovernor::govern, this);
+            costmap_subscriber = n.subscribe("/move_base/local_costmap/costmap", 1,
+                    &SpeedGovernor::updateDistances, this);
+            imu_subscriber = n.subscribe("/sensors/mti/sensor/imu", 20,
+                    &SpeedGovernor::updateStability, this);
+        }
+
+        ~SpeedGovernor() = default;
+        SpeedGovernor(const SpeedGovernor&) = delete;
+        SpeedGovernor& operator=(const SpeedGovernor&) = delete;
+        SpeedGovernor(SpeedGovernor&&) = delete;
+        SpeedGovernor& operator=(SpeedGovernor&&) = delete;
+
+    private:
+        //smoothing of the vibration estimate per imu sample
+        const double VIBRATION_GAIN = 0.05;
+
+        tf2_ros::Buffer tf_buffer;
+        tf2_ros::TransformListener tf_listener;
+        ros::Publisher publisher;
+        ros::Subscriber command_subscriber, costmap_subscriber, imu_subscriber;
+        const std::string footprint_frame;
+        const GovernorConstraints& constraints;
+
+        ClearanceMap clearance_map;
+        std::string costmap_frame;
+
+        double tilt, vibration, mean_acceleration;
+        ros::Time last_imu;
+
+        geometry_msgs::Twist governed;
+
+        void updateDistances(const nav_msgs::OccupancyGridConstPtr& map)
+        {
+            const auto& info = map->info;
+            clearance_map.update(map->data.data(), info.width, info.height,
+                    info.resolution, info.origin.position.x, info.origin.position.y,
+                    constraints.lethal_cost);
+            costmap_frame = stripSlash(map->header.frame_id);
+        }
+
+        void updateStability(const sensor_msgs::ImuConstPtr& imu)
+        {
+            tf2::Quaternion orientation;
+            tf2::fromMsg(imu->orientation, orientation);
+            double roll, pitch, yaw;
+            tf2::Matrix3x3(orientation).getRPY(roll, pitch, yaw);
+            tilt = std::max(std::abs(roll), std::abs(pitch));
+
+            const auto& a = imu->linear_acceleration;
+            double magnitude = std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+            mean_acceleration += VIBRATION_GAIN * (magnitude - mean_acceleration);
+            vibration += VIBRATION_GAIN * (std::abs(magnitude - mean_acceleration) - vibration);
+            last_imu = ros::Time::now();
+        }
+
+        /*
+         * Closest the command's arc gets to an obstacle. Negative infinity if
+         * we have no map or pose to check against.
+         * */
+        double clearance(const geometry_msgs::Twist& command)
+        {
+            if (!clearance_map.hasMap())
+                return -std::numeric_limits<double>::infinity();
+            geometry_msgs::TransformStamped pose;
+            try
+            {
+                pose = tf_buffer.lookupTransform(costmap_frame, footprint_frame, ros::Time(0));
+            }
+            catch (tf2::TransformException &ex)
+            {
+                ROS_WARN_THROTTLE(5, "Speed Governor: %s", ex.what());
+                return -std::numeric_limits<double>::infinity();
+            }
+            tf2::Quaternion rotation;
+            tf2::fromMsg(pose.transform.rotation, rotation);
+            double roll, pitch, yaw;
+            tf2::Matrix3x3(rotation).getRPY(roll, pitch, yaw);
+            return clearance_map.clearance(pose.transform.translation.x,
+                    pose.transform.translation.y, yaw,
+                    command.linear.x, command.angular.z, constraints);
+        }
+
+        void govern(const geometry_msgs::TwistConstPtr& command)
+        {
+            governed = *command;
+            double speed = std::abs(command->linear.x);
+            if (speed <= constraints.min_speed)
+            {
+                publisher.publish(governed);
+                return;
+            }
+
+            //only go past the safe baseline if the imu says the ride is smooth
+            bool fresh = (ros::Time::now() - last_imu).toSec() < constraints.imu_timeout;
+            double cap = tfr_navigation::speedCap(clearance(*command),
+                    tfr_navigation::rideStability(tilt, vibration, fresh, constraints),
+                    constraints);
+
+            if (speed > cap)
+            {
+                double scale = cap / speed;
+                governed.linear.x *= scale;
+                governed.angular.z *= scale;
+                ROS_DEBUG_THROTTLE(1, "Speed Governor: capped to %f", cap);
+            }
+            publisher.publish(governed);
+        }
+};
+
+int main(int argc, char** argv)
+{
+    ros::init(argc, argv, "speed_governor");
+    ros::NodeHandle n{};
+
+    std::string footprint_frame;
+    GovernorConstraints constraints;
+    ros::param::param<std::string>("~footprint_frame", footprint_frame, "base_footprint");
+    ros::param::param<double>("~min_speed", constraints.min_speed, 0.33);
+    ros::param::param<double>("~max_speed", constraints.max_speed, 0.6);
+    ros::param::param<double>("~near_clearance", constraints.near_clearance, 0.3);
+    ros::param::param<double>("~far_clearance", constraints.far_clearance, 1.2);
+    ros::param::param<double>("~inscribed_radius", constraints.inscribed_radius, 0.33);
+    ros::param::param<double>("~horizon", constraints.horizon, 2.0);
+    ros::param::param<int>("~lethal_cost", constraints.lethal_cost, 100);
+    ros::param::param<double>("~max_tilt", constraints.max_tilt, 0.25);
+    ros::param::param<double>("~max_vibration", constraints.max_vibration, 3.0);
+    ros::param::param<double>("~imu_timeout", constraints.imu_timeout, 0.5);
+
+    SpeedGovernor governor{n, footprint_frame, constraints};
+    ros::spin();
+    return 0;
+}
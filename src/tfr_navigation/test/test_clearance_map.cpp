@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "clearance_map.h"
+
+using tfr_navigation::ClearanceMap;
+using tfr_navigation::GovernorConstraints;
+
+namespace
+{
+    const GovernorConstraints CONSTRAINTS{0.33, 0.6, 0.3, 1.2, 0.33, 2.0, 100,
+        0.25, 3.0, 0.5};
+    const double RESOLUTION = 0.1;
+    const int SIZE = 20;
+
+    struct Grid
+    {
+        std::vector<int8_t> costs;
+        Grid() : costs(SIZE * SIZE, 0) {}
+        void set(int x, int y, int8_t cost) { costs[y * SIZE + x] = cost; }
+        void load(ClearanceMap& map) const
+        {
+            map.update(costs.data(), SIZE, SIZE, RESOLUTION, 0, 0,
+                    CONSTRAINTS.lethal_cost);
+        }
+    };
+
+    //the middle of a cell
+    double at(int cell) { return (cell + 0.5) * RESOLUTION; }
+}
+
+TEST(ClearanceMap, DistanceField)
+{
+    Grid grid{};
+    grid.set(10, 10, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    ASSERT_TRUE(map.hasMap());
+    EXPECT_NEAR(map.distance(at(10), at(10)), 0.0, 1e-9);
+    EXPECT_NEAR(map.distance(at(11), at(10)), 0.1, 1e-9);
+    EXPECT_NEAR(map.distance(at(10), at(8)), 0.2, 1e-9);
+    EXPECT_NEAR(map.distance(at(11), at(11)), 0.14, 1e-9);
+}
+
+TEST(ClearanceMap, LowCostIsFree)
+{
+    Grid grid{};
+    grid.set(10, 10, 99);
+    grid.set(0, 10, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    EXPECT_NEAR(map.distance(at(10), at(10)), 1.0, 1e-9);
+}
+
+TEST(ClearanceMap, UnknownIsAnObstacle)
+{
+    Grid grid{};
+    grid.set(10, 10, -1);
+    ClearanceMap map{};
+    grid.load(map);
+    EXPECT_NEAR(map.distance(at(10), at(10)), 0.0, 1e-9);
+    EXPECT_NEAR(map.distance(at(13), at(10)), 0.3, 1e-9);
+}
+
+TEST(ClearanceMap, BlindWithoutAMap)
+{
+    ClearanceMap map{};
+    ASSERT_FALSE(map.hasMap());
+    EXPECT_EQ(map.distance(at(5), at(5)), -INFINITY);
+    EXPECT_EQ(map.clearance(at(5), at(5), 0, 0.5, 0, CONSTRAINTS), -INFINITY);
+}
+
+TEST(ClearanceMap, BlindOffTheMap)
+{
+    Grid grid{};
+    grid.set(10, 10, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    EXPECT_EQ(map.distance(-0.05, at(5)), -INFINITY);
+    EXPECT_EQ(map.distance(at(5), at(SIZE)), -INFINITY);
+    EXPECT_EQ(map.clearance(-1, -1, 0, 0.5, 0, CONSTRAINTS), -INFINITY);
+}
+
+TEST(ClearanceMap, StandingStillIsTheCurrentCell)
+{
+    Grid grid{};
+    grid.set(15, 5, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    //10 cells off, less the inscribed radius
+    EXPECT_NEAR(map.clearance(at(5), at(5), 0, 0, 0, CONSTRAINTS),
+            1.0 - CONSTRAINTS.inscribed_radius, 1e-9);
+}
+
+TEST(ClearanceMap, ClosestPointAlongTheArc)
+{
+    Grid grid{};
+    grid.set(10, 5, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    //0.5m over the horizon ends 5 cells short of the obstacle
+    EXPECT_NEAR(map.clearance(at(0), at(5), 0, 0.25, 0, CONSTRAINTS),
+            0.5 - CONSTRAINTS.inscribed_radius, 1e-9);
+    //backing away keeps the distance we start with
+    EXPECT_NEAR(map.clearance(at(8), at(5), 0, -0.25, 0, CONSTRAINTS),
+            0.2 - CONSTRAINTS.inscribed_radius, 1e-9);
+}
+
+TEST(ClearanceMap, TurningAwayKeepsClear)
+{
+    Grid grid{};
+    grid.set(12, 5, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    double straight = map.clearance(at(5), at(5), 0, 0.25, 0, CONSTRAINTS);
+    double turning = map.clearance(at(5), at(5), 0, 0.25, 1.0, CONSTRAINTS);
+    EXPECT_NEAR(straight, 0.2 - CONSTRAINTS.inscribed_radius, 1e-9);
+    EXPECT_GT(turning, straight);
+    EXPECT_LE(turning, 0.7 - CONSTRAINTS.inscribed_radius + 1e-9);
+}
+
+TEST(ClearanceMap, ArcStopsAtTheEdge)
+{
+    Grid grid{};
+    grid.set(0, 5, 100);
+    ClearanceMap map{};
+    grid.load(map);
+    //driving off the map only counts what we can see
+    EXPECT_NEAR(map.clearance(at(18), at(5), 0, 0.5, 0, CONSTRAINTS),
+            1.8 - CONSTRAINTS.inscribed_radius, 1e-9);
+}
+
+TEST(SpeedCap, LinearBetweenNearAndFar)
+{
+    EXPECT_NEAR(tfr_navigation::speedCap(0.3, 1, CONSTRAINTS), 0.33, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(0.75, 1, CONSTRAINTS), 0.465, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(1.2, 1, CONSTRAINTS), 0.6, 1e-9);
+}
+
+TEST(SpeedCap, Clamped)
+{
+    EXPECT_NEAR(tfr_navigation::speedCap(-INFINITY, 1, CONSTRAINTS), 0.33, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(-0.5, 1, CONSTRAINTS), 0.33, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(5.0, 1, CONSTRAINTS), 0.6, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(5.0, 2, CONSTRAINTS), 0.6, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(5.0, -1, CONSTRAINTS), 0.33, 1e-9);
+}
+
+TEST(SpeedCap, StabilityScalesTowardMinSpeed)
+{
+    EXPECT_NEAR(tfr_navigation::speedCap(1.2, 0, CONSTRAINTS), 0.33, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(1.2, 0.5, CONSTRAINTS), 0.465, 1e-9);
+    EXPECT_NEAR(tfr_navigation::speedCap(0.3, 0.5, CONSTRAINTS), 0.33, 1e-9);
+}
+
+TEST(RideStability, StaleImuHoldsUsBack)
+{
+    EXPECT_EQ(tfr_navigation::rideStability(0, 0, false, CONSTRAINTS), 0);
+    EXPECT_EQ(tfr_navigation::rideStability(0, 0, true, CONSTRAINTS), 1);
+}
+
+TEST(RideStability, WorstOfTiltAndVibration)
+{
+    EXPECT_NEAR(tfr_navigation::rideStability(0.125, 0, true, CONSTRAINTS), 0.5, 1e-9);
+    EXPECT_NEAR(tfr_navigation::rideStability(0, 1.5, true, CONSTRAINTS), 0.5, 1e-9);
+    EXPECT_NEAR(tfr_navigation::rideStability(0.125, 2.25, true, CONSTRAINTS), 0.25, 1e-9);
+    EXPECT_EQ(tfr_navigation::rideStability(0.5, 0, true, CONSTRAINTS), 0);
+    EXPECT_EQ(tfr_navigation::rideStability(0, 6.0, true, CONSTRAINTS), 0);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "pivot_lattice.h"
+
+using tfr_navigation::PivotLattice;
+using tfr_navigation::TreadDynamics;
+using tfr_navigation::LatticeCosts;
+
+namespace
+{
+    const TreadDynamics DYNAMICS{0.5, 0.5, 0.6, 0.7, 0.5};
+    const LatticeCosts COSTS{1.0, 127, true};
+    const double RESOLUTION = 0.1;
+    //the arena at the global costmap's resolution
+    const int SIZE = 150;
+
+    struct Grid
+    {
+        std::vector<unsigned char> costs;
+        Grid() : costs(SIZE * SIZE, 0) {}
+        void fill(int x_0, int y_0, int x_1, int y_1, unsigned char cost)
+        {
+            for (int y = y_0; y <= y_1; ++y)
+                for (int x = x_0; x <= x_1; ++x)
+                    costs[y * SIZE + x] = cost;
+        }
+        unsigned char at(int x, int y) const { return costs[y * SIZE + x]; }
+    };
+
+    int pivots(const std::vector<PivotLattice::State>& path)
+    {
+        int count = 0;
+        for (size_t i = 1; i < path.size(); ++i)
+            count += path[i].heading != path[i - 1].heading;
+        return count;
+    }
+
+    /*
+     * Every move is a pivot in place or one step along the heading, and no
+     * cell the robot ends up in is blocked
+     * */
+    void expectDrivable(const Grid& grid, const std::vector<PivotLattice::State>& path)
+    {
+        for (size_t i = 1; i < path.size(); ++i)
+        {
+            const auto& from = path[i - 1];
+            const auto& to = path[i];
+            EXPECT_LT(grid.at(to.x, to.y), 253) << "step " << i;
+            if (from.heading != to.heading)
+            {
+                EXPECT_EQ(from.x, to.x) << "step " << i;
+                EXPECT_EQ(from.y, to.y) << "step " << i;
+                continue;
+            }
+            double yaw = PivotLattice::headingYaw(from.heading);
+            double length = std::hypot(to.x - from.x, to.y - from.y);
+            EXPECT_NEAR(std::cos(yaw) * length, to.x - from.x, 1e-9) << "step " << i;
+            EXPECT_NEAR(std::sin(yaw) * length, to.y - from.y, 1e-9) << "step " << i;
+        }
+    }
+}
+
+TEST(PivotLattice, HeadingsRoundTrip)
+{
+    for (int heading = 0; heading < PivotLattice::HEADINGS; ++heading)
+        ASSERT_EQ(PivotLattice::nearestHeading(PivotLattice::headingYaw(heading)), heading);
+    ASSERT_EQ(PivotLattice::nearestHeading(2 * M_PI - 0.01), 0);
+}
+
+TEST(PivotLattice, DrivesStraightWithoutPivoting)
+{
+    Grid grid{};
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 10, 0}, 110, 10, path));
+    ASSERT_EQ(pivots(path), 0);
+    ASSERT_EQ(path.size(), 101u);
+    ASSERT_NEAR(lattice.getPlanTime(), 100 * RESOLUTION / DYNAMICS.linear_speed, 1e-4);
+}
+
+TEST(PivotLattice, PivotsOnceThenGoesStraight)
+{
+    Grid grid{};
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    //behind and off the lattice line, one pivot then a corner on the way
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {75, 75, 0}, 75, 130, path));
+    ASSERT_EQ(pivots(path), 1);
+    ASSERT_EQ(path[1].heading, 4);
+    //from heading 0, (30, 10) is 10 straight then 10 along (2, 1)
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 10, 0}, 40, 20, path));
+    ASSERT_EQ(pivots(path), 1);
+    expectDrivable(grid, path);
+}
+
+TEST(PivotLattice, GoesAroundAWall)
+{
+    Grid grid{};
+    grid.fill(70, 0, 72, 120, 254);
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {20, 20, 0}, 120, 20, path));
+    expectDrivable(grid, path);
+    //no cutting through the corner of the wall on a diagonal
+    for (const auto& state : path)
+        ASSERT_FALSE(state.x >= 70 && state.x <= 72 && state.y <= 120);
+    ASSERT_LE(pivots(path), 4);
+}
+
+TEST(PivotLattice, OnlyPivotsWhereTheFootprintTurns)
+{
+    //a corridor the robot fits down but can't turn in
+    Grid grid{};
+    grid.fill(0, 0, SIZE - 1, SIZE - 1, 254);
+    grid.fill(10, 50, 100, 50, 0);
+    grid.fill(10, 49, 100, 49, 200);
+    grid.fill(10, 51, 100, 51, 200);
+    //with room to turn at the far end
+    grid.fill(95, 45, 105, 100, 0);
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 50, 0}, 100, 90, path));
+    expectDrivable(grid, path);
+    for (size_t i = 1; i < path.size(); ++i)
+        if (path[i].heading != path[i - 1].heading)
+        {
+            ASSERT_GE(path[i].x, 95);
+        }
+}
+
+TEST(PivotLattice, SlowsDownThroughCostlyCells)
+{
+    Grid grid{};
+    //a wide band that's slow to cross but not blocked
+    grid.fill(60, 0, 80, SIZE - 1, 252);
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {20, 75, 0}, 120, 75, path));
+    //no way round, it crosses straight at double the time through the band
+    ASSERT_EQ(pivots(path), 0);
+    ASSERT_NEAR(lattice.getPlanTime(), (79 + 21 * 2) * RESOLUTION / DYNAMICS.linear_speed, 1e-3);
+}
+
+TEST(PivotLattice, FailsWhenBoxedIn)
+{
+    Grid grid{};
+    grid.fill(90, 90, 110, 110, 254);
+    grid.fill(95, 95, 105, 105, 0);
+    PivotLattice lattice{};
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    std::vector<PivotLattice::State> path;
+    ASSERT_FALSE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 10, 0}, 100, 100, path));
+    ASSERT_TRUE(path.empty());
+    //or when the goal is blocked or off the grid
+    ASSERT_FALSE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 10, 0}, 90, 90, path));
+    ASSERT_FALSE(lattice.plan(grid.costs.data(), SIZE, SIZE, {10, 10, 0}, SIZE, 10, path));
+}
+
+TEST(PivotLattice, UnknownFollowsTheSetting)
+{
+    Grid grid{};
+    grid.fill(60, 0, 62, SIZE - 1, 255);
+    PivotLattice lattice{};
+    std::vector<PivotLattice::State> path;
+    lattice.configure(DYNAMICS, COSTS, RESOLUTION);
+    ASSERT_TRUE(lattice.plan(grid.costs.data(), SIZE, SIZE, {20, 75, 0}, 120, 75, path));
+    lattice.configure(DYNAMICS, LatticeCosts{1.0, 127, false}, RESOLUTION);
+    ASSERT_FALSE(lattice.plan(grid.costs.data(), SIZE, SIZE, {20, 75, 0}, 120, 75, path));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,53 @@
+#ifndef DEPTH_SCAN_H
+#define DEPTH_SCAN_H
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <tf2/LinearMath/Transform.h>
+#include <vector>
+#include "scan_matcher.h"
+
+/**
+ * Cuts a 2d scan out of a depth image, like a planar lidar would see.
+ *
+ * For every sampled column the closest point whose height above the footprint
+ * lies in a band is kept, so the ground and anything above the band drop out.
+ * The result is in the footprint frame and ordered by bearing, which is what
+ * the scan matcher and line fitting expect. Handles both the raw (16UC1 mm)
+ * and processed (32FC1 m) depth encodings.
+ * */
+class DepthScan
+{
+    public:
+        struct ScanConstraints
+        {
+            double min_height;
+            double max_height;
+            double max_range;
+            int column_step;
+            int row_step;
+        };
+
+        DepthScan(const ScanConstraints& c);
+        ~DepthScan() = default;
+        DepthScan(const DepthScan&) = delete;
+        DepthScan& operator=(const DepthScan&) = delete;
+        DepthScan(DepthScan&&) = delete;
+        DepthScan& operator=(DepthScan&&) = delete;
+
+        /*
+         * footprint_from_camera takes points in the image's optical frame into
+         * the footprint. Returns false if the encoding is unsupported or
+         * nothing is in the band.
+         * */
+        bool extract(const sensor_msgs::Image& image,
+                const sensor_msgs::CameraInfo& info,
+                const tf2::Transform& footprint_from_camera,
+                std::vector<ScanMatcher::Point>& scan);
+
+    private:
+        const ScanConstraints& constraints;
+        //closest squared range per column, reused between calls
+        std::vector<double> column_range;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef ELEVATION_GRID_H
+#define ELEVATION_GRID_H
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <tf2/LinearMath/Transform.h>
+#include <vector>
+
+/**
+ * A height map of a box on the ground, built from depth images.
+ *
+ * Every depth pixel that lands in the box is binned by its xy in the target
+ * frame and the cell keeps the mean height of what landed in it. Frames
+ * accumulate until cleared, averaging a few frames takes out most of the
+ * kinect noise. For a map that has to follow the ground as it changes, age()
+ * fades out old samples so memory stays fixed. Cells are indexed with x along
+ * the columns and y along the rows, row 0 is min_y.
+ * */
+class ElevationGrid
+{
+    public:
+        struct GridConstraints
+        {
+            double min_x, max_x;
+            double min_y, max_y;
+            double resolution;
+            //sample every nth pixel in both directions
+            int pixel_step;
+            //least sample weight for a cell to count as seen
+            double min_samples;
+        };
+
+        ElevationGrid(const GridConstraints& c);
+        ~ElevationGrid() = default;
+        ElevationGrid(const ElevationGrid&) = delete;
+        ElevationGrid& operator=(const ElevationGrid&) = delete;
+        ElevationGrid(ElevationGrid&&) = delete;
+        ElevationGrid& operator=(ElevationGrid&&) = delete;
+
+        /*
+         * Adds one depth image, grid_from_camera takes points in the image's
+         * optical frame into the frame of the grid. Returns false if the
+         * encoding is unsupported.
+         * */
+        bool add(const sensor_msgs::Image& image,
+                const sensor_msgs::CameraInfo& info,
+                const tf2::Transform& grid_from_camera);
+
+        /*
+         * Scales the weight of everything seen so far, heights don't move but
+         * new samples count for more
+         * */
+        void age(double factor);
+
+        /*
+         * Forgets everything added so far
+         * */
+        void clear();
+
+        /*
+         * Exchanges contents with a grid of the same size, cheap
+         * */
+        void swap(ElevationGrid& other);
+
+        /*
+         * Mean height of a cell, false if it hasn't been seen enough
+         * */
+        bool height(int column, int row, double& value) const;
+
+        /*
+         * Volume that is lower here than in before, over the cells both grids
+         * have seen. Fill is ignored, what was dug out is what we care about.
+         * */
+        double removedSince(const ElevationGrid& before) const;
+
+        /*
+         * Cell holding a point, false if it is outside the grid
+         * */
+        bool cellOf(double x, double y, int& column, int& row) const;
+
+        int getColumns() const;
+        int getRows() const;
+        double getResolution() const;
+        //fraction of the cells which have been seen
+        double getCoverage() const;
+
+    private:
+        const GridConstraints& constraints;
+        const int columns, rows;
+        std::vector<double> sums;
+        std::vector<double> samples;
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RIGID_FIT_H
+#define RIGID_FIT_H
+#include <vector>
+#include <random>
+
+/**
+ * Fits the 2d rigid transform between two sets of matched points while
+ * ignoring bad matches.
+ *
+ * Random pairs of matches propose a transform in closed form, the one that
+ * agrees with the most matches wins and is refit by least squares over
+ * everything that agrees with it. The random sequence is seeded the same
+ * every time, so a given input always gives the same answer.
+ *
+ * All working storage is kept between calls.
+ * */
+class RigidFit
+{
+    public:
+        struct Point
+        {
+            double x;
+            double y;
+        };
+
+        struct Transform
+        {
+            double x;
+            double y;
+            double yaw;
+        };
+
+        struct FitConstraints
+        {
+            //furthest a transformed match can land from its partner (m)
+            double inlier_threshold;
+            //fail with fewer matches agreeing than this
+            int min_inliers;
+        };
+
+        struct FitResult
+        {
+            int inliers;
+            //mean squared distance of the inliers from their centroid, tells
+            //us how well the rotation is constrained
+            double spread;
+        };
+
+        RigidFit(const FitConstraints& c);
+        ~RigidFit() = default;
+        RigidFit(const RigidFit&) = delete;
+        RigidFit& operator=(const RigidFit&) = delete;
+        RigidFit(RigidFit&&) = delete;
+        RigidFit& operator=(RigidFit&&) = delete;
+
+        /*
+         * Finds the transform taking each from point onto the to point with
+         * the same index. Fails if the lists differ in length or too few
+         * matches agree.
+         * */
+        bool fit(const std::vector<Point>& from, const std::vector<Point>& to,
+                Transform& transform, FitResult& result);
+
+    private:
+        static const int ITERATIONS = 64;
+        //two points too close together can't constrain rotation (m)
+        static constexpr double MIN_SEPARATION = 0.05;
+
+        const FitConstraints& constraints;
+        std::minstd_rand random;
+        std::vector<int> inliers, best_inliers;
+
+        double fitIndexes(const std::vector<Point>& from, const std::vector<Point>& to,
+                const std::vector<int>& indexes, Transform& transform) const;
+        void collectInliers(const std::vector<Point>& from, const std::vector<Point>& to,
+                const Transform& transform, std::vector<int>& out) const;
+};
+
+#endif
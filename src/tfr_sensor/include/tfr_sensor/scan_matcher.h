@@ -0,0 +1,94 @@
+#ifndef SCAN_MATCHER_H
+#define SCAN_MATCHER_H
+#include <vector>
+#include <cstdint>
+
+/**
+ * Registers 2d scans against a reference scan with point to line icp.
+ *
+ * The reference is stored in a spatial hash with cells the size of the
+ * correspondence gate, so finding the closest reference point only has to
+ * look at the 3x3 cells around the query. Normals for the reference come from
+ * its neighbors in scan order, which is why scans have to be given sorted by
+ * bearing.
+ *
+ * All working storage is kept between calls, once the buffers have grown to
+ * the size of a typical scan no more allocation happens.
+ * */
+class ScanMatcher
+{
+    public:
+        struct Point
+        {
+            double x;
+            double y;
+        };
+
+        struct Pose
+        {
+            double x;
+            double y;
+            double yaw;
+        };
+
+        struct MatchConstraints
+        {
+            //furthest a correspondence can be, also the hash cell size (m)
+            double max_correspondence;
+            int max_iterations;
+            //stop once an update moves less than this (m and rad)
+            double convergence;
+            //fraction of the scan that needs a correspondence to succeed
+            double min_overlap;
+        };
+
+        struct MatchResult
+        {
+            //row major 3x3 over x, y, yaw
+            double covariance[9];
+            int iterations;
+            int correspondences;
+            double rms;
+        };
+
+        ScanMatcher(const MatchConstraints& c);
+        ~ScanMatcher() = default;
+        ScanMatcher(const ScanMatcher&) = delete;
+        ScanMatcher& operator=(const ScanMatcher&) = delete;
+        ScanMatcher(ScanMatcher&&) = delete;
+        ScanMatcher& operator=(ScanMatcher&&) = delete;
+
+        /*
+         * Replaces the reference scan, points must be ordered by bearing
+         * */
+        void setReference(const std::vector<Point>& points);
+
+        /*
+         * Finds the pose of the scan in the frame of the reference. estimate
+         * is used as the starting guess and holds the answer on success. Fails
+         * without enough overlap, on a degenerate scene, or without converging
+         * within max_iterations.
+         * */
+        bool match(const std::vector<Point>& scan, Pose& estimate, MatchResult& result);
+
+        bool hasReference() const { return !reference.empty(); }
+
+    private:
+        static const int TABLE_SIZE = 4096;
+        const MatchConstraints& constraints;
+
+        std::vector<Point> reference;
+        std::vector<Point> normals;
+        std::vector<bool> has_normal;
+
+        //counting sort hash, reference indexes grouped by bucket
+        std::vector<int> bucket_start;
+        std::vector<int> bucket_points;
+        std::vector<int> point_bucket;
+
+        int bucketOf(int cell_x, int cell_y) const;
+        int cellOf(double value) const;
+        int closest(const Point& p) const;
+};
+
+#endif
@@ -0,0 +1,62 @@
+#include "depth_scan.h"
+#include <sensor_msgs/image_encodings.h>
+#include <ros/console.h>
+#include <cmath>
+#include <limits>
+
+DepthScan::DepthScan(const ScanConstraints& c) :
+    constraints{c}
+{ }
+
+bool DepthScan::extract(const sensor_msgs::Image& image,
+        const sensor_msgs::CameraInfo& info,
+        const tf2::Transform& footprint_from_camera,
+        std::vector<ScanMatcher::Point>& scan)
+{
+    bool millimeters = image.encoding == sensor_msgs::image_encodings::TYPE_16UC1;
+    if (!millimeters && image.encoding != sensor_msgs::image_encodings::TYPE_32FC1)
+    {
+        ROS_WARN_ONCE("Depth Scan: unsupported depth encoding %s", image.encoding.c_str());
+        return false;
+    }
+
+    double fx = info.K[0], fy = info.K[4], cx = info.K[2], cy = info.K[5];
+    double max_range_squared = constraints.max_range * constraints.max_range;
+    int columns = (image.width + constraints.column_step - 1) / constraints.column_step;
+    column_range.assign(columns, std::numeric_limits<double>::infinity());
+    scan.resize(columns);
+
+    for (uint32_t row = 0; row < image.height; row += constraints.row_step)
+    {
+        const uint8_t* data = &image.data[row * image.step];
+        for (uint32_t col = 0, i = 0; col < image.width; col += constraints.column_step, ++i)
+        {
+            double depth;
+            if (millimeters)
+                depth = reinterpret_cast<const uint16_t*>(data)[col] * 1e-3;
+            else
+                depth = reinterpret_cast<const float*>(data)[col];
+            if (!(depth > 0) || std::isinf(depth))
+                continue;
+
+            tf2::Vector3 point = footprint_from_camera * tf2::Vector3(
+                    (col - cx) * depth / fx, (row - cy) * depth / fy, depth);
+            if (point.z() < constraints.min_height || point.z() > constraints.max_height)
+                continue;
+            double range = point.x() * point.x() + point.y() * point.y();
+            if (range > max_range_squared || range >= column_range[i])
+                continue;
+            column_range[i] = range;
+            scan[i].x = point.x();
+            scan[i].y = point.y();
+        }
+    }
+
+    //compact out the empty columns, order by bearing is kept
+    size_t count = 0;
+    for (size_t i = 0; i < column_range.size(); ++i)
+        if (!std::isinf(column_range[i]))
+            scan[count++] = scan[i];
+    scan.resize(count);
+    return count > 0;
+}
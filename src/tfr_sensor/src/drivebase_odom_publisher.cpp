@@ -7,8 +7,9 @@
  * Parameters:
  *   - ~parent_frame: the frame our robot exists in (string, default: "odom")
  *   - ~child_frame: the frame of the robot (string, default: "base_footprint")
- *   - ~wheel_span: the separation of the treads of the robot. (double,
- *   default)
+ *   - ~wheel_span: the separation of the treads of the robot, can be tuned
+ *   live through dynamic_reconfigure (cfg/DrivebaseOdometry.cfg). (double,
+ *   default 0.645)
  *   - ~rate: how quickly to publish hz. (double, default 10)
  * Subscribed topics:
  *   - /arduino :(tfr_msgs/ArduinoReading) The most current information coming
@@ -28,6 +29,8 @@
 #include <geometry_msgs/Quaternion.h>
 #include <nav_msgs/Odometry.h>
 #include <std_srvs/Empty.h>
+#include <dynamic_reconfigure/server.h>
+#include <tfr_sensor/DrivebaseOdometryConfig.h>
 #include <tf/transform_datatypes.h>
 #include <tf2_ros/transform_broadcaster.h>
 #include <geometry_msgs/TransformStamped.h>
@@ -54,8 +57,12 @@ class DrivebaseOdometryPublisher
             x{},
             y{},
             angle{},
-            tf_broadcaster{}
+            tf_broadcaster{},
+            reconfigure_server{ros::NodeHandle{"~"}}
     {
+        //callbacks run in the same spinOnce as processOdometry, no locking needed
+        reconfigure_server.setCallback(
+                boost::bind(&DrivebaseOdometryPublisher::reconfigure, this, _1, _2));
 		//get most current sensor infromation 
         arduino_a = n.subscribe("/sensors/arduino_a", 15, &DrivebaseOdometryPublisher::readArduinoA, this);
         arduino_b = n.subscribe("/sensors/arduino_b", 15, &DrivebaseOdometryPublisher::readArduinoB, this);
@@ -70,6 +77,26 @@ class DrivebaseOdometryPublisher
         angle.y = 0;
         angle.z = 0;
         angle.w = 1;
+
+        //everything that doesn't change between cycles is set once here
+        msg.header.frame_id = parent_frame;
+        msg.child_frame_id = child_frame;
+        msg.pose.pose.position.z = 0;
+        msg.pose.covariance = { 1e-1,    0,    0,    0,    0,    0,
+            0, 1e-1,    0,    0,    0,    0,
+            0,    0, 1e-1,    0,    0,    0,
+            0,    0,    0, 1e-1,    0,    0,
+            0,    0,    0,    0, 1e-1,    0,
+            0,    0,    0,    0,    0, 1e-1 };
+        msg.twist.twist.linear.z = 0;
+        msg.twist.twist.angular.x = 0;
+        msg.twist.twist.angular.y = 0;
+        msg.twist.covariance = { 5e-2,    0,    0,    0,    0,    0,
+            0, 5e-2,    0,    0,    0,    0,
+            0,    0, 5e-2,    0,    0,    0,
+            0,    0,    0, 5e-2,    0,    0,
+            0,    0,    0,    0, 5e-2,    0,
+            0,    0,    0,    0,    0, 5e-2 };
 	}
 
     ~DrivebaseOdometryPublisher() = default;
@@ -134,35 +161,15 @@ class DrivebaseOdometryPublisher
 
             t_0 = t_1;
 
-            //let's package up the message
-            nav_msgs::Odometry msg;
+            //let's package up the message, only the values that move
             msg.header.stamp = ros::Time::now();
-            msg.header.frame_id = parent_frame;
-            msg.child_frame_id = child_frame;
-
             msg.pose.pose.position.x = x;
             msg.pose.pose.position.y = y;
-            msg.pose.pose.position.z = 0;
             msg.pose.pose.orientation = angle;
-            msg.pose.covariance = { 1e-1,    0,    0,    0,    0,    0,
-                0, 1e-1,    0,    0,    0,    0,
-                0,    0, 1e-1,    0,    0,    0,
-                0,    0,    0, 1e-1,    0,    0,
-                0,    0,    0,    0, 1e-1,    0,
-                0,    0,    0,    0,    0, 1e-1 };
 
             msg.twist.twist.linear.x = v_x;
             msg.twist.twist.linear.y = v_y;
-            msg.twist.twist.linear.z = 0;
-            msg.twist.twist.angular.x = 0;
-            msg.twist.twist.angular.y = 0;
             msg.twist.twist.angular.z = v_ang;
-            msg.twist.covariance = { 5e-2,    0,    0,    0,    0,    0,
-                0, 5e-2,    0,    0,    0,    0,
-                0,    0, 5e-2,    0,    0,    0,
-                0,    0,    0, 5e-2,    0,    0,
-                0,    0,    0,    0, 5e-2,    0,
-                0,    0,    0,    0,    0, 5e-2 };
 	//publish the message
             odometry_publisher.publish(msg);
         }
@@ -179,13 +186,21 @@ class DrivebaseOdometryPublisher
         tf2_ros::TransformBroadcaster tf_broadcaster;
         const std::string& parent_frame; //the parent frame of the robot
         const std::string& child_frame; //the child frame of the robot
-        const double& wheel_span;
+        double wheel_span;
         double x; //the x coordinate of the robot (meters)
         double y; //the y coordinate of the robot (meters)
         geometry_msgs::Quaternion angle; 
         const double MAX_XY_DELTA = 0.25;
         const double MAX_THETA_DELTA = 0.065;
         ros::Time t_0;
+        //reused every cycle
+        nav_msgs::Odometry msg;
+        dynamic_reconfigure::Server<tfr_sensor::DrivebaseOdometryConfig> reconfigure_server;
+
+        void reconfigure(tfr_sensor::DrivebaseOdometryConfig &config, uint32_t level)
+        {
+            wheel_span = config.wheel_span;
+        }
 
 	/********************************************************************************************
 	* readArduinoA: Get most current sensor infromation
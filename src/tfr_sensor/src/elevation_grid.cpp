@@ -0,0 +1,122 @@
+#include "elevation_grid.h"
+#include <sensor_msgs/image_encodings.h>
+#include <ros/console.h>
+#include <algorithm>
+#include <cmath>
+
+ElevationGrid::ElevationGrid(const GridConstraints& c) :
+    constraints{c},
+    columns{static_cast<int>(std::ceil((c.max_x - c.min_x) / c.resolution))},
+    rows{static_cast<int>(std::ceil((c.max_y - c.min_y) / c.resolution))},
+    sums(columns * rows, 0.0),
+    samples(columns * rows, 0.0)
+{ }
+
+bool ElevationGrid::add(const sensor_msgs::Image& image,
+        const sensor_msgs::CameraInfo& info,
+        const tf2::Transform& grid_from_camera)
+{
+    bool millimeters = image.encoding == sensor_msgs::image_encodings::TYPE_16UC1;
+    if (!millimeters && image.encoding != sensor_msgs::image_encodings::TYPE_32FC1)
+    {
+        ROS_WARN_ONCE("Elevation Grid: unsupported depth encoding %s", image.encoding.c_str());
+        return false;
+    }
+
+    double fx = info.K[0], fy = info.K[4], cx = info.K[2], cy = info.K[5];
+    for (uint32_t row = 0; row < image.height; row += constraints.pixel_step)
+    {
+        const uint8_t* data = &image.data[row * image.step];
+        for (uint32_t col = 0; col < image.width; col += constraints.pixel_step)
+        {
+            double depth;
+            if (millimeters)
+                depth = reinterpret_cast<const uint16_t*>(data)[col] * 1e-3;
+            else
+                depth = reinterpret_cast<const float*>(data)[col];
+            if (!(depth > 0) || std::isinf(depth))
+                continue;
+
+            tf2::Vector3 point = grid_from_camera * tf2::Vector3(
+                    (col - cx) * depth / fx, (row - cy) * depth / fy, depth);
+            int cell_x, cell_y;
+            if (!cellOf(point.x(), point.y(), cell_x, cell_y))
+                continue;
+            sums[cell_y * columns + cell_x] += point.z();
+            samples[cell_y * columns + cell_x] += 1;
+        }
+    }
+    return true;
+}
+
+void ElevationGrid::clear()
+{
+    std::fill(sums.begin(), sums.end(), 0.0);
+    std::fill(samples.begin(), samples.end(), 0.0);
+}
+
+void ElevationGrid::age(double factor)
+{
+    for (size_t i = 0; i < sums.size(); ++i)
+    {
+        sums[i] *= factor;
+        samples[i] *= factor;
+    }
+}
+
+void ElevationGrid::swap(ElevationGrid& other)
+{
+    sums.swap(other.sums);
+    samples.swap(other.samples);
+}
+
+bool ElevationGrid::height(int column, int row, double& value) const
+{
+    int index = row * columns + column;
+    if (samples[index] < constraints.min_samples)
+        return false;
+    value = sums[index] / samples[index];
+    return true;
+}
+
+double ElevationGrid::removedSince(const ElevationGrid& before) const
+{
+    double depth = 0;
+    for (int row = 0; row < rows; ++row)
+        for (int column = 0; column < columns; ++column)
+        {
+            double now, then;
+            if (height(column, row, now) && before.height(column, row, then) && now < then)
+                depth += then - now;
+        }
+    return depth * constraints.resolution * constraints.resolution;
+}
+
+bool ElevationGrid::cellOf(double x, double y, int& column, int& row) const
+{
+    column = std::floor((x - constraints.min_x) / constraints.resolution);
+    row = std::floor((y - constraints.min_y) / constraints.resolution);
+    return column >= 0 && column < columns && row >= 0 && row < rows;
+}
+
+int ElevationGrid::getColumns() const
+{
+    return columns;
+}
+
+int ElevationGrid::getRows() const
+{
+    return rows;
+}
+
+double ElevationGrid::getResolution() const
+{
+    return constraints.resolution;
+}
+
+double ElevationGrid::getCoverage() const
+{
+    int seen = std::count_if(samples.begin(), samples.end(),
+            [this](double weight) { return weight >= constraints.min_samples; });
+    return static_cast<double>(seen) / samples.size();
+}
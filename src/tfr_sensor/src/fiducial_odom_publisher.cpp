@@ -13,6 +13,10 @@
  *   image (sensor_msgs/Image) - the camera topic
  * published topics:
  *   fiducial_odom (geometry_msgs/Odometry)- the odometry topic 
+ *
+ * The sightings here don't go to the bin estimator, this node corrects
+ * odometry against the bin frame, so the bin following them would chase the
+ * drift the correction is there to take out.
  * */
 #include <ros/ros.h>
 #include <ros/console.h>
@@ -6,6 +6,8 @@
 
 #include <cv_bridge/cv_bridge.h>
 #include <sensor_msgs/image_encodings.h>
+#include <dynamic_reconfigure/server.h>
+#include <tfr_sensor/LightDetectionConfig.h>
 
 
 /*
@@ -14,6 +16,10 @@
  *  
  *  The server will not examine anything until commanded, and will set it's
  *  status to succeeded, when it sees the light.
+ *
+ *  The threshold can be tuned live through dynamic_reconfigure
+ *  (cfg/LightDetection.cfg). The reconfigure callback and detect both run on
+ *  the spin thread, so the value is just overwritten.
  * */
 class DetectionActionServer
 {
@@ -24,8 +30,11 @@ class DetectionActionServer
             n{node},
             server{node, name, false},
             threshold{thresh},
-            it{node}
+            it{node},
+            reconfigure_server{ros::NodeHandle{"~"}}
         {
+            reconfigure_server.setCallback(
+                    boost::bind(&DetectionActionServer::reconfigure, this, _1, _2));
             server.registerGoalCallback(
                     boost::bind(&DetectionActionServer::setGoal,this));
             server.registerPreemptCallback(
@@ -65,6 +74,11 @@ class DetectionActionServer
             server.setPreempted();
         }
 
+        void reconfigure(tfr_sensor::LightDetectionConfig &config, uint32_t level)
+        {
+            threshold = config.threshold;
+        }
+
         /*
          * Detects if the light has been turned on 
          * */
@@ -104,6 +118,7 @@ class DetectionActionServer
         actionlib::SimpleActionServer<tfr_msgs::EmptyAction> server;
         image_transport::ImageTransport it;
         image_transport::Subscriber image_subscriber;
+        dynamic_reconfigure::Server<tfr_sensor::LightDetectionConfig> reconfigure_server;
 
 };
 
@@ -0,0 +1,91 @@
+#include "rigid_fit.h"
+#include <cmath>
+
+constexpr double RigidFit::MIN_SEPARATION;
+
+RigidFit::RigidFit(const FitConstraints& c) :
+    constraints{c}
+{ }
+
+bool RigidFit::fit(const std::vector<Point>& from, const std::vector<Point>& to,
+        Transform& transform, FitResult& result)
+{
+    int count = from.size();
+    if (count != static_cast<int>(to.size()) || count < constraints.min_inliers ||
+            count < 2)
+        return false;
+
+    //the same answer for the same input, call to call
+    random.seed();
+    std::uniform_int_distribution<int> pick{0, count - 1};
+    best_inliers.clear();
+    for (int iteration = 0; iteration < ITERATIONS; ++iteration)
+    {
+        int a = pick(random), b = pick(random);
+        if (std::hypot(from[a].x - from[b].x, from[a].y - from[b].y) < MIN_SEPARATION)
+            continue;
+        inliers.assign({a, b});
+        Transform candidate;
+        fitIndexes(from, to, inliers, candidate);
+        collectInliers(from, to, candidate, inliers);
+        if (inliers.size() > best_inliers.size())
+            std::swap(inliers, best_inliers);
+    }
+    if (static_cast<int>(best_inliers.size()) < constraints.min_inliers)
+        return false;
+
+    result.spread = fitIndexes(from, to, best_inliers, transform);
+    result.inliers = best_inliers.size();
+    return true;
+}
+
+/*
+ * Least squares 2d rigid fit over the given matches (closed form), returns
+ * the spread of the from points about their centroid.
+ * */
+double RigidFit::fitIndexes(const std::vector<Point>& from, const std::vector<Point>& to,
+        const std::vector<int>& indexes, Transform& transform) const
+{
+    Point from_mean{0, 0}, to_mean{0, 0};
+    for (int i : indexes)
+    {
+        from_mean.x += from[i].x;
+        from_mean.y += from[i].y;
+        to_mean.x += to[i].x;
+        to_mean.y += to[i].y;
+    }
+    from_mean.x /= indexes.size();
+    from_mean.y /= indexes.size();
+    to_mean.x /= indexes.size();
+    to_mean.y /= indexes.size();
+
+    double cos_sum = 0, sin_sum = 0, spread = 0;
+    for (int i : indexes)
+    {
+        double from_x = from[i].x - from_mean.x, from_y = from[i].y - from_mean.y;
+        double to_x = to[i].x - to_mean.x, to_y = to[i].y - to_mean.y;
+        cos_sum += from_x * to_x + from_y * to_y;
+        sin_sum += from_x * to_y - from_y * to_x;
+        spread += from_x * from_x + from_y * from_y;
+    }
+    transform.yaw = std::atan2(sin_sum, cos_sum);
+    double c = std::cos(transform.yaw), s = std::sin(transform.yaw);
+    transform.x = to_mean.x - (c * from_mean.x - s * from_mean.y);
+    transform.y = to_mean.y - (s * from_mean.x + c * from_mean.y);
+    return spread / indexes.size();
+}
+
+void RigidFit::collectInliers(const std::vector<Point>& from, const std::vector<Point>& to,
+        const Transform& transform, std::vector<int>& out) const
+{
+    out.clear();
+    double threshold = constraints.inlier_threshold * constraints.inlier_threshold;
+    double c = std::cos(transform.yaw), s = std::sin(transform.yaw);
+    for (size_t i = 0; i < from.size(); ++i)
+    {
+        double dx = c * from[i].x - s * from[i].y + transform.x - to[i].x;
+        double dy = s * from[i].x + c * from[i].y + transform.y - to[i].y;
+        if (dx * dx + dy * dy < threshold)
+            out.push_back(i);
+    }
+}
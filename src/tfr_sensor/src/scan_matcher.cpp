@@ -0,0 +1,208 @@
+#include "scan_matcher.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    /*
+     * Inverts a row major 3x3, returns false if it is singular
+     * */
+    bool invert(const double m[9], double out[9])
+    {
+        double c00 = m[4] * m[8] - m[5] * m[7];
+        double c01 = m[5] * m[6] - m[3] * m[8];
+        double c02 = m[3] * m[7] - m[4] * m[6];
+        double det = m[0] * c00 + m[1] * c01 + m[2] * c02;
+        if (std::abs(det) < 1e-12)
+            return false;
+        double inv = 1.0 / det;
+        out[0] = c00 * inv;
+        out[1] = (m[2] * m[7] - m[1] * m[8]) * inv;
+        out[2] = (m[1] * m[5] - m[2] * m[4]) * inv;
+        out[3] = c01 * inv;
+        out[4] = (m[0] * m[8] - m[2] * m[6]) * inv;
+        out[5] = (m[2] * m[3] - m[0] * m[5]) * inv;
+        out[6] = c02 * inv;
+        out[7] = (m[1] * m[6] - m[0] * m[7]) * inv;
+        out[8] = (m[0] * m[4] - m[1] * m[3]) * inv;
+        return true;
+    }
+}
+
+ScanMatcher::ScanMatcher(const MatchConstraints& c) :
+    constraints{c},
+    bucket_start(TABLE_SIZE + 1)
+{ }
+
+/*
+ * Stores the reference, estimates a normal at every point from its
+ * neighbors in scan order, and buckets it into the hash.
+ * */
+void ScanMatcher::setReference(const std::vector<Point>& points)
+{
+    reference.assign(points.begin(), points.end());
+    int count = reference.size();
+    normals.resize(count);
+    has_normal.assign(count, false);
+
+    //neighbors further than this belong to a different surface
+    double gap = 2 * constraints.max_correspondence;
+    for (int i = 0; i < count; ++i)
+    {
+        const Point& p = reference[i];
+        Point before = p, after = p;
+        if (i > 0 && std::hypot(reference[i-1].x - p.x, reference[i-1].y - p.y) < gap)
+            before = reference[i-1];
+        if (i + 1 < count && std::hypot(reference[i+1].x - p.x, reference[i+1].y - p.y) < gap)
+            after = reference[i+1];
+        double tx = after.x - before.x, ty = after.y - before.y;
+        double length = std::hypot(tx, ty);
+        if (length < 1e-6)
+            continue;
+        normals[i].x = -ty / length;
+        normals[i].y = tx / length;
+        has_normal[i] = true;
+    }
+
+    //counting sort into buckets, after filling bucket_start[b] is the
+    //first index of bucket b and bucket_start[b+1] one past its end
+    std::fill(bucket_start.begin(), bucket_start.end(), 0);
+    point_bucket.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        point_bucket[i] = bucketOf(cellOf(reference[i].x), cellOf(reference[i].y));
+        ++bucket_start[point_bucket[i]];
+    }
+    for (int b = 1; b <= TABLE_SIZE; ++b)
+        bucket_start[b] += bucket_start[b - 1];
+    bucket_points.resize(count);
+    for (int i = count - 1; i >= 0; --i)
+        bucket_points[--bucket_start[point_bucket[i]]] = i;
+}
+
+/*
+ * Gauss newton on the point to line error. Each iteration finds the closest
+ * reference point to every transformed scan point, then takes one step on
+ * the distances along the reference normals, linearized about the current
+ * yaw. Residuals past a quarter of the gate are down weighted (huber) so
+ * stray correspondences from things that moved don't drag the fit. Running
+ * out of iterations before a step gets under convergence is a failure, the
+ * estimate is left alone.
+ * */
+bool ScanMatcher::match(const std::vector<Point>& scan, Pose& estimate, MatchResult& result)
+{
+    if (reference.empty() || scan.empty())
+        return false;
+
+    Pose pose = estimate;
+    double huber = constraints.max_correspondence / 4;
+    double hessian[9] = {}, gradient[3] = {}, inverse[9] = {};
+    int correspondences = 0;
+    double squared_error = 0;
+    int iteration = 0;
+    bool converged = false;
+    for (; iteration < constraints.max_iterations; ++iteration)
+    {
+        double c = std::cos(pose.yaw), s = std::sin(pose.yaw);
+        std::fill(hessian, hessian + 9, 0.0);
+        std::fill(gradient, gradient + 3, 0.0);
+        correspondences = 0;
+        squared_error = 0;
+
+        for (const auto& p : scan)
+        {
+            Point q{c * p.x - s * p.y + pose.x, s * p.x + c * p.y + pose.y};
+            int j = closest(q);
+            if (j < 0 || !has_normal[j])
+                continue;
+            const Point& n = normals[j];
+            double residual = n.x * (q.x - reference[j].x) + n.y * (q.y - reference[j].y);
+            double jacobian[3] = {n.x, n.y,
+                n.x * (-s * p.x - c * p.y) + n.y * (c * p.x - s * p.y)};
+            double weight = (std::abs(residual) < huber) ? 1 : huber / std::abs(residual);
+            for (int row = 0; row < 3; ++row)
+            {
+                gradient[row] += weight * jacobian[row] * residual;
+                for (int col = 0; col < 3; ++col)
+                    hessian[row * 3 + col] += weight * jacobian[row] * jacobian[col];
+            }
+            squared_error += residual * residual;
+            ++correspondences;
+        }
+
+        if (correspondences < 3 ||
+                correspondences < constraints.min_overlap * scan.size())
+            return false;
+        //a single flat wall can't constrain sliding along it
+        if (!invert(hessian, inverse))
+            return false;
+
+        double step[3];
+        for (int row = 0; row < 3; ++row)
+            step[row] = -(inverse[row * 3] * gradient[0] +
+                    inverse[row * 3 + 1] * gradient[1] +
+                    inverse[row * 3 + 2] * gradient[2]);
+        pose.x += step[0];
+        pose.y += step[1];
+        pose.yaw += step[2];
+        if (std::abs(step[0]) < constraints.convergence &&
+                std::abs(step[1]) < constraints.convergence &&
+                std::abs(step[2]) < constraints.convergence)
+        {
+            ++iteration;
+            converged = true;
+            break;
+        }
+    }
+    if (!converged)
+        return false;
+
+    //the sensor noise floor keeps a perfect fit from claiming zero variance
+    result.rms = std::sqrt(squared_error / correspondences);
+    double variance = std::max(result.rms * result.rms, 1e-6);
+    for (int i = 0; i < 9; ++i)
+        result.covariance[i] = variance * inverse[i];
+    result.iterations = iteration;
+    result.correspondences = correspondences;
+    estimate = pose;
+    return true;
+}
+
+int ScanMatcher::cellOf(double value) const
+{
+    return static_cast<int>(std::floor(value / constraints.max_correspondence));
+}
+
+int ScanMatcher::bucketOf(int cell_x, int cell_y) const
+{
+    uint32_t hash = static_cast<uint32_t>(cell_x) * 73856093u ^
+        static_cast<uint32_t>(cell_y) * 19349663u;
+    return hash & (TABLE_SIZE - 1);
+}
+
+/*
+ * Closest reference point within the correspondence gate, or -1
+ * */
+int ScanMatcher::closest(const Point& p) const
+{
+    int cell_x = cellOf(p.x), cell_y = cellOf(p.y);
+    int best = -1;
+    double best_distance = constraints.max_correspondence * constraints.max_correspondence;
+    for (int dx = -1; dx <= 1; ++dx)
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            int bucket = bucketOf(cell_x + dx, cell_y + dy);
+            for (int k = bucket_start[bucket]; k < bucket_start[bucket + 1]; ++k)
+            {
+                const Point& r = reference[bucket_points[k]];
+                double distance = (r.x - p.x) * (r.x - p.x) + (r.y - p.y) * (r.y - p.y);
+                if (distance < best_distance)
+                {
+                    best_distance = distance;
+                    best = bucket_points[k];
+                }
+            }
+        }
+    return best;
+}
@@ -0,0 +1,266 @@
+/**
+ * Tracks the motion of the robot by registering consecutive 2d scans cut out
+ * of the kinect depth image. Walls, the bin and rocks don't slip the way the
+ * treads do, so this gives fusion a translation source that holds up on sand.
+ *
+ * Each depth image is turned into a scan by keeping, for every sampled column,
+ * the closest point whose height above the footprint is inside a band. That
+ * drops the ground and anything too tall to be a wall, and keeps the points
+ * ordered by bearing for the matcher. Scans are matched against a keyframe
+ * with point to line icp, a new keyframe is taken once the robot has moved far
+ * enough from the last one, which keeps drift down while stationary.
+ *
+ * Parameters:
+ *   - ~footprint_frame: the frame of the robot on the ground (string,
+ *   default: "base_footprint")
+ *   - ~odom_frame: the frame the pose is in (string, default: "odom")
+ *   - ~min_height: lowest point used in the scan in meters (double, default: 0.1)
+ *   - ~max_height: highest point used in the scan in meters (double, default: 0.8)
+ *   - ~max_range: ignore points further than this in meters (double, default: 5.0)
+ *   - ~column_step: sample every nth column (int, default: 4)
+ *   - ~row_step: sample every nth row (int, default: 4)
+ *   - ~keyframe_distance: move this far before taking a new keyframe in
+ *   meters (double, default: 0.25)
+ *   - ~keyframe_angle: turn this far before taking a new keyframe in radians
+ *   (double, default: 0.15)
+ *   - ~max_correspondence: icp correspondence gate in meters (double,
+ *   default: 0.2)
+ *   - ~max_iterations: icp iteration limit (int, default: 20)
+ *   - ~min_overlap: fraction of the scan which has to match (double,
+ *   default: 0.5)
+ * Subscribed topics:
+ *   - depth/image_raw, depth/camera_info : the kinect depth stream
+ * Published topics:
+ *   - /scan_odom : (nav_msgs/Odometry) the pose of the footprint tracked by
+ *   scan matching
+ * */
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <nav_msgs/Odometry.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <image_transport/image_transport.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include <cmath>
+#include "scan_matcher.h"
+#include "depth_scan.h"
+
+/*
+ * When to move on to a new keyframe
+ * */
+struct KeyframeConstraints
+{
+    double distance;
+    double angle;
+};
+
+class ScanOdometryPublisher
+{
+    public:
+        ScanOdometryPublisher(ros::NodeHandle& n,
+                const std::string& f_frame,
+                const std::string& o_frame,
+                const DepthScan::ScanConstraints& s,
+                const KeyframeConstraints& k,
+                const ScanMatcher::MatchConstraints& m) :
+            tf_listener{tf_buffer},
+            image_transport{n},
+            footprint_frame{f_frame},
+            odometry_frame{o_frame},
+            keyframe{k},
+            depth_scan{s},
+            matcher{m},
+            pose{0, 0, 0},
+            keyframe_pose{0, 0, 0},
+            relative{0, 0, 0}
+        {
+            publisher = n.advertise<nav_msgs::Odometry>("/scan_odom", 10);
+            subscriber = image_transport.subscribeCamera("depth/image_raw", 1,
+                    &ScanOdometryPublisher::processDepth, this);
+            msg.header.frame_id = odometry_frame;
+            msg.child_frame_id = footprint_frame;
+        }
+
+        ~ScanOdometryPublisher() = default;
+        ScanOdometryPublisher(const ScanOdometryPublisher&) = delete;
+        ScanOdometryPublisher& operator=(const ScanOdometryPublisher&) = delete;
+        ScanOdometryPublisher(ScanOdometryPublisher&&) = delete;
+        ScanOdometryPublisher& operator=(ScanOdometryPublisher&&) = delete;
+
+    private:
+        tf2_ros::Buffer tf_buffer;
+        tf2_ros::TransformListener tf_listener;
+        image_transport::ImageTransport image_transport;
+        image_transport::CameraSubscriber subscriber;
+        ros::Publisher publisher;
+        const std::string& footprint_frame;
+        const std::string& odometry_frame;
+        const KeyframeConstraints& keyframe;
+
+        DepthScan depth_scan;
+        ScanMatcher matcher;
+        //pose of the footprint in odom, of the keyframe in odom, and of the
+        //footprint in the keyframe
+        ScanMatcher::Pose pose, keyframe_pose, relative;
+        ros::Time last_stamp;
+
+        //reused every frame
+        std::vector<ScanMatcher::Point> scan;
+        nav_msgs::Odometry msg;
+
+        /*
+         * Turns one depth image into a scan and registers it
+         * */
+        void processDepth(const sensor_msgs::ImageConstPtr& image,
+                const sensor_msgs::CameraInfoConstPtr& info)
+        {
+            if (!extractScan(*image, *info))
+                return;
+
+            if (!matcher.hasReference())
+            {
+                takeKeyframe(image->header.stamp);
+                return;
+            }
+
+            //the last offset from the keyframe is a good guess at 30hz
+            ScanMatcher::Pose estimate = relative;
+            ScanMatcher::MatchResult result;
+            if (!matcher.match(scan, estimate, result))
+            {
+                ROS_WARN_THROTTLE(5, "Scan Odometry: lost track, restarting from this scan");
+                takeKeyframe(image->header.stamp);
+                return;
+            }
+
+            ScanMatcher::Pose previous = pose;
+            relative = estimate;
+            pose = compose(keyframe_pose, relative);
+            publish(image->header.stamp, previous, result);
+
+            if (std::hypot(relative.x, relative.y) > keyframe.distance ||
+                    std::abs(relative.yaw) > keyframe.angle)
+                takeKeyframe(image->header.stamp);
+        }
+
+        /*
+         * Looks up where the kinect is and cuts the scan out of the image,
+         * returns false if the transform isn't there yet or nothing is in view
+         * */
+        bool extractScan(const sensor_msgs::Image& image, const sensor_msgs::CameraInfo& info)
+        {
+            geometry_msgs::TransformStamped mount;
+            try
+            {
+                mount = tf_buffer.lookupTransform(footprint_frame,
+                        image.header.frame_id, ros::Time(0));
+            }
+            catch (tf2::TransformException &ex)
+            {
+                ROS_WARN_THROTTLE(5, "Scan Odometry: waiting on transform %s", ex.what());
+                return false;
+            }
+            tf2::Transform transform;
+            tf2::fromMsg(mount.transform, transform);
+            return depth_scan.extract(image, info, transform, scan);
+        }
+
+        void takeKeyframe(const ros::Time& stamp)
+        {
+            matcher.setReference(scan);
+            keyframe_pose = pose;
+            relative = ScanMatcher::Pose{0, 0, 0};
+            last_stamp = stamp;
+        }
+
+        /*
+         * Applies b in the frame of a
+         * */
+        ScanMatcher::Pose compose(const ScanMatcher::Pose& a, const ScanMatcher::Pose& b)
+        {
+            double c = std::cos(a.yaw), s = std::sin(a.yaw);
+            return ScanMatcher::Pose{a.x + c * b.x - s * b.y,
+                a.y + s * b.x + c * b.y,
+                a.yaw + b.yaw};
+        }
+
+        void publish(const ros::Time& stamp, const ScanMatcher::Pose& previous,
+                const ScanMatcher::MatchResult& result)
+        {
+            double d_t = (stamp - last_stamp).toSec();
+            last_stamp = stamp;
+
+            tf2::Quaternion orientation;
+            orientation.setRPY(0, 0, pose.yaw);
+            msg.header.stamp = stamp;
+            msg.pose.pose.position.x = pose.x;
+            msg.pose.pose.position.y = pose.y;
+            msg.pose.pose.orientation = tf2::toMsg(orientation);
+
+            //match covariance is in the keyframe, rotate xy into odom
+            double c = std::cos(keyframe_pose.yaw), s = std::sin(keyframe_pose.yaw);
+            const double* m = result.covariance;
+            double xx = c*c*m[0] - 2*c*s*m[1] + s*s*m[4];
+            double yy = s*s*m[0] + 2*c*s*m[1] + c*c*m[4];
+            double xy = c*s*(m[0] - m[4]) + (c*c - s*s)*m[1];
+            double xt = c*m[2] - s*m[5];
+            double yt = s*m[2] + c*m[5];
+            msg.pose.covariance = {  xx,  xy,   0,   0,   0,   xt,
+                                     xy,  yy,   0,   0,   0,   yt,
+                                      0,   0, 1e3,   0,   0,    0,
+                                      0,   0,   0, 1e3,   0,    0,
+                                      0,   0,   0,   0, 1e3,    0,
+                                     xt,  yt,   0,   0,   0, m[8] };
+
+            //velocity in the body frame from the change since the last scan
+            if (d_t > 0)
+            {
+                double dx = pose.x - previous.x, dy = pose.y - previous.y;
+                double cp = std::cos(previous.yaw), sp = std::sin(previous.yaw);
+                msg.twist.twist.linear.x = (cp * dx + sp * dy) / d_t;
+                msg.twist.twist.linear.y = (-sp * dx + cp * dy) / d_t;
+                msg.twist.twist.angular.z = (pose.yaw - previous.yaw) / d_t;
+                //both ends of the difference carry the match noise
+                double scale = 2 / (d_t * d_t);
+                msg.twist.covariance = { scale*m[0], scale*m[1],   0,   0,   0, scale*m[2],
+                                         scale*m[3], scale*m[4],   0,   0,   0, scale*m[5],
+                                                  0,          0, 1e3,   0,   0,          0,
+                                                  0,          0,   0, 1e3,   0,          0,
+                                                  0,          0,   0,   0, 1e3,          0,
+                                         scale*m[6], scale*m[7],   0,   0,   0, scale*m[8] };
+            }
+            publisher.publish(msg);
+        }
+};
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "scan_odom_publisher");
+    ros::NodeHandle n;
+
+    std::string footprint_frame, odometry_frame;
+    DepthScan::ScanConstraints scan_constraints;
+    KeyframeConstraints keyframe_constraints;
+    ScanMatcher::MatchConstraints match_constraints;
+    ros::param::param<std::string>("~footprint_frame", footprint_frame, "base_footprint");
+    ros::param::param<std::string>("~odom_frame", odometry_frame, "odom");
+    ros::param::param<double>("~min_height", scan_constraints.min_height, 0.1);
+    ros::param::param<double>("~max_height", scan_constraints.max_height, 0.8);
+    ros::param::param<double>("~max_range", scan_constraints.max_range, 5.0);
+    ros::param::param<int>("~column_step", scan_constraints.column_step, 4);
+    ros::param::param<int>("~row_step", scan_constraints.row_step, 4);
+    ros::param::param<double>("~keyframe_distance", keyframe_constraints.distance, 0.25);
+    ros::param::param<double>("~keyframe_angle", keyframe_constraints.angle, 0.15);
+    ros::param::param<double>("~max_correspondence", match_constraints.max_correspondence, 0.2);
+    ros::param::param<int>("~max_iterations", match_constraints.max_iterations, 20);
+    ros::param::param<double>("~min_overlap", match_constraints.min_overlap, 0.5);
+    match_constraints.convergence = 1e-4;
+
+    ScanOdometryPublisher publisher{n, footprint_frame, odometry_frame,
+        scan_constraints, keyframe_constraints, match_constraints};
+    ros::spin();
+    return 0;
+}
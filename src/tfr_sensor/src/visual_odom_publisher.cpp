@@ -0,0 +1,589 @@
+/**
+ * Estimates the motion of the robot from ground features seen by the front and
+ * rear cameras, gives fusion a source of translation between fiducial
+ * sightings that doesn't care about the treads slipping.
+ *
+ * Each camera gets its own worker thread. FAST corners are detected in the
+ * part of the image that looks at the ground, and tracked frame to frame
+ * with pyramidal KLT. Tracked pixels are undistorted with the camera
+ * calibration and back projected onto the ground plane using the mounting
+ * transform from tf. The ground is flat and the cameras are rigid, so the
+ * motion between two frames is a 2d rigid transform of those ground points,
+ * which is fit with ransac and refined on the inliers, see rigid_fit.h.
+ *
+ * Only the twist is meant to be fused, the integrated pose is published for
+ * debugging and drifts like any other dead reckoning.
+ *
+ * Parameters:
+ *   - ~footprint_frame: the frame of the robot on the ground (string,
+ *   default: "base_footprint")
+ *   - ~odom_frame: the frame the integrated pose is in (string, default: "odom")
+ *   - ~rate: how quickly to publish hz (double, default: 30)
+ *   - ~max_features: how many features to track per camera (int, default: 200)
+ *   - ~min_features: detect new features below this many, at most
+ *   max_features (int, default: 80)
+ *   - ~fast_threshold: corner threshold for FAST (int, default: 20)
+ *   - ~max_range: ignore ground further than this in meters (double, default: 3.0)
+ *   - ~inlier_threshold: ransac tolerance in meters (double, default: 0.02)
+ *   - ~min_inliers: reject motion fit with fewer inliers (int, default: 15)
+ * Subscribed topics:
+ *   - front/image_raw, front/camera_info : the front camera
+ *   - rear/image_raw, rear/camera_info : the rear camera
+ * Published topics:
+ *   - /visual_odom : (nav_msgs/Odometry) the motion of the footprint tracked
+ *   by the cameras
+ * */
+#include <ros/ros.h>
+#include <ros/console.h>
+#include <nav_msgs/Odometry.h>
+#include <sensor_msgs/Image.h>
+#include <sensor_msgs/CameraInfo.h>
+#include <image_transport/image_transport.h>
+#include <cv_bridge/cv_bridge.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/features2d.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <tf2/LinearMath/Transform.h>
+#include <tf2_geometry_msgs/tf2_geometry_msgs.h>
+#include <tf2_ros/transform_listener.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include "rigid_fit.h"
+
+/*
+ * Tuning knobs shared by both cameras
+ * */
+struct TrackingConstraints
+{
+    int max_features;
+    int min_features;
+    int fast_threshold;
+    double max_range;
+    RigidFit::FitConstraints fit;
+};
+
+/*
+ * The motion of the footprint between two frames of a single camera, in the
+ * footprint frame of the earlier image.
+ * */
+struct GroundMotion
+{
+    ros::Time stamp;
+    double dt;
+    double x;
+    double y;
+    double yaw;
+    int inliers;
+    //mean squared distance of the inliers from their centroid, tells us how
+    //well the rotation is constrained
+    double spread;
+};
+
+/*
+ * Tracks ground features for one camera on its own thread.
+ * */
+class GroundTracker
+{
+    public:
+        GroundTracker(image_transport::ImageTransport& it,
+                const std::string& base_topic,
+                tf2_ros::Buffer& buffer,
+                const std::string& f_frame,
+                const TrackingConstraints& c) :
+            tf_buffer(buffer),
+            footprint_frame{f_frame},
+            constraints{c},
+            detector{cv::FastFeatureDetector::create(c.fast_threshold)},
+            rigid_fit{c.fit},
+            running{true}
+        {
+            subscriber = it.subscribeCamera(base_topic, 1, &GroundTracker::receive, this);
+            worker = std::thread{&GroundTracker::work, this};
+        }
+
+        ~GroundTracker()
+        {
+            subscriber.shutdown();
+            {
+                std::lock_guard<std::mutex> lock(frame_mutex);
+                running = false;
+            }
+            frame_ready.notify_one();
+            worker.join();
+        }
+
+        GroundTracker(const GroundTracker&) = delete;
+        GroundTracker& operator=(const GroundTracker&) = delete;
+        GroundTracker(GroundTracker&&) = delete;
+        GroundTracker& operator=(GroundTracker&&) = delete;
+
+        /*
+         * Gives the newest motion estimate, returns false if there hasn't
+         * been one since the last call
+         * */
+        bool getMotion(GroundMotion& out)
+        {
+            std::lock_guard<std::mutex> lock(motion_mutex);
+            if (!fresh_motion)
+                return false;
+            out = motion;
+            fresh_motion = false;
+            return true;
+        }
+
+    private:
+        //tracker window and pyramid depth for KLT
+        const cv::Size WINDOW{21, 21};
+        const int LEVELS = 3;
+        //rotation between the optical frame and our camera links, which
+        //follow the ros body convention (x forward, z up)
+        const tf2::Matrix3x3 LINK_FROM_OPTICAL{0, 0, 1,
+                                              -1, 0, 0,
+                                               0,-1, 0};
+
+        image_transport::CameraSubscriber subscriber;
+        tf2_ros::Buffer& tf_buffer;
+        const std::string& footprint_frame;
+        const TrackingConstraints& constraints;
+        cv::Ptr<cv::FastFeatureDetector> detector;
+        RigidFit rigid_fit;
+
+        //handoff from the ros thread, only the newest frame is kept
+        std::mutex frame_mutex;
+        std::condition_variable frame_ready;
+        sensor_msgs::ImageConstPtr pending_image;
+        sensor_msgs::CameraInfoConstPtr pending_info;
+        bool running;
+        std::thread worker;
+
+        std::mutex motion_mutex;
+        GroundMotion motion;
+        bool fresh_motion = false;
+
+        //calibration and mounting, filled on the first frame
+        bool initialized = false;
+        cv::Matx33d camera_matrix;
+        cv::Mat distortion;
+        tf2::Matrix3x3 footprint_from_optical;
+        tf2::Vector3 camera_origin;
+        int roi_top = 0;
+
+        //working state, owned by the worker thread and preallocated so the
+        //steady state doesn't touch the heap
+        ros::Time previous_stamp;
+        std::vector<cv::Mat> previous_pyramid, current_pyramid;
+        std::vector<cv::Point2f> previous_pixels, current_pixels;
+        std::vector<uchar> status;
+        std::vector<float> error;
+        std::vector<cv::Point2f> distorted, normalized;
+        std::vector<cv::Point2f> previous_ground, current_ground;
+        std::vector<RigidFit::Point> matched_previous, matched_current;
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat mask;
+
+        //subscription callback, runs on the ros thread so keep it short
+        void receive(const sensor_msgs::ImageConstPtr& image,
+                const sensor_msgs::CameraInfoConstPtr& info)
+        {
+            {
+                std::lock_guard<std::mutex> lock(frame_mutex);
+                pending_image = image;
+                pending_info = info;
+            }
+            frame_ready.notify_one();
+        }
+
+        void work()
+        {
+            while (true)
+            {
+                sensor_msgs::ImageConstPtr image;
+                sensor_msgs::CameraInfoConstPtr info;
+                {
+                    std::unique_lock<std::mutex> lock(frame_mutex);
+                    frame_ready.wait(lock, [this] { return !running || pending_image != nullptr; });
+                    if (!running)
+                        return;
+                    image.swap(pending_image);
+                    info.swap(pending_info);
+                }
+                if (!initialized && !initialize(*info))
+                    continue;
+                process(image);
+            }
+        }
+
+        /*
+         * Pulls the calibration from camera_info and the mounting transform
+         * from tf, then works out which rows of the image see usable ground.
+         * */
+        bool initialize(const sensor_msgs::CameraInfo& info)
+        {
+            geometry_msgs::TransformStamped mount;
+            try
+            {
+                mount = tf_buffer.lookupTransform(footprint_frame,
+                        info.header.frame_id, ros::Time(0));
+            }
+            catch (tf2::TransformException &ex)
+            {
+                ROS_WARN_THROTTLE(5, "Visual Odometry: waiting on transform %s",
+                        ex.what());
+                return false;
+            }
+            tf2::Transform transform;
+            tf2::fromMsg(mount.transform, transform);
+            footprint_from_optical = transform.getBasis() * LINK_FROM_OPTICAL;
+            camera_origin = transform.getOrigin();
+
+            camera_matrix = cv::Matx33d(info.K.data());
+            distortion = cv::Mat(info.D, true);
+
+            //the first row whose center pixel lands within range is the top
+            //of our region of interest, everything above it is wasted work
+            roi_top = info.height;
+            for (int row = 0; row < static_cast<int>(info.height); ++row)
+            {
+                distorted.assign(1, cv::Point2f(info.K[2], row));
+                cv::Point2f ground;
+                cv::undistortPoints(distorted, normalized, camera_matrix, distortion);
+                if (projectToGround(normalized[0], ground))
+                {
+                    roi_top = row;
+                    break;
+                }
+            }
+            if (roi_top > static_cast<int>(info.height) - WINDOW.height * 2)
+            {
+                ROS_WARN_ONCE("Visual Odometry: %s doesn't see enough ground",
+                        info.header.frame_id.c_str());
+                return false;
+            }
+            ROS_INFO("Visual Odometry: %s tracking ground below row %d",
+                    info.header.frame_id.c_str(), roi_top);
+            initialized = true;
+            return true;
+        }
+
+        /*
+         * Intersects a ray in normalized camera coordinates with the ground,
+         * returns false if it misses or lands out of range.
+         * */
+        bool projectToGround(const cv::Point2f& ray, cv::Point2f& ground)
+        {
+            tf2::Vector3 direction = footprint_from_optical * tf2::Vector3(ray.x, ray.y, 1.0);
+            if (direction.z() > -1e-3)
+                return false;
+            double scale = -camera_origin.z() / direction.z();
+            double x = scale * direction.x();
+            double y = scale * direction.y();
+            if (x * x + y * y > constraints.max_range * constraints.max_range)
+                return false;
+            ground.x = camera_origin.x() + x;
+            ground.y = camera_origin.y() + y;
+            return true;
+        }
+
+        void process(const sensor_msgs::ImageConstPtr& image)
+        {
+            cv_bridge::CvImageConstPtr cv_image;
+            try
+            {
+                cv_image = cv_bridge::toCvShare(image, "mono8");
+            }
+            catch (cv_bridge::Exception &ex)
+            {
+                ROS_WARN_THROTTLE(5, "Visual Odometry: %s", ex.what());
+                return;
+            }
+            //a view of the ground rows, no copy
+            cv::Mat roi = cv_image->image.rowRange(roi_top, cv_image->image.rows);
+            cv::buildOpticalFlowPyramid(roi, current_pyramid, WINDOW, LEVELS);
+
+            current_pixels.clear();
+            if (!previous_pixels.empty() && !previous_pyramid.empty())
+            {
+                cv::calcOpticalFlowPyrLK(previous_pyramid, current_pyramid,
+                        previous_pixels, current_pixels, status, error, WINDOW, LEVELS);
+                match();
+                estimateMotion(image->header.stamp);
+            }
+
+            if (static_cast<int>(current_pixels.size()) < constraints.min_features)
+                detect(roi);
+
+            std::swap(previous_pyramid, current_pyramid);
+            std::swap(previous_pixels, current_pixels);
+            previous_stamp = image->header.stamp;
+        }
+
+        /*
+         * Drops failed tracks and projects the survivors onto the ground for
+         * both frames, current_pixels is compacted to what is left so it can
+         * seed the next frame.
+         * */
+        void match()
+        {
+            matched_previous.clear();
+            matched_current.clear();
+            size_t kept = 0;
+            for (size_t i = 0; i < current_pixels.size(); ++i)
+            {
+                if (!status[i])
+                    continue;
+                previous_pixels[kept] = previous_pixels[i];
+                current_pixels[kept] = current_pixels[i];
+                ++kept;
+            }
+            previous_pixels.resize(kept);
+            current_pixels.resize(kept);
+            if (kept == 0)
+                return;
+
+            projectAll(previous_pixels, previous_ground);
+            projectAll(current_pixels, current_ground);
+            size_t survivors = 0;
+            for (size_t i = 0; i < kept; ++i)
+            {
+                //features walking out of the ground region are dropped too
+                if (std::isnan(previous_ground[i].x) || std::isnan(current_ground[i].x))
+                    continue;
+                matched_previous.push_back({previous_ground[i].x, previous_ground[i].y});
+                matched_current.push_back({current_ground[i].x, current_ground[i].y});
+                current_pixels[survivors++] = current_pixels[i];
+            }
+            current_pixels.resize(survivors);
+        }
+
+        /*
+         * Projects roi pixels onto the ground, misses are marked with nan so
+         * indexes still line up
+         * */
+        void projectAll(const std::vector<cv::Point2f>& pixels,
+                std::vector<cv::Point2f>& ground)
+        {
+            distorted.resize(pixels.size());
+            for (size_t i = 0; i < pixels.size(); ++i)
+                distorted[i] = cv::Point2f(pixels[i].x, pixels[i].y + roi_top);
+            cv::undistortPoints(distorted, normalized, camera_matrix, distortion);
+            ground.resize(pixels.size());
+            for (size_t i = 0; i < normalized.size(); ++i)
+                if (!projectToGround(normalized[i], ground[i]))
+                    ground[i].x = ground[i].y = NAN;
+        }
+
+        /*
+         * Finds new corners away from the ones we are already tracking,
+         * strongest first.
+         * */
+        void detect(const cv::Mat& roi)
+        {
+            mask.create(roi.size(), CV_8UC1);
+            mask.setTo(255);
+            for (const auto& pixel : current_pixels)
+                cv::circle(mask, pixel, 10, 0, -1);
+            detector->detect(roi, keypoints, mask);
+            //no negative count if we already track more than max_features
+            int wanted = std::max(constraints.max_features -
+                    static_cast<int>(current_pixels.size()), 0);
+            if (static_cast<int>(keypoints.size()) > wanted)
+            {
+                std::nth_element(keypoints.begin(), keypoints.begin() + wanted, keypoints.end(),
+                        [](const cv::KeyPoint& a, const cv::KeyPoint& b)
+                        { return a.response > b.response; });
+                keypoints.resize(wanted);
+            }
+            for (const auto& keypoint : keypoints)
+                current_pixels.push_back(keypoint.pt);
+        }
+
+        /*
+         * Fits the rigid transform taking current ground points to previous
+         * ones, which is the pose of the robot now in the frame of the robot
+         * last frame.
+         * */
+        void estimateMotion(const ros::Time& stamp)
+        {
+            double dt = (stamp - previous_stamp).toSec();
+            RigidFit::Transform transform;
+            RigidFit::FitResult fit;
+            if (dt <= 0 || !rigid_fit.fit(matched_current, matched_previous, transform, fit))
+                return;
+
+            GroundMotion result;
+            result.stamp = stamp;
+            result.dt = dt;
+            result.x = transform.x;
+            result.y = transform.y;
+            result.yaw = transform.yaw;
+            result.inliers = fit.inliers;
+            result.spread = fit.spread;
+
+            std::lock_guard<std::mutex> lock(motion_mutex);
+            motion = result;
+            fresh_motion = true;
+        }
+};
+
+class VisualOdometryPublisher
+{
+    public:
+        VisualOdometryPublisher(ros::NodeHandle& n,
+                const std::string& f_frame,
+                const std::string& o_frame,
+                const TrackingConstraints& c) :
+            tf_listener{tf_buffer},
+            image_transport{n},
+            footprint_frame{f_frame},
+            odometry_frame{o_frame},
+            constraints{c},
+            x{}, y{}, yaw{}
+        {
+            publisher = n.advertise<nav_msgs::Odometry>("/visual_odom", 10);
+            trackers.emplace_back(new GroundTracker{image_transport, "front/image_raw",
+                    tf_buffer, footprint_frame, constraints});
+            trackers.emplace_back(new GroundTracker{image_transport, "rear/image_raw",
+                    tf_buffer, footprint_frame, constraints});
+            msg.header.frame_id = odometry_frame;
+            msg.child_frame_id = footprint_frame;
+        }
+
+        ~VisualOdometryPublisher() = default;
+        VisualOdometryPublisher(const VisualOdometryPublisher&) = delete;
+        VisualOdometryPublisher& operator=(const VisualOdometryPublisher&) = delete;
+        VisualOdometryPublisher(VisualOdometryPublisher&&) = delete;
+        VisualOdometryPublisher& operator=(VisualOdometryPublisher&&) = delete;
+
+        /*
+         * Combines whatever the cameras measured since the last call, weighted
+         * by their inliers, and publishes it.
+         * */
+        void processOdometry()
+        {
+            double weight = 0, v_x = 0, v_y = 0, v_yaw = 0;
+            double information_xy = 0, information_yaw = 0;
+            ros::Time stamp;
+            GroundMotion motion;
+            for (auto& tracker : trackers)
+            {
+                if (!tracker->getMotion(motion))
+                    continue;
+                double w = motion.inliers;
+                v_x += w * motion.x / motion.dt;
+                v_y += w * motion.y / motion.dt;
+                v_yaw += w * motion.yaw / motion.dt;
+                weight += w;
+
+                //every inlier is within the threshold, so that bounds the
+                //variance of the averaged translation, rotation is that
+                //spread over how far apart the points are
+                double threshold = constraints.fit.inlier_threshold;
+                double var_xy = threshold * threshold /
+                    (motion.inliers * motion.dt * motion.dt);
+                information_xy += 1 / var_xy;
+                information_yaw += std::max(motion.spread, 1e-3) / var_xy;
+                if (motion.stamp > stamp)
+                    stamp = motion.stamp;
+            }
+            if (weight == 0)
+                return;
+            v_x /= weight;
+            v_y /= weight;
+            v_yaw /= weight;
+
+            //dead reckon the pose for debugging
+            if (last_stamp.isValid())
+            {
+                double d_t = (stamp - last_stamp).toSec();
+                x += (v_x * std::cos(yaw) - v_y * std::sin(yaw)) * d_t;
+                y += (v_x * std::sin(yaw) + v_y * std::cos(yaw)) * d_t;
+                yaw += v_yaw * d_t;
+            }
+            last_stamp = stamp;
+
+            tf2::Quaternion orientation;
+            orientation.setRPY(0, 0, yaw);
+            msg.header.stamp = stamp;
+            msg.pose.pose.position.x = x;
+            msg.pose.pose.position.y = y;
+            msg.pose.pose.orientation = tf2::toMsg(orientation);
+            //not meant to be fused, make sure nobody trusts it
+            msg.pose.covariance = { 1e3,   0,   0,   0,   0,   0,
+                                      0, 1e3,   0,   0,   0,   0,
+                                      0,   0, 1e3,   0,   0,   0,
+                                      0,   0,   0, 1e3,   0,   0,
+                                      0,   0,   0,   0, 1e3,   0,
+                                      0,   0,   0,   0,   0, 1e3 };
+
+            msg.twist.twist.linear.x = v_x;
+            msg.twist.twist.linear.y = v_y;
+            msg.twist.twist.angular.z = v_yaw;
+            double var_xy = 1 / information_xy, var_yaw = 1 / information_yaw;
+            msg.twist.covariance = { var_xy,      0,   0,   0,   0,       0,
+                                          0, var_xy,   0,   0,   0,       0,
+                                          0,      0, 1e3,   0,   0,       0,
+                                          0,      0,   0, 1e3,   0,       0,
+                                          0,      0,   0,   0, 1e3,       0,
+                                          0,      0,   0,   0,   0, var_yaw };
+            publisher.publish(msg);
+        }
+
+    private:
+        tf2_ros::Buffer tf_buffer;
+        tf2_ros::TransformListener tf_listener;
+        image_transport::ImageTransport image_transport;
+        ros::Publisher publisher;
+        const std::string& footprint_frame;
+        const std::string& odometry_frame;
+        const TrackingConstraints& constraints;
+        std::vector<std::unique_ptr<GroundTracker>> trackers;
+        nav_msgs::Odometry msg;
+        ros::Time last_stamp;
+        double x, y, yaw;
+};
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "visual_odom_publisher");
+    ros::NodeHandle n;
+
+    std::string footprint_frame, odometry_frame;
+    double rate;
+    TrackingConstraints constraints;
+    ros::param::param<std::string>("~footprint_frame", footprint_frame, "base_footprint");
+    ros::param::param<std::string>("~odom_frame", odometry_frame, "odom");
+    ros::param::param<double>("~rate", rate, 30.0);
+    ros::param::param<int>("~max_features", constraints.max_features, 200);
+    ros::param::param<int>("~min_features", constraints.min_features, 80);
+    if (constraints.min_features > constraints.max_features)
+    {
+        ROS_ERROR("Visual Odometry: min_features %d is over max_features %d, exiting",
+                constraints.min_features, constraints.max_features);
+        return 1;
+    }
+    ros::param::param<int>("~fast_threshold", constraints.fast_threshold, 20);
+    ros::param::param<double>("~max_range", constraints.max_range, 3.0);
+    ros::param::param<double>("~inlier_threshold", constraints.fit.inlier_threshold, 0.02);
+    ros::param::param<int>("~min_inliers", constraints.fit.min_inliers, 15);
+
+    //image callbacks only hand frames off to the trackers, the real work is
+    //on their own threads
+    ros::AsyncSpinner spinner(2);
+    spinner.start();
+
+    VisualOdometryPublisher publisher{n, footprint_frame, odometry_frame, constraints};
+    ros::Rate r(rate);
+    while (ros::ok())
+    {
+        publisher.processOdometry();
+        r.sleep();
+    }
+    return 0;
+}
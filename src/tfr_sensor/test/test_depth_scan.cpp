@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "depth_scan.h"
+
+namespace
+{
+    const DepthScan::ScanConstraints CONSTRAINTS{0.1, 0.8, 5.0, 1, 1};
+    const int WIDTH = 64, HEIGHT = 48;
+    const double FOCAL = 40, CENTER_X = 32, CENTER_Y = 24;
+    //the camera half a meter up, looking straight ahead
+    const double MOUNT_X = 0.2, MOUNT_Z = 0.5;
+    const double WALL = 2.0;
+
+    sensor_msgs::CameraInfo info()
+    {
+        sensor_msgs::CameraInfo info{};
+        info.width = WIDTH;
+        info.height = HEIGHT;
+        info.K = {FOCAL, 0, CENTER_X,
+                  0, FOCAL, CENTER_Y,
+                  0, 0, 1};
+        return info;
+    }
+
+    tf2::Transform mount()
+    {
+        //optical z forward, x right, y down into footprint x forward, y
+        //left, z up
+        tf2::Matrix3x3 rotation{0, 0, 1,
+                               -1, 0, 0,
+                                0,-1, 0};
+        return tf2::Transform{rotation, tf2::Vector3{MOUNT_X, 0, MOUNT_Z}};
+    }
+
+    /*
+     * Depths of a flat floor running up to a wall square to the camera, in
+     * meters, row major
+     * */
+    std::vector<double> room()
+    {
+        std::vector<double> depths;
+        for (int row = 0; row < HEIGHT; ++row)
+            for (int col = 0; col < WIDTH; ++col)
+            {
+                double down = (row - CENTER_Y) / FOCAL;
+                double depth = WALL;
+                if (down > 0)
+                    depth = std::min(depth, MOUNT_Z / down);
+                depths.push_back(depth);
+            }
+        return depths;
+    }
+
+    sensor_msgs::Image meters(const std::vector<double>& depths)
+    {
+        sensor_msgs::Image image{};
+        image.width = WIDTH;
+        image.height = HEIGHT;
+        image.encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+        image.step = WIDTH * sizeof(float);
+        image.data.resize(image.step * HEIGHT);
+        for (size_t i = 0; i < depths.size(); ++i)
+        {
+            float depth = depths[i];
+            std::memcpy(&image.data[i * sizeof(float)], &depth, sizeof(float));
+        }
+        return image;
+    }
+
+    sensor_msgs::Image millimeters(const std::vector<double>& depths)
+    {
+        sensor_msgs::Image image{};
+        image.width = WIDTH;
+        image.height = HEIGHT;
+        image.encoding = sensor_msgs::image_encodings::TYPE_16UC1;
+        image.step = WIDTH * sizeof(uint16_t);
+        image.data.resize(image.step * HEIGHT);
+        for (size_t i = 0; i < depths.size(); ++i)
+        {
+            uint16_t depth = std::round(depths[i] * 1000);
+            std::memcpy(&image.data[i * sizeof(uint16_t)], &depth, sizeof(uint16_t));
+        }
+        return image;
+    }
+
+    void fill(std::vector<double>& depths, int col_0, int row_0, int col_1, int row_1,
+            double depth)
+    {
+        for (int row = row_0; row <= row_1; ++row)
+            for (int col = col_0; col <= col_1; ++col)
+                depths[row * WIDTH + col] = depth;
+    }
+}
+
+TEST(DepthScan, CutsTheWallOutOfTheBand)
+{
+    DepthScan depth_scan{CONSTRAINTS};
+    std::vector<ScanMatcher::Point> scan;
+    ASSERT_TRUE(depth_scan.extract(meters(room()), info(), mount(), scan));
+    //the floor drops out, every column sees the wall
+    ASSERT_EQ(scan.size(), static_cast<size_t>(WIDTH));
+    for (int col = 0; col < WIDTH; ++col)
+    {
+        ASSERT_NEAR(scan[col].x, MOUNT_X + WALL, 1e-5);
+        ASSERT_NEAR(scan[col].y, -(col - CENTER_X) * WALL / FOCAL, 1e-5);
+    }
+    //in bearing order
+    for (size_t i = 1; i < scan.size(); ++i)
+        ASSERT_LT(std::atan2(scan[i].y, scan[i].x), std::atan2(scan[i - 1].y, scan[i - 1].x));
+}
+
+TEST(DepthScan, KeepsTheClosestPointInTheBand)
+{
+    auto depths = room();
+    //a post in front of the wall across the band
+    fill(depths, 10, 20, 19, 30, 1.0);
+    //and a ledge overhead, closer still but above the band
+    fill(depths, 40, 0, 49, 5, 0.8);
+    DepthScan depth_scan{CONSTRAINTS};
+    std::vector<ScanMatcher::Point> scan;
+    ASSERT_TRUE(depth_scan.extract(meters(depths), info(), mount(), scan));
+    ASSERT_EQ(scan.size(), static_cast<size_t>(WIDTH));
+    for (int col = 10; col <= 19; ++col)
+        ASSERT_NEAR(scan[col].x, MOUNT_X + 1.0, 1e-5);
+    for (int col = 40; col <= 49; ++col)
+        ASSERT_NEAR(scan[col].x, MOUNT_X + WALL, 1e-5);
+}
+
+TEST(DepthScan, ReadsMillimeters)
+{
+    DepthScan depth_scan{CONSTRAINTS};
+    std::vector<ScanMatcher::Point> in_meters, in_millimeters;
+    ASSERT_TRUE(depth_scan.extract(meters(room()), info(), mount(), in_meters));
+    ASSERT_TRUE(depth_scan.extract(millimeters(room()), info(), mount(), in_millimeters));
+    ASSERT_EQ(in_meters.size(), in_millimeters.size());
+    for (size_t i = 0; i < in_meters.size(); ++i)
+    {
+        ASSERT_NEAR(in_meters[i].x, in_millimeters[i].x, 1e-3);
+        ASSERT_NEAR(in_meters[i].y, in_millimeters[i].y, 1e-3);
+    }
+}
+
+TEST(DepthScan, SkipsMissingAndDistantColumns)
+{
+    auto depths = room();
+    //no return at all in some columns
+    fill(depths, 0, 0, 3, HEIGHT - 1, 0);
+    fill(depths, 4, 0, 7, HEIGHT - 1, std::numeric_limits<double>::quiet_NaN());
+    fill(depths, 8, 0, 11, HEIGHT - 1, std::numeric_limits<double>::infinity());
+    DepthScan depth_scan{CONSTRAINTS};
+    std::vector<ScanMatcher::Point> scan;
+    ASSERT_TRUE(depth_scan.extract(meters(depths), info(), mount(), scan));
+    ASSERT_EQ(scan.size(), static_cast<size_t>(WIDTH - 12));
+    ASSERT_NEAR(scan[0].y, -(12 - CENTER_X) * WALL / FOCAL, 1e-5);
+
+    //the wall out of range leaves nothing
+    DepthScan::ScanConstraints near = CONSTRAINTS;
+    near.max_range = 1.5;
+    DepthScan short_scan{near};
+    ASSERT_FALSE(short_scan.extract(meters(room()), info(), mount(), scan));
+    ASSERT_TRUE(scan.empty());
+}
+
+TEST(DepthScan, SamplesEveryStep)
+{
+    DepthScan::ScanConstraints sparse = CONSTRAINTS;
+    sparse.column_step = 3;
+    sparse.row_step = 4;
+    DepthScan depth_scan{sparse};
+    std::vector<ScanMatcher::Point> scan;
+    ASSERT_TRUE(depth_scan.extract(meters(room()), info(), mount(), scan));
+    ASSERT_EQ(scan.size(), static_cast<size_t>((WIDTH + 2) / 3));
+    ASSERT_NEAR(scan[1].y, -(3 - CENTER_X) * WALL / FOCAL, 1e-5);
+}
+
+TEST(DepthScan, RefusesOtherEncodings)
+{
+    DepthScan depth_scan{CONSTRAINTS};
+    auto image = meters(room());
+    image.encoding = sensor_msgs::image_encodings::RGB8;
+    std::vector<ScanMatcher::Point> scan;
+    ASSERT_FALSE(depth_scan.extract(image, info(), mount(), scan));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <sensor_msgs/image_encodings.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "elevation_grid.h"
+
+namespace
+{
+    //2 m square in 10 cm cells, a cell needs 4 samples to count
+    const ElevationGrid::GridConstraints CONSTRAINTS{0, 2, 0, 2, 0.1, 1, 4};
+    const int WIDTH = 64, HEIGHT = 48;
+    const double FOCAL = 40, CENTER_X = 32, CENTER_Y = 24;
+    //off the cell boundaries so no pixel lands right on one
+    const double CAMERA_X = 1.01, CAMERA_Y = 1.01;
+    //a meter up the pixels land 2.5 cm apart, 16 to a cell, covering cell
+    //columns 2 to 17 and rows 4 to 16
+    const int SEEN = 16 * 13;
+
+    sensor_msgs::CameraInfo info()
+    {
+        sensor_msgs::CameraInfo info{};
+        info.width = WIDTH;
+        info.height = HEIGHT;
+        info.K = {FOCAL, 0, CENTER_X,
+                  0, FOCAL, CENTER_Y,
+                  0, 0, 1};
+        return info;
+    }
+
+    //looking straight down from height, image right along x and down along -y
+    tf2::Transform overhead(double height, double shift = 0)
+    {
+        tf2::Matrix3x3 rotation{1, 0, 0,
+                                0,-1, 0,
+                                0, 0,-1};
+        return tf2::Transform{rotation, tf2::Vector3{CAMERA_X + shift, CAMERA_Y, height}};
+    }
+
+    sensor_msgs::Image flat(double depth)
+    {
+        sensor_msgs::Image image{};
+        image.width = WIDTH;
+        image.height = HEIGHT;
+        image.encoding = sensor_msgs::image_encodings::TYPE_32FC1;
+        image.step = WIDTH * sizeof(float);
+        image.data.resize(image.step * HEIGHT);
+        float value = depth;
+        for (int i = 0; i < WIDTH * HEIGHT; ++i)
+            std::memcpy(&image.data[i * sizeof(float)], &value, sizeof(float));
+        return image;
+    }
+
+    int seen(const ElevationGrid& grid)
+    {
+        int count = 0;
+        double value;
+        for (int row = 0; row < grid.getRows(); ++row)
+            for (int column = 0; column < grid.getColumns(); ++column)
+                count += grid.height(column, row, value);
+        return count;
+    }
+}
+
+TEST(ElevationGrid, MapsFlatGround)
+{
+    ElevationGrid grid{CONSTRAINTS};
+    ASSERT_EQ(grid.getColumns(), 20);
+    ASSERT_EQ(grid.getRows(), 20);
+    ASSERT_DOUBLE_EQ(grid.getCoverage(), 0);
+    ASSERT_TRUE(grid.add(flat(1.0), info(), overhead(1.0)));
+
+    ASSERT_EQ(seen(grid), SEEN);
+    ASSERT_DOUBLE_EQ(grid.getCoverage(), SEEN / 400.0);
+    double value = 1;
+    ASSERT_TRUE(grid.height(10, 10, value));
+    ASSERT_NEAR(value, 0, 1e-9);
+    ASSERT_TRUE(grid.height(2, 4, value));
+    ASSERT_FALSE(grid.height(1, 4, value));
+    ASSERT_FALSE(grid.height(18, 10, value));
+    ASSERT_FALSE(grid.height(10, 17, value));
+}
+
+TEST(ElevationGrid, FindsTheCell)
+{
+    ElevationGrid grid{CONSTRAINTS};
+    int column, row;
+    ASSERT_TRUE(grid.cellOf(0.05, 0.15, column, row));
+    ASSERT_EQ(column, 0);
+    ASSERT_EQ(row, 1);
+    ASSERT_TRUE(grid.cellOf(1.99, 1.99, column, row));
+    ASSERT_EQ(column, 19);
+    ASSERT_EQ(row, 19);
+    ASSERT_FALSE(grid.cellOf(-0.01, 1.0, column, row));
+    ASSERT_FALSE(grid.cellOf(1.0, 2.01, column, row));
+}
+
+TEST(ElevationGrid, AveragesFrames)
+{
+    ElevationGrid grid{CONSTRAINTS};
+    ASSERT_TRUE(grid.add(flat(1.0), info(), overhead(1.0)));
+    ASSERT_TRUE(grid.add(flat(1.0), info(), overhead(1.2)));
+    double value;
+    ASSERT_TRUE(grid.height(10, 10, value));
+    ASSERT_NEAR(value, 0.1, 1e-9);
+
+    grid.clear();
+    ASSERT_EQ(seen(grid), 0);
+    //nor do other encodings get in
+    auto image = flat(1.0);
+    image.encoding = sensor_msgs::image_encodings::RGB8;
+    ASSERT_FALSE(grid.add(image, info(), overhead(1.0)));
+    ASSERT_EQ(seen(grid), 0);
+}
+
+TEST(ElevationGrid, AgesOutOldSamples)
+{
+    ElevationGrid grid{CONSTRAINTS};
+    ASSERT_TRUE(grid.add(flat(1.0), info(), overhead(1.0)));
+    //16 samples a cell down to 4, then 16 new ones at 0.2
+    grid.age(0.25);
+    double value;
+    ASSERT_TRUE(grid.height(10, 10, value));
+    ASSERT_NEAR(value, 0, 1e-9);
+    ASSERT_TRUE(grid.add(flat(1.0), info(), overhead(1.2)));
+    ASSERT_TRUE(grid.height(10, 10, value));
+    ASSERT_NEAR(value, 0.2 * 16 / 20, 1e-9);
+
+    //faded under min_samples, the cells go back to unseen
+    grid.age(0.1);
+    ASSERT_EQ(seen(grid), 0);
+}
+
+TEST(ElevationGrid, MeasuresWhatWasDug)
+{
+    ElevationGrid before{CONSTRAINTS}, after{CONSTRAINTS};
+    ASSERT_TRUE(before.add(flat(1.0), info(), overhead(1.0)));
+    //the same ground 10 cm lower
+    ASSERT_TRUE(after.add(flat(1.0), info(), overhead(0.9)));
+    ASSERT_NEAR(after.removedSince(before), SEEN * 0.1 * 0.01, 1e-9);
+    //filling in doesn't count
+    ASSERT_NEAR(before.removedSince(after), 0, 1e-9);
+
+    //only cells both have seen count, half a meter over only 11 columns of
+    //16 overlap
+    ElevationGrid shifted{CONSTRAINTS};
+    ASSERT_TRUE(shifted.add(flat(1.0), info(), overhead(0.9, 0.5)));
+    ASSERT_NEAR(shifted.removedSince(before), 11 * 13 * 0.1 * 0.01, 1e-9);
+}
+
+TEST(ElevationGrid, SwapsContents)
+{
+    ElevationGrid full{CONSTRAINTS}, empty{CONSTRAINTS};
+    ASSERT_TRUE(full.add(flat(1.0), info(), overhead(1.0)));
+    full.swap(empty);
+    ASSERT_EQ(seen(full), 0);
+    ASSERT_EQ(seen(empty), SEEN);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
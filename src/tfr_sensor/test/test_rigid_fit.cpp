@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include "rigid_fit.h"
+
+namespace
+{
+    const RigidFit::FitConstraints CONSTRAINTS{0.02, 15};
+
+    RigidFit::Point apply(const RigidFit::Transform& t, const RigidFit::Point& p)
+    {
+        double c = std::cos(t.yaw), s = std::sin(t.yaw);
+        return RigidFit::Point{c * p.x - s * p.y + t.x, s * p.x + c * p.y + t.y};
+    }
+
+    //ground features scattered in front of a camera, a pseudo random grid
+    std::vector<RigidFit::Point> features(int count)
+    {
+        std::vector<RigidFit::Point> points;
+        for (int i = 0; i < count; ++i)
+            points.push_back(RigidFit::Point{0.5 + (i * 37 % 50) * 0.03,
+                    -0.8 + (i * 23 % 40) * 0.04});
+        return points;
+    }
+
+    std::vector<RigidFit::Point> moved(const RigidFit::Transform& t,
+            const std::vector<RigidFit::Point>& points)
+    {
+        std::vector<RigidFit::Point> out;
+        for (const auto& p : points)
+            out.push_back(apply(t, p));
+        return out;
+    }
+}
+
+TEST(RigidFit, RecoversAnExactMotion)
+{
+    RigidFit fit{CONSTRAINTS};
+    const RigidFit::Transform truth{0.03, -0.01, 0.02};
+    auto from = features(60);
+    auto to = moved(truth, from);
+    RigidFit::Transform transform;
+    RigidFit::FitResult result;
+    ASSERT_TRUE(fit.fit(from, to, transform, result));
+    ASSERT_EQ(result.inliers, 60);
+    ASSERT_NEAR(transform.x, truth.x, 1e-9);
+    ASSERT_NEAR(transform.y, truth.y, 1e-9);
+    ASSERT_NEAR(transform.yaw, truth.yaw, 1e-9);
+    ASSERT_GT(result.spread, 0.1);
+}
+
+TEST(RigidFit, IgnoresBadTracks)
+{
+    RigidFit fit{CONSTRAINTS};
+    const RigidFit::Transform truth{-0.05, 0.02, -0.04};
+    auto from = features(60);
+    auto to = moved(truth, from);
+    //a third of the tracks jumped somewhere else entirely
+    for (size_t i = 0; i < to.size(); i += 3)
+    {
+        to[i].x += 0.3;
+        to[i].y -= 0.2;
+    }
+    RigidFit::Transform transform;
+    RigidFit::FitResult result;
+    ASSERT_TRUE(fit.fit(from, to, transform, result));
+    ASSERT_EQ(result.inliers, 40);
+    ASSERT_NEAR(transform.x, truth.x, 1e-9);
+    ASSERT_NEAR(transform.y, truth.y, 1e-9);
+    ASSERT_NEAR(transform.yaw, truth.yaw, 1e-9);
+}
+
+TEST(RigidFit, AveragesNoise)
+{
+    RigidFit fit{CONSTRAINTS};
+    const RigidFit::Transform truth{0.02, 0.0, 0.01};
+    auto from = features(100);
+    auto to = moved(truth, from);
+    //a few mm of alternating error, well inside the threshold
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+        to[i].x += (i % 2 ? 0.004 : -0.004);
+        to[i].y += (i % 3 ? 0.003 : -0.006);
+    }
+    RigidFit::Transform transform;
+    RigidFit::FitResult result;
+    ASSERT_TRUE(fit.fit(from, to, transform, result));
+    ASSERT_EQ(result.inliers, 100);
+    ASSERT_NEAR(transform.x, truth.x, 2e-3);
+    ASSERT_NEAR(transform.y, truth.y, 2e-3);
+    ASSERT_NEAR(transform.yaw, truth.yaw, 2e-3);
+}
+
+TEST(RigidFit, RepeatsItself)
+{
+    RigidFit fit{CONSTRAINTS};
+    auto from = features(60);
+    auto to = moved({0.01, 0.01, 0.1}, from);
+    for (size_t i = 0; i < to.size(); i += 2)
+        to[i].x += 0.01;
+    RigidFit::Transform first, second;
+    RigidFit::FitResult result;
+    ASSERT_TRUE(fit.fit(from, to, first, result));
+    ASSERT_TRUE(fit.fit(from, to, second, result));
+    ASSERT_EQ(first.x, second.x);
+    ASSERT_EQ(first.y, second.y);
+    ASSERT_EQ(first.yaw, second.yaw);
+}
+
+TEST(RigidFit, FailsWithoutAgreement)
+{
+    RigidFit fit{CONSTRAINTS};
+    RigidFit::Transform transform;
+    RigidFit::FitResult result;
+    //too few tracks to trust
+    auto from = features(10);
+    ASSERT_FALSE(fit.fit(from, moved({0.01, 0, 0}, from), transform, result));
+    //mismatched lists
+    from = features(30);
+    auto to = moved({0.01, 0, 0}, from);
+    to.pop_back();
+    ASSERT_FALSE(fit.fit(from, to, transform, result));
+    //every track moving its own way
+    to = from;
+    for (size_t i = 0; i < to.size(); ++i)
+    {
+        to[i].x += std::cos(i * 2.4) * 0.2;
+        to[i].y += std::sin(i * 2.4) * 0.2;
+    }
+    ASSERT_FALSE(fit.fit(from, to, transform, result));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
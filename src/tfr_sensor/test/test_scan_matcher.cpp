@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "scan_matcher.h"
+
+namespace
+{
+    const ScanMatcher::MatchConstraints CONSTRAINTS{0.3, 20, 1e-4, 0.5};
+
+    /*
+     * What a scanner at pose sees of a 4 by 3 m room centered on the origin,
+     * one point a degree, in bearing order
+     * */
+    std::vector<ScanMatcher::Point> room(const ScanMatcher::Pose& pose)
+    {
+        std::vector<ScanMatcher::Point> scan;
+        for (int degree = -180; degree < 180; ++degree)
+        {
+            double bearing = degree * M_PI / 180;
+            double dx = std::cos(pose.yaw + bearing), dy = std::sin(pose.yaw + bearing);
+            double range = std::numeric_limits<double>::infinity();
+            if (std::abs(dx) > 1e-9)
+                range = std::min(range, ((dx > 0 ? 2.0 : -2.0) - pose.x) / dx);
+            if (std::abs(dy) > 1e-9)
+                range = std::min(range, ((dy > 0 ? 1.5 : -1.5) - pose.y) / dy);
+            scan.push_back(ScanMatcher::Point{range * std::cos(bearing),
+                    range * std::sin(bearing)});
+        }
+        return scan;
+    }
+}
+
+TEST(ScanMatcher, FindsTheOffset)
+{
+    ScanMatcher matcher{CONSTRAINTS};
+    ASSERT_FALSE(matcher.hasReference());
+    matcher.setReference(room({0, 0, 0}));
+    ASSERT_TRUE(matcher.hasReference());
+
+    ScanMatcher::Pose truth{0.08, -0.05, 0.06};
+    ScanMatcher::Pose estimate{0, 0, 0};
+    ScanMatcher::MatchResult result;
+    ASSERT_TRUE(matcher.match(room(truth), estimate, result));
+    ASSERT_NEAR(estimate.x, truth.x, 2e-3);
+    ASSERT_NEAR(estimate.y, truth.y, 2e-3);
+    ASSERT_NEAR(estimate.yaw, truth.yaw, 2e-3);
+    ASSERT_GT(result.iterations, 1);
+    ASSERT_LE(result.iterations, CONSTRAINTS.max_iterations);
+    ASSERT_GT(result.correspondences, 300);
+    ASSERT_LT(result.rms, 0.01);
+    for (int i = 0; i < 3; ++i)
+    {
+        ASSERT_GT(result.covariance[i * 4], 0);
+        for (int j = 0; j < 3; ++j)
+            ASSERT_NEAR(result.covariance[i * 3 + j], result.covariance[j * 3 + i], 1e-12);
+    }
+}
+
+TEST(ScanMatcher, FailsWithoutConverging)
+{
+    ScanMatcher::MatchConstraints constraints = CONSTRAINTS;
+    ScanMatcher matcher{constraints};
+    matcher.setReference(room({0, 0, 0}));
+    auto scan = room({0.08, -0.05, 0.06});
+    ScanMatcher::MatchResult result;
+
+    //no iterations at all
+    constraints.max_iterations = 0;
+    ScanMatcher::Pose estimate{0, 0, 0};
+    ASSERT_FALSE(matcher.match(scan, estimate, result));
+    ASSERT_EQ(estimate.x, 0);
+    ASSERT_EQ(estimate.y, 0);
+    ASSERT_EQ(estimate.yaw, 0);
+
+    //one step can't get under the convergence threshold from this far off
+    constraints.max_iterations = 1;
+    ASSERT_FALSE(matcher.match(scan, estimate, result));
+    ASSERT_EQ(estimate.x, 0);
+
+    constraints.max_iterations = 20;
+    ASSERT_TRUE(matcher.match(scan, estimate, result));
+}
+
+TEST(ScanMatcher, FailsOnAFlatWall)
+{
+    //a wall along x can't pin down sliding along it
+    std::vector<ScanMatcher::Point> wall;
+    for (int i = -50; i <= 50; ++i)
+        wall.push_back(ScanMatcher::Point{i * 0.02, 1.0});
+    ScanMatcher matcher{CONSTRAINTS};
+    matcher.setReference(wall);
+    ScanMatcher::Pose estimate{0, 0, 0};
+    ScanMatcher::MatchResult result;
+    ASSERT_FALSE(matcher.match(wall, estimate, result));
+}
+
+TEST(ScanMatcher, FailsWithoutOverlap)
+{
+    ScanMatcher matcher{CONSTRAINTS};
+    ScanMatcher::Pose estimate{0, 0, 0};
+    ScanMatcher::MatchResult result;
+    //no reference yet
+    ASSERT_FALSE(matcher.match(room({0, 0, 0}), estimate, result));
+    matcher.setReference(room({0, 0, 0}));
+    ASSERT_FALSE(matcher.match({}, estimate, result));
+    //a guess a meter off puts almost nothing inside the gate
+    estimate = ScanMatcher::Pose{1.0, 1.0, 0};
+    ASSERT_FALSE(matcher.match(room({0, 0, 0}), estimate, result));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
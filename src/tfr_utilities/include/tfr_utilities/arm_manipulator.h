@@ -6,6 +6,21 @@
 #include <actionlib/server/simple_action_server.h>
 #include <trajectory_msgs/JointTrajectory.h>
 
+/**
+ * The two trajectories moveArm sends. The joint names and sizes are filled in
+ * once, each move only writes the positions and the stamps, so sending a
+ * command doesn't touch the heap.
+ * */
+struct ArmTrajectories
+{
+    ArmTrajectories();
+    void set(const double& turntable, const double& lower_arm,
+            const double& upper_arm, const double& scoop_angle, const ros::Time& stamp);
+
+    trajectory_msgs::JointTrajectory arm;
+    trajectory_msgs::JointTrajectory scoop;
+};
+
 /**
  * Collection of utility methods for arm
  * */
@@ -22,6 +37,7 @@ class ArmManipulator
     private:
         ros::Publisher trajectory_publisher;
         ros::Publisher scoop_trajectory_publisher;
+        ArmTrajectories trajectories;
  };
 
 #endif
@@ -0,0 +1,68 @@
+/* A callback queue with a thread of its own to serve it, for keeping one
+ * kind of traffic from waiting behind another. Hand out node handles from
+ * handle() and whatever is subscribed or advertised through them runs on this
+ * thread instead of the node's global queue (or the nodelet manager's).
+ *
+ * The thread is named, so the scheduling profile (tfr_launch) can give it a
+ * priority and cores of its own, names are capped at 15 characters.
+ *
+ * Subscribers and servers take the queue with them when they go, declare the
+ * CallbackThread before anything using its handles so it outlives them.
+ * */
+#ifndef CALLBACK_THREAD_H
+#define CALLBACK_THREAD_H
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+class CallbackThread
+{
+    public:
+        explicit CallbackThread(const std::string& name) :
+            queue{}, stopping{false}, worker{&CallbackThread::spin, this}
+        {
+            pthread_setname_np(worker.native_handle(), name.substr(0, 15).c_str());
+        }
+        ~CallbackThread() { stop(); }
+        CallbackThread(const CallbackThread&) = delete;
+        CallbackThread& operator=(const CallbackThread&) = delete;
+        CallbackThread(CallbackThread&&) = delete;
+        CallbackThread& operator=(CallbackThread&&) = delete;
+
+        /*
+         * A copy of n with its callbacks on this thread
+         * */
+        ros::NodeHandle handle(const ros::NodeHandle& n)
+        {
+            ros::NodeHandle queued{n};
+            queued.setCallbackQueue(&queue);
+            return queued;
+        }
+
+        void stop()
+        {
+            stopping = true;
+            if (worker.joinable())
+                worker.join();
+        }
+
+    private:
+        //how long to wait for a callback before checking for a stop [s]
+        static constexpr double POLL_PERIOD = 0.1;
+
+        ros::CallbackQueue queue;
+        std::atomic<bool> stopping;
+        std::thread worker;
+
+        void spin()
+        {
+            while (!stopping && ros::ok())
+                queue.callAvailable(ros::WallDuration(POLL_PERIOD));
+        }
+};
+
+#endif
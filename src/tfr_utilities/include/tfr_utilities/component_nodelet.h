@@ -0,0 +1,69 @@
+/* Base for running one of our components as a nodelet, so the whole robot
+ * can share one manager process (robot.launch composed:=true), or each piece
+ * can run on its own with `nodelet standalone` for debugging.
+ *
+ * Most components block in their constructor until the servers they talk to
+ * come up. A manager loads nodelets one at a time, so blocking in onInit
+ * would stall everything loaded after it, and two components waiting on each
+ * other would never come up. start() runs on a thread of its own instead.
+ * Components with a loop of their own keep looping in start() while
+ * running(). The thread is named after the nodelet, so the scheduling
+ * profile (tfr_launch) can find it inside a shared manager.
+ *
+ * Parameters come from getPrivateNodeHandle(), not "~", which resolves to the
+ * manager when loaded into one. Derived classes call stop() first thing in
+ * their destructor, before the members start() works with go away.
+ * */
+#ifndef COMPONENT_NODELET_H
+#define COMPONENT_NODELET_H
+
+#include <ros/ros.h>
+#include <nodelet/nodelet.h>
+#include <pthread.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+class ComponentNodelet : public nodelet::Nodelet
+{
+    public:
+        ComponentNodelet() : stopping{false} {}
+        virtual ~ComponentNodelet() { stop(); }
+        ComponentNodelet(const ComponentNodelet&) = delete;
+        ComponentNodelet& operator=(const ComponentNodelet&) = delete;
+        ComponentNodelet(ComponentNodelet&&) = delete;
+        ComponentNodelet& operator=(ComponentNodelet&&) = delete;
+
+    protected:
+        /*
+         * Builds the component, on the worker thread
+         * */
+        virtual void start() = 0;
+
+        bool running() const
+        {
+            return !stopping && ros::ok();
+        }
+
+        void stop()
+        {
+            stopping = true;
+            if (worker.joinable())
+                worker.join();
+        }
+
+    private:
+        std::atomic<bool> stopping;
+        std::thread worker;
+
+        void onInit() override
+        {
+            worker = std::thread{&ComponentNodelet::start, this};
+            //thread names are capped at 15 characters
+            const std::string& name = getName();
+            std::string thread_name = name.substr(name.rfind('/') + 1, 15);
+            pthread_setname_np(worker.native_handle(), thread_name.c_str());
+        }
+};
+
+#endif
@@ -0,0 +1,52 @@
+/* Holds a set of tuning values that can be swapped out while other threads
+ * are reading them, used behind the dynamic_reconfigure servers.
+ *
+ * Readers call get() once per cycle and work from that reference, so they
+ * always see a whole consistent set, never half of an update. get() is a
+ * single atomic load, no lock is taken on the hot path.
+ *
+ * set() publishes a new copy. Old copies are kept until the snapshot goes
+ * away, since a reader could still be holding one. Sets only come from a
+ * person dragging sliders, so the handful of retired copies doesn't matter.
+ * Only one thread may call set() at a time, dynamic_reconfigure already
+ * serializes its callbacks.
+ * */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+template <typename T>
+class Snapshot
+{
+    public:
+        explicit Snapshot(const T& initial) :
+            current{nullptr}
+        {
+            set(initial);
+        }
+        ~Snapshot() = default;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot(Snapshot&&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+
+        const T& get() const
+        {
+            return *current.load(std::memory_order_acquire);
+        }
+
+        void set(const T& values)
+        {
+            versions.emplace_back(new T(values));
+            current.store(versions.back().get(), std::memory_order_release);
+        }
+
+    private:
+        std::atomic<const T*> current;
+        std::vector<std::unique_ptr<const T>> versions;
+};
+
+#endif
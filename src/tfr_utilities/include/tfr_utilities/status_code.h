@@ -65,4 +65,9 @@ enum class StatusCode : uint16_t
  */
 std::string getStatusMessage(StatusCode code, float data);
 
+/**
+ * Same message without the copy, points at a literal.
+ */
+const char* getStatusText(StatusCode code, float data);
+
 #endif
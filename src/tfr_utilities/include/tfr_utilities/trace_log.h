@@ -0,0 +1,303 @@
+/* Logging for hot loops.
+ *
+ * TFR_INFO_LIMITED(period, format, ...), and the DEBUG and WARN versions,
+ * log through rosconsole like ROS_INFO, except each call site prints at most
+ * once every period seconds, and repeats of the line it last printed are held
+ * back for REPEAT_PERIOD. The next line out says how many were held back. A
+ * call that's held back by the period costs a clock read, nothing is
+ * formatted. The lines go to the <package>.limited logger, so rqt_logger_level
+ * can quiet them or turn them up to debug without touching the rest.
+ *
+ * To debug with every call, not just the ones printed, set TFR_TRACE_DIR in
+ * the node's environment. Each call then also copies its arguments into a
+ * lock free ring as a fixed size binary record, and a background thread
+ * writes them to <TFR_TRACE_DIR>/<node>-<pid>.trace. Read it back with
+ * `rosrun tfr_utilities trace_dump <file>` on the same machine type. When the
+ * writer falls behind records are dropped, never waited on, and the dump says
+ * how many.
+ *
+ * Arguments are numbers or C strings, at most MAX_TRACE_ARGS of them, and the
+ * compiler checks them against the format as with printf. Strings are cut to
+ * 15 characters in the trace.
+ * */
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <ros/console.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace tfr_utilities
+{
+    const size_t MAX_TRACE_ARGS = 4;
+    const size_t MAX_LOG_LENGTH = 256;
+    //a line the same as the last one printed waits this long [s]
+    const double REPEAT_PERIOD = 10.0;
+
+    struct TraceArg
+    {
+        enum class Type : uint8_t
+        {
+            NONE,
+            INTEGER,
+            REAL,
+            TEXT
+        };
+
+        Type type;
+        union
+        {
+            int64_t integer;
+            double real;
+            char text[16];
+        };
+    };
+
+    class TraceSite;
+
+    /*
+     * One call, stamped with the wall clock in nanoseconds
+     * */
+    struct TraceRecord
+    {
+        //only meaningful in this process, the file goes by the id
+        const TraceSite* source;
+        uint32_t site;
+        uint32_t count;
+        int64_t stamp;
+        TraceArg args[MAX_TRACE_ARGS];
+    };
+
+    /*
+     * Where a limited log is called from and when it last printed, one per
+     * call site, made by the macros
+     * */
+    class TraceSite
+    {
+        public:
+            TraceSite(const char* file, int line, const char* format, double period);
+            ~TraceSite() = default;
+            TraceSite(const TraceSite&) = delete;
+            TraceSite& operator=(const TraceSite&) = delete;
+            TraceSite(TraceSite&&) = delete;
+            TraceSite& operator=(TraceSite&&) = delete;
+
+            /*
+             * Whether a period has passed since the last try, time in
+             * nanoseconds on the steady clock
+             * */
+            bool due(int64_t now);
+
+            /*
+             * Whether text should print, it's held back if it repeats the
+             * last line printed within REPEAT_PERIOD. When it prints,
+             * held_back gets how many calls since the last line didn't.
+             * */
+            bool fresh(const char* text, int64_t now, uint32_t& held_back);
+
+            const char* const file;
+            const int line;
+            const char* const format;
+            const uint32_t id;
+
+        private:
+            const int64_t period;
+            std::atomic<int64_t> last_try;
+            std::atomic<int64_t> last_print;
+            std::atomic<uint64_t> last_hash;
+            std::atomic<uint32_t> skipped;
+    };
+
+    /*
+     * Bounded queue of records for many writers and one reader, without
+     * locks (Vyukov's bounded queue). Full means the record is dropped.
+     * */
+    class TraceRing
+    {
+        public:
+            explicit TraceRing(size_t capacity);
+            ~TraceRing() = default;
+            TraceRing(const TraceRing&) = delete;
+            TraceRing& operator=(const TraceRing&) = delete;
+            TraceRing(TraceRing&&) = delete;
+            TraceRing& operator=(TraceRing&&) = delete;
+
+            bool push(const TraceRecord& record);
+            bool pop(TraceRecord& record);
+
+        private:
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                TraceRecord record;
+            };
+
+            //power of two, so positions wrap with a mask
+            const size_t mask;
+            std::unique_ptr<Cell[]> cells;
+            std::atomic<size_t> enqueue_position;
+            std::atomic<size_t> dequeue_position;
+    };
+
+    /*
+     * The process wide trace file, only on when TFR_TRACE_DIR is set
+     * */
+    class TraceSink
+    {
+        public:
+            static TraceSink& instance();
+            ~TraceSink();
+            TraceSink(const TraceSink&) = delete;
+            TraceSink& operator=(const TraceSink&) = delete;
+            TraceSink(TraceSink&&) = delete;
+            TraceSink& operator=(TraceSink&&) = delete;
+
+            bool enabled() const
+            {
+                return file != nullptr;
+            }
+
+            /*
+             * Queues a call, never blocks
+             * */
+            void push(const TraceSite& site, const TraceArg* args, uint32_t count);
+
+        private:
+            static const size_t CAPACITY = 8192;
+            //how often the writer empties the ring [ms]
+            static const int WRITE_PERIOD = 50;
+
+            TraceSink();
+
+            std::FILE* file;
+            TraceRing ring;
+            std::atomic<uint64_t> dropped;
+            std::atomic<bool> stopping;
+            std::thread writer;
+
+            void write();
+    };
+
+    int64_t steadyNanoseconds();
+
+    inline TraceArg toTraceArg(const char* value)
+    {
+        TraceArg arg{};
+        arg.type = TraceArg::Type::TEXT;
+        //zeroed above, so whatever fits is terminated
+        for (size_t i = 0; i + 1 < sizeof(arg.text) && value[i] != '\0'; ++i)
+            arg.text[i] = value[i];
+        return arg;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value,
+             TraceArg>::type toTraceArg(T value)
+    {
+        TraceArg arg{};
+        arg.type = TraceArg::Type::INTEGER;
+        arg.integer = static_cast<int64_t>(value);
+        return arg;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, TraceArg>::type
+        toTraceArg(T value)
+    {
+        TraceArg arg{};
+        arg.type = TraceArg::Type::REAL;
+        arg.real = value;
+        return arg;
+    }
+
+    /*
+     * Never called, the macros call it in dead code so the compiler checks
+     * the arguments against the format
+     * */
+    inline void checkFormat(const char*, ...) __attribute__((format(printf, 1, 2)));
+    inline void checkFormat(const char*, ...)
+    {
+    }
+
+    /*
+     * Queues the call for the trace file if it's on, the format is already
+     * in the site
+     * */
+    template<typename... Args>
+    void trace(const TraceSite& site, const char*, const Args&... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_TRACE_ARGS,
+                "a limited log takes at most MAX_TRACE_ARGS arguments");
+        TraceSink& sink = TraceSink::instance();
+        if (!sink.enabled())
+            return;
+        //the leading empty argument lets this build with no arguments
+        const TraceArg converted[] = {TraceArg{}, toTraceArg(args)...};
+        sink.push(site, converted + 1, sizeof...(Args));
+    }
+
+    /*
+     * Decides whether the call prints, formatting it into text if it might
+     * */
+    template<typename... Args>
+    bool limit(TraceSite& site, char (&text)[MAX_LOG_LENGTH], uint32_t& held_back,
+            const char* format, const Args&... args)
+    {
+        int64_t now = steadyNanoseconds();
+        if (!site.due(now))
+            return false;
+        std::snprintf(text, MAX_LOG_LENGTH, format, args...);
+        return site.fresh(text, now, held_back);
+    }
+
+    inline bool limit(TraceSite& site, char (&text)[MAX_LOG_LENGTH], uint32_t& held_back,
+            const char* format)
+    {
+        int64_t now = steadyNanoseconds();
+        if (!site.due(now))
+            return false;
+        std::snprintf(text, MAX_LOG_LENGTH, "%s", format);
+        return site.fresh(text, now, held_back);
+    }
+}
+
+#define TFR_LOG_FORMAT(...) TFR_LOG_FORMAT_IMPL(__VA_ARGS__, unused)
+#define TFR_LOG_FORMAT_IMPL(format, ...) format
+
+#define TFR_LOG_LIMITED(level, period, ...) \
+    do \
+    { \
+        if (false) \
+            ::tfr_utilities::checkFormat(__VA_ARGS__); \
+        static ::tfr_utilities::TraceSite tfr_log_site{__FILE__, __LINE__, \
+            TFR_LOG_FORMAT(__VA_ARGS__), period}; \
+        ::tfr_utilities::trace(tfr_log_site, __VA_ARGS__); \
+        ROSCONSOLE_DEFINE_LOCATION(true, level, ROSCONSOLE_DEFAULT_NAME ".limited"); \
+        if (ROS_UNLIKELY(__rosconsole_define_location__enabled)) \
+        { \
+            char tfr_log_text[::tfr_utilities::MAX_LOG_LENGTH]; \
+            uint32_t tfr_log_held_back = 0; \
+            if (::tfr_utilities::limit(tfr_log_site, tfr_log_text, \
+                        tfr_log_held_back, __VA_ARGS__)) \
+            { \
+                if (tfr_log_held_back > 0) \
+                    ROSCONSOLE_PRINT_AT_LOCATION("%s [%u held back]", tfr_log_text, \
+                            tfr_log_held_back); \
+                else \
+                    ROSCONSOLE_PRINT_AT_LOCATION("%s", tfr_log_text); \
+            } \
+        } \
+    } while (false)
+
+#define TFR_DEBUG_LIMITED(period, ...) \
+    TFR_LOG_LIMITED(::ros::console::levels::Debug, period, __VA_ARGS__)
+#define TFR_INFO_LIMITED(period, ...) \
+    TFR_LOG_LIMITED(::ros::console::levels::Info, period, __VA_ARGS__)
+#define TFR_WARN_LIMITED(period, ...) \
+    TFR_LOG_LIMITED(::ros::console::levels::Warn, period, __VA_ARGS__)
+
+#endif
@@ -1,5 +1,30 @@
 #include <arm_manipulator.h>
 
+ArmTrajectories::ArmTrajectories()
+{
+    arm.joint_names = {"turntable_joint", "lower_arm_joint", "upper_arm_joint"};
+    arm.points.resize(1);
+    arm.points[0].positions.resize(3);
+    arm.points[0].time_from_start = ros::Duration(0.06);
+
+    scoop.joint_names = {"scoop_joint"};
+    scoop.points.resize(1);
+    scoop.points[0].positions.resize(1);
+    scoop.points[0].time_from_start = ros::Duration(0.06);
+}
+
+void ArmTrajectories::set(const double& turntable, const double& lower_arm,
+        const double& upper_arm, const double& scoop_angle, const ros::Time& stamp)
+{
+    arm.header.stamp = stamp;
+    arm.points[0].positions[0] = turntable;
+    arm.points[0].positions[1] = lower_arm;
+    arm.points[0].positions[2] = upper_arm;
+
+    scoop.header.stamp = stamp;
+    scoop.points[0].positions[0] = scoop_angle;
+}
+
 ArmManipulator::ArmManipulator(ros::NodeHandle &n):
             trajectory_publisher{n.advertise<trajectory_msgs::JointTrajectory>("/arm_controller/command", 5)},
             scoop_trajectory_publisher{n.advertise<trajectory_msgs::JointTrajectory>("/arm_end_controller/command", 5)}
@@ -7,27 +32,7 @@ ArmManipulator::ArmManipulator(ros::NodeHandle &n):
 
 void  ArmManipulator::moveArm(const double& turntable, const double& lower_arm ,const double& upper_arm,  const double& scoop )
 {
-    trajectory_msgs::JointTrajectory trajectory;
-    trajectory.header.stamp = ros::Time::now();
-    trajectory.joint_names.resize(3);
-    trajectory.points.resize(1);
-    trajectory.points[0].positions.resize(3);
-    trajectory.joint_names[0]="turntable_joint";
-    trajectory.joint_names[1]="lower_arm_joint";
-    trajectory.joint_names[2]="upper_arm_joint";
-    trajectory.points[0].positions[0] = turntable;
-    trajectory.points[0].positions[1] = lower_arm;
-    trajectory.points[0].positions[2] = upper_arm;
-    trajectory.points[0].time_from_start = ros::Duration(0.06);
-    trajectory_publisher.publish(trajectory);
-
-    trajectory_msgs::JointTrajectory scoop_trajectory;
-    scoop_trajectory.header.stamp = ros::Time::now();
-    scoop_trajectory.joint_names.resize(1);
-    scoop_trajectory.points.resize(1);
-    scoop_trajectory.points[0].positions.resize(1);
-    scoop_trajectory.joint_names[0]="scoop_joint";
-    scoop_trajectory.points[0].positions[0] = scoop;
-    scoop_trajectory.points[0].time_from_start = ros::Duration(0.06);
-    scoop_trajectory_publisher.publish(scoop_trajectory);
+    trajectories.set(turntable, lower_arm, upper_arm, scoop, ros::Time::now());
+    trajectory_publisher.publish(trajectories.arm);
+    scoop_trajectory_publisher.publish(trajectories.scoop);
 }
@@ -7,17 +7,22 @@ enum { SystemMask = 0b1111111100000000 };
  * Sub System specific getters for system messages.
  *
  * Any new status codes should have their associated messaged added into these
- * functions.
+ * functions. They return literals so logging a status never allocates.
  */
-std::string parseSysCode(StatusCode code, float data);
-std::string parseExecCode(StatusCode code, float data);
-std::string parseLocCode(StatusCode code, float data);
-std::string parseNavCode(StatusCode code, float data);
-std::string parseMineCode(StatusCode code, float data);
-std::string parseDumpCode(StatusCode code, float data);
+const char* parseSysCode(StatusCode code, float data);
+const char* parseExecCode(StatusCode code, float data);
+const char* parseLocCode(StatusCode code, float data);
+const char* parseNavCode(StatusCode code, float data);
+const char* parseMineCode(StatusCode code, float data);
+const char* parseDumpCode(StatusCode code, float data);
 
 
 std::string getStatusMessage(StatusCode code, float data)
+{
+    return std::string{getStatusText(code, data)};
+}
+
+const char* getStatusText(StatusCode code, float data)
 {
     //switch to find the sub system and use associated code parser
     switch (static_cast<SubSystem>(SystemMask & static_cast<uint16_t>(code)))
@@ -54,7 +59,7 @@ std::string getStatusMessage(StatusCode code, float data)
 }
 
 //Parser for all system level status codes
-std::string parseSysCode(StatusCode code, float data)
+const char* parseSysCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -75,7 +80,7 @@ std::string parseSysCode(StatusCode code, float data)
 
 
 //Parser for all status codes in the Executive sub system
-std::string parseExecCode(StatusCode code, float data)
+const char* parseExecCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -100,7 +105,7 @@ std::string parseExecCode(StatusCode code, float data)
 }
 
 //Parser for all status codes in the Localization sub system
-std::string parseLocCode(StatusCode code, float data)
+const char* parseLocCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -116,7 +121,7 @@ std::string parseLocCode(StatusCode code, float data)
 }
 
 //Parser for all status codes in the Navigation sub system
-std::string parseNavCode(StatusCode code, float data)
+const char* parseNavCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -132,7 +137,7 @@ std::string parseNavCode(StatusCode code, float data)
 }
 
 //Parser for all status codes in the Mining sub system
-std::string parseMineCode(StatusCode code, float data)
+const char* parseMineCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -148,7 +153,7 @@ std::string parseMineCode(StatusCode code, float data)
 }
 
 //Parser for all status codes in the Dumping sub system
-std::string parseDumpCode(StatusCode code, float data)
+const char* parseDumpCode(StatusCode code, float data)
 {
     switch(code)
     {
@@ -7,35 +7,35 @@ StatusPublisher::StatusPublisher(ros::NodeHandle &n) :
 //  mission control
 void StatusPublisher::status(const StatusCode &code, const float &data)  const
 {
-    ROS_INFO("%s" ,getStatusMessage(code,data).c_str());
+    ROS_INFO("%s" ,getStatusText(code,data));
     missionControl(code,data);
 }
 
 // ROS_INFO visibility + mission control
 void StatusPublisher::info(const StatusCode &code, const float &data)  const
 {
-    ROS_INFO("%s" ,getStatusMessage(code,data).c_str());
+    ROS_INFO("%s" ,getStatusText(code,data));
     missionControl(code,data);
 }
 
 // ROS_DEBUG visibility + mission control
 void StatusPublisher::debug(const StatusCode &code, const float &data) const
 {
-    ROS_DEBUG("%s" ,getStatusMessage(code,data).c_str());
+    ROS_DEBUG("%s" ,getStatusText(code,data));
     missionControl(code,data);
 }
 
 // ROS_WARN visibility + mission control
 void StatusPublisher::warn(const StatusCode &code, const float &data) const
 {
-    ROS_WARN("%s" ,getStatusMessage(code,data).c_str());
+    ROS_WARN("%s" ,getStatusText(code,data));
     missionControl(code,data);
 }
 
 // ROS_ERROR visibility + mission control
 void StatusPublisher::error(const StatusCode &code, const float &data) const
 {
-    ROS_ERROR("%s" ,getStatusMessage(code,data).c_str());
+    ROS_ERROR("%s" ,getStatusText(code,data));
     missionControl(code,data);
 }
 
@@ -43,9 +43,10 @@ void StatusPublisher::error(const StatusCode &code, const float &data) const
 void StatusPublisher::missionControl(const StatusCode &code, const float &data)
     const
 {
+    //fixed size, building it on the stack doesn't touch the heap
     tfr_msgs::SystemStatus status;
     status.time_stamp = ros::Time::now();
-    status.status_code = static_cast<uint8_t>(code);
+    status.status_code = static_cast<uint16_t>(code);
     status.data = data;
     com.publish(status);
 }
@@ -0,0 +1,161 @@
+/**
+ * trace_dump.cpp
+ *
+ * Prints a trace written by the limited logs (see trace_log.h) one call per
+ * line, as "<wall time> <file>:<line> <message>". The records are read as
+ * they are in memory, so run it on the same kind of machine that wrote them.
+ *
+ * usage: trace_dump <file.trace>
+ */
+#include <tfr_utilities/trace_log.h>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+
+using tfr_utilities::TraceArg;
+using tfr_utilities::TraceRecord;
+
+namespace
+{
+    struct Site
+    {
+        int32_t line;
+        std::string file;
+        std::string format;
+    };
+
+    bool readText(std::FILE* file, std::string& text)
+    {
+        uint32_t length;
+        if (std::fread(&length, sizeof(length), 1, file) != 1)
+            return false;
+        text.resize(length);
+        return length == 0 || std::fread(&text[0], 1, length, file) == length;
+    }
+
+    /*
+     * Fills in format from the recorded arguments, each conversion gets the
+     * type it asks for whatever was recorded
+     * */
+    std::string render(const std::string& format, const TraceRecord& record)
+    {
+        std::string output;
+        uint32_t next = 0;
+        char buffer[256];
+        for (size_t i = 0; i < format.size(); ++i)
+        {
+            if (format[i] != '%')
+            {
+                output += format[i];
+                continue;
+            }
+            size_t end = format.find_first_of("diouxXcfFeEgGaAs%", i + 1);
+            if (end == std::string::npos)
+                break;
+            char conversion = format[end];
+            if (conversion == '%')
+            {
+                output += '%';
+                i = end;
+                continue;
+            }
+
+            //keep the flags, width and precision, drop any length
+            std::string spec = format.substr(i, end - i);
+            spec.erase(spec.find_last_not_of("hljztL") + 1);
+            const TraceArg* arg = next < record.count ? &record.args[next++] : nullptr;
+            if (arg == nullptr)
+                output += "<missing>";
+            else if (std::strchr("diouxXc", conversion) != nullptr)
+            {
+                long long value = arg->type == TraceArg::Type::REAL ?
+                    static_cast<long long>(arg->real) : arg->integer;
+                std::snprintf(buffer, sizeof(buffer), (spec + "ll" + conversion).c_str(),
+                        value);
+                output += buffer;
+            }
+            else if (conversion == 's')
+            {
+                if (arg->type == TraceArg::Type::TEXT)
+                    std::snprintf(buffer, sizeof(buffer), (spec + 's').c_str(), arg->text);
+                else if (arg->type == TraceArg::Type::REAL)
+                    std::snprintf(buffer, sizeof(buffer), "%g", arg->real);
+                else
+                    std::snprintf(buffer, sizeof(buffer), "%lld",
+                            static_cast<long long>(arg->integer));
+                output += buffer;
+            }
+            else
+            {
+                double value = arg->type == TraceArg::Type::INTEGER ?
+                    static_cast<double>(arg->integer) : arg->real;
+                std::snprintf(buffer, sizeof(buffer), (spec + conversion).c_str(), value);
+                output += buffer;
+            }
+            i = end;
+        }
+        return output;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::fprintf(stderr, "usage: trace_dump <file.trace>\n");
+        return 1;
+    }
+    std::FILE* file = std::fopen(argv[1], "rb");
+    if (file == nullptr)
+    {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    std::map<uint32_t, Site> sites;
+    uint64_t dropped = 0;
+    int tag;
+    while ((tag = std::fgetc(file)) != EOF)
+    {
+        if (tag == 'S')
+        {
+            uint32_t id;
+            Site site;
+            if (std::fread(&id, sizeof(id), 1, file) != 1 ||
+                    std::fread(&site.line, sizeof(site.line), 1, file) != 1 ||
+                    !readText(file, site.file) || !readText(file, site.format))
+                break;
+            sites[id] = site;
+        }
+        else if (tag == 'R')
+        {
+            TraceRecord record;
+            if (std::fread(&record, sizeof(record), 1, file) != 1)
+                break;
+            auto site = sites.find(record.site);
+            if (site == sites.end())
+                continue;
+            std::printf("%lld.%09lld %s:%d %s\n",
+                    static_cast<long long>(record.stamp / 1000000000),
+                    static_cast<long long>(record.stamp % 1000000000),
+                    site->second.file.c_str(), site->second.line,
+                    render(site->second.format, record).c_str());
+        }
+        else if (tag == 'D')
+        {
+            if (std::fread(&dropped, sizeof(dropped), 1, file) != 1)
+                break;
+        }
+        else
+        {
+            std::fprintf(stderr, "trace_dump: unknown entry '%c', stopping\n", tag);
+            break;
+        }
+    }
+    std::fclose(file);
+    if (dropped > 0)
+        std::printf("%llu records dropped while writing\n",
+                static_cast<unsigned long long>(dropped));
+    return 0;
+}
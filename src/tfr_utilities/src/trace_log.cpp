@@ -0,0 +1,263 @@
+#include "trace_log.h"
+#include <ros/this_node.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace tfr_utilities
+{
+    namespace
+    {
+        std::atomic<uint32_t> next_site{0};
+
+        int64_t toNanoseconds(double seconds)
+        {
+            return static_cast<int64_t>(seconds * 1e9);
+        }
+
+        //fnv-1a
+        uint64_t hashText(const char* text)
+        {
+            uint64_t hash = 14695981039346656037ull;
+            for (; *text != '\0'; ++text)
+            {
+                hash ^= static_cast<unsigned char>(*text);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        size_t roundUpToPowerOfTwo(size_t value)
+        {
+            size_t rounded = 1;
+            while (rounded < value)
+                rounded <<= 1;
+            return rounded;
+        }
+
+        void writeText(std::FILE* file, const char* text)
+        {
+            uint32_t length = std::strlen(text);
+            std::fwrite(&length, sizeof(length), 1, file);
+            std::fwrite(text, 1, length, file);
+        }
+    }
+
+    int64_t steadyNanoseconds()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    TraceSite::TraceSite(const char* f, int l, const char* fmt, double p) :
+        file{f}, line{l}, format{fmt}, id{next_site++},
+        period{toNanoseconds(p)},
+        //the first call always goes out
+        last_try{steadyNanoseconds() - toNanoseconds(p) - 1},
+        last_print{0}, last_hash{0}, skipped{0}
+    {
+    }
+
+    bool TraceSite::due(int64_t now)
+    {
+        int64_t last = last_try.load(std::memory_order_relaxed);
+        //another thread taking the same slot counts as held back too
+        if (now - last <= period ||
+                !last_try.compare_exchange_strong(last, now, std::memory_order_relaxed))
+        {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    bool TraceSite::fresh(const char* text, int64_t now, uint32_t& held_back)
+    {
+        uint64_t hash = hashText(text);
+        if (hash == last_hash.load(std::memory_order_relaxed) &&
+                now - last_print.load(std::memory_order_relaxed) <
+                toNanoseconds(REPEAT_PERIOD))
+        {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        last_hash.store(hash, std::memory_order_relaxed);
+        last_print.store(now, std::memory_order_relaxed);
+        held_back = skipped.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    TraceRing::TraceRing(size_t capacity) :
+        mask{roundUpToPowerOfTwo(capacity) - 1},
+        cells{new Cell[mask + 1]},
+        enqueue_position{0},
+        dequeue_position{0}
+    {
+        for (size_t i = 0; i <= mask; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool TraceRing::push(const TraceRecord& record)
+    {
+        size_t position = enqueue_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (enqueue_position.compare_exchange_weak(position, position + 1,
+                            std::memory_order_relaxed))
+                {
+                    cell.record = record;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            //the reader hasn't got to this cell yet, full
+            else if (difference < 0)
+                return false;
+            else
+                position = enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool TraceRing::pop(TraceRecord& record)
+    {
+        size_t position = dequeue_position.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[position & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) -
+                static_cast<intptr_t>(position + 1);
+            if (difference == 0)
+            {
+                if (dequeue_position.compare_exchange_weak(position, position + 1,
+                            std::memory_order_relaxed))
+                {
+                    record = cell.record;
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            //nothing written here yet, empty
+            else if (difference < 0)
+                return false;
+            else
+                position = dequeue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t TraceSink::CAPACITY;
+    const int TraceSink::WRITE_PERIOD;
+
+    TraceSink& TraceSink::instance()
+    {
+        static TraceSink sink{};
+        return sink;
+    }
+
+    TraceSink::TraceSink() :
+        file{nullptr}, ring{CAPACITY}, dropped{0}, stopping{false}
+    {
+        const char* directory = std::getenv("TFR_TRACE_DIR");
+        if (directory == nullptr || *directory == '\0')
+            return;
+
+        //a limited log before ros::init gets here without a node name
+        std::string name = ros::this_node::getName();
+        if (!name.empty() && name[0] == '/')
+            name.erase(0, 1);
+        if (name.empty())
+            name = "unnamed";
+        //nested namespaces would make subdirectories
+        for (char& c : name)
+            if (c == '/')
+                c = '_';
+        std::string path = std::string{directory} + "/" + name + "-" +
+            std::to_string(getpid()) + ".trace";
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr)
+        {
+            ROS_WARN("Trace Log: couldn't open %s, not tracing", path.c_str());
+            return;
+        }
+        writer = std::thread{&TraceSink::write, this};
+    }
+
+    TraceSink::~TraceSink()
+    {
+        stopping = true;
+        if (writer.joinable())
+            writer.join();
+        if (file != nullptr)
+            std::fclose(file);
+    }
+
+    void TraceSink::push(const TraceSite& site, const TraceArg* args, uint32_t count)
+    {
+        TraceRecord record;
+        record.source = &site;
+        record.site = site.id;
+        record.count = count;
+        record.stamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+        for (uint32_t i = 0; i < count; ++i)
+            record.args[i] = args[i];
+        if (!ring.push(record))
+            dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /*
+     * Writes each site the first time it shows up ('S', id, line, file,
+     * format), then the records ('R' and the record as it is in memory), and
+     * the count of dropped records ('D') as it goes up
+     * */
+    void TraceSink::write()
+    {
+        std::vector<bool> written{};
+        uint64_t reported = 0;
+        TraceRecord record;
+        while (true)
+        {
+            //read before emptying, so nothing pushed before the stop is lost
+            bool last = stopping;
+            while (ring.pop(record))
+            {
+                if (record.site >= written.size())
+                    written.resize(record.site + 1, false);
+                if (!written[record.site])
+                {
+                    written[record.site] = true;
+                    const TraceSite& site = *record.source;
+                    int32_t line = site.line;
+                    std::fputc('S', file);
+                    std::fwrite(&site.id, sizeof(site.id), 1, file);
+                    std::fwrite(&line, sizeof(line), 1, file);
+                    writeText(file, site.file);
+                    writeText(file, site.format);
+                }
+                std::fputc('R', file);
+                std::fwrite(&record, sizeof(record), 1, file);
+            }
+
+            uint64_t total = dropped.load(std::memory_order_relaxed);
+            if (total != reported)
+            {
+                reported = total;
+                std::fputc('D', file);
+                std::fwrite(&total, sizeof(total), 1, file);
+            }
+            std::fflush(file);
+            if (last)
+                return;
+            std::this_thread::sleep_for(std::chrono::milliseconds(WRITE_PERIOD));
+        }
+    }
+}
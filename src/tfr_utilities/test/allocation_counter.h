@@ -0,0 +1,29 @@
+/* Test hook that counts heap allocations. Linking allocation_counter.cpp into
+ * a test replaces the global operator new, so anything that allocates
+ * between two reads of the count shows up, including allocations made inside
+ * std::string, std::vector and the message types.
+ *
+ * Usage:
+ *      AllocationScope scope;
+ *      thingThatShouldNotAllocate();
+ *      EXPECT_EQ(scope.allocations(), 0);
+ * */
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+namespace allocation_counter
+{
+    //allocations since the program started
+    long count();
+}
+
+class AllocationScope
+{
+    public:
+        AllocationScope() : start{allocation_counter::count()} {}
+        long allocations() const { return allocation_counter::count() - start; }
+    private:
+        long start;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "status_code.h"
+#include "arm_manipulator.h"
+
+TEST(MessageReuse, CounterSeesAllocations)
+{
+    AllocationScope scope;
+    std::string message = getStatusMessage(StatusCode::NAV_OK, 0);
+    ASSERT_GT(scope.allocations(), 0);
+}
+
+TEST(MessageReuse, StatusTextDoesNotAllocate)
+{
+    AllocationScope scope;
+    const char* text = nullptr;
+    for (int i = 0; i < 100; ++i)
+        text = getStatusText(StatusCode::EXC_OK, i);
+    ASSERT_EQ(scope.allocations(), 0);
+    ASSERT_STREQ(text, "Executive System OK");
+}
+
+TEST(MessageReuse, ArmTrajectoriesSteadyState)
+{
+    ArmTrajectories trajectories;
+    AllocationScope scope;
+    for (int i = 0; i < 100; ++i)
+        trajectories.set(0.1 * i, 0.2, 1.07, 1.6, ros::Time(i + 1));
+    ASSERT_EQ(scope.allocations(), 0);
+
+    ASSERT_EQ(trajectories.arm.joint_names.size(), 3u);
+    ASSERT_EQ(trajectories.arm.joint_names[1], "lower_arm_joint");
+    ASSERT_DOUBLE_EQ(trajectories.arm.points[0].positions[0], 9.9);
+    ASSERT_DOUBLE_EQ(trajectories.arm.points[0].positions[2], 1.07);
+    ASSERT_EQ(trajectories.scoop.joint_names[0], "scoop_joint");
+    ASSERT_DOUBLE_EQ(trajectories.scoop.points[0].positions[0], 1.6);
+    ASSERT_EQ(trajectories.scoop.header.stamp, ros::Time(100));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <thread>
+#include <vector>
+#include "trace_log.h"
+
+using tfr_utilities::TraceArg;
+using tfr_utilities::TraceRecord;
+using tfr_utilities::TraceRing;
+using tfr_utilities::TraceSite;
+
+namespace
+{
+    const int64_t SECOND = 1000000000;
+
+    TraceRecord makeRecord(uint32_t site, int64_t value)
+    {
+        TraceRecord record{};
+        record.site = site;
+        record.count = 1;
+        record.args[0] = tfr_utilities::toTraceArg(value);
+        return record;
+    }
+}
+
+TEST(TraceLog, SitePrintsOncePerPeriod)
+{
+    TraceSite site{__FILE__, __LINE__, "%d", 1.0};
+    int64_t start = tfr_utilities::steadyNanoseconds();
+    ASSERT_TRUE(site.due(start));
+    ASSERT_FALSE(site.due(start + SECOND / 2));
+    ASSERT_FALSE(site.due(start + SECOND));
+    ASSERT_TRUE(site.due(start + SECOND + 1));
+}
+
+TEST(TraceLog, RepeatsAreHeldBack)
+{
+    TraceSite site{__FILE__, __LINE__, "%s", 0.0};
+    uint32_t held_back = 0;
+    ASSERT_TRUE(site.fresh("state ACTIVE", 0, held_back));
+    ASSERT_EQ(held_back, 0u);
+    ASSERT_FALSE(site.fresh("state ACTIVE", SECOND, held_back));
+    ASSERT_FALSE(site.fresh("state ACTIVE", 2 * SECOND, held_back));
+    ASSERT_TRUE(site.fresh("state SUCCEEDED", 3 * SECOND, held_back));
+    ASSERT_EQ(held_back, 2u);
+    //repeats still go out now and then
+    ASSERT_TRUE(site.fresh("state SUCCEEDED", 14 * SECOND, held_back));
+    ASSERT_EQ(held_back, 0u);
+}
+
+TEST(TraceLog, LimitFormatsOnlyWhatPrints)
+{
+    TraceSite site{__FILE__, __LINE__, "%s %d %.1f", 100.0};
+    char text[tfr_utilities::MAX_LOG_LENGTH];
+    uint32_t held_back = 0;
+    ASSERT_TRUE(tfr_utilities::limit(site, text, held_back, "%s %d %.1f",
+                "goal", 3, 0.25));
+    ASSERT_STREQ(text, "goal 3 0.2");
+    text[0] = '\0';
+    ASSERT_FALSE(tfr_utilities::limit(site, text, held_back, "%s %d %.1f",
+                "goal", 4, 0.5));
+    ASSERT_STREQ(text, "");
+}
+
+TEST(TraceLog, ArgumentsKeepTheirType)
+{
+    TraceArg text = tfr_utilities::toTraceArg("a long state name to cut");
+    ASSERT_EQ(text.type, TraceArg::Type::TEXT);
+    ASSERT_STREQ(text.text, "a long state na");
+    TraceArg flag = tfr_utilities::toTraceArg(true);
+    ASSERT_EQ(flag.type, TraceArg::Type::INTEGER);
+    ASSERT_EQ(flag.integer, 1);
+    TraceArg real = tfr_utilities::toTraceArg(0.5f);
+    ASSERT_EQ(real.type, TraceArg::Type::REAL);
+    ASSERT_DOUBLE_EQ(real.real, 0.5);
+}
+
+TEST(TraceLog, RingDropsWhenFull)
+{
+    TraceRing ring{4};
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(ring.push(makeRecord(0, i)));
+    ASSERT_FALSE(ring.push(makeRecord(0, 4)));
+
+    TraceRecord record;
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE(ring.pop(record));
+        ASSERT_EQ(record.args[0].integer, i);
+    }
+    ASSERT_FALSE(ring.pop(record));
+    ASSERT_TRUE(ring.push(makeRecord(0, 5)));
+}
+
+TEST(TraceLog, RingTakesManyWriters)
+{
+    const int WRITERS = 4;
+    const int EACH = 20000;
+    TraceRing ring{256};
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; ++w)
+        writers.emplace_back([&ring, w]()
+        {
+            for (int i = 0; i < EACH; ++i)
+                while (!ring.push(makeRecord(w, i)))
+                    std::this_thread::yield();
+        });
+
+    //every record comes out once, in order for each writer
+    std::vector<int64_t> next(WRITERS, 0);
+    int received = 0;
+    TraceRecord record;
+    while (received < WRITERS * EACH)
+    {
+        if (!ring.pop(record))
+            continue;
+        ASSERT_EQ(record.args[0].integer, next[record.site]);
+        ++next[record.site];
+        ++received;
+    }
+    for (auto& writer : writers)
+        writer.join();
+    ASSERT_FALSE(ring.pop(record));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}